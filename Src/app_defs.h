@@ -61,14 +61,16 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 // USB Defines ////////////////////////////////////////////////////////////////
+#if !defined(MX_ENABLE_USB)
 #define MX_ENABLE_USB           0
+#endif
 #define RX_BUF_USB_SIZE         256         // Size of the USB receive buffer
-#define RX_BUF_USB_COUNTERTYPE  uint32_t    // Type used for counters in the USB receive buffer
 #define RX_BUF_USB_COMMANDS     16          // Number of commands the USB receive buffer can store
+#define RX_BUF_USB_ISR_SIZE     128         // Size of buffer between USB receive interrupt and main loop, must be power of 2
 
 #define TX_BUF_USB_SIZE         256         // Size of the USB receive buffer
-#define TX_BUF_USB_COUNTERTYPE  uint32_t    // Type used for counters in the USB receive buffer
 #define TX_BUF_USB_COMMANDS     16          // Number of commands the USB receive buffer can store
+#define USB_TX_WAIT_TIMEOUT     200         // Maximum time to wait for space in USB transmit buffer for multi part replies, in ms
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -81,6 +83,8 @@
 #define RESET_TIMEOUT_RADIO     30  //CPU will reset if no Ratio TX or RX for this period (in seconds)
 #define RESET_TIMEOUT_USB_CMD   30  //CPU will reset if no USB command processed for this period (in seconds)
 
+#define CONFIG_SAVE_DELAY       2000    //Changed config is saved to EEPROM when no more changes made for this period (in ms)
+
 //Receive listeners
 #define RX_LISTENER_APP         0x01
 #define RX_LISTENER_USB         0x02
@@ -124,6 +128,9 @@
 #define LORA_FIX_LENGTH_PAYLOAD_ON                  false   // true = No Header(Implicit header mode), false = Has header(Explicit header mode)
 #define LORA_FHSS_ENABLED                           false
 #define LORA_NB_SYMB_HOP                            4
+#define LORA_FHSS_CHANNELS                          8       // Number of FHSS hop channels, starting at configured frequency
+#define LORA_FHSS_SPACING                           200000  // FHSS hop channel spacing in Hz
+#define LORA_FHSS_SEED                              0x4D58  // Seed for pseudo random hop channel order, must be same for all radios
 #define LORA_IQ_INVERSION_ON                        false
 #define LORA_CRC_ENABLED                            true
 
@@ -187,6 +194,7 @@ typedef struct AppData_ {
             uint32_t    dirtyConf           :1; //Set when AppConfig changes. Used & Cleared by main App
             uint32_t    dirtyConfDisp       :1; //Set when AppConfig changes. Used & Cleared by Display
             uint32_t    displayOff          :1; //Display is currently off
+            uint32_t    unsavedConf         :1; //AppConfig changed, but not saved to EEPROM yet. Cleared by saveConfigNow()
         } bits;
         uint32_t Val;
         //Constructors
@@ -202,6 +210,7 @@ typedef struct AppData_ {
     uint16_t    rxCountPingPong;        //Ping-Pong valid receive count
     uint16_t    rxErrCountPingPong;     //Ping-Pong error count, is incremented for timeout or faulty received packet(addressed to us)
     uint16_t    oldRxCountPingPong;     //Value of "rxCountPingPong" when last PING message was sent
+    int         tmrConfChanged;         //Time of last unsaved AppConfig or RadioConfig change
 } PACKED AppData;
 
 typedef struct RadioData_ {
@@ -213,6 +222,7 @@ typedef struct RadioData_ {
             uint32_t noRadio            :1; //No radio detected
             uint32_t noRadioMsgUSB      :1; //Send "No Radio" message via USB
             uint32_t rxMsgLost          :1; //Set if OnRxDone is called, and previous received msg not processed yet(rxLen!=0)
+            uint32_t unsavedConf        :1; //RadioConfig changed, but not saved to EEPROM yet. Cleared by saveConfigNow()
         } bits;
         uint32_t    Val;
 
@@ -250,6 +260,21 @@ typedef struct RadioData_ {
 #define MXCONF_ADR_START                EEPROM_START_ADDRESS
 #define MXCONF_ADR_LAST                 MXCONF_ADR_RadioConfig4 /* Address of LAST structure "MxConfig Structure" */
 #define MXCONF_SIZE_BASE                16
+#define MXCONF_ID_COUNT                 6       /* Number of "MxConfig Structure" IDs */
+#define MXCONF_MAX_DATA                 64      /* Maximum sizeData of a "MxConfig Structure" */
+#define MXCONF_MAX_DESC_SIZE            33      /* Maximum size of "Data Descriptor" = 1 + 8 MxConfDataDesc */
+
+//"MxConfig Structures" are saved in a log, see mx_config.cpp. It uses 2 banks, and starts after the area
+//used by old firmware for fixed address structures. Old structures are moved to the log when first read.
+#define EEPROM_SIZE                     0x2000  /* Size of Data EEPROM, 8KB on STM32L151xC */
+#define MXCONF_LOG_ADR                  0x400   /* Offset of first bank in EEPROM */
+#define MXCONF_LOG_BANK_SIZE            0xC00   /* Size of each bank, must be multiple of 4 */
+#define MXCONF_ERASE_WORDS              2       /* Words of spare bank erased by each mxconf_erase_spare() call, about 3ms each */
+
+//Host build (MX_HOST_SIM defined), use a RAM array for Data EEPROM
+#if defined(MX_HOST_SIM) && !defined(MXCONF_EEPROM_SIM)
+#define MXCONF_EEPROM_SIM
+#endif
 
 // AppConfig Defines //////////////////////////////////////////////////////////
 #define MXCONF_ID_AppConfig             0
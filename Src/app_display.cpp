@@ -30,6 +30,7 @@
 #include "mx_config.h"
 #include "nz32s.h"
 #include "mx_ssd1306.h"
+#include "mx_gfx_widget.h"
 #include "im4oled.h"
 
 #if !defined(DISABLE_OLED)
@@ -47,7 +48,6 @@ extern RadioData       radioData[RADIO_COUNT];
 // VARIABLES //////////////////////////////////////////////////////////////////
 bool            hasOLED;
 int             tmrDisplayOff;
-int             tmrUpdateBatt;
 uint16_t        percentBatt;    //Battery percentage
 #if !defined(DISABLE_OLED)
 MxSSD1306_I2C   oled(0x78, i2cBus1, 64);
@@ -96,20 +96,124 @@ enum MENU2_SETTINGS_STATES {
 };
 
 
+// Menu Widgets ///////////////////////////////////////////////////////////////
+//Each widget is bound to its value via a format function. Widgets of the current screen are updated every
+//menu tick, and only redraw characters that changed.
+#define WIDGETS(arr)    arr, (sizeof(arr)/sizeof(arr[0]))
+
+static const char* getBoardName(void) {
+    if (radioConfig[0].boardType == BOARD_INAIR4)
+        return "inAir4";
+    else if (radioConfig[0].boardType == BOARD_INAIR9)
+        return "inAir9";
+    return "inAir9B";
+}
+
+//Frequency in MHz, with 1 decimal. +100 to correct rounding error
+#define FREQ_MHZ(f)     (int)(((f)+100)/1000000)
+#define FREQ_FRAC1(f)   (int)((((f)+100)/100000)%10)
+
+static void fmtBoardName(char* buf, uint8_t size) {
+    snprintf(buf, size, "%s", getBoardName());
+}
+
+static void fmtBatt(char* buf, uint8_t size) {
+    snprintf(buf, size, "%d%%", percentBatt);
+}
+
+static void fmtHomeRadio(char* buf, uint8_t size) {
+    snprintf(buf, size, "F=%d.%d BW=%s SF=%d", FREQ_MHZ(radioConfig[0].frequency), FREQ_FRAC1(radioConfig[0].frequency),
+            arrBwChar[radioConfig[0].bw], radioConfig[0].sf);
+}
+
+static void fmtHomeRxCount(char* buf, uint8_t size) {
+    snprintf(buf, size, "RXed OK=%04d Err=%04d", appData.rxCountPingPong, appData.rxErrCountPingPong);
+}
+
+static void fmtHomeMode(char* buf, uint8_t size) {
+    if (radioData[0].mode == RADIO_MODE_STOPPED)
+        snprintf(buf, size, "Mode: Stopped");
+    else if (radioData[0].mode == RADIO_MODE_MASTER)
+        snprintf(buf, size, "Mode: Master -> Slv%d", appConfig.remotelAdr);
+    else if (radioData[0].mode >= RADIO_MODE_SLAVE)
+        snprintf(buf, size, "Mode: Slave %d", appConfig.localAdr);
+    else if (radioData[0].mode >= RADIO_MODE_ERR_FIRST)
+        snprintf(buf, size, "Error: Code = %d", radioData[0].mode - RADIO_MODE_ERR_FIRST);
+}
+
+static void fmtSetDispTimeout(char* buf, uint8_t size) {
+    snprintf(buf, size, "Disp. Timeout = %03d", appConfig.displayAutoOff);
+}
+
+static void fmtSetBrightness(char* buf, uint8_t size) {
+    snprintf(buf, size, "Brightness = %d", appConfig.displayBrigtness);
+}
+
+static void fmtCfgBoard(char* buf, uint8_t size) {
+    snprintf(buf, size, "Board = %s", getBoardName());
+}
+
+static void fmtCfgFreq(char* buf, uint8_t size) {
+    snprintf(buf, size, "Freq = %d.%d", FREQ_MHZ(radioConfig[0].frequency), FREQ_FRAC1(radioConfig[0].frequency));
+}
+
+static void fmtCfgBw(char* buf, uint8_t size) {
+    snprintf(buf, size, "BW = %s", arrBwChar[radioConfig[0].bw]);
+}
+
+static void fmtCfgSf(char* buf, uint8_t size) {
+    snprintf(buf, size, "SF = %d", radioConfig[0].sf);
+}
+
+//Header of all "Select Menu" screens. Rows are at x=10, leaving space for '>' character
+static MxTextWidget wSelectHeader(0, 2, "Select or * To Return");
+
+//Home screen
+static MxTextWidget wHomeBoard(0, 0, 7, fmtBoardName, 2);
+static MxTextWidget wHomeBatt(104, 5, 4, fmtBatt);
+static MxTextWidget wHomeRadio(0, 36, 21, fmtHomeRadio);    //Line 3 - For 3 lines, use 36,46,56
+static MxTextWidget wHomeRxCount(0, 46, 21, fmtHomeRxCount);
+static MxTextWidget wHomeMode(0, 56, 21, fmtHomeMode);
+static MxTextWidget* const homeWidgets[] = {&wHomeBoard, &wHomeBatt, &wHomeRadio, &wHomeRxCount, &wHomeMode};
+
+//Select Settings or Radio Config
+static MxTextWidget wSelSettings(10, 16, "Settings");
+static MxTextWidget wSelCfgRadio(10, 27, "Configure Radio");
+static MxTextWidget wSelResetCounters(10, 38, "Reset Counters");
+static MxTextWidget* const selectWidgets[] = {&wSelectHeader, &wSelSettings, &wSelCfgRadio, &wSelResetCounters};
+
+//Settings
+static MxTextWidget wSetDispTimeout(10, 16, 19, fmtSetDispTimeout);
+static MxTextWidget wSetBrightness(10, 27, 15, fmtSetBrightness);
+static MxTextWidget wSetRestore(10, 38, "Restore Defaults");
+static MxTextWidget* const settingsWidgets[] = {&wSelectHeader, &wSetDispTimeout, &wSetBrightness, &wSetRestore};
+
+//Configure Radio, first and second screen
+static MxTextWidget wCfgBoard(10, 16, 15, fmtCfgBoard);
+static MxTextWidget wCfgFreq(10, 27, 12, fmtCfgFreq);
+static MxTextWidget wCfgBw(10, 38, 9, fmtCfgBw);
+static MxTextWidget wCfgSf(10, 49, 7, fmtCfgSf);
+static MxTextWidget wCfgRestore(10, 16, "Restore Defaults");
+static MxTextWidget* const cfgRadio1Widgets[] = {&wSelectHeader, &wCfgBoard, &wCfgFreq, &wCfgBw, &wCfgSf};
+static MxTextWidget* const cfgRadio2Widgets[] = {&wSelectHeader, &wCfgRestore};
+
+//Blinking '>' in front of selected row of "Select Menu", and blinking '=' of value being edited
+static MxSelectWidget wSelCursor(0, 16, '>');
+static MxSelectWidget wEditMark(0, 16, '=', 1);
+
+
 // Function Prototypes ////////////////////////////////////////////////////////
 void checkFrequency(uint8_t radioId);
-void selectMenuBlinkEq(uint8_t posEq, uint8_t row, int& tmrDisplay, bool& blinkOn);
-void selectMenuUpdate(uint8_t& selectMenuCurrRow, uint8_t selectMenuRows, uint8_t yFirstGt, int& tmrDisplay, bool& blinkOn);
+static void drawScreen(MxTextWidget* const* widgets, uint8_t count);
+static void selectMenuBlinkEq(uint8_t posEq, uint8_t row, MxPollTimer& tmrDisplay);
+static void selectMenuUpdate(MxPollTimer& tmrDisplay);
 extern void blinkLED(bool reset);
 extern void setRadioMode(uint8_t newMode, uint8_t iRadio);
-void updateBattLevel(void);
 
 
 
 void mx_display_init(void) {
 
-    tmrUpdateBatt = 0;
-
     //Initialize Auto Off timer
     tmrDisplayOff = MxTick::read_ms()
             + ((appConfig.displayAutoOff<10?10:appConfig.displayAutoOff)*1000); //Set auto off at startup to 30 seconds
@@ -155,10 +259,8 @@ void mx_display_task(void) {
         }
     }
 
-    if (MxTick::read_ms() > tmrUpdateBatt) {
-        tmrUpdateBatt += 1000;  //Update in 1 second again
-        updateBattLevel();
-    }
+    //Battery is measured in background by NZ32S::batt_task()
+    percentBatt = NZ32S::get_batt_percent();
 }
 
 
@@ -166,8 +268,6 @@ void mx_display_task(void) {
  * Call every 10mS
  */
 void mx_menu_task(void) {
-    float fVal;
-
 #define MENU_MASK    0x0fff     //Use bottom 14 bits for menu state
 #define MENU_ENTRY   0x8000     //Bit 16 indicates if menu entry has been processed
 #define MENU_EXIT    0x4000     //Bit 15 indicates if menu exit has been processed
@@ -175,15 +275,13 @@ void mx_menu_task(void) {
 
     static uint16_t     smMenu1 = 0;    //Top level menu state machine
     static uint16_t     smMenu2 = 0;    //Second level menu state machine
+    MX_PROFILE_SCOPE(MX_PROF_MENU_TASK);
 
 #if !defined(DISABLE_OLED)
-    static uint8_t  selectMenuCurrRow;  //Current selected row index. Each screen has 4 rows. For first screen is 0-3, next 4-7....
     static uint8_t  selectMenuOldRow;   //Cursor position for menu 2
-    static uint8_t  selectMenuRows;
     static uint16_t oldRxCntPingPong = 0xffff;
     static uint16_t oldRxErrCnt = 0xffff;
-    static uint16_t oldPercentBatt = 0;
-    static int      tmrDisplay;
+    static MxPollTimer tmrDisplay;
     static bool     blinkOn;
 #endif
 
@@ -214,7 +312,7 @@ void mx_menu_task(void) {
         //Display Auto Off enabled
         if(appConfig.displayAutoOff != 0) {
             //Display off timer expired, turn display off
-            if (MxTick::read_ms() >= tmrDisplayOff) {
+            if (MxTick::expired_ms(tmrDisplayOff)) {
                 appData.flags.bits.displayOff = true;
                 MX_DEBUG("\r\nDisplay Off");
                 oled.displayOn(false);  //Turn display off
@@ -222,12 +320,11 @@ void mx_menu_task(void) {
         }
     }
 
-    //If any dirtyConfDisp flags set, display must be redrawn!
+    //If any dirtyConfDisp flags set, mode text of home screen must be redrawn! Widgets update themselves.
     if(appData.flags.bits.dirtyConfDisp || radioData[0].flags.bits.dirtyConfDisp) {
         appData.flags.bits.dirtyConfDisp = false;
         radioData[0].flags.bits.dirtyConfDisp = false;
-        smMenu1 &= ~MENU_REDRAW;    //Clear "redraw" flag - cause display to get redrawn!
-        smMenu2 &= ~MENU_REDRAW;    //Clear "redraw" flag - cause display to get redrawn!
+        smMenu1 &= ~MENU_REDRAW;    //Clear "redraw" flag - cause home screen line 2 to get redrawn!
     }
 
     //Top level menu
@@ -236,42 +333,25 @@ void mx_menu_task(void) {
         // HOME Entry /////////////////////////////////////////////////////////
         if ((smMenu1 & MENU_ENTRY) == 0) {
             smMenu1 |= MENU_ENTRY; //Set "entry" flag
-        }
-        // HOME Redraw ////////////////////////////////////////////////////////
-        if ((smMenu1 & MENU_REDRAW) == 0) {
-            smMenu1 |= MENU_REDRAW; //Set "entry" flag
-
-            oldPercentBatt = 0xff;  //Force battery level to be updated in next step
-            oled.clearDisplay();    //Clear display. Will cause WHOLE display to be redrawn! Use fillRect() to clear only required area if possible!
+            smMenu1 &= ~MENU_REDRAW;    //Clear "redraw" flag - cause line 2 to get redrawn!
+            drawScreen(WIDGETS(homeWidgets));
 
             //Line 1 - Battery //////////////////
-            oled.setTextSize(1);
             oled.fillRect(94, 1, 4, 2, 1); //x, y, w, h
             oled.fillRect(92, 4, 8, 3, 1);
             oled.fillRect(92, 8, 8, 3, 1);
             oled.fillRect(92, 12, 8, 3, 1);
-            oled.setTextCursor(104, 5);
-            //oled.printf("100%%");
+        }
+        // HOME Redraw ////////////////////////////////////////////////////////
+        if ((smMenu1 & MENU_REDRAW) == 0) {
+            smMenu1 |= MENU_REDRAW; //Set "redraw" flag
 
-            // Line 1 ///////////////////////////
+            // Line 2 ///////////////////////////
+            //Clear only second line, and write large text for current mode
+            oled.fillRect(0, 16, oled.width(), 16, 0); //x, y, w, h
             oled.setTextSize(2);
-            oled.setTextCursor(0, 0);
-            if (radioConfig[0].boardType == BOARD_INAIR4)
-                oled.printf("inAir4");
-            else if (radioConfig[0].boardType == BOARD_INAIR9)
-                oled.printf("inAir9");
-            else
-                oled.printf("inAir9B");
-            oled.setTextSize(1);    //Return to default text size
-
-
-            // Line 2 & 5 ///////////////////////
-            oled.setTextCursor(0, 56);  //Line 5
+            oled.setTextCursor(0, 16);  //Second line(16), first column. First line is 0-13 (14x10 chars)
             if (radioData[0].mode == RADIO_MODE_STOPPED) {
-                oled.printf("Mode: Stopped       ");
-                //Write large text to second line
-                oled.setTextSize(2);
-                oled.setTextCursor(0, 16);  //Second line(16), first column. First line is 0-13 (14x10 chars)
                 if(radioData[0].flags.bits.noRadio) {
                     oled.printf("No Radio! ");
                 }
@@ -280,37 +360,15 @@ void mx_menu_task(void) {
                 }
             }
             else if (radioData[0].mode == RADIO_MODE_MASTER) {
-                oled.printf("Mode: Master -> Slv%d", appConfig.remotelAdr);
-                oled.setTextSize(2);        //Write large text to second line
-                oled.setTextCursor(0, 16);  //Second line(16), first column. First line is 0-13 (14x10 chars)
                 oled.printf("Master");
             }
             else if (radioData[0].mode >= RADIO_MODE_SLAVE) {
-                oled.printf("Mode: Slave %d       ", appConfig.localAdr);
-                oled.setTextSize(2);        //Write large text to second line
-                oled.setTextCursor(0, 16);  //Second line(16), first column. First line is 0-13 (14x10 chars)
                 oled.printf("Slave %d", appConfig.localAdr);
             }
             else if (radioData[0].mode >= RADIO_MODE_ERR_FIRST) {
-                oled.printf("Error: Code = %d     ", radioData[0].mode - RADIO_MODE_ERR_FIRST);
-                //Write large text to second line
-                oled.setTextSize(2);
-                oled.setTextCursor(0, 16);  //Second line(16), first column. First line is 0-13 (14x10 chars)
                 oled.printf("Error");
             }
             oled.setTextSize(1);    //Return to default text size
-
-
-            // Line 3 ///////////////////////////
-            fVal = ((float)(radioConfig[0].frequency+100))/1000000.0f; //+100 to correct rounding error
-            oled.setTextCursor(0, 36);
-            oled.printf("F=%d.%d BW=%s SF=%d", (uint)fVal, MxHelpers::get_frac1(fVal),
-                    arrBwChar[radioConfig[0].bw], radioConfig[0].sf);
-
-            // Line 4 ///////////////////////////
-            //Line 4 - For 3 lines, use 36,46,56 (Could also have 4 lines at 33,41,49 and 57)
-            oled.setTextCursor(0, 46);
-            oled.printf("RXed OK=0000 Err=0000");
         }
 
         // HOME Menu /////////////////////////////////////////////////////////
@@ -369,28 +427,15 @@ void mx_menu_task(void) {
             //    break;
             //}
 
-            //Update battery level if it changed
-            if(oldPercentBatt != percentBatt) {
-                oldPercentBatt = percentBatt;
-                oled.setTextCursor(104, 5);
-                oled.printf("%d%%", percentBatt);
-                if (percentBatt<100) oled.putc(' ');  //Add 1 space after '%' if percentage is only 2 digits long
-                if (percentBatt<10)  oled.putc(' ');  //Add 2 spaces after '%' if percentage is only 1 digits long
-            }
+            //Update battery level, radio config, RX counters and mode line if they changed
+            MxTextWidget::updateAll(oled, WIDGETS(homeWidgets));
 
-            //Update Line 2 and 4
+            //Update Line 2
             if((oldRxCntPingPong!=appData.rxCountPingPong) || (oldRxErrCnt!=appData.rxErrCountPingPong)) {
-                //10+((posEq+1)*(DISPLAY_CHAR_WIDTH+1)),              // X - Editable part is after posEq characters (+1 for space between characters)
-
-                // Line 4 ///////////////////////////
-                //Line 4 - For 3 lines, use 36,46,56 (Could also have 4 lines at 33,41,49 and 57)
-                oled.setTextCursor(0, 46);
-                oled.printf("RXed OK=%04d Err=%04d", appData.rxCountPingPong, appData.rxErrCountPingPong);
-
                 // Line 2 ///////////////////////////
                 // Update line 2 for Master and Slave mode if new data received!
                 //Clear second line from x=50. No lines should be shorter(end before 50) than that
-                oled.fillRect(50, 16, (127-50), 16, 0); //x, y, w, h  - NOT REQUIRED, clearDisplay() called above
+                oled.fillRect(50, 16, (127-50), 16, 0); //x, y, w, h
                 oled.setTextSize(2);        //Write large text to second line
                 oled.setTextCursor(0, 16);  //Second line(16), first column. First line is 0-13 (14x10 chars)
                 if (radioData[0].mode == RADIO_MODE_MASTER) {
@@ -440,46 +485,27 @@ void mx_menu_task(void) {
     //Select "Setting" or "Radio Config"
     case MENU1_SELECT:
     {
-        selectMenuRows = 3; // "Select Menu" has 2 rows
-
         // Select Menu - State Entry //////////////////////////////////////////
         if ((smMenu1 & MENU_ENTRY) == 0) {
             smMenu1 |= MENU_ENTRY; //Set "entry" flag
-            oled.clearDisplay();    //Clear display. Will cause WHOLE display to be redrawn! Use fillRect() to clear only required area if possible!
-            //Line 1
-            oled.setTextCursor(0, 2);
-            oled.printf("Select or * To Return");
-
-            //Line 2
-            fVal = ((float)(radioConfig[0].frequency+100))/1000000.0f; //+1 to correct rounding error
-            oled.setTextCursor(10, 16); //x=10, leave space for '>' character
-            oled.printf("Settings");
-
-            //Line 3
-            oled.setTextCursor(10, 27); //x=10, leave space for '>' character
-            oled.printf("Configure Radio");
+            drawScreen(WIDGETS(selectWidgets));
 
-            //Line 4
-            oled.setTextCursor(10, 38);
-            oled.printf("Reset Counters");
-
-            selectMenuCurrRow = 0;
-            blinkOn = true;
-            tmrDisplay = MxTick::read_ms();
+            wSelCursor.setRows(3);  //"Select Menu" has 3 rows
+            tmrDisplay.stop();
         }
         // Select Menu ////////////////////////////////////////////////////////
         else {
             //Select current menu
             if(im4Oled.getOkBtnFalling() != 0) {
-                if(selectMenuCurrRow==0) {
+                if(wSelCursor.getRow()==0) {
                     smMenu1 = MENU1_SETTINGS;
                     smMenu2 = MENU2_SETTINGS_MAIN;
                 }
-                else if(selectMenuCurrRow==1) {
+                else if(wSelCursor.getRow()==1) {
                     smMenu1 = MENU1_CONFIG_RADIO;
                     smMenu2 = MENU2_CFGRADIO_MAIN;
                 }
-                else if(selectMenuCurrRow==2) {
+                else if(wSelCursor.getRow()==2) {
                     smMenu1 = MENU1_RESET_COUNTERS;
                     smMenu2 = 0xff; //Is no second level menu!
                 }
@@ -488,7 +514,7 @@ void mx_menu_task(void) {
             else if(im4Oled.getStarBtnFalling() != 0) {
                 smMenu1 = MENU1_HOME;
             }
-            selectMenuUpdate(selectMenuCurrRow, selectMenuRows, 16, tmrDisplay, blinkOn);
+            selectMenuUpdate(tmrDisplay);
         }
         break;
     } //case MENU1_SELECT:
@@ -499,18 +525,18 @@ void mx_menu_task(void) {
     }
     case MENU1_RESET_COUNTERS:
     {
-        if (MxTick::read_ms() >= tmrDisplay) {
+        if (tmrDisplay.expired()) {
             blinkOn = !blinkOn;
 
             //Line 4
             oled.setTextCursor(0, 38); //x=0, Row 3 = 38
             if(blinkOn) {
                 oled.printf(" OK or * to Cancel!");
-                tmrDisplay = MxTick::read_ms() + 600;
+                tmrDisplay.start_ms(600);
             }
             else {
                 oled.printf("                   ");
-                tmrDisplay = MxTick::read_ms() + 200;
+                tmrDisplay.start_ms(200);
             }
         }
         //OK button = Restore Defaults
@@ -537,46 +563,11 @@ void mx_menu_task(void) {
     if ((smMenu1 & MENU_MASK) == MENU1_SETTINGS) {
 
         //Does "Select Menu" have to be redrawn. Each screen can hold 4 menu items.
-        if( ((smMenu2 & MENU_REDRAW) == 0) || ((selectMenuOldRow/4) != (selectMenuCurrRow/4)) ) {
+        if( ((smMenu2 & MENU_REDRAW) == 0) || ((selectMenuOldRow/4) != (wSelCursor.getRow()/4)) ) {
             smMenu2 |= MENU_REDRAW; //Set "redraw" flag
 
-            //First screen
-            //if((selectMenuCurrRow/4) == 0) {
-            {
-                MX_DEBUG("\r\nDraw Screen1");
-
-                oled.clearDisplay();    //Clear display. Will cause WHOLE display to be redrawn! Use fillRect() to clear only required area if possible!
-                //Line 1
-                oled.setTextCursor(0, 2);
-                oled.printf("Select or * To Return");
-
-                //Line 2
-                oled.setTextCursor(10, 16);  //x=10, leave space for '>' character
-                oled.printf("Disp. Timeout = %03d", appConfig.displayAutoOff);
-
-                //Line 3
-                oled.setTextCursor(10, 27); //x=10, leave space for '>' character
-                oled.printf("Brightness = %d ", appConfig.displayBrigtness);
-
-                //Line 4
-                oled.setTextCursor(10, 38); //x=10, leave space for '>' character
-                oled.printf("Restore Defaults");
-            }
-            //Second Screen
-            /*
-            else if((selectMenuCurrRow/4) == 1) {
-                MX_DEBUG("\r\nDraw Screen2");
-
-                oled.clearDisplay();    //Clear display. Will cause WHOLE display to be redrawn! Use fillRect() to clear only required area if possible!
-                //Line 1
-                oled.setTextCursor(0, 2);
-                oled.printf("Select or * To Return");
-
-                //Line 2
-                oled.setTextCursor(10, 16); //x=10, leave space for '>' character
-                oled.printf("Some text....");
-            }
-            */
+            MX_DEBUG("\r\nDraw Screen1");
+            drawScreen(WIDGETS(settingsWidgets));
         }
 
         switch (smMenu2 & MENU_MASK) {
@@ -585,25 +576,24 @@ void mx_menu_task(void) {
             // Configure Main Screen - State Entry ////////////////////////////
             if ((smMenu2 & MENU_ENTRY) == 0) {
                 smMenu2 |= MENU_ENTRY;      //Set "entry" flag
-                selectMenuRows = 3;         //"Select Menu" has 3 rows.
-                selectMenuCurrRow = 0;
+                wSelCursor.setRows(3);      //"Select Menu" has 3 rows.
                 selectMenuOldRow = 0xff;    //Ensure menu screen gets updated
                 smMenu2 &= ~MENU_REDRAW;    //Clear "redraw" flag - cause display to get redrawn!
-                blinkOn = true;
-                tmrDisplay = MxTick::read_ms();
+                tmrDisplay.stop();
             }
             // Configure Main Screen //////////////////////////////////////////
             else {
                 //Select current menu
                 if(im4Oled.getOkBtnFalling() != 0) {
-                    smMenu2 = MENU2_SETTINGS_DISPLAY_OFF_TIME + selectMenuCurrRow;
+                    smMenu2 = MENU2_SETTINGS_DISPLAY_OFF_TIME + wSelCursor.getRow();
                 }
                 //Return Home
                 else if(im4Oled.getStarBtnFalling() != 0) {
                     smMenu1 = MENU1_SELECT;
                 }
-                selectMenuOldRow = selectMenuCurrRow;
-                selectMenuUpdate(selectMenuCurrRow, selectMenuRows, 16, tmrDisplay, blinkOn);
+                wEditMark.restore(oled);    //Leave '=' of last edited value drawn
+                selectMenuOldRow = wSelCursor.getRow();
+                selectMenuUpdate(tmrDisplay);
             }
             break;
         // Display Off Time ///////////////////////////////////////////////////
@@ -613,7 +603,7 @@ void mx_menu_task(void) {
             //Save and Exit Configuration menu
             if( (im4Oled.getOkBtnFalling()!=0) || (im4Oled.getStarBtnFalling()!=0)) {
                 smMenu2 = MENU2_SETTINGS_MAIN | MENU_ENTRY; //Return to MENU2_SETTINGS_MAIN.
-                saveAppConfig(&appConfig);
+                setAppConfigUnsaved();
                 break;
             }
             //Up button
@@ -637,7 +627,7 @@ void mx_menu_task(void) {
             }
 
             //Toggle '=' sign before editable part of "Select Menu", it is at position 15.
-            selectMenuBlinkEq(15, 1, tmrDisplay, blinkOn);
+            selectMenuBlinkEq(15, 1, tmrDisplay);
             break;
         }
         // Display Brightness /////////////////////////////////////////////////
@@ -645,7 +635,7 @@ void mx_menu_task(void) {
             //Save and Exit Configuration menu
             if( (im4Oled.getOkBtnFalling()!=0) || (im4Oled.getStarBtnFalling()!=0)) {
                 smMenu2 = MENU2_SETTINGS_MAIN | MENU_ENTRY; //Return to MENU2_SETTINGS_MAIN.
-                saveAppConfig(&appConfig);
+                setAppConfigUnsaved();
                 break;
             }
             //Up button
@@ -665,22 +655,22 @@ void mx_menu_task(void) {
             //Check valid value
 
             //Toggle '=' sign before editable part of "Select Menu", it is at position 12.
-            selectMenuBlinkEq(12, 2, tmrDisplay, blinkOn);
+            selectMenuBlinkEq(12, 2, tmrDisplay);
             break;
         // Restore Defaults ///////////////////////////////////////////////////
         case MENU2_SETTINGS_RESTORE_DEFAULTS:
-            if (MxTick::read_ms() >= tmrDisplay) {
+            if (tmrDisplay.expired()) {
                 blinkOn = !blinkOn;
 
                 //Line 4
                 oled.setTextCursor(0, 38); //x=0, Row 3 = 38
                 if(blinkOn) {
                     oled.printf(" OK or * to Cancel!");
-                    tmrDisplay = MxTick::read_ms() + 600;
+                    tmrDisplay.start_ms(600);
                 }
                 else {
                     oled.printf("                   ");
-                    tmrDisplay = MxTick::read_ms() + 200;
+                    tmrDisplay.start_ms(200);
                 }
             }
             //OK button = Restore Defaults
@@ -689,7 +679,7 @@ void mx_menu_task(void) {
                 //Restore defaults
                 appConfig.displayAutoOff = 0;
                 appConfig.displayBrigtness = 2;
-                saveAppConfig(&appConfig);
+                setAppConfigUnsaved();
                 appData.flags.bits.dirtyConf = true;
                 break;
             }
@@ -701,6 +691,9 @@ void mx_menu_task(void) {
             break;
         } //switch (smMenu2 & MENU_MASK)
 
+        //Update values that changed
+        MxTextWidget::updateAll(oled, WIDGETS(settingsWidgets));
+
         if(appData.flags.bits.dirtyConf == true) {
             appData.flags.bits.dirtyConfDisp = true;    //Mark AppData dirty for display
         }
@@ -714,53 +707,17 @@ void mx_menu_task(void) {
     if ((smMenu1 & MENU_MASK) == MENU1_CONFIG_RADIO) {
 
         //Does "Select Menu" have to be redrawn. Each screen can hold 4 menu items.
-        if( ((smMenu2 & MENU_REDRAW) == 0) || ((selectMenuOldRow/4) != (selectMenuCurrRow/4)) ) {
+        if( ((smMenu2 & MENU_REDRAW) == 0) || ((selectMenuOldRow/4) != (wSelCursor.getRow()/4)) ) {
             smMenu2 |= MENU_REDRAW; //Set "redraw" flag
             //First screen
-            if((selectMenuCurrRow/4) == 0) {
-                float fVal;
+            if((wSelCursor.getRow()/4) == 0) {
                 MX_DEBUG("\r\nDraw Screen1");
-
-                oled.clearDisplay();    //Clear display. Will cause WHOLE display to be redrawn! Use fillRect() to clear only required area if possible!
-                //Line 1
-                oled.setTextCursor(0, 2);
-                oled.printf("Select or * To Return");
-
-                //Line 2
-                oled.setTextCursor(10, 16);  //x=10, leave space for '>' character
-                oled.printf("Board = ");
-                if (radioConfig[0].boardType == BOARD_INAIR4)
-                    oled.printf("inAir4 ");
-                else if (radioConfig[0].boardType == BOARD_INAIR9)
-                    oled.printf("inAir9 ");
-                else
-                    oled.printf("inAir9B");
-
-                //Line 3
-                fVal = ((float)(radioConfig[0].frequency+100))/1000000.0f; //+100 to correct rounding error
-                oled.setTextCursor(10, 27); //x=10, leave space for '>' character
-                oled.printf("Freq = %d.%d ", (uint)fVal, MxHelpers::get_frac1(fVal));
-
-                //Line 4
-                oled.setTextCursor(10, 38); //x=10, leave space for '>' character
-                oled.printf("BW = %s  ", arrBwChar[radioConfig[0].bw]);
-
-                //Line 5
-                oled.setTextCursor(10, 49); //x=10, leave space for '>' character
-                oled.printf("SF = %d  ", radioConfig[0].sf);
+                drawScreen(WIDGETS(cfgRadio1Widgets));
             }
             //Second Screen
-            else if((selectMenuCurrRow/4) == 1) {
+            else if((wSelCursor.getRow()/4) == 1) {
                 MX_DEBUG("\r\nDraw Screen2");
-
-                oled.clearDisplay();    //Clear display. Will cause WHOLE display to be redrawn! Use fillRect() to clear only required area if possible!
-                //Line 1
-                oled.setTextCursor(0, 2);
-                oled.printf("Select or * To Return");
-
-                //Line 2
-                oled.setTextCursor(10, 16); //x=10, leave space for '>' character
-                oled.printf("Restore Defaults");
+                drawScreen(WIDGETS(cfgRadio2Widgets));
             }
         }
 
@@ -771,24 +728,23 @@ void mx_menu_task(void) {
             // Configure Main Screen - State Entry ////////////////////////////
             if ((smMenu2 & MENU_ENTRY) == 0) {
                 smMenu2 |= MENU_ENTRY;      //Set "entry" flag
-                selectMenuRows = 5;         //"Select Menu" has 5 rows. First screen has 4, second 1
-                selectMenuCurrRow = 0;
+                wSelCursor.setRows(5);      //"Select Menu" has 5 rows. First screen has 4, second 1
                 selectMenuOldRow = 0xff;    //Ensure menu screen gets updated
-                blinkOn = true;
-                tmrDisplay = MxTick::read_ms();
+                tmrDisplay.stop();
             }
             // Configure Main Screen //////////////////////////////////////////
             else {
                 //Select current menu
                 if(im4Oled.getOkBtnFalling() != 0) {
-                    smMenu2 = MENU2_CFGRADIO_BOARD + selectMenuCurrRow;
+                    smMenu2 = MENU2_CFGRADIO_BOARD + wSelCursor.getRow();
                 }
                 //Return Home
                 else if(im4Oled.getStarBtnFalling() != 0) {
                     smMenu1 = MENU1_SELECT;
                 }
-                selectMenuOldRow = selectMenuCurrRow;
-                selectMenuUpdate(selectMenuCurrRow, selectMenuRows, 16, tmrDisplay, blinkOn);
+                wEditMark.restore(oled);    //Leave '=' of last edited value drawn
+                selectMenuOldRow = wSelCursor.getRow();
+                selectMenuUpdate(tmrDisplay);
             }
             break;
         // Configure Board ////////////////////////////////////////////////
@@ -796,7 +752,7 @@ void mx_menu_task(void) {
             //Save and Exit Configuration menu
             if( (im4Oled.getOkBtnFalling()!=0) || (im4Oled.getStarBtnFalling()!=0)) {
                 smMenu2 = MENU2_CFGRADIO_MAIN | MENU_ENTRY; //Return to MENU2_CFGRADIO_MAIN. Skip MENU_ENTRY!
-                saveRadioConfig(MXCONF_ID_RadioConfig0, &radioConfig[0]);
+                setRadioConfigUnsaved(0);
                 break;
             }
             //Up button
@@ -815,14 +771,14 @@ void mx_menu_task(void) {
             }
 
             //Toggle '=' sign before editable part of "Select Menu", it is at position 7.
-            selectMenuBlinkEq(7, 1, tmrDisplay, blinkOn);
+            selectMenuBlinkEq(7, 1, tmrDisplay);
             break;
         // Configure Frequency ////////////////////////////////////////////////////
         case MENU2_CFGRADIO_FREQ:
             //Save and Exit Configuration menu
             if( (im4Oled.getOkBtnFalling()!=0) || (im4Oled.getStarBtnFalling()!=0)) {
                 smMenu2 = MENU2_CFGRADIO_MAIN | MENU_ENTRY; //Return to MENU2_CFGRADIO_MAIN. Skip MENU_ENTRY!
-                saveRadioConfig(MXCONF_ID_RadioConfig0, &radioConfig[0]);
+                setRadioConfigUnsaved(0);
                 break;
             }
             //Up button
@@ -838,14 +794,14 @@ void mx_menu_task(void) {
             checkFrequency(0);  //Ensure new frequency values are OK
 
             //Toggle '=' sign before editable part of "Select Menu", it is at position 6.
-            selectMenuBlinkEq(6, 2, tmrDisplay, blinkOn);
+            selectMenuBlinkEq(6, 2, tmrDisplay);
             break;
         // Configure BW ///////////////////////////////////////////////////////////
         case MENU2_CFGRADIO_BW:
             //Save and Exit Configuration menu
             if( (im4Oled.getOkBtnFalling()!=0) || (im4Oled.getStarBtnFalling()!=0)) {
                 smMenu2 = MENU2_CFGRADIO_MAIN | MENU_ENTRY; //Return to MENU2_CFGRADIO_MAIN. Skip MENU_ENTRY!
-                saveRadioConfig(MXCONF_ID_RadioConfig0, &radioConfig[0]);
+                setRadioConfigUnsaved(0);
                 break;
             }
             //Up button
@@ -864,14 +820,14 @@ void mx_menu_task(void) {
             }
 
             //Toggle '=' sign before editable part of "Select Menu", it is at position 4.
-            selectMenuBlinkEq(4, 3, tmrDisplay, blinkOn);
+            selectMenuBlinkEq(4, 3, tmrDisplay);
             break;
         // Configure SF ///////////////////////////////////////////////////////////
         case MENU2_CFGRADIO_SF:
             //Save and Exit Configuration menu
             if( (im4Oled.getOkBtnFalling()!=0) || (im4Oled.getStarBtnFalling()!=0)) {
                 smMenu2 = MENU2_CFGRADIO_MAIN | MENU_ENTRY; //Return to MENU2_CFGRADIO_MAIN. Skip MENU_ENTRY!
-                saveRadioConfig(MXCONF_ID_RadioConfig0, &radioConfig[0]);
+                setRadioConfigUnsaved(0);
                 break;
             }
             //Up button
@@ -890,22 +846,22 @@ void mx_menu_task(void) {
             }
 
             //Toggle '=' sign before editable part of "Select Menu", it is at position 7.
-            selectMenuBlinkEq(4, 4, tmrDisplay, blinkOn);
+            selectMenuBlinkEq(4, 4, tmrDisplay);
             break;
         // Restore Defaults ///////////////////////////////////////////////////
         case MENU2_CFGRADIO_RESTORE_DEFAULTS:
-            if (MxTick::read_ms() >= tmrDisplay) {
+            if (tmrDisplay.expired()) {
                 blinkOn = !blinkOn;
 
                 //Line 1
                 oled.setTextCursor(0, 16);  //x=0, Row 1 = 16
                 if(blinkOn) {
                     oled.printf(" OK or * to Cancel!");
-                    tmrDisplay = MxTick::read_ms() + 600;
+                    tmrDisplay.start_ms(600);
                 }
                 else {
                     oled.printf("                   ");
-                    tmrDisplay = MxTick::read_ms() + 200;
+                    tmrDisplay.start_ms(200);
                 }
             }
             //OK button = Restore Defaults
@@ -915,7 +871,7 @@ void mx_menu_task(void) {
                 restoreRadioConfigDefaults(&radioConfig[0]);
                 setRadioMode(radioData[0].mode, 0);
                 radioData[0].flags.bits.dirtyConf = true;
-                saveRadioConfig(MXCONF_ID_RadioConfig0, &radioConfig[0]);
+                setRadioConfigUnsaved(0);
                 break;
             }
             //Start button = return
@@ -926,6 +882,14 @@ void mx_menu_task(void) {
             break;
         } //switch (smMenu2 & MENU_MASK)
 
+        //Update values that changed
+        if((wSelCursor.getRow()/4) == 0) {
+            MxTextWidget::updateAll(oled, WIDGETS(cfgRadio1Widgets));
+        }
+        else {
+            MxTextWidget::updateAll(oled, WIDGETS(cfgRadio2Widgets));
+        }
+
         if(radioData[0].flags.bits.dirtyConf == true) {
             radioData[0].flags.bits.dirtyConfDisp = true;   //Mark RadioData[0] dirty for display
         }
@@ -935,43 +899,36 @@ void mx_menu_task(void) {
 }
 
 /**
- * Update "Select Menu" blinking '>' cursor. Also update "selectMenuCurrRow" and "tmrDisplay".
- * Each "Select Menu" can have 4 rows with options to select.
- *
- * @param selectMenuCurrRow Current row index, a value from 0 to "selectMenuRows-1". Is the row where the '>' char is blinking.
- *        Each screen can have 4 rows, so first screen will be 0-3, second 4-7...
- * @param selectMenuRows Number of rows. Each screen can have 4 rows.
- * @param Y position of first '>' symbol.
+ * Clear display, and draw all widgets of new screen. The display is cleared with fillRect(), so only parts
+ * that actually change are sent to the display.
+ */
+static void drawScreen(MxTextWidget* const* widgets, uint8_t count) {
+    oled.fillRect(0, 0, oled.width(), oled.height(), 0);
+    MxTextWidget::invalidateAll(widgets, count);
+    MxTextWidget::updateAll(oled, widgets, count);
+    wSelCursor.invalidate();
+    wEditMark.invalidate();
+}
+
+/**
+ * Update "Select Menu" blinking '>' cursor. Moves the cursor with the Up and Down buttons, and blinks it with "tmrDisplay".
+ * Each "Select Menu" screen can have 4 rows with options to select, the rows are set with wSelCursor.setRows().
  */
-void selectMenuUpdate(uint8_t& selectMenuCurrRow, uint8_t selectMenuRows, uint8_t yFirstGt, int& tmrDisplay, bool& blinkOn) {
+static void selectMenuUpdate(MxPollTimer& tmrDisplay) {
     //Up
     if(im4Oled.getUpBtnFalling() != 0) {
-        if(selectMenuCurrRow-- == 0) {
-            selectMenuCurrRow = selectMenuRows-1;
-        }
+        wSelCursor.up();
     }
     //Down
     else if(im4Oled.getDownBtnFalling() != 0) {
-        if (++selectMenuCurrRow == selectMenuRows) {
-            selectMenuCurrRow = 0;
-        }
+        wSelCursor.down();
     }
 
-    if (MxTick::read_ms() >= tmrDisplay) {
-        uint8_t rows = selectMenuRows-1;
-        if (rows>3)
-            rows=3;
-        tmrDisplay = MxTick::read_ms() + 250;   //Blink '>' character every 500mS
-        //Clear all '>' characters
-        for(int i=0; i<=rows; i++) {
-            oled.setTextCursor(0, yFirstGt+(i*11));
-            if ((i==(selectMenuCurrRow%4)) && (blinkOn))
-                oled.printf(">");
-            else
-                oled.printf(" ");
-        }
-        blinkOn = !blinkOn;
+    if (tmrDisplay.expired()) {
+        tmrDisplay.start_ms(250);   //Blink '>' character every 500mS
+        wSelCursor.blink();
     }
+    wSelCursor.update(oled);
 }
 
 /**
@@ -979,41 +936,18 @@ void selectMenuUpdate(uint8_t& selectMenuCurrRow, uint8_t selectMenuRows, uint8_
  * @param posEq The character position of the equal sign
  * @param row Current row number, a value from 1 to 4.
  */
-void selectMenuBlinkEq(uint8_t posEq, uint8_t row, int& tmrDisplay, bool& blinkOn) {
-    if (MxTick::read_ms() >= tmrDisplay) {
-        blinkOn = !blinkOn;
-
-        //Get position of '=' sign. Text always start at x=10, so "10+" required.
-        //11 pixels between rows
-        oled.setTextCursor(10+((posEq-1)*(DISPLAY_CHAR_WIDTH+1)), 5+(row*11));
-        oled.putc(blinkOn?'=':' ');
-        tmrDisplay = MxTick::read_ms() + 250;
-
-        // ----- ALTERNATIVE -----
-        //Toggle line under editable part of "Select Menu". First line is at 16.
-        // - Keep "Board = " part = 8 character. Starts at x=10.
-        // - Remove "inAirxB" part = 7 character.
-        /*
-        oled.fillRect(
-                10+((posEq+1)*(DISPLAY_CHAR_WIDTH+1)),              // X - Editable part is after posEq characters (+1 for space between characters)
-                5+DISPLAY_CHAR_HEIGHT+1+(row*11),                   // Y - Get location under editable part. 11 pixels between rows
-                (6*(DISPLAY_CHAR_WIDTH+1)),                         // Width is 6 characters (+1 for space between characters). Add 'width' parameter if using this method!
-                1, blinkOn?1:0);
-        tmrDisplay += blinkOn?200:600;                              //On for 100ms, off for 900ms
-        */
+static void selectMenuBlinkEq(uint8_t posEq, uint8_t row, MxPollTimer& tmrDisplay) {
+    //Get position of '=' sign. Text always start at x=10, so "10+" required.
+    //11 pixels between rows
+    wEditMark.setPos(10+((posEq-1)*(DISPLAY_CHAR_WIDTH+1)), 5+(row*11));
+
+    if (tmrDisplay.expired()) {
+        tmrDisplay.start_ms(250);
+        wEditMark.blink();
     }
+    wEditMark.update(oled);
 }
 
-#ifdef NZ32_ST1L_REV1
-AnalogIn        ainVSense(PB_12);
-#else
-AnalogIn        ainVSense(PC_4);
-#endif
-AnalogIn        ainVBatt(PC_5);
-#if (NZ32S_USE_A13_A14 == 1)
-DigitalInOut    ctrVBatt(PA_13);
-#endif
-
 /** Check frequency is valid. If not, set to valid frequency
  */
 void checkFrequency(uint8_t radioId) {
@@ -1038,57 +972,4 @@ void checkFrequency(uint8_t radioId) {
     }
 }
 
-void updateBattLevel(void) {
-    #define     SIZE_ARR_BATT_ADC   32      //Must be factor of 2 value (4,8,16,32...)
-    //Static variables
-    static uint8_t  arrBattAdcInit = 0;
-    static uint8_t  putArrBattAdc = 0;
-    static uint16_t arrBattAdc[SIZE_ARR_BATT_ADC];
-
-    float           fval = 0;
-    uint32_t        averBattAdc;
-    uint16_t        mvBatt;       //Battery mv value
-    uint16_t        i;
-
-    //Assume voltage decreases linearly from 4.2 to 3.2V
-    //Measure Vbatt. It doesn't seem to make lots of a difference if we disable the DC/DC converter!
-#if (NZ32S_USE_A13_A14 == 1)
-    ctrVBatt = 0;
-    ctrVBatt.output();
-#endif
-    wait_ms(150);
-    arrBattAdc[(putArrBattAdc++) & (SIZE_ARR_BATT_ADC-1)] = ainVBatt.read_u16(); // Converts and read the analog input value
-    //First time, fill whole array with read value (first element just got current value in code above)
-    if (arrBattAdcInit == 0) {
-        arrBattAdcInit = 1;
-        for (i=1; i<SIZE_ARR_BATT_ADC; i++) {
-            arrBattAdc[i] = arrBattAdc[0];
-        }
-    }
-
-    averBattAdc = 0;
-    for (i=0; i<SIZE_ARR_BATT_ADC; i++) {
-        //averBattAdc += arrBattAdc[i];
-        averBattAdc = averBattAdc + arrBattAdc[i];
-    }
-
-    averBattAdc = averBattAdc / SIZE_ARR_BATT_ADC;
-#if (NZ32S_USE_A13_A14 == 1)
-    ctrVBatt.input();
-#endif
-    //fval = ((float)meas / (float)0xffff) * 6600; //6600 = 3300*2, because resistor divider = 2
-    fval = averBattAdc * ((float)6600.0 / (float)65535.0);
-    mvBatt = (uint16_t)fval;
-
-    if (mvBatt < 3200) {
-        percentBatt = 0;
-    }
-    else {
-        percentBatt = (mvBatt - 3200)/10;  //Convert to value from 0 to 1000, then divide by 10 to get 0-100 percentage
-    }
-
-    if (percentBatt > 100)
-        percentBatt = 100; //Not more than 100%
-}
-
 #endif //#if !defined(DISABLE_OLED)
@@ -32,6 +32,11 @@
 
 
 // VARIABLES //////////////////////////////////////////////////////////////////
+extern AppConfig       appConfig;
+extern AppData         appData;
+extern RadioConfig     radioConfig[RADIO_COUNT];
+extern RadioData       radioData[RADIO_COUNT];
+
 const uint8_t   mxconfDescAppConfig[] = MXCONF_DESC_AppConfig;
 const uint8_t   mxconfDescRadioConfig[] = MXCONF_DESC_RadioConfig;
 
@@ -99,146 +104,19 @@ const uint8_t   mxconfDescRadioConfig[] = MXCONF_DESC_RadioConfig;
  *         case, nothing is added to the buffer.
  */
 uint16_t decodeAsciiCmd(uint8_t* pDst, uint16_t destSize, const uint8_t* pSrc, uint8_t escChar) {
-    uint8_t     c;
-    uint8_t     msb=0;
-    uint16_t    dstIdx=0;
-
-    union {
-        struct {
-            unsigned char inSq : 1;             //We are inside a "Quoted String"
-            unsigned char sqFoundInSq : 1;      //Single quote found inside "Quoted String"
-            unsigned char firstHexChar : 1;     //First hex character found
-            unsigned char putEsc : 1;           //Put a backslash character
-            unsigned char notEnoughSpace : 1;   //Not enought space in destination buffer
-        } bits;
-        uint8_t val;
-    } flags;
-    flags.val = 0;
+    AsciiCmdDecoder decoder(escChar);
 
     //Do some checks
     if ((destSize==0)) {
         return 0;
     }
 
-    //Read bytes from source
-    while (1) {
-        //Get next character.
-        c = *pSrc++;
-
-        //End of source string
-        if ((c == 0) || (c==';')) {
-            break;
-        }
-
-        //Process read byte
-        //Previous char was a ' inside a '. Can be escape sequence to put a single quote, or end of "Quoted String"
-        if (flags.bits.sqFoundInSq == true) {
-            //flags2.bits.dqFoundInDq = false;   //Don't clear, is needed below!
-
-            //It was the end of the "Quoted String". Clear flag. c contains next char, will be processed below
-            if (c != '\'') {
-                flags.bits.inSq = false;
-                flags.bits.sqFoundInSq = false;
-            }
-            //else, it was an escape sequence to put a single quote. Will be processed below in if (flags2.bits.dqFoundInDq == true) {}
-        }
-
-        //Second byte of hex character expected
-        if (flags.bits.firstHexChar == true) {
-            flags.bits.firstHexChar = false;
-
-            //Second hex char must be now
-            c = MxHelpers::ascii_hex_nibble_to_byte(c);
-
-            //If both bytes were not hex encoded characters, ERROR!
-            if ((c == 0xff) || (msb == 0xff)) {
-                //DEBUG_PUT_STR(DEBUG_LEVEL_WARNING, "\ncbufPAECStr Hex Err!");
-                return 0; //Nothing added to destination, or removed from source buffers
-            }
-
-            //Get hex number represented by last two hex characters received
-            c = ((msb << 4) | c);
-
-            //c already contains correct character (hex code), will be added to buffer below
-        }
-        //Inside "Quoted String"
-        else if (flags.bits.inSq == true) {
-            //Single quote found inside current "Quoted String". Can be escape sequence to put a single single quote,
-            //or end of "Quoted String"
-            if (c == '\'') {
-                //Previous char was a ' inside a '. This is another ' = an escaped single quote (two '' = single '), leave c as is, will be added to buffer below.
-                if (flags.bits.sqFoundInSq == true) {
-                    flags.bits.sqFoundInSq = false;
-                    //c already contains correct character ('), will be added to buffer below
-                } else {
-                    flags.bits.sqFoundInSq = true;
-                    continue;               //Don't put c, continue!
-                }
-            }
-            //c already contains correct character, will be added to buffer below
-        }
-        //First character of two byte hex code
-        else if ((c <= 'F') && (c >= '0')) {
-            //This is the MSB of a hex code (in 2 character ASCII HEX format)
-            flags.bits.firstHexChar = true;
-            msb = MxHelpers::ascii_hex_nibble_to_byte(c);
-            continue;              //Don't put first byte of hex code, continue!
-        }
-        //Found a single quote
-        else if (c == '\'') {
-            //DEBUG_PUT_STR(DEBUG_LEVEL_INFO, "\n\' Found");
-            flags.bits.inSq = true;
-            continue;               //Don't put ', continue!
-        }
-        //Found a control character (lower case character)
-        else if ((c <= 'z') && (c >= 'a')) {
-            //DEBUG_PUT_STR(DEBUG_LEVEL_INFO, "\nc Found");
-
-            //Control character not supported!
-            if (escChar ==0 ) {
-                continue;
-            }
-
-            flags.bits.putEsc = true; //Cause an "Escape" character to precede the control character
-
-            //We have to write a "escape character" followed by the current "control character" to the TX buffer.
-            //c already contains the "control character", and flags2.bits.putEsc will cause an "escape character" to be put before it.
-        } else {
-            //Invalid char, continue
-            continue;
-        }
-
-        //If it the Escape Character, it must be escaped. Do NOT escape if inside "Single quotes"
-        if ((escChar!=0) && (c==escChar)) {
-            flags.bits.putEsc = true; //Cause an "Escape" character to precede the control character
-        }
-
-        //Must escape character be written to destination?
-        if (flags.bits.putEsc == true) {
-            flags.bits.putEsc = false;
-            pDst[dstIdx++] = escChar;
-            if (dstIdx >= destSize) {
-                flags.bits.notEnoughSpace = true;
-                break;
-            }
-        }
-
-        //Write current char to tx buffer
-        pDst[dstIdx++] = c;
-
-        //If no more place for writing, set error (putAvailable=-1) and break out of loop
-        if (dstIdx >= destSize) {
-            flags.bits.notEnoughSpace = true;
-            break;
-        }
-    }
-
-    //NULL terminate end of destination
-    if(flags.bits.notEnoughSpace) {
-        return 0;
+    //Last byte of destination is not used, it is reserved for a NULL terminator
+    AsciiCmdArraySink sink(pDst, destSize - 1);
+    if (decoder.decode(pSrc, strlen((const char*)pSrc), sink) == false) {
+        return 0;   //Invalid hex character, or not enough space in destination
     }
-
-    return dstIdx;
+    return sink.len;
 }
 
 
@@ -323,3 +201,73 @@ bool saveRadioConfig(uint8_t id, RadioConfig* radioConf) {
             MXCONF_SIZE_RadioConfig,
             (uint8_t*)mxconfDescRadioConfig);
 }
+
+
+/**
+ * Mark AppConfig as changed
+ */
+void setAppConfigUnsaved(void) {
+    appData.flags.bits.unsavedConf = true;
+    appData.tmrConfChanged = MxTick::read_ms();
+}
+
+
+/**
+ * Mark RadioConfig as changed
+ */
+void setRadioConfigUnsaved(uint8_t iRadio) {
+    radioData[iRadio].flags.bits.unsavedConf = true;
+    appData.tmrConfChanged = MxTick::read_ms();
+}
+
+
+/**
+ * Save changed config if no more changes were made for CONFIG_SAVE_DELAY ms. When idle, the spare config log
+ * bank is erased a few words at a time, so compacting the log does not stall the main loop.
+ */
+void saveConfigTask(void) {
+    if (MxTick::elapsed_ms(appData.tmrConfChanged) < CONFIG_SAVE_DELAY) {
+        return;
+    }
+    saveConfigNow();
+    mxconf_erase_spare();
+}
+
+
+/**
+ * Save all changed config now. The "unsaved" flag is only cleared after a structure has been saved, and each
+ * change is committed to EEPROM by the last word written. A reset while saving leaves each value either
+ * unchanged or updated.
+ * @return True if OK, else false
+ */
+bool saveConfigNow(void) {
+    uint8_t iRadio;
+    bool ok = true;
+
+    for(iRadio=0; iRadio < RADIO_COUNT; iRadio++) {
+        if (radioData[iRadio].flags.bits.unsavedConf) {
+            if (saveRadioConfig(MXCONF_ID_RadioConfig0 + iRadio, &radioConfig[iRadio])) {
+                radioData[iRadio].flags.bits.unsavedConf = false;
+            }
+            else {
+                ok = false;
+            }
+        }
+    }
+
+    if (appData.flags.bits.unsavedConf) {
+        if (saveAppConfig(&appConfig)) {
+            appData.flags.bits.unsavedConf = false;
+        }
+        else {
+            ok = false;
+        }
+    }
+
+    //Try again after CONFIG_SAVE_DELAY
+    if (ok == false) {
+        MX_DEBUG("\r\nConfig save ERR!");
+        appData.tmrConfChanged = MxTick::read_ms();
+    }
+    return ok;
+}
@@ -22,6 +22,7 @@
 #define APP_HELPERS_H_
 
 #include "app_defs.h"            //Application defines, must be first include after debugging includes/defines(in main.cpp)
+#include "mx_helpers.h"
 
 /**
  * Restore default values for given RadioConfig structure
@@ -54,7 +55,249 @@ bool loadRadioConfig(uint8_t id, RadioConfig* radioConf);
 bool saveRadioConfig(uint8_t id, RadioConfig* radioConf);
 
 
+/**
+ * Mark AppConfig as changed. It is saved to EEPROM by saveConfigTask() once no more changes are made
+ * for CONFIG_SAVE_DELAY ms, or by saveConfigNow().
+ */
+void setAppConfigUnsaved(void);
+
+/**
+ * Mark RadioConfig of given radio as changed. It is saved to EEPROM by saveConfigTask() once no more
+ * changes are made for CONFIG_SAVE_DELAY ms, or by saveConfigNow().
+ */
+void setRadioConfigUnsaved(uint8_t iRadio);
+
+/**
+ * Save changed config to EEPROM if no more changes were made for CONFIG_SAVE_DELAY ms. Call from main loop.
+ */
+void saveConfigTask(void);
+
+/**
+ * Save all changed config to EEPROM now.
+ * @return True if OK, else false
+ */
+bool saveConfigNow(void);
+
+
 uint16_t decodeAsciiCmd(uint8_t* pDst, uint16_t destSize, const uint8_t* pSrc, uint8_t escChar = 0);
 
 
+/** Sink for AsciiCmdDecoder that only counts decoded bytes. Can be used to check an "Ascii Command" is valid, and
+ * get it's decoded length, before decoding it to the final destination.
+ */
+struct AsciiCmdCounter {
+    bool put(const uint8_t& c) {
+        return true;
+    }
+};
+
+
+/** Sink for AsciiCmdDecoder that writes decoded bytes to an array
+ */
+struct AsciiCmdArraySink {
+    AsciiCmdArraySink(uint8_t* p, uint16_t size) : pDst(p), destSize(size), len(0) {
+    }
+
+    bool put(const uint8_t& c) {
+        if (len >= destSize) {
+            return false;
+        }
+        pDst[len++] = c;
+        return true;
+    }
+
+    uint8_t*    pDst;
+    uint16_t    destSize;
+    uint16_t    len;
+};
+
+
+/**
+ * Incremental decoder for "Ascii Command" strings, see decodeAsciiCmd() for format. The state(quoted string, escape
+ * and first hex character) is kept between calls to decode(), so a string can be decoded in parts. For example
+ * directly from the two spans of a MxCmdBuffer::View, without first copying it to a contiguous buffer.
+ *
+ * Decoded bytes are written to a "Sink", which can be any object with a "bool put(const uint8_t& c)" function that
+ * returns false if full. For example a MxCircularBuffer, AsciiCmdArraySink or AsciiCmdCounter.
+ */
+class AsciiCmdDecoder {
+public:
+    /**
+     * @param escChar If 0, escape processing is NOT used. Else, it gives the escape character.
+     *      Recommended "Escape Character" is '^'
+     */
+    AsciiCmdDecoder(uint8_t escChar = 0) : escChar(escChar) {
+        reset();
+    }
+
+    /** Reset decoder, must be called before decoding a new string
+     */
+    void reset() {
+        flags.val = 0;
+        msb = 0;
+        count = 0;
+    }
+
+    /**
+     * Decode given part of an "Ascii Command" string, and write result to given sink. Decoding stops when a NULL or
+     * ';' character is found, any following calls will not decode anything.
+     *
+     * @param pSrc Source, does not have to be NULL terminated.
+     * @param srcLen Number of characters in source
+     * @param sink Destination for decoded bytes
+     *
+     * @return False if an error occurred(invalid hex character, or sink full), else true
+     */
+    template<typename Sink> bool decode(const uint8_t* pSrc, uint16_t srcLen, Sink& sink) {
+        uint8_t c;
+        uint16_t i = 0;
+        bool putEsc;
+
+        while ((i < srcLen) && (flags.bits.end == false) && (flags.bits.error == false)) {
+            //Fast path for runs of "two character upper case hex" data. Decodes 4 bytes at a time. Not used with
+            //escape processing, decoded bytes equal to escChar have to be escaped.
+            if ((escChar == 0) && (flags.val == 0) && ((srcLen - i) >= 8)) {
+                uint8_t tmp[8];
+                uint16_t n = (srcLen - i) / 2;
+                n = MxHelpers::ascii_hex_to_bytes(&pSrc[i], (n > 8) ? 8 : n, tmp, false);
+                i += n * 2;
+                for (uint16_t j = 0; j < n; j++) {
+                    putByte(sink, tmp[j]);
+                }
+                if (n != 0) {
+                    continue;
+                }
+            }
+
+            //Get next character.
+            c = pSrc[i++];
+            putEsc = false;
+
+            //End of source string
+            if ((c == 0) || (c==';')) {
+                flags.bits.end = true;
+                break;
+            }
+
+            //Previous char was a ' inside a '. Can be escape sequence to put a single quote, or end of "Quoted String"
+            if (flags.bits.sqFoundInSq == true) {
+                //It was the end of the "Quoted String". Clear flag. c contains next char, will be processed below
+                if (c != '\'') {
+                    flags.bits.inSq = false;
+                    flags.bits.sqFoundInSq = false;
+                }
+            }
+
+            //Second byte of hex character expected
+            if (flags.bits.firstHexChar == true) {
+                flags.bits.firstHexChar = false;
+
+                //Second hex char must be now
+                c = MxHelpers::ascii_hex_nibble_to_byte(c);
+
+                //If both bytes were not hex encoded characters, ERROR!
+                if ((c == 0xff) || (msb == 0xff)) {
+                    flags.bits.error = true;
+                    break;
+                }
+
+                //Get hex number represented by last two hex characters received
+                c = ((msb << 4) | c);
+            }
+            //Inside "Quoted String"
+            else if (flags.bits.inSq == true) {
+                //Single quote found inside current "Quoted String". Can be escape sequence to put a single single
+                //quote, or end of "Quoted String"
+                if (c == '\'') {
+                    //Previous char was a ' inside a '. This is another ' = an escaped single quote
+                    if (flags.bits.sqFoundInSq == true) {
+                        flags.bits.sqFoundInSq = false;
+                    } else {
+                        flags.bits.sqFoundInSq = true;
+                        continue;               //Don't put c, continue!
+                    }
+                }
+            }
+            //First character of two byte hex code
+            else if ((c <= 'F') && (c >= '0')) {
+                flags.bits.firstHexChar = true;
+                msb = MxHelpers::ascii_hex_nibble_to_byte(c);
+                continue;              //Don't put first byte of hex code, continue!
+            }
+            //Found a single quote
+            else if (c == '\'') {
+                flags.bits.inSq = true;
+                continue;               //Don't put ', continue!
+            }
+            //Found a control character (lower case character)
+            else if ((c <= 'z') && (c >= 'a')) {
+                //Control character not supported!
+                if (escChar == 0) {
+                    continue;
+                }
+                putEsc = true;  //Cause an "Escape" character to precede the control character
+            } else {
+                //Invalid char, continue
+                continue;
+            }
+
+            //If it the Escape Character, it must be escaped
+            if ((escChar != 0) && (c == escChar)) {
+                putEsc = true;
+            }
+            if (putEsc) {
+                putByte(sink, escChar);
+            }
+            putByte(sink, c);
+        }
+
+        return (flags.bits.error == false);
+    }
+
+    /** Returns true if an error occurred(invalid hex character, or sink full)
+     */
+    bool isError() {
+        return flags.bits.error;
+    }
+
+    /** Returns true if end of string(NULL or ';' character) was found
+     */
+    bool isEnd() {
+        return flags.bits.end;
+    }
+
+    /** Get number of bytes written to sink since last reset()
+     */
+    uint16_t getCount() {
+        return count;
+    }
+
+private:
+    template<typename Sink> void putByte(Sink& sink, uint8_t c) {
+        if (flags.bits.error) {
+            return;
+        }
+        if (sink.put(c) == false) {
+            flags.bits.error = true;    //Not enough space in destination
+            return;
+        }
+        count++;
+    }
+
+    union {
+        struct {
+            unsigned char inSq : 1;             //We are inside a "Quoted String"
+            unsigned char sqFoundInSq : 1;      //Single quote found inside "Quoted String"
+            unsigned char firstHexChar : 1;     //First hex character found
+            unsigned char end : 1;              //End of string found
+            unsigned char error : 1;            //Invalid hex character, or not enough space in destination
+        } bits;
+        uint8_t val;
+    } flags;
+    uint8_t     escChar;
+    uint8_t     msb;
+    uint16_t    count;
+};
+
+
 #endif /* APP_HELPERS_H_ */
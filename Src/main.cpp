@@ -72,11 +72,35 @@ const uint8_t   pongMsg[] = "pOnG";
     int tmrSecLastTxRx = 0;     //Timer value since last Radio transmit or receive
 #endif
 
+//Metrics of all radios, read with "mtr" USB command
+static MxCounter    mtrTx("tx");                //Transmissions done
+static MxCounter    mtrTxTimeout("txtimeout");  //Transmission timeouts
+static MxCounter    mtrRx("rx");                //Valid receptions
+static MxCounter    mtrRxTimeout("rxtimeout");  //Reception timeouts
+static MxCounter    mtrRxErr("rxerr");          //Reception CRC errors
+static MxCounter    mtrRxLost("rxlost");        //Received messages lost, previous message not processed yet
+static MxHistogram  mtrRxLen("rxlen");          //Received message length
+static MxHistogram  mtrRxRssi("rxrssi");        //Negative RSSI of received messages
+static MxCounter    mtrI2cErr("i2cerr");        //I2C bus errors
+static MxGauge      mtrBattMv("battmv");        //Battery voltage in mV
+
+#if (INAIR_ENABLE_WARM_START==1)
+//GPIO configuration saved before going to sleep, see saveGpioConfig()
+static GPIO_TypeDef* const gpioPorts[] = {GPIOA, GPIOB, GPIOC, GPIOD, GPIOH};
+static struct {
+    uint32_t    moder;
+    uint32_t    otyper;
+    uint32_t    ospeedr;
+    uint32_t    pupdr;
+    uint32_t    afr[2];
+} gpioSaved[sizeof(gpioPorts) / sizeof(gpioPorts[0])];
+#endif
+
 
 // External GLOBAL VARIABLES //////////////////////////////////////////////////
 #if ((MX_ENABLE_USB==1))
-extern MxCmdBuffer <RX_BUF_USB_SIZE, RX_BUF_USB_COMMANDS, RX_BUF_USB_COUNTERTYPE> rxBufUsb;
-extern MxCmdBuffer <TX_BUF_USB_SIZE, TX_BUF_USB_COMMANDS, TX_BUF_USB_COUNTERTYPE> txBufUsb;
+extern MxCmdBuffer <RX_BUF_USB_SIZE, RX_BUF_USB_COMMANDS> rxBufUsb;
+extern MxCmdBuffer <TX_BUF_USB_SIZE, TX_BUF_USB_COMMANDS> txBufUsb;
 #endif
 
 
@@ -92,10 +116,44 @@ void processRxDataUSB(uint8_t iRadio);
 #endif
 
 
+#if (INAIR_ENABLE_WARM_START==1)
+/**
+ * Save configuration of all GPIO ports, before they are put in analog mode for sleeping
+ */
+void saveGpioConfig(void) {
+    uint8_t i;
+
+    for(i=0; i < (sizeof(gpioPorts) / sizeof(gpioPorts[0])); i++) {
+        gpioSaved[i].moder = gpioPorts[i]->MODER;
+        gpioSaved[i].otyper = gpioPorts[i]->OTYPER;
+        gpioSaved[i].ospeedr = gpioPorts[i]->OSPEEDR;
+        gpioSaved[i].pupdr = gpioPorts[i]->PUPDR;
+        gpioSaved[i].afr[0] = gpioPorts[i]->AFR[0];
+        gpioSaved[i].afr[1] = gpioPorts[i]->AFR[1];
+    }
+}
+
+/**
+ * Restore configuration of all GPIO ports saved by saveGpioConfig(). Output values are kept in STOP mode.
+ */
+void restoreGpioConfig(void) {
+    uint8_t i;
+
+    for(i=0; i < (sizeof(gpioPorts) / sizeof(gpioPorts[0])); i++) {
+        gpioPorts[i]->AFR[0] = gpioSaved[i].afr[0];
+        gpioPorts[i]->AFR[1] = gpioSaved[i].afr[1];
+        gpioPorts[i]->OTYPER = gpioSaved[i].otyper;
+        gpioPorts[i]->OSPEEDR = gpioSaved[i].ospeedr;
+        gpioPorts[i]->PUPDR = gpioSaved[i].pupdr;
+        gpioPorts[i]->MODER = gpioSaved[i].moder;
+    }
+}
+#endif
+
 void pwrIntISR() {
     if(pwrIntEn) {
         //Debounce 500ms
-        if (mxTick.read_ms() >= tmrPwrInt) {
+        if (mxTick.expired_ms(tmrPwrInt)) {
             tmrPwrInt += 1000;
             if (goToSleep == false) {
                 goToSleep = true;
@@ -111,7 +169,6 @@ void pwrIntISR() {
 /** Main function */
 int main() {
     uint8_t iRadio;
-    volatile uint8_t dummy;
 #if !defined(DISABLE_OLED)
     int tmrMenu = 0;
 #endif
@@ -141,6 +198,10 @@ int main() {
 
     NZ32S::enable_fast_charging();  //Enable fast charging
 
+    #if (NZ32S_USE_PROFILER==1)
+    MxProfile::init();
+    #endif
+
     #if defined(HAS_WATCHDOG)
     if (NZ32S::watchdog_caused_reset(true)) {
         MX_DEBUG("\r\nWatchdog Reset!");
@@ -211,13 +272,25 @@ int main() {
 
             mx_display_on_off(0);
 
+            saveConfigNow();    //Save changed config, system is reset when woken up
+
             //Put all radios to sleep
             for(iRadio=0; iRadio < RADIO_COUNT; iRadio++) {
                 pRadios[iRadio]->Sleep();
+                #if (INAIR_ENABLE_WARM_START==1)
+                //Save radio registers, are restored with WarmStart() after we wake up
+                if (radioData[iRadio].flags.bits.initialized) {
+                    pRadios[iRadio]->SaveRegisterImage();
+                }
+                #endif
             }
 
             wait_ms(200);
 
+            #if (INAIR_ENABLE_WARM_START==1)
+            saveGpioConfig();
+            #endif
+
             {
                 GPIO_InitTypeDef GPIO_InitStructure;
 
@@ -269,15 +342,33 @@ int main() {
             deepsleep();
         #endif
 
+        #if (INAIR_ENABLE_WARM_START==1)
+            //After we wake up, continue without resetting system. Radios restore their registers with a warm start,
+            //instead of being created and configured again. They can be used once InitTask() returns true.
+            restoreGpioConfig();
+            for(iRadio=0; iRadio < RADIO_COUNT; iRadio++) {
+                if (radioData[iRadio].flags.bits.initialized) {
+                    if (pRadios[iRadio]->WarmStart() == false) {
+                        radioData[iRadio].flags.bits.initialized = false;
+                    }
+                    radioData[iRadio].smRadio = IDLE;
+                }
+            }
+            mx_display_on_off(1);
+            tmrPwrInt = mxTick.read_ms() + 1000;    //Ignore button press that woke us up
+            goToSleep = false;
+            continue;
+        #else
             //After we wake up, reset system
             NVIC_SystemReset();
+        #endif
         }
 
 #if !defined(DISABLE_RESET_RADIO_USB_TIMERS)
         //Watchdog timer refresh with following conditions:
         // - A Radio reception or transmission occurred less than RESET_TIMEOUT_RADIO seconds ago
         // - A USB Command was processed less than RESET_TIMEOUT_USB_CMD seconds ago
-        if ( ((mxTick.read_sec()-tmrSecLastTxRx) < RESET_TIMEOUT_RADIO) && ((mxTick.read_sec()-tmrSecLastUsbCmd) < RESET_TIMEOUT_USB_CMD))
+        if ( (mxTick.elapsed_sec(tmrSecLastTxRx) < RESET_TIMEOUT_RADIO) && (mxTick.elapsed_sec(tmrSecLastUsbCmd) < RESET_TIMEOUT_USB_CMD))
         {
             #if defined(HAS_WATCHDOG)
             NZ32S::watchdog_refresh();
@@ -298,6 +389,7 @@ int main() {
         //Try to fix any I2C error
         if (i2cBus1OK == false) {
             i2cBus1OK = true;
+            mtrI2cErr.inc();
             NZ32S::i2c_reset(1, PB_9, PB_8);
             wait_ms(2);
             i2cBus1.frequency(I2C1_SPEED);  //Set bus speed
@@ -307,7 +399,7 @@ int main() {
 
         //Service menu every 10mS
         #if !defined(DISABLE_OLED)
-        if (mxTick.read_ms() >= tmrMenu) {
+        if (mxTick.expired_ms(tmrMenu)) {
             tmrMenu += 10; //Every 10mS
             mx_menu_task();  //OLED Display and menu task
         }
@@ -325,12 +417,18 @@ int main() {
             #endif
         }
 
+        //Save changed config to EEPROM once no more changes are made
+        saveConfigTask();
+
+        NZ32S::batt_task();     //Measure battery in background
+        mtrBattMv.set(NZ32S::get_batt_mv());
+
         blinkLED(false); //Blink system LED
 
         //If Master, send PING message
         if (radioData[0].mode == RADIO_MODE_MASTER) {
 
-            if (mxTick.read_ms() >= tmrSendPing) {
+            if (mxTick.expired_ms(tmrSendPing)) {
                 tmrSendPing = mxTick.read_ms() + PING_PERIOD_MS;
 
                 //Check if PONG reply was received for previous PING we sent?
@@ -367,6 +465,11 @@ int main() {
                 radioData[iRadio].flags.bits.initialized = true;
             }
 
+            //Radio not ready yet after a warm start
+            if (pRadios[iRadio]->InitTask() == false) {
+                continue;
+            }
+
             //Low level radio Task
             pRadios[iRadio]->task();
 
@@ -425,9 +528,12 @@ void OnRxDone(uint8_t radioID, uint8_t *payload, uint16_t size, int16_t rssi, in
         radioData[radioID].smRadio = RX_DONE;
         memcpy(&radioData[radioID].rxBuf[0], payload, size);
         radioData[radioID].rxLen = size;
+        mtrRxLen.add(size);
+        mtrRxRssi.add((rssi < 0) ? -rssi : 0);
     }
     else {
         radioData[radioID].flags.bits.rxMsgLost = 1;
+        mtrRxLost.inc();
     }
 }
 
@@ -465,32 +571,550 @@ void OnRxError(uint8_t radioID) {
 }
 
 #if ((MX_ENABLE_USB==1))
+#define MX_NAME_LEN    32
+#define MX_VALUE_LEN   32
+
+enum CMD_RESPONCE {
+    CMD_RESPONCE_UNKNOWN = 0,
+    CMD_RESPONCE_OK,
+    CMD_RESPONCE_NONE,
+    CMD_RESPONCE_ERROR      //Valid command, but it failed
+};
+
+/** USB command passed to command handlers
+ */
+struct UsbCmd {
+    const uint8_t*  value;              //'value' part of "name=value" commands, NULL terminated. Empty for valueView handlers
+    uint16_t        valueLen;           //Length of 'value' part, 0 for valueView handlers
+    uint8_t         radio;              //Transceiver to use. Is trailing digit of 'name', else current transceiver
+    uint8_t         trailingNameDig;    //If a trailing digit was removed from 'name', this gives it's value. Else, 0xff.
+};
+
+/** USB command handler. Returns a CMD_RESPONCE_xx value
+ */
+typedef uint8_t (*UsbCmdHandler)(const UsbCmd& cmd);
+
+/** Entry of USB command dispatch table
+ */
+struct UsbCmdEntry {
+    const char*     name;       //Name of command, excluding trailing transceiver digit
+    UsbCmdHandler   handler;
+    bool            valueView;  //Handler reads 'value' with rxBufUsb.getCommandValueView(), is not copied to UsbCmd.value
+};
+
+
+/**
+ * t=asciiCmd - Transmit Packet. The 'value' is decoded directly from rxBufUsb to the radio TX buffer, so is not
+ * limited to MX_VALUE_LEN.
+ */
+static uint8_t usbCmdTransmit(const UsbCmd& cmd) {
+    MxCmdBuffer <RX_BUF_USB_SIZE, RX_BUF_USB_COMMANDS>::View value = rxBufUsb.getCommandValueView();
+    MxCircularBuffer<uint8_t, RADIO_TXBUF_SIZE>* pTxBuf = &radioData[cmd.radio].txBuf;
+    AsciiCmdDecoder decoder;
+    AsciiCmdCounter counter;
+
+    //Check value is valid, and get decoded length. Value can wrap around end of rxBufUsb, decode both parts.
+    decoder.decode(value.p1, value.len1, counter);
+    decoder.decode(value.p2, value.len2, counter);
+    if (decoder.isError() || (decoder.getCount() > pTxBuf->getFree())) {
+        MX_DEBUG_INFO("\r\nTx decode ERR!");
+        return CMD_RESPONCE_ERROR;
+    }
+
+    //Decode value to radio TX buffer
+    decoder.reset();
+    decoder.decode(value.p1, value.len1, *pTxBuf);
+    decoder.decode(value.p2, value.len2, *pTxBuf);
+    //radioData[cmd.radio].tmrRadio = timerMain.read_ms() + 10;    //Delay sending for 10ms
+    return CMD_RESPONCE_NONE;   //This command already send a "rn=.." reply
+}
+
 /**
- * Process any USB Commands
+ * tv=n - Set current transceiver
+ */
+static uint8_t usbCmdSetTransceiver(const UsbCmd& cmd) {
+    if((cmd.value[0]<RADIO_COUNT_CHAR) && (cmd.value[0]>='0')) {
+        //Set new current transceiver radio
+        currRadio = cmd.value[0]-'0';
+        MX_DEBUG_INFO("\r\nTrcvr=%d", currRadio);
+        return CMD_RESPONCE_OK;
+    }
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * tm=n - Set "transmit mode"
+ */
+static uint8_t usbCmdTxMode(const UsbCmd& cmd) {
+    if((cmd.value[0]>='0') && (cmd.value[0]<='1')) {
+        MX_DEBUG_INFO("\r\nTx mode=%d", cmd.value[0]-'0');
+        if (radioConfig[cmd.radio].txMode != cmd.value[0]-'0') {
+            radioConfig[cmd.radio].txMode = cmd.value[0]-'0';
+            radioData[cmd.radio].flags.bits.dirtyConf = true;
+        }
+        return CMD_RESPONCE_OK;
+    }
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * tpw=v - Set "transmit power"
+ */
+static uint8_t usbCmdTxPower(const UsbCmd& cmd) {
+    uint8_t newVal;
+    newVal = atoi((const char*)cmd.value);
+    if (newVal <= 20) {
+        MX_DEBUG_INFO("\r\nTX Pwr=%d", newVal);
+        if (radioConfig[cmd.radio].power != newVal) {
+            radioConfig[cmd.radio].power = newVal;
+            radioData[cmd.radio].flags.bits.dirtyConf = true;
+        }
+        return CMD_RESPONCE_OK;
+    }
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * rm=n - Set "receive mode"
+ */
+static uint8_t usbCmdRxMode(const UsbCmd& cmd) {
+    int val;
+    val = cmd.value[0]-'0';
+    if((val >= 0) && (val <= 2)) {
+        MX_DEBUG_INFO("\r\nRx mode=%d", val);
+        if (radioConfig[cmd.radio].rxMode != val) {
+            radioConfig[cmd.radio].rxMode = val;
+            radioData[cmd.radio].flags.bits.dirtyConf = true;
+        }
+        return CMD_RESPONCE_OK;
+    }
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * rto=n - Set "receive timeout" in milli seconds
+ */
+static uint8_t usbCmdRxTimeout(const UsbCmd& cmd) {
+    uint32_t val;
+    val = atoi((const char *)cmd.value);
+    //Valid value from 0 to 10,000
+    if (val <= 10000) {
+        MX_DEBUG_INFO("\r\nRx TO=%d ms", val);
+        val = val * 1000;
+        if (radioConfig[cmd.radio].rxTimeout != val) {
+            radioConfig[cmd.radio].rxTimeout = val;
+            radioData[cmd.radio].flags.bits.dirtyConf = true;
+        }
+        return CMD_RESPONCE_OK;
+    }
+    MX_DEBUG_INFO("\r\nRx TO ERR!");
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * rsym=n - Set "receive symbol" value
+ */
+static uint8_t usbCmdRxSymbolTimeout(const UsbCmd& cmd) {
+    uint32_t val;
+    val = atoi((const char *)cmd.value);
+    //Valid value from 4 to 1023
+    if ((val >= 4) && (val <= 1023)) {
+        MX_DEBUG_INFO("\r\nRxSymTO=%d", val);
+        if (radioConfig[cmd.radio].symbolTimeout != val) {
+            radioConfig[cmd.radio].symbolTimeout = val;
+            radioData[cmd.radio].flags.bits.dirtyConf = true;
+        }
+        return CMD_RESPONCE_OK;
+    }
+    MX_DEBUG_INFO("\r\nRxSymTO ERR!");
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * bw=x - Set bandwidth
+ */
+static uint8_t usbCmdBandwidth(const UsbCmd& cmd) {
+    if ((cmd.valueLen==1) && (cmd.value[0]>='6') && (cmd.value[0]<='9')) {
+        MX_DEBUG_INFO("\r\nBW=%d", cmd.value[0] - '0');
+        if (radioConfig[cmd.radio].bw != cmd.value[0]-'0') {
+            radioConfig[cmd.radio].bw = cmd.value[0]-'0';
+            radioData[cmd.radio].flags.bits.dirtyConf = true;
+        }
+        return CMD_RESPONCE_OK;
+    }
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * crc=x - Enable or disable CRC
+ */
+static uint8_t usbCmdCrc(const UsbCmd& cmd) {
+    bool newVal;
+    newVal = cmd.value[0]=='0'?false:true;
+    MX_DEBUG_INFO("\r\nCRC=%d", newVal);
+    if (radioConfig[cmd.radio].conf.lora.crcEnable != newVal) {
+        radioConfig[cmd.radio].conf.lora.crcEnable = newVal;
+        radioData[cmd.radio].flags.bits.dirtyConf = true;
+    }
+    return CMD_RESPONCE_OK;
+}
+
+/**
+ * pr=l - Set "preamble length" in symbols
+ */
+static uint8_t usbCmdPreamble(const UsbCmd& cmd) {
+    uint32_t val;
+    val = atoi((const char *)cmd.value);
+    if ((val >= 4) && (val <= 1000)) {
+        MX_DEBUG_INFO("\r\nPre=%d", val);
+        if (radioConfig[cmd.radio].preambleLength != val) {
+            radioConfig[cmd.radio].preambleLength = val;
+            radioData[cmd.radio].flags.bits.dirtyConf = true;
+        }
+        return CMD_RESPONCE_OK;
+    }
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * sf=x - Set spreading factor
+ */
+static uint8_t usbCmdSpreadingFactor(const UsbCmd& cmd) {
+    uint32_t val;
+    val = atoi((const char *)cmd.value);
+    if ((val >= 7) && (val <= 12)) {
+        MX_DEBUG_INFO("\r\nSF=%d", val);
+        if (radioConfig[cmd.radio].sf != val) {
+            radioConfig[cmd.radio].sf = val;
+            radioData[cmd.radio].flags.bits.dirtyConf = true;
+        }
+        return CMD_RESPONCE_OK;
+    }
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * f=x - Set frequency
+ */
+static uint8_t usbCmdFrequency(const UsbCmd& cmd) {
+    uint32_t val;
+    val = atoi((const char *)cmd.value);
+    //Support short format giving MHz/10. For example, 916.7MHz = 9167
+    if (cmd.valueLen==4) {
+        val = val * 100000;
+    }
+    if ((val >= 400000000) && (val <= 950000000)) {
+        MX_DEBUG_INFO("\r\nF=%d", val);
+        if (radioConfig[cmd.radio].frequency != val) {
+            radioConfig[cmd.radio].frequency = val;
+            radioData[cmd.radio].flags.bits.dirtyConf = true;
+        }
+        return CMD_RESPONCE_OK;
+    }
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+/**
+ * rs - Request RSSI value of last reception
+ */
+static uint8_t usbCmdRssi(const UsbCmd& cmd) {
+    uint8_t buf[16];
+    int len = 0;
+    buf[0] = 'r';
+    buf[1] = 's';
+    buf[2] = '0' + cmd.radio;
+    buf[3] = '=';
+    len = MxHelpers::cvt_int16_to_ascii_str(radioData[cmd.radio].RssiValue, &buf[4]);
+    buf[4+len] = ';';
+    txBufUsb.putArray(buf, len+5);
+
+    #if (DEBUG_ENABLE_MAIN==1)
+    buf[5+len] = 0;
+    MX_DEBUG_INFO("\r\n%s(%d)", buf, radioData[cmd.radio].RssiValue);
+    #endif
+    return CMD_RESPONCE_NONE;   //This command already send a reply
+}
+
+/**
+ * rx - Put ratio in receive mode
+ */
+static uint8_t usbCmdReceive(const UsbCmd& cmd) {
+    InAir* pRadio           = pRadios[cmd.radio];
+    RadioData* pRadioData   = &radioData[cmd.radio];
+    MX_DEBUG_INFO("\r\nRx%d", cmd.radio);
+    if (pRadio!=NULL) {
+        pRadioData->smRadio = IDLE;
+        pRadio->Rx(radioConfig[cmd.radio].rxTimeout);    //Continues reception mode
+    }
+    else {
+        MX_DEBUG_INFO(" - NULL!!");
+    }
+    return CMD_RESPONCE_NONE;   //This command already send a reply
+}
+
+/**
+ * rst - Reset
+ */
+static uint8_t usbCmdReset(const UsbCmd& cmd) {
+    saveConfigNow();
+    MX_DEBUG("\r\nResetting!");
+    wait(1);
+    NVIC_SystemReset();
+    return CMD_RESPONCE_OK;
+}
+
+/**
+ * run - Run command
+ */
+static uint8_t usbCmdRun(const UsbCmd& cmd) {
+    MX_DEBUG_INFO("\r\nRun");
+    return CMD_RESPONCE_OK;
+}
+
+/**
+ * save - Save changed config to EEPROM now. Replies with "er;" if EEPROM could not be written.
+ */
+static uint8_t usbCmdSave(const UsbCmd& cmd) {
+    MX_DEBUG_INFO("\r\nSave");
+    return saveConfigNow() ? CMD_RESPONCE_OK : CMD_RESPONCE_ERROR;
+}
+
+#if (NZ32S_USE_METRICS==1) || (NZ32S_USE_PROFILER==1)
+/**
+ * Add given reply to txBufUsb. If there is not enough space, or no free command entry, waits until USB task has
+ * sent enough data. If the host does not read the data within USB_TX_WAIT_TIMEOUT ms, the reply is dropped.
+ * @return True if reply added, else false
+ */
+static bool putTxBufUsbWait(const char* buf, uint16_t len) {
+    int tmr = mxTick.read_ms();
+
+    while((txBufUsb.getFree() < len) || (txBufUsb.getCommandsAvailable() >= TX_BUF_USB_COMMANDS)) {
+        if (mxTick.elapsed_ms(tmr) >= USB_TX_WAIT_TIMEOUT) {
+            MX_DEBUG("\r\nUSB TX timeout, reply dropped!");
+            return false;
+        }
+        mx_usbcdc_task();
+    }
+    txBufUsb.putArray((const uint8_t*)buf, len);
+    return true;
+}
+#endif
+
+#if (NZ32S_USE_METRICS==1)
+/**
+ * Send all metrics. First reply is "mtr=seq,ms;", followed by "mtr<name>=value;" for each metric.
+ *
+ * @param reset If true, counters and histograms are reset after being sent
+ */
+static uint8_t sendMetrics(bool reset) {
+    char buf[128];
+    uint16_t len;
+    MxMetric* m;
+    MX_DEBUG_INFO("\r\nMetrics");
+
+    len = MxMetrics::header(buf, sizeof(buf), reset);
+    if (putTxBufUsbWait(buf, len) == false) {
+        return CMD_RESPONCE_NONE;
+    }
+    for (m = MxMetrics::first(); m != NULL; m = m->getNext()) {
+        len = MxMetrics::snapshot(m, buf, sizeof(buf), reset);
+        if (putTxBufUsbWait(buf, len) == false) {
+            break;  //Host not reading, drop rest of reply
+        }
+    }
+    return CMD_RESPONCE_NONE;   //This command already send a reply
+}
+
+/**
+ * mtr - Request all metrics.
+ */
+static uint8_t usbCmdMetrics(const UsbCmd& cmd) {
+    return sendMetrics(cmd.trailingNameDig==1);
+}
+
+/**
+ * mtr1 - Same as "mtr", but also resets counters and histograms. Use for periodic polling, each reply then contains
+ * the events since the previous poll. Has it's own dispatch table entry, because a trailing digit is only removed
+ * from 'name' if it is a transceiver number.
+ */
+static uint8_t usbCmdMetricsReset(const UsbCmd& cmd) {
+    return sendMetrics(true);
+}
+#endif
+
+#if (NZ32S_USE_PROFILER==1)
+/**
+ * Send profiler statistics, for example "prfradio=120,1850,40210,2214;" = count,min,max,mean cycles.
+ *
+ * @param reset If true, statistics are reset after being sent
+ */
+static uint8_t sendProfile(bool reset) {
+    char buf[64];
+    uint16_t len;
+    uint8_t region;
+    MX_DEBUG_INFO("\r\nProfile");
+
+    for(region=0; region < MX_PROF_COUNT; region++) {
+        len = MxProfile::dump(region, buf, sizeof(buf));
+        if (putTxBufUsbWait(buf, len) == false) {
+            break;  //Host not reading, drop rest of reply
+        }
+    }
+    if(reset) {
+        MxProfile::reset();
+    }
+    return CMD_RESPONCE_NONE;   //This command already send a reply
+}
+
+/**
+ * prof - Request profiler statistics
+ */
+static uint8_t usbCmdProfile(const UsbCmd& cmd) {
+    return sendProfile(cmd.trailingNameDig==1);
+}
+
+/**
+ * prof1 - Same as "prof", but also resets statistics after sending them
+ */
+static uint8_t usbCmdProfileReset(const UsbCmd& cmd) {
+    return sendProfile(true);
+}
+#endif
+
+/**
+ * tvs - Request Status of all Transceiver
+ */
+static uint8_t usbCmdTransceiverStatus(const UsbCmd& cmd) {
+    uint8_t iRadio;
+    MX_DEBUG_INFO("\r\nTcvr Stat");
+
+    for(iRadio=0; iRadio < RADIO_COUNT; iRadio++) {
+        txBufUsb.put("tvs");
+        txBufUsb.put('0' + iRadio);
+        if (pRadios[iRadio]!=0) {
+            txBufUsb.put("=1;");
+        }
+        else {
+            txBufUsb.put("=0;");
+        }
+    }
+    return CMD_RESPONCE_NONE;   //This command already send a reply
+}
+
+/**
+ * testn - Test commands
+ */
+static uint8_t usbCmdTest(const UsbCmd& cmd) {
+    //test1 - Virtual com port speed test
+    if(cmd.trailingNameDig==1) {
+        uint8_t tempBuf[16];
+        MX_DEBUG_INFO("\r\nTest1");
+        strcpy((char*)tempBuf, "012345678;");
+        for (int i = 0; i<10; i++) {
+        //for (int i = 0; i<1000; i++) {
+            while(txBufUsb.getFree() < 12) {
+                mx_usbcdc_task();
+            }
+            txBufUsb.putArray(tempBuf, 10);
+            mx_usbcdc_task();
+        }
+        return CMD_RESPONCE_NONE;   //This command already send a reply
+    }
+    //test2 - Test watchdog timer
+    else if(cmd.trailingNameDig==2) {
+        while(1){};
+    }
+    return CMD_RESPONCE_UNKNOWN;
+}
+
+
+//Dispatch table for "name=value" commands. MUST be sorted alphabetically(strcmp order), is searched with a binary search!
+static const UsbCmdEntry usbNameValueCmds[] = {
+    {"bw",      usbCmdBandwidth},
+    {"crc",     usbCmdCrc},
+    {"f",       usbCmdFrequency},
+    {"pr",      usbCmdPreamble},
+    {"rm",      usbCmdRxMode},
+    {"rsym",    usbCmdRxSymbolTimeout},
+    {"rto",     usbCmdRxTimeout},
+    {"sf",      usbCmdSpreadingFactor},
+    {"t",       usbCmdTransmit,     true},
+    {"tm",      usbCmdTxMode},
+    {"tpw",     usbCmdTxPower},
+    {"tv",      usbCmdSetTransceiver},
+};
+
+//Dispatch table for commands without a 'value' part. MUST be sorted alphabetically(strcmp order)!
+static const UsbCmdEntry usbCmds[] = {
+#if (NZ32S_USE_METRICS==1)
+    {"mtr",     usbCmdMetrics},
+    {"mtr1",    usbCmdMetricsReset},
+#endif
+#if (NZ32S_USE_PROFILER==1)
+    {"prof",    usbCmdProfile},
+    {"prof1",   usbCmdProfileReset},
+#endif
+    {"rs",      usbCmdRssi},
+    {"rst",     usbCmdReset},
+    {"run",     usbCmdRun},
+    {"rx",      usbCmdReceive},
+    {"save",    usbCmdSave},
+    {"test",    usbCmdTest},
+    {"tvs",     usbCmdTransceiverStatus},
+};
+
+
+/**
+ * Find given command in given dispatch table
+ *
+ * @param table Dispatch table, must be sorted alphabetically
+ * @param count Number of entries in table
+ * @param name NULL terminated name of command to find
+ *
+ * @return Entry of given command, or NULL if not found
+ */
+static const UsbCmdEntry* findUsbCmd(const UsbCmdEntry* table, uint8_t count, const char* name) {
+    uint8_t lo = 0;
+    uint8_t hi = count;
+    uint8_t mid;
+    int cmp;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        cmp = strcmp(name, table[mid].name);
+        if (cmp == 0) {
+            return &table[mid];
+        }
+        if (cmp < 0) {
+            hi = mid;
+        }
+        else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+#endif  //#if ((MX_ENABLE_USB==1))
+
+
+#if ((MX_ENABLE_USB==1))
+/**
+ * Process any USB Commands. Commands are looked up in the usbNameValueCmds[] and usbCmds[] dispatch tables.
  */
 void processUsbCmds() {
-    #define MX_NAME_LEN    32
-    #define MX_VALUE_LEN   32
-    #define MX_BIN_LEN     32
     uint8_t     nameBuf[MX_NAME_LEN];
     uint8_t     valueBuf[MX_VALUE_LEN];
-    uint8_t     binBuf[MX_VALUE_LEN];
-    uint8_t     iRadio;
     uint8_t     currCmdRadio;       //If the current command has "namex=value" where 'x' is ratio number 0-(number of radios-1)
     uint8_t     trailingNameDig;    //If a trailing digit was removed from 'name', this gives it's value. Else, 0xff.
     uint16_t    nameLen=0;
+    uint16_t    valueOffset;        //Offset of 'value' part in command
     uint16_t    valueLen=0;
-    uint16_t    binLen=0;
     uint16_t    cmdLen;
-    uint32_t    val;
     uint8_t     cmdResponse;        //Assign a CMD_RESPONCE_xx value
     bool        isNameValue;
-
-    enum CMD_RESPONCE {
-        CMD_RESPONCE_UNKNOWN = 0,
-        CMD_RESPONCE_OK,
-        CMD_RESPONCE_NONE
-    };
+    const UsbCmdEntry* pEntry;
+    UsbCmd      cmd;
+    MX_PROFILE_SCOPE(MX_PROF_USB_CMDS);
 
     //////////////////////////////////////////
     //Sent Command - command send by this unit
@@ -596,32 +1220,25 @@ void processUsbCmds() {
             break;
         }
 
-        //Get name=value pair
+        //Get name. For 'name=value' commands, the value is only copied to valueBuf once the handler is known.
         nameLen = rxBufUsb.getCommandName(nameBuf, MX_NAME_LEN, isNameValue);
-        //This command has 'name=value' format
-        if((nameLen>0) && (isNameValue==true)) {
-            //At this stage, we know nameLen+1 = first character of 'value'
-            valueLen = rxBufUsb.getCommandValue(valueBuf, MX_VALUE_LEN, nameLen+1);
-            //if (valueLen != 0) {
-            //    MX_DEBUG_INFO("\r\nN='%s' V='%s'", nameBuf, valueBuf);
-            //}
-        }
-        else {
+        if(nameLen==0) {
             isNameValue=false;
         }
+        valueOffset = nameLen+1;    //At this stage, we know nameLen+1 = first character of 'value'
 
-        //Check if 'name' ends with digit, and if so, remove it.
+        //Check if 'name' ends with digit, and if so, remove it. Was recorded when command was added to buffer.
         //The digit has to be the radio number, a value from 0 to (number of radios-1)
-        trailingNameDig = 0xff; //Name does not have a trailing digit
-        if((nameLen>1) && (nameBuf[nameLen-1]<RADIO_COUNT_CHAR) && (nameBuf[nameLen-1]>='0')) {
+        trailingNameDig = rxBufUsb.getCommandNameDigit();
+        if((nameLen>1) && (nameLen<MX_NAME_LEN) && (trailingNameDig<RADIO_COUNT)) {
             nameLen--;  //Remove trailing digit
-            currCmdRadio    = nameBuf[nameLen]-'0';
-            trailingNameDig = currCmdRadio;      //Indicate the trailing digit was removed from 'name'
+            currCmdRadio    = trailingNameDig;  //Indicate the trailing digit was removed from 'name'
             //MX_DEBUG_INFO("\r\ncurCmdRadio=%d", currCmdRadio);
             nameBuf[nameLen] = 0;   //Overwrite last byte of name (radio number) with NULL
         }
-
-        cmdResponse = CMD_RESPONCE_UNKNOWN;
+        else {
+            trailingNameDig = 0xff; //Name does not have a trailing digit
+        }
 
         //Process name-value commands
         //NOTE that if 'name' ended with trailing digit (0 - max radio), it is removed and saved in trailingNameDig
@@ -631,387 +1248,33 @@ void processUsbCmds() {
                 rxBufUsb.removeCommand();
                 break;
             }
-
-            //t....... - Command starting with 't'
-            if(nameBuf[0]=='t') {
-                // ---------- Name-Value COMMAND ----------
-                //t=asciiCmd    - Transmit Packet on current transceiver
-                //tn=asciiCmd   - Same as "t", but n gives transceiver to use. A value from 0 to (Radios-1).
-                //      Where asciiCmd is an "Ascii Command" string containing "two character upper case hex" data
-                //      If transmission successful, a "rn=tok" message will be sent (n = transceiver ID)
-                //      If transmission timeout, a "rn=tto" message will be sent (n = transceiver ID)
-                if(nameLen==1) {
-                    cmdResponse = CMD_RESPONCE_NONE;        //This command already send a "rn=.." reply
-                    //convert to binary
-                    binLen = decodeAsciiCmd(binBuf, MX_BIN_LEN, valueBuf);
-                    binBuf[binLen>=MX_BIN_LEN?(MX_BIN_LEN-1):binLen] = 0;   //NULL terminate
-                    //MX_DEBUG_INFO("Bin=%s", valueBuf);
-                    //MX_DEBUG_INFO("\r\nBin=");
-                    //for(int i=0; i<binLen; i++) {
-                    //    MX_DEBUG_INFO("%02x,", binBuf[i]);
-                    //}
-
-                    //Send value
-                    for (int i=0; i<binLen; i++) {
-                        radioData[currCmdRadio].txBuf.put(binBuf[i]);
-                    }
-                    //radioData[currCmdRadio].tmrRadio = timerMain.read_ms() + 10;    //Delay sending for 10ms
-                }
-                //t. - Command exactly 2 characters long, starting with 't'
-                else if(nameLen==2) {
-                    // ---------- Name-Value COMMAND ----------
-                    //tv=n  - Set current transceiver to use for all commands that does not specify transceiver
-                    //      Where n is a value from 0-(number of radios)
-                    if(nameBuf[1]=='v') {
-                        if((valueBuf[0]<RADIO_COUNT_CHAR) && (valueBuf[0]>='0')) {
-                            //Set new current transceiver radio
-                            currRadio = valueBuf[0]-'0';
-                            cmdResponse = CMD_RESPONCE_OK;
-                            MX_DEBUG_INFO("\r\nTrcvr=%d", currRadio);
-                        }
-                    }
-                    // ---------- Name-Value COMMAND ----------
-                    //tm=n  - Set "transmit mode" for current transceiver
-                    //tmn   - Same as "tm", but n gives transceiver to use. A value from 0 to (Radios-1).
-                    //      Valid modes are:
-                    //      0 = Radio enters Idle mode after transmitting a message
-                    //      1 = Radio enters Receive mode after transmitting a message
-                    else if(nameBuf[1]=='m') {
-                        if((valueBuf[0]>='0') && (valueBuf[0]<='1')) {
-                            cmdResponse = CMD_RESPONCE_OK;
-                            MX_DEBUG_INFO("\r\nTx mode=%d", valueBuf[0]-'0');
-                            if (radioConfig[currCmdRadio].txMode != valueBuf[0]-'0') {
-                                radioConfig[currCmdRadio].txMode = valueBuf[0]-'0';
-                                radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                            }
-                        }
-                    }
-                }
-                //tpw=v  - Set "transmit power" for current transceiver
-                //tpwn=v - Same as "tpw", but n gives transceiver to use. A value from 0 to (Radios-1).
-                //       Given power values(value of 'v') must be from 0 to 20 (0 to 20dBm)
-                else if(strcmp((const char*)&nameBuf[1], "pw") == 0) {
-                    uint8_t newVal;
-                    newVal = atoi((const char*)&valueBuf[0]);
-                    if (newVal <= 20) {
-                        cmdResponse = CMD_RESPONCE_OK;
-                        MX_DEBUG_INFO("\r\nTX Pwr=%d", newVal);
-                        //Set new CRC
-                        if (radioConfig[currCmdRadio].power != newVal) {
-                            radioConfig[currCmdRadio].power = newVal;
-                            radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                        }
-                    }
-                }
-            }
-            //r....... - Command starting with 'r'
-            else if(nameBuf[0]=='r') {
-                //r. - Command exactly 2 characters long, starting with 'r'
-                if(nameLen==2) {
-                    // ---------- Name-Value COMMAND ----------
-                    //rm=n  - Set "receive mode" for current transceiver
-                    //rmn=n - Same as "rm", but n gives transceiver to use. A value from 0 to (Radios-1).
-                    //      Valid modes are:
-                    //      0 = Single receive mode, Radio enters Idle mode after receiving a message
-                    //      1 = Continues receive mode, Radio enters Idle mode after receiving first message
-                    //      2 = Continues receive mode, Radio stays in receive modo after receiving a message
-                    if(nameBuf[1]=='m') {
-                        int val;
-                        val = valueBuf[0]-'0';
-                        if((val >= 0) && (val <= 2)) {
-                            cmdResponse = CMD_RESPONCE_OK;
-                            MX_DEBUG_INFO("\r\nRx mode=%d", val);
-
-                            //Set value in RadioConfig
-                            if (radioConfig[currCmdRadio].rxMode != val) {
-                                radioConfig[currCmdRadio].rxMode = val;
-                                radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                            }
-                        }
-                    }
-                }
-                //r... - Command longer than 2 characters, starting with 'r'
-                else  {
-                    // ---------- Name-Value COMMAND ----------
-                    //rto=n  - Set "receive timeout" in milli seconds for current transceiver
-                    //rton=n - Same as "rto", but n gives transceiver to use. A value from 0 to (Radios-1).
-                    //       Valid modes are:
-                    //       0 = No timeout, stay in receive mode
-                    //if((nameBuf[1]=='t') && (nameBuf[2]=='o')) {
-                    if(strcmp((const char*)&nameBuf[1], "to") == 0) {
-                        val = atoi((const char *)valueBuf);
-                        //Valid value from 0 to 10,000
-                        if ((val >= 0) && (val <= 10000)) {
-                            cmdResponse = CMD_RESPONCE_OK;
-                            MX_DEBUG_INFO("\r\nRx TO=%d ms", val);
-                            val = val * 1000;
-                            if (radioConfig[currCmdRadio].rxTimeout != val) {
-                                radioConfig[currCmdRadio].rxTimeout = val;
-                                radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                            }
-                        }
-                        else {
-                            MX_DEBUG_INFO("\r\nRx TO ERR!");
-                        }
-                    }
-                    //rsym=n    - Set "receive symbol" value.
-                    //rsymn=n   - Same as "rsym", but n gives transceiver to use. A value from 0 to (Radios-1).
-                    if(strcmp((const char*)&nameBuf[1], "sym") == 0) {
-                        val = atoi((const char *)valueBuf);
-                        //Valid value from 4 to 1023
-                        if ((val >= 4) && (val <= 1023)) {
-                            cmdResponse = CMD_RESPONCE_OK;
-                            MX_DEBUG_INFO("\r\nRxSymTO=%d", val);
-                            if (radioConfig[currCmdRadio].symbolTimeout != val) {
-                                radioConfig[currCmdRadio].symbolTimeout = val;
-                                radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                            }
-                        }
-                        else {
-                            MX_DEBUG_INFO("\r\nRxSymTO ERR!");
-                        }
-                    }
-                }
-            }
-            //b....... - Command starting with 'b'
-            else if(nameBuf[0]=='b') {
-                //b. - Command exactly 2 characters long, starting with 'b'
-                if(nameLen==2) {
-                    // ---------- Name-Value COMMAND ----------
-                    //bw=x      - Set bandwidth of current transceiver (set via previous 'tr' command)
-                    //bwn=x     - Same as "bw", but n gives transceiver to use. A value from 0 to (Radios-1).
-                    //      Bandwidth is given by x is one of the following: 6=62.5kHz, 7=125kHz, 8=250kHz, 9=500kHz (0 to 5 not supported = 7.8kHz to 41.7kHz)
-                    if(nameBuf[1]=='w') {
-                        if ((valueLen==1) && (valueBuf[0]>='6') && (valueBuf[0]<='9')) {
-                            cmdResponse = CMD_RESPONCE_OK;
-                            MX_DEBUG_INFO("\r\nBW=%d", valueBuf[0] - '0');
-                            //Set new bandwidth
-                            if (radioConfig[currCmdRadio].bw != valueBuf[0]-'0') {
-                                radioConfig[currCmdRadio].bw = valueBuf[0]-'0';
-                                radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                            }
-                        }
-                    }
-                }
-            }
-            //c....... - Command starting with 'c'
-            else if(nameBuf[0]=='c') {
-                //c.. - Command exactly 3 characters long, starting with 'c'
-                if(nameLen==3) {
-                    // ---------- Name-Value COMMAND ----------
-                    //crc=x  - Enable or disable CRC
-                    //crcn=x - Same as "crc", but n gives transceiver to use. A value from 0 to (Radios-1).
-                    if(strcmp((const char*)&nameBuf[1], "rc") == 0) {
-                        bool newVal;
-                        cmdResponse = CMD_RESPONCE_OK;
-                        newVal = valueBuf[0]=='0'?false:true;
-                        MX_DEBUG_INFO("\r\nCRC=%d", newVal);
-                        //Set new CRC
-                        if (radioConfig[currCmdRadio].conf.lora.crcEnable != newVal) {
-                            radioConfig[currCmdRadio].conf.lora.crcEnable = newVal;
-                            radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                        }
-                    }
-                }
-            }
-             //p....... - Command starting with 'p'
-             else if(nameBuf[0]=='p') {
-                 //s. - Command exactly 2 characters long, starting with 's'
-                 if(nameLen==2) {
-                     // ---------- Name-Value COMMAND ----------
-                     //pr=l   - Set "preamble length" in symbols
-                     //prn=l  - Same as "pr", but n gives transceiver to use. A value from 0 to (Radios-1).
-                     //     WhereValid l = Preamble length in symbols, 4 to 1000
-                     if(nameBuf[1]=='r') {
-                         val = atoi((const char *)valueBuf);
-                         if ((val >= 4) && (val <= 1000)) {
-                             cmdResponse = CMD_RESPONCE_OK;
-                             MX_DEBUG_INFO("\r\nPre=%d", val);
-
-                             //Set new Preamble
-                             if (radioConfig[currCmdRadio].preambleLength != val) {
-                                 radioConfig[currCmdRadio].preambleLength = val;
-                                 radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                             }
-                         }
-                     }
-                 }
-             }
-            //s....... - Command starting with 's'
-            else if(nameBuf[0]=='s') {
-                //s. - Command exactly 2 characters long, starting with 's'
-                if(nameLen==2) {
-                    // ---------- Name-Value COMMAND ----------
-                    //sf=x      - Set spreading factor of current transceiver (set via previous 'tr' command)
-                    //sfn=x     - Same as "sf", but n gives transceiver to use. A value from 0 to (Radios-1).
-                    //      Spreading factor is given by x and is a value from 7 to 12
-                    if(nameBuf[1]=='f') {
-                        val = atoi((const char *)valueBuf);
-                        if ((val >= 7) && (val <= 12)) {
-                            cmdResponse = CMD_RESPONCE_OK;
-                            MX_DEBUG_INFO("\r\nSF=%d", val);
-
-                            //Set new SF
-                            if (radioConfig[currCmdRadio].sf != val) {
-                                radioConfig[currCmdRadio].sf = val;
-                                radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                            }
-                        }
-                    }
-                }
-            }
-            //f....... - Command starting with 'f'
-            else if(nameBuf[0]=='f') {
-                // ---------- Name-Value COMMAND ----------
-                //f=x       - Set frequency of current transceiver (set via previous 'tr' command).
-                //fn=x      - Same as "f", but n gives transceiver to use. A value from 0 to (Radios-1).
-                //      Frequency is given by x, and is a value from 400000000 to 950000000 (or short 4000 to 9500)
-                if(nameLen==1) {
-                    val = atoi((const char *)valueBuf);
-                    //Support short format giving MHz/10. For example, 916.7MHz = 9167
-                    if (valueLen==4) {
-                        val = val * 100000;
-                    }
-                    if ((val >= 400000000) && (val <= 950000000)) {
-                        cmdResponse = CMD_RESPONCE_OK;
-                        MX_DEBUG_INFO("\r\nF=%d", val);
-                        if (radioConfig[currCmdRadio].frequency != val) {
-                            radioConfig[currCmdRadio].frequency = val;
-                            radioData[currCmdRadio].flags.bits.dirtyConf = true;
-                        }
-                    }
-                }
-                //f. - Command exactly 2 characters long, starting with 'f'
-                //else if(nameLen==2) {
-                //}
-            }
-        }   //if (isNameValue)
-        //////////////////////////////////////////////////////////////////
-        //Command only (NO "value" part)
-        //////////////////////////////////////////////////////////////////
+            pEntry = findUsbCmd(usbNameValueCmds, sizeof(usbNameValueCmds)/sizeof(usbNameValueCmds[0]), (const char*)nameBuf);
+        }
         //Command does NOT have "name=value" format. Command is in nameBuf
-        //NOTE that if command ended with trailing digit (0 - max radio), it is removed and saved in trailingNameDig
         else {
-            //r....... - Command starting with 'r'
-            if(nameBuf[0]=='r') {
-                //r. - Command exactly 2 characters long, starting with 'r'
-                if(nameLen==2) {
-                    // ---------- COMMAND ----------
-                    //rs  - Request RSSI value of last reception.
-                    //rsn - Same as "rs", but n gives transceiver to use. A value from 0 to (Radios-1).
-                    //      Returns the RSSI value for the previous reception for given transceiver.
-                    //      Return format is "rsn=v", where n is transceiver ID, and v = RSSI value
-                    if(nameBuf[1]=='s') {
-                        int len = 0;
-                        cmdResponse = CMD_RESPONCE_NONE;    //This command already send a reply
-                        //Use nameBuf to build reply string
-                        nameBuf[0] = 'r';
-                        nameBuf[1] = 's';
-                        nameBuf[2] = '0' + currCmdRadio;
-                        nameBuf[3] = '=';
-                        //itoa((int)(radioData[currCmdRadio].RssiValue), (char*)&nameBuf[4], 10);
-                        len = MxHelpers::cvt_int16_to_ascii_str(radioData[currCmdRadio].RssiValue, &nameBuf[4]);
-                        nameBuf[4+len] = ';';
-                        txBufUsb.putArray(nameBuf, len+5);
-
-                        #if (DEBUG_ENABLE_MAIN==1)
-                        nameBuf[5+len] = 0;
-                        MX_DEBUG_INFO("\r\n%s(%d)", nameBuf, radioData[currCmdRadio].RssiValue);
-                        #endif
-                    }
-                    // ---------- COMMAND ----------
-                    //rx  - Put ratio in receive mode. Timeout given with previous "Receive Time Out" command(rto=n) is used.
-                    //rxn - Same as "rx", but n gives transceiver to use. A value from 0 to (Radios-1).
-                    //      If message received successfully, a "rn=asciiString" message will be sent (n = transceiver ID)
-                    //      If receive error, a "rn=rer" message will be sent (n = transceiver ID)
-                    //      If receive timeout, a "rn=rto" message will be sent (n = transceiver ID)
-                    else if(nameBuf[1]=='x') {
-                        InAir* pRadio           = pRadios[currCmdRadio];
-                        RadioData* pRadioData   = &radioData[currCmdRadio];
-                        cmdResponse = CMD_RESPONCE_NONE;    //This command already send a reply
-                        MX_DEBUG_INFO("\r\nRx%d", currCmdRadio);
-                        if (pRadio!=NULL) {
-                            pRadioData->smRadio = IDLE;
-                            pRadio->Rx(radioConfig[currCmdRadio].rxTimeout);    //Continues reception mode
-                        }
-                        else {
-                            MX_DEBUG_INFO(" - NULL!!");
-                        }
-                    }
-                }   //if(nameLen==2)
-                // ---------- COMMAND ----------
-                //rst   - Run command
-                else if(strcmp((const char*)&nameBuf[1], "st") == 0) {
-                    cmdResponse = CMD_RESPONCE_OK;
-                    MX_DEBUG("\r\nResetting!");
-                    wait(1);
-                    NVIC_SystemReset();
-                }
-                // ---------- COMMAND ----------
-                //run   - Run command
-                else if(strcmp((const char*)&nameBuf[1], "un") == 0) {
-                    cmdResponse = CMD_RESPONCE_OK;
-                    MX_DEBUG_INFO("\r\nRun");
-                }
+            pEntry = findUsbCmd(usbCmds, sizeof(usbCmds)/sizeof(usbCmds[0]), (const char*)nameBuf);
+        }
 
-            }   //if(nameBuf[0]=='r')
-            //t...... - Command starting with 't'
-            else if(nameBuf[0]=='t') {
-                // ---------- COMMAND ----------
-                //tvs - Request Status of all Transceiver
-                //      Returns status of all transceivers. For each transceiver, will return command will following format:
-                //      "tvsn=x", where n is transceiver ID, and x is status:
-                //       - 0 = Uninitialized
-                //       - 1 = OK
-                if(strcmp((const char*)&nameBuf[1], "vs") == 0) {
-                    cmdResponse = CMD_RESPONCE_NONE;        //This command already send a reply
-                    MX_DEBUG_INFO("\r\nTcvr Stat");
-
-                    for(iRadio=0; iRadio < RADIO_COUNT; iRadio++) {
-                        InAir* pRadio               = pRadios[iRadio];
-                        //RadioConfig* pRadioConfig = &radioConfig[iRadio];
-                        //RadioData* pRadioData     = &radioData[iRadio];
-
-                        txBufUsb.put("tvs");
-                        txBufUsb.put('0' + iRadio);
-                        if (pRadio!=0) {
-                            txBufUsb.put("=1;");
-                        }
-                        else {
-                            txBufUsb.put("=0;");
-                        }
-                    }
-                }
-                else if(strcmp((const char*)&nameBuf[1], "est") == 0) {
-                    // ---------- COMMAND ----------
-                    //test1 - Virtual com port speed test
-                    if(trailingNameDig==1) {
-                        uint8_t tempBuf[16];
-                        cmdResponse = CMD_RESPONCE_NONE;        //This command already send a reply
-                        MX_DEBUG_INFO("\r\nTest1");
-                        strcpy((char*)tempBuf, "012345678;");
-                        for (int i = 0; i<10; i++) {
-                        //for (int i = 0; i<1000; i++) {
-                            while(txBufUsb.getFree() < 12) {
-                                mx_usbcdc_task();
-                            }
-                            txBufUsb.putArray(tempBuf, 10);
-                            mx_usbcdc_task();
-                        }
-                    }
-                    // ---------- COMMAND ----------
-                    //test2 - Test watchdog timer
-                    else if(trailingNameDig==2) {
-                        cmdResponse = CMD_RESPONCE_OK;
-                        while(1){};
-                    }
-                }
-            }   //else if(nameBuf[0]=='t')
-        }   // else - Command does NOT have "name=value" format
+        cmdResponse = CMD_RESPONCE_UNKNOWN;
+        if (pEntry != NULL) {
+            //Copy 'value' to valueBuf, if the handler does not read it from rxBufUsb itself
+            valueLen = 0;
+            valueBuf[0] = 0;
+            if (isNameValue && (pEntry->valueView == false)) {
+                valueLen = rxBufUsb.getCommandValue(valueBuf, MX_VALUE_LEN, valueOffset);
+                //MX_DEBUG_INFO("\r\nN='%s' V='%s'", nameBuf, valueBuf);
+            }
+            cmd.value           = valueBuf;
+            cmd.valueLen        = valueLen;
+            cmd.radio           = currCmdRadio;
+            cmd.trailingNameDig = trailingNameDig;
+            cmdResponse = pEntry->handler(cmd);
+        }
 
-        //If dirty, mark RadioData dirty for display
+        //If dirty, mark RadioData dirty for display, and save it to EEPROM later
         if (radioData[currCmdRadio].flags.bits.dirtyConf == true) {
             radioData[currCmdRadio].flags.bits.dirtyConfDisp = true;
+            setRadioConfigUnsaved(currCmdRadio);
         }
 
         //Unknown command
@@ -1031,6 +1294,12 @@ void processUsbCmds() {
                 tmrSecLastUsbCmd = mxTick.read_sec();   //Save last time a valid USB command processed
             #endif
         }
+        else if(cmdResponse==CMD_RESPONCE_ERROR) {
+            #if !defined(DISABLE_RESET_RADIO_USB_TIMERS)
+                tmrSecLastUsbCmd = mxTick.read_sec();   //Save last time a valid USB command processed
+            #endif
+            txBufUsb.put("er;");                    //Command failed
+        }
 
         rxBufUsb.removeCommand();
         break;
@@ -1092,7 +1361,7 @@ void blinkLED(bool reset) {
 
 
     //Flash LED
-    if (mxTick.read_ms() >= tmrLED) {
+    if (mxTick.expired_ms(tmrLED)) {
 
         //LED currently OFF
         if(NZ32S::get_led1() == false) {
@@ -1148,14 +1417,16 @@ void processRxDataUSB(uint8_t iRadio) {
 
         //Copy received data to USB
         //Enough space for data plus 4 bytes: Leading "rn=" and trailing ';'
-        if(txBufUsb.getFree() >= (TX_BUF_USB_COUNTERTYPE)((pRadioData->rxLen*2)+4)) {
+        if((uint32_t)txBufUsb.getFree() >= (uint32_t)((pRadioData->rxLen*2)+4)) {
             bufTemp[0] = 'r';
             bufTemp[1] = iRadio + '0';
             bufTemp[2] = '=';
             txBufUsb.putArray(bufTemp, 3);
-            for(int i=0; i<pRadioData->rxLen; i++) {
-                MxHelpers::byte_to_ascii_hex_str(pRadioData->rxBuf[i], (char*)bufTemp);
-                txBufUsb.putArray(bufTemp, 2);
+            //Convert 8 bytes at a time to "two character upper case hex" data
+            for(int i=0; i<pRadioData->rxLen; i+=8) {
+                int len = ((pRadioData->rxLen - i) < 8) ? (pRadioData->rxLen - i) : 8;
+                MxHelpers::bytes_to_ascii_hex(&pRadioData->rxBuf[i], len, bufTemp);
+                txBufUsb.putArray(bufTemp, len*2);
             }
             txBufUsb.put(';');
         }
@@ -1239,6 +1510,7 @@ void radioTask(uint8_t iRadio) {
     InAir* pRadio               = pRadios[iRadio];
     RadioConfig* pRadioConfig = &radioConfig[iRadio];
     RadioData* pRadioData     = &radioData[iRadio];
+    MX_PROFILE_SCOPE(MX_PROF_RADIO_TASK);
 
     ///////////////////////////////////////////////////////////////////
     // Main Radio Task ////////////////////////////////////////////////
@@ -1246,18 +1518,14 @@ void radioTask(uint8_t iRadio) {
     //Idle, and not currently waiting for a transmission to finish.
     //This state will check if there is anything in buffer to send.
     case IDLE:
-        if (mxTick.read_ms() >= pRadioData->tmrRadio) {
+        if (mxTick.expired_ms(pRadioData->tmrRadio)) {
             pRadioData->tmrRadio = mxTick.read_ms();    //Always update tick, else it will expire after a while!
 
             //Check if there is data to send
             if (pRadioData->txBuf.isEmpty() == false) {
                 uint8_t tx[32];
-                int i;
                 MX_DEBUG_INFO("\r\nTx%d", iRadio);
-                int txSize = pRadioData->txBuf.getAvailable();  // TODO - Debug shows txSize of 0 returned!!!!!!!!!!
-                for(i=0; i<txSize; i++) {
-                    tx[i] = pRadioData->txBuf.get();
-                }
+                int txSize = pRadioData->txBuf.getArray(tx, sizeof(tx));
 
                 if ((pRadioData->mode!=RADIO_MODE_STOPPED) && (pRadio!=NULL) ) {
                     pRadio->Send(tx, txSize);
@@ -1279,6 +1547,7 @@ void radioTask(uint8_t iRadio) {
         #if !defined(DISABLE_RESET_RADIO_USB_TIMERS)
             tmrSecLastTxRx = mxTick.read_sec(); //Save last time Radio did a successful transmission
         #endif
+        mtrTx.inc();
         MX_DEBUG_INFO("\r\n> Tx Done");
 
         //Send TX OK reply
@@ -1300,6 +1569,7 @@ void radioTask(uint8_t iRadio) {
         }
         break;
     case TX_TIMEOUT:
+        mtrTxTimeout.inc();
         MX_DEBUG_INFO("\r\nTx Timeout");
 
         //Send TX Timeout reply
@@ -1319,11 +1589,13 @@ void radioTask(uint8_t iRadio) {
         //Set all "RX Listener" flags
         pRadioData->rxListeners |= RX_LISTENER_MASK;
         pRadioData->rxCount++;      //Increment RX Count
+        mtrRx.inc();
         pRadioData->smRadio = IDLE; //Return to IDLE mode, check if any new data available to send
         break;
     case RX_TIMEOUT:
         pRadioData->rxStatus = RX_STATUS_TIMEOUT;
         pRadioData->rxErrCnt++;     //Increment for Timeouts and CRC errors
+        mtrRxTimeout.inc();
         MX_DEBUG_INFO("\r\nRx%d Timeout", iRadio);
         //Send RX Timeout reply
         #if ((MX_ENABLE_USB==1))
@@ -1337,6 +1609,7 @@ void radioTask(uint8_t iRadio) {
     case RX_ERROR:
         pRadioData->rxStatus = RX_STATUS_ERR_CRC;
         pRadioData->rxErrCnt++;     //Increment for Timeouts and CRC errors
+        mtrRxErr.inc();
         MX_DEBUG_INFO("\r\nRx%d Error", iRadio);
         //Send RX Error reply
         #if ((MX_ENABLE_USB==1))
@@ -1362,7 +1635,7 @@ bool initializeRadio(uint8_t iRadio) {
     RadioConfig* pRadioConfig = &radioConfig[iRadio];
     RadioData* pRadioData     = &radioData[iRadio];
 
-    if (mxTick.read_ms() >= pRadioData->tmrRadio) {
+    if (mxTick.expired_ms(pRadioData->tmrRadio)) {
         pRadioData->tmrRadio = mxTick.read_ms();    //Always update tick, else it will expire after a while!
 
         //Create and Initialize instance of SX1276inAir
@@ -1395,8 +1668,10 @@ bool initializeRadio(uint8_t iRadio) {
             //    pRadio->SetBoardType(pRadioConfig->boardType);
             //    pRadios[iRadio] = pRadio;
             //}
-            //Wait 100mS before executing radio functions again
-            pRadioData->tmrRadio = mxTick.read_ms() + 100;
+        }
+
+        //Radio is only ready RADIO_POWER_UP_TIME after it was created, check again on next call
+        if ((pRadio == NULL) || (pRadio->InitTask() == false)) {
             return false;   //Radio NOT initialized, try again later
         }
 
@@ -1429,14 +1704,24 @@ bool initializeRadio(uint8_t iRadio) {
         pRadioData->mode = RADIO_MODE_MASTER;
         #endif
 
-        //Set Channel Frequency
+        //Set Channel Frequency, and calibrate RX chain if band or temperature changed since last calibration
         pRadio->SetChannel(pRadioConfig->frequency);
+        if (pRadio->CalibrateIfRequired() == true) {
+            MX_DEBUG("\r\n%d=RX Calibrated", iRadio);
+        }
 
         if(pRadioConfig->conf.lora.fshhEnable == true) {
             MX_DEBUG("\r\n%d=LORA FHSS Mode", iRadio);
+            #if (INAIR_FHSS_MAX_CHANNELS > 0)
+            //Precompute hop table, channels start at configured frequency
+            pRadio->SetHopTable(pRadioConfig->frequency, LORA_FHSS_SPACING, LORA_FHSS_CHANNELS, LORA_FHSS_SEED);
+            #endif
         }
         else {
             MX_DEBUG("\r\n%d=LORA Mode", iRadio);
+            #if (INAIR_FHSS_MAX_CHANNELS > 0)
+            pRadio->ClearHopTable();
+            #endif
         }
 
         pRadio->SetTxConfig(MODEM_LORA, pRadioConfig->power, 0, pRadioConfig->bw,
@@ -1456,7 +1741,7 @@ bool initializeRadio(uint8_t iRadio) {
 
         pRadioData->smRadio = IDLE;
         return true;    //Radio Initialized!
-    }   //if (mxTick.read_ms() >= pRadioData->tmrRadio)
+    }   //if (mxTick.expired_ms(pRadioData->tmrRadio))
 
     return false;   //Radio NOT initialized, try again later
 }
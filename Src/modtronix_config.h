@@ -71,6 +71,9 @@
 //functions, but will enable programming and debugging via SWD (ST-Link)
 #define     NZ32S_USE_A13_A14    1
 
+//Set to 1 to enable the MxProfile cycle counter profiler, and "prof" USB command
+#define     NZ32S_USE_PROFILER    0
+
 
 
 #endif
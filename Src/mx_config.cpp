@@ -45,10 +45,46 @@
 //#define MXCONF_GET_OFFSET(id)  (mxconfIdAdr[id])
 
 
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define LOG_BANK_ADR(bank)      ((uint32_t)MXCONF_LOG_ADR + ((bank) * MXCONF_LOG_BANK_SIZE))
+#define LOG_REC_SIZE(len)       (sizeof(MxConfRec) + (((len) + 3) & ~3))
+#define EEP_ERASED              0   //Value of erased EEPROM word
+
+#if defined(MXCONF_EEPROM_SIM)
+#define EEP_PTR(offset)         (&mxconfSimEeprom[offset])
+#define EEP_UNLOCK()
+#define EEP_LOCK()
+#else
+#define EEP_PTR(offset)         ((__IO uint8_t*)(EEPROM_START_ADDRESS + (offset)))
+#define EEP_UNLOCK()            HAL_FLASHEx_DATAEEPROM_Unlock()
+#define EEP_LOCK()              HAL_FLASHEx_DATAEEPROM_Lock()
+#endif
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+#if defined(MXCONF_EEPROM_SIM)
+uint8_t  mxconfSimEeprom[EEPROM_SIZE];
+uint32_t mxconfSimCycles[EEPROM_SIZE/4];
+int32_t  mxconfSimFailAfter = -1;
+void     (*mxconfSimPowerFail)(void);
+#endif
+
+static bool     logInitDone = false;
+static bool     logCorrupt;     //Set if invalid record found, log is compacted before next write
+static uint8_t  logBank;        //Active bank, 0 or 1
+static uint16_t logGen;         //Generation of active bank
+static uint16_t logHead;        //EEPROM offset of first free byte in active bank
+static uint16_t logErase;       //EEPROM offset of first word of spare bank not erased yet
+
+
 // Function Prototypes ////////////////////////////////////////////////////////
-bool readHeader(uint8_t id, MxConfHdr* pHdr, uint32_t address, uint16_t sizeStruct);
-bool eepSaveAndConfirm(uint32_t adr, uint8_t value);
-bool updateAllStructures(void);
+bool readHeader(uint8_t id, MxConfHdr* pHdr, uint16_t adrOffset, uint16_t sizeStruct);
+static void logInit(void);
+static uint16_t logReplay(uint8_t id, uint8_t* pDest, uint16_t start, uint16_t size);
+static uint16_t logReplayDesc(uint8_t id, uint8_t* pDesc, uint16_t sizeDesc);
+static bool logAppend(uint8_t type, uint8_t id, uint8_t offset, uint8_t len, const uint8_t* pData, uint16_t structSize);
+static bool logCompact(void);
+
 
 /**
  * Used for Debug only! Print size of structures.
@@ -68,241 +104,596 @@ void infoConfigStructs(void) {
 }
 
 
-bool mxconf_read_struct(uint8_t id, uint8_t* pDest, uint16_t sizeData, uint16_t adrOffset, uint16_t sizeStruct, uint8_t* pDataDsc) {
-    MxConfHdr hdr;
-    uint32_t address;
-    uint32_t addressData;   //Address to first byte of data
 
-    MX_DEBUG_INFO("\r\nRead Structure!");
-    //MX_DEBUG("\r\nMxConf Offset=%d, size=%d", MXCONF_GET_OFFSET(id), MxConf::getSize(id));
-    address = EEPROM_START_ADDRESS + adrOffset; //Address of header
+/**
+ * Update CRC-16 (CCITT) with given data
+ */
+static uint16_t crc16(uint16_t crc, const uint8_t* pData, uint16_t len) {
+    uint8_t i;
 
-    //EEPROM does NOT currently contain valid data.
-    if(readHeader(id, &hdr, address, sizeStruct) == false) {
-        MX_DEBUG("\r\nMxConf%d Invalid!", id);
-        //Save structure again. This should save correct version of structure!
-        mxconf_save_struct(id, pDest, sizeData, adrOffset, sizeStruct, pDataDsc);
+    while (len-- != 0) {
+        crc ^= (uint16_t)(*pData++) << 8;
+        for (i=0; i<8; i++) {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+
+/**
+ * Read 32-bit word from EEPROM. Offset must be multiple of 4
+ */
+static inline uint32_t eepReadWord(uint16_t offset) {
+#if defined(MXCONF_EEPROM_SIM)
+    uint32_t val;
+    memcpy(&val, EEP_PTR(offset), 4);
+    return val;
+#else
+    return *(__IO uint32_t*)EEP_PTR(offset);
+#endif
+}
+
+
+/**
+ * Program given 32-bit word to EEPROM, and confirm it. Is not written if it already has given value.
+ * EEPROM must be unlocked.
+ * @return True if OK, else false
+ */
+static bool eepWriteWord(uint16_t offset, uint32_t value) {
+    //Check if word already has requested value
+    if (eepReadWord(offset) == value) {
+        return true;    //Nothing to do, return OK
+    }
+
+#if defined(MXCONF_EEPROM_SIM)
+    //Simulated power failure. Only the lower half of the word is programmed
+    if ((mxconfSimFailAfter >= 0) && (mxconfSimFailAfter-- == 0)) {
+        memcpy(EEP_PTR(offset), &value, 2);
+        mxconfSimCycles[offset/4]++;
+        if (mxconfSimPowerFail != NULL) {
+            mxconfSimPowerFail();
+        }
         return false;
     }
+    memcpy(EEP_PTR(offset), &value, 4);
+    mxconfSimCycles[offset/4]++;
+#else
+    if (HAL_FLASHEx_DATAEEPROM_Program(FLASH_TYPEPROGRAMDATA_WORD, EEPROM_START_ADDRESS + offset, value) != HAL_OK) {
+        MX_DEBUG("\r\nEEPROM Save ERR!");
+        return false;
+    }
+#endif
 
-    //TODO - Seems like EEPROM contains old data structure! In this case, we have to rewrite WHOLE eeprom to new structures!
-    if(hdr.structSize != (sizeStruct/MXCONF_SIZE_BASE)) {
-        updateAllStructures();
-    }
-
-    //Get address of first byte of data
-    addressData = address + sizeof(MxConfHdr);
-
-    //Read ALL data (TODO - Replace with method below in future)
-    MX_DEBUG_INFO("\r\nData=");
-    for (uint i=0; i<hdr.dataSize; i++) {
-        *pDest = *(__IO uint8_t*)addressData++;
-        MX_DEBUG_INFO("%02x ", *pDest);
-        pDest++;
-    }
-
-    //TODO - Enable this in future if needed. Only have to implement bit copying below, all rest is done
-    //Check if EEPRM contains "Data Description". Will follow data
-    /*
-    uint8_t* pDataDesc;
-    MX_DEBUG_INFO("\r\nData=");
-    pDataDesc = (uint8_t*)(addressData + hdr.dataSize); //First byte AFTER data = "Data Descriptor"
-    if(*pDataDesc != 0) {
-        MxConfDataDesc desc;
-        uint8_t* pCurrDest;
-        uint8_t numDesc = *pDataDesc++;     //Number of "Data Descriptors"
-        MX_DEBUG_INFO("\r\nDataDesc Num=%d", numDesc);
-        //Read only data defined by "Data Descriptor"
-        for (int iDesc=0; iDesc<numDesc; iDesc++) {
-            uint i;
-            //Read current "Data Descriptor"
-            for(i=0; i<sizeof(MxConfDataDesc); i++) {
-                ((uint8_t*)(&desc))[i] = *pDataDesc++;
-            }
+    //Confirm word written correctly
+    if (eepReadWord(offset) != value) {
+        MX_DEBUG("\r\nEEPROM Save ERR!");
+        return false;
+    }
+    return true;
+}
 
-            address = addressData + desc.offset;    //Source address of block of data pointed to by current "Data Descriptor"
-            pCurrDest = pDest + desc.offset;        //Destination address of block of data pointed to by current "Data Descriptor"
 
-            //Copy 1-Bit data given by "Data Description"
-            if(desc.type == MXCONF_DESC_TYPE_1BIT) {
-                //TODO - Copy desc.size number of bits from source to destination
-            }
-            //Copy 8-Bit data given by "Data Description"
-            if(desc.type == MXCONF_DESC_TYPE_8BIT) {
-                for(i=0; i<desc.size; i++) {
-                    *pCurrDest = *(__IO uint8_t*)address++;
-                }
-            }
-            else {
-                MX_DEBUG("\r\nERR: DataDesc Type NOT supported!")
+/**
+ * Read and check record at given EEPROM offset. Is a valid record if it fits in the active bank, and CRC is OK.
+ * @return True if valid record, else false
+ */
+static bool logReadRec(uint16_t offset, MxConfRec* pRec) {
+    uint16_t crc;
+
+    memcpy(pRec, (const void*)EEP_PTR(offset), sizeof(MxConfRec));
+    if ((pRec->type != MXCONF_REC_DATA) && (pRec->type != MXCONF_REC_DESC)) {
+        return false;
+    }
+    if ((offset + LOG_REC_SIZE(pRec->len)) > (LOG_BANK_ADR(logBank) + MXCONF_LOG_BANK_SIZE)) {
+        return false;
+    }
+    crc = crc16(0xffff, &pRec->id, 5);  //id, offset, len and structSize
+    crc = crc16(crc, (const uint8_t*)EEP_PTR(offset + sizeof(MxConfRec)), pRec->len);
+    if (crc != pRec->crc) {
+        return false;
+    }
+    //Descriptor record must contain whole "Data Descriptor"
+    if (pRec->type == MXCONF_REC_DESC) {
+        return (MXCONF_DESC_SIZE(*EEP_PTR(offset + sizeof(MxConfRec))) <= pRec->len);
+    }
+    return true;
+}
+
+
+/**
+ * Find active bank, and end of log in it. If EEPROM does not contain a valid bank, bank 0 is made active.
+ */
+static void logInit(void) {
+    MxConfBankHdr bankHdr[2];
+    MxConfRec rec;
+    bool valid[2];
+    uint8_t bank;
+
+    if (logInitDone) {
+        return;
+    }
+    logInitDone = true;
+    logCorrupt = false;
+
+    for (bank=0; bank<2; bank++) {
+        memcpy(&bankHdr[bank], (const void*)EEP_PTR(LOG_BANK_ADR(bank)), sizeof(MxConfBankHdr));
+        valid[bank] = (bankHdr[bank].magic == MXCONF_BANK_MAGIC) && (bankHdr[bank].genInv == (uint16_t)~bankHdr[bank].gen);
+    }
+
+    //Use bank with highest generation. If both are valid, compaction was interrupted after new bank was completed
+    if (valid[0] && valid[1]) {
+        logBank = ((int16_t)(bankHdr[1].gen - bankHdr[0].gen) > 0) ? 1 : 0;
+    }
+    else if (valid[0] || valid[1]) {
+        logBank = valid[1] ? 1 : 0;
+    }
+    else {
+        //No valid bank, activate bank 0. Compacting empty bank 1 into it only writes bank header
+        MX_DEBUG("\r\nCreating MxConfig Log!");
+        logBank = 1;
+        logGen = 0;
+        logErase = LOG_BANK_ADR(0);
+        logHead = LOG_BANK_ADR(logBank) + sizeof(MxConfBankHdr);   //Empty
+        logCompact();
+        return;
+    }
+    logGen = bankHdr[logBank].gen;
+    logErase = LOG_BANK_ADR(logBank ^ 1);   //Erased by mxconf_erase_spare(), words already erased are only read
+
+    //Find end of log
+    logHead = LOG_BANK_ADR(logBank) + sizeof(MxConfBankHdr);
+    while ((logHead + sizeof(MxConfRec)) <= (LOG_BANK_ADR(logBank) + MXCONF_LOG_BANK_SIZE)) {
+        if (logReadRec(logHead, &rec) == false) {
+            //Not end of log, but an incomplete or corrupt record. Don't append after it, compact on next write
+            if (rec.type != 0) {
+                MX_DEBUG("\r\nMxConfig Log corrupt at 0x%x", logHead);
+                logCorrupt = true;
             }
+            break;
         }
+        logHead += LOG_REC_SIZE(rec.len);
     }
-    else {
-        //Read ALL data (TODO - Only copy data defined by "Data Descriptor")
-        for (uint i=0; i<hdr.dataSize; i++) {
-            *pDest = *(__IO uint8_t*)address++;
-            MX_DEBUG_INFO("%02x ", *pDest);
-            pDest++;
+    MX_DEBUG_INFO("\r\nMxConfig Log Bank=%d Gen=%d Used=%d", logBank, logGen, logHead - LOG_BANK_ADR(logBank));
+}
+
+
+/**
+ * Replay all records of given structure ID in active bank. Only bytes 'start' to 'start+size-1' of the structure
+ * are written to pDest, pDest[0] is byte 'start'.
+ * @return Data size of structure in last record, or 0 if log does not contain given ID
+ */
+static uint16_t logReplay(uint8_t id, uint8_t* pDest, uint16_t start, uint16_t size) {
+    MxConfRec rec;
+    uint16_t offset;
+    uint16_t structSize = 0;
+    uint16_t src;           //EEPROM offset of record data
+    uint16_t recOffset;     //Offset in structure of record data
+    uint16_t recLen;        //Length of record data
+    uint16_t first;
+    uint16_t last;
+    uint16_t descLen;
+
+    for (offset = LOG_BANK_ADR(logBank) + sizeof(MxConfBankHdr); offset < logHead; offset += LOG_REC_SIZE(rec.len)) {
+        memcpy(&rec, (const void*)EEP_PTR(offset), sizeof(MxConfRec));
+        if (rec.id != id) {
+            continue;
+        }
+        structSize = rec.structSize;
+        src = offset + sizeof(MxConfRec);
+        recOffset = rec.offset;
+        recLen = rec.len;
+
+        //Descriptor record, whole structure follows "Data Descriptor"
+        if (rec.type == MXCONF_REC_DESC) {
+            descLen = MXCONF_DESC_SIZE(*EEP_PTR(src));
+            src += descLen;
+            recOffset = 0;
+            recLen -= descLen;
+        }
 
+        //Copy part of record data that is in requested part of structure
+        first = (recOffset > start) ? recOffset : start;
+        last = ((recOffset + recLen) < (start + size)) ? (recOffset + recLen) : (start + size);
+        if (first < last) {
+            memcpy(&pDest[first - start], (const void*)EEP_PTR(src + first - recOffset), last - first);
         }
     }
-    */
+    return structSize;
+}
 
-    return true;    //OK
+
+/**
+ * Get "Data Descriptor" of last descriptor record of given structure ID in active bank. Only first sizeDesc
+ * bytes are copied to pDesc.
+ * @return Size of "Data Descriptor", or 0 if log does not contain one for given ID
+ */
+static uint16_t logReplayDesc(uint8_t id, uint8_t* pDesc, uint16_t sizeDesc) {
+    MxConfRec rec;
+    uint16_t offset;
+    uint16_t descLen = 0;
+
+    for (offset = LOG_BANK_ADR(logBank) + sizeof(MxConfBankHdr); offset < logHead; offset += LOG_REC_SIZE(rec.len)) {
+        memcpy(&rec, (const void*)EEP_PTR(offset), sizeof(MxConfRec));
+        if ((rec.id != id) || (rec.type != MXCONF_REC_DESC)) {
+            continue;
+        }
+        descLen = MXCONF_DESC_SIZE(*EEP_PTR(offset + sizeof(MxConfRec)));
+        memcpy(pDesc, (const void*)EEP_PTR(offset + sizeof(MxConfRec)), (descLen < sizeDesc) ? descLen : sizeDesc);
+    }
+    return descLen;
 }
 
+
 /**
- * Save given "MxConfig Structure".
- * @param id "MxConfig Structure" ID
- * @param pSrc Pointer to source structure
- * @param sizeData Size of used data in structure. This is NOT the size that is reserved in EEPROM, which is larger.
- * @param adrOffset Offset in Non Volatile memory where structure is located
- * @param sizeStruct Size of structure in Non Volatile memory
- * @param pDataDsc First byte is number of MxConfDataDesc structures, followed by array of MxConfDataDesc[]
+ * Write record at given EEPROM offset. Data is written first, and first word of header last. EEPROM must be unlocked.
  * @return True if OK, else false
  */
-bool mxconf_save_struct(uint8_t id, uint8_t* pSrc, uint16_t sizeData, uint16_t adrOffset, uint16_t sizeStruct, uint8_t* pDataDsc) {
-    uint i;
-    uint8_t endIncNbr;
-    uint16_t sizeDataDsc = 0;   //Size of "Data Descriptor"
-    MxConfHdr hdr;
-    HAL_StatusTypeDef status;
-    uint32_t address;
-    uint8_t* ptr;
+static bool logWriteRec(uint16_t offset, uint8_t type, uint8_t id, uint8_t recOffset, uint8_t len, const uint8_t* pData, uint16_t structSize) {
+    MxConfRec rec;
+    uint32_t word;
+    uint16_t i;
+
+    rec.type        = type;
+    rec.id          = id;
+    rec.offset      = recOffset;
+    rec.len         = len;
+    rec.structSize  = structSize;
+    rec.crc         = crc16(crc16(0xffff, &rec.id, 5), pData, len);
+
+    //Data, last word padded with 0
+    for (i=0; i<len; i+=4) {
+        word = 0;
+        memcpy(&word, &pData[i], ((len - i) < 4) ? (len - i) : 4);
+        if (eepWriteWord(offset + sizeof(MxConfRec) + i, word) == false) {
+            return false;
+        }
+    }
 
-    MX_DEBUG_INFO("\r\nSave Struct %d", id);
+    //Header, first word containing type is written last
+    memcpy(&word, ((uint8_t*)&rec) + 4, 4);
+    if (eepWriteWord(offset + 4, word) == false) {
+        return false;
+    }
+    memcpy(&word, &rec, 4);
+    return eepWriteWord(offset, word);
+}
+
+
+/**
+ * Append record to log. If active bank is full, log is first compacted into other bank.
+ * @return True if OK, else false
+ */
+static bool logAppend(uint8_t type, uint8_t id, uint8_t offset, uint8_t len, const uint8_t* pData, uint16_t structSize) {
+    bool ok;
 
-    #if (DEBUG_ENABLE==1)
-    if((sizeStruct%MXCONF_SIZE_BASE) != 0) {
-        MX_DEBUG("\r\nERR: sizeStruct invalid!");
+    if (logCorrupt || ((logHead + LOG_REC_SIZE(len)) > (LOG_BANK_ADR(logBank) + MXCONF_LOG_BANK_SIZE))) {
+        if (logCompact() == false) {
+            return false;
+        }
+        if ((logHead + LOG_REC_SIZE(len)) > (LOG_BANK_ADR(logBank) + MXCONF_LOG_BANK_SIZE)) {
+            MX_DEBUG("\r\nMxConfig Log full!");
+            return false;
+        }
+    }
+
+    EEP_UNLOCK();
+    ok = logWriteRec(logHead, type, id, offset, len, pData, structSize);
+    EEP_LOCK();
+
+    //If it failed, record might be partially written. Replay ends before it, and log is compacted before next
+    //write, so it is never written over
+    if (ok == false) {
+        MX_DEBUG("\r\nMxConfig Log write failed!");
+        logCorrupt = true;
         return false;
     }
-    #endif
+    logHead += LOG_REC_SIZE(len);
+    return true;
+}
+
+
+/**
+ * Compact log into other bank. Erases part of other bank not erased by mxconf_erase_spare() yet, writes a single
+ * record with the current data of each structure, and then the bank header. Active bank is not modified, so it
+ * remains valid if this is interrupted.
+ * @return True if OK, else false
+ */
+static bool logCompact(void) {
+    uint8_t buf[MXCONF_MAX_DESC_SIZE + MXCONF_MAX_DATA];
+    MxConfBankHdr bankHdr;
+    uint8_t newBank = logBank ^ 1;
+    uint16_t offset;
+    uint16_t structSize;
+    uint16_t descLen;
+    uint32_t word;
+    bool ok = true;
+    uint8_t id;
+
+    MX_DEBUG_INFO("\r\nCompacting MxConfig Log to bank %d", newBank);
+
+    EEP_UNLOCK();
+
+    //Erase rest of new bank. Bank header is erased first, so it is invalid until compaction is complete
+    for (offset = logErase; ok && (offset < (LOG_BANK_ADR(newBank) + MXCONF_LOG_BANK_SIZE)); offset += 4) {
+        ok = eepWriteWord(offset, EEP_ERASED);
+    }
 
-    //Get "Data Descriptor" size
-    if(pDataDsc!=0) {
-        sizeDataDsc = *pDataDsc;  //Get number of "Data Descriptors"
-        if(sizeDataDsc != 0) {
-            sizeDataDsc = 1 + (sizeDataDsc * sizeof(MxConfDataDesc));
+    //Write current data of all structures, with "Data Descriptor" if it has one
+    offset = LOG_BANK_ADR(newBank) + sizeof(MxConfBankHdr);
+    for (id=0; ok && (id<MXCONF_ID_COUNT); id++) {
+        memset(buf, 0, sizeof(buf));
+        descLen = logReplayDesc(id, buf, MXCONF_MAX_DESC_SIZE);
+        if (descLen > MXCONF_MAX_DESC_SIZE) {
+            descLen = 0;    //Should not happen, save structure without descriptor
         }
-        MX_DEBUG_INFO("\r\nDataDesc Size=%d", sizeDataDsc);
+        structSize = logReplay(id, &buf[descLen], 0, MXCONF_MAX_DATA);
+        if (structSize == 0) {
+            continue;
+        }
+        if (structSize > MXCONF_MAX_DATA) {
+            structSize = MXCONF_MAX_DATA;
+        }
+        ok = logWriteRec(offset, (descLen != 0) ? MXCONF_REC_DESC : MXCONF_REC_DATA, id, 0, descLen + structSize, buf, structSize);
+        offset += LOG_REC_SIZE(descLen + structSize);
+    }
+
+    //Write bank header, first word last
+    if (ok) {
+        bankHdr.magic   = MXCONF_BANK_MAGIC;
+        bankHdr.fill    = 0;
+        bankHdr.gen     = logGen + 1;
+        bankHdr.genInv  = ~bankHdr.gen;
+        bankHdr.fill2   = 0;
+        memcpy(&word, ((uint8_t*)&bankHdr) + 4, 4);
+        ok = eepWriteWord(LOG_BANK_ADR(newBank) + 4, word);
+        memcpy(&word, &bankHdr, 4);
+        ok = ok && eepWriteWord(LOG_BANK_ADR(newBank), word);
     }
 
-    //Check if structure size is large enough
-    if(sizeStruct < (sizeData + sizeDataDsc)) {
-        MX_DEBUG("\r\nsizeStruct TOO SMALL!");
+    EEP_LOCK();
+
+    if (ok == false) {
+        MX_DEBUG("\r\nMxConfig Log compaction failed!");
+        logCorrupt = true;  //Try again on next write
+        logErase = LOG_BANK_ADR(newBank);
         return false;
     }
 
-    //Print reserved space
-    MX_DEBUG_INFO("\r\nSize=%d, Reserve=%d", sizeStruct, sizeStruct-(sizeData+sizeDataDsc));
+    logBank = newBank;
+    logGen++;
+    logHead = offset;
+    logCorrupt = false;
+    logErase = LOG_BANK_ADR(newBank ^ 1);   //Old bank is erased by mxconf_erase_spare()
+    return true;
+}
+
+
+/**
+ * Erase MXCONF_ERASE_WORDS words of the spare log bank.
+ */
+bool mxconf_erase_spare(void) {
+    uint16_t end;
+    bool ok = true;
 
-    address = EEPROM_START_ADDRESS + adrOffset;
+    logInit();
 
-    //EEPROM does NOT currently contain valid data.
-    if(readHeader(id, &hdr, address, sizeStruct) == false) {
-        MX_DEBUG("\r\nInvalid Hdr%d in EEPROM, creating new Hdr!", id);
-        hdr.startIncNbr = 0;
+    end = LOG_BANK_ADR(logBank ^ 1) + MXCONF_LOG_BANK_SIZE;
+    if (logErase >= end) {
+        return true;
+    }
+    if ((end - logErase) > (MXCONF_ERASE_WORDS * 4)) {
+        end = logErase + (MXCONF_ERASE_WORDS * 4);
     }
 
-    hdr.structSize = sizeStruct/MXCONF_SIZE_BASE;
-    hdr.dataSize = sizeData;
-    hdr.structID = id;
-    hdr.magicNumber = (adrOffset==MXCONF_ADR_LAST) ? 0xA4 : 0xA5;
-    #if(DEBUG_ENABLE_INFO==1)
-    if(adrOffset==MXCONF_ADR_LAST) {
-        MX_DEBUG_INFO("\r\nLast Structure!");
+    EEP_UNLOCK();
+    for ( ; ok && (logErase < end); logErase += 4) {
+        ok = eepWriteWord(logErase, EEP_ERASED);
     }
-    #endif
+    EEP_LOCK();
 
-    //Increment "Incrementing numbers"
-    hdr.startIncNbr++;
-    endIncNbr = hdr.startIncNbr;
-    endIncNbr++;
+    return ok;
+}
 
-    ////Unlock before we can write
-    HAL_FLASHEx_DATAEEPROM_Unlock();
 
-    //If code below brings errors, this will clear error flag before attempting to write to EEPROM
-    //FLASH_WaitForLastOperation((uint32_t)100); //Wait for last operation for 100ms
+#if defined(MXCONF_EEPROM_SIM)
+/**
+ * Simulated reboot, log state in RAM is lost. Is read from the EEPROM again on next access.
+ */
+void mxconfSimReboot(void) {
+    logInitDone = false;
+    mxconfSimFailAfter = -1;
+}
+#endif
 
-    //Check and Print Flash error
-    //if(__HAL_FLASH_GET_FLAG(FLASH_FLAG_WRPERR)     != RESET) { MX_DEBUG("\r\nFlErr FLASH_FLAG_WRPERR");}
-    //if(__HAL_FLASH_GET_FLAG(FLASH_FLAG_PGAERR)     != RESET) { MX_DEBUG("\r\nFlErr FLASH_FLAG_PGAERR");}
-    //if(__HAL_FLASH_GET_FLAG(FLASH_FLAG_SIZERR)     != RESET) { MX_DEBUG("\r\nFlErr FLASH_FLAG_SIZERR");}
-    //if(__HAL_FLASH_GET_FLAG(FLASH_FLAG_RDERR)      != RESET) { MX_DEBUG("\r\nFlErr FLASH_FLAG_RDERR");}
-    //if(__HAL_FLASH_GET_FLAG(FLASH_FLAG_OPTVERRUSR) != RESET) { MX_DEBUG("\r\nFlErr FLASH_FLAG_OPTVERRUSR");}
-    //if(__HAL_FLASH_GET_FLAG(FLASH_FLAG_OPTVERR)    != RESET) { MX_DEBUG("\r\nFlErr FLASH_FLAG_OPTVERR");}
 
-    //Save header
-    ptr = (uint8_t*)&hdr;
-    for(i=0; i<sizeof(MxConfHdr); i++) {
-        if (eepSaveAndConfirm(address++, *ptr) == false) {
-            status = HAL_ERROR;
-            break;
-        }
-        ptr++;
+/**
+ * Decode "Data Descriptor" entry
+ */
+static void decodeDesc(const uint8_t* p, uint8_t* pType, uint16_t* pSize, uint16_t* pOffset) {
+    *pType = p[0];
+    *pSize = p[1] | ((uint16_t)(p[2] & 0xf0) << 4); //Bits 12-15 of offset are MSB of size
+    *pOffset = ((uint16_t)(p[2] & 0x0f) << 8) | p[3];
+}
+
+
+/**
+ * Copy fields given by old "Data Descriptor" from old structure, to fields given by new "Data Descriptor" in new
+ * structure. Descriptors are matched by index. If a field grew, only the old size is copied. Fields only contained
+ * in new structure are not modified, and keep their default values.
+ */
+static void migrateStruct(const uint8_t* pOldDesc, uint16_t sizeOldDesc, const uint8_t* pOld, uint16_t sizeOld,
+        const uint8_t* pNewDesc, uint8_t* pNew, uint16_t sizeNew) {
+    uint8_t count;
+    uint8_t i;
+    uint8_t oldType, newType;
+    uint16_t oldSize, newSize;
+    uint16_t oldOffset, newOffset;
+    uint16_t size;
+    uint16_t bit;
+
+    count = (pOldDesc[0] < pNewDesc[0]) ? pOldDesc[0] : pNewDesc[0];
+    if (count > ((sizeOldDesc - 1) / sizeof(MxConfDataDesc))) {
+        count = (sizeOldDesc - 1) / sizeof(MxConfDataDesc);
     }
 
-    //Save actual structure
-    if(status != HAL_OK) {
-        MX_DEBUG_INFO("\r\nData=");
-        for (i=0; i<sizeData; i++) {
-            MX_DEBUG_INFO("%02x ", *pSrc);
-            if (eepSaveAndConfirm(address++, *pSrc) == false) {
-                status = HAL_ERROR;
-                break;
+    for (i=0; i<count; i++) {
+        decodeDesc(&pOldDesc[MXCONF_DESC_SIZE(i)], &oldType, &oldSize, &oldOffset);
+        decodeDesc(&pNewDesc[MXCONF_DESC_SIZE(i)], &newType, &newSize, &newOffset);
+        if (oldType != newType) {
+            MX_DEBUG("\r\nDataDesc %d type changed!", i);
+            continue;
+        }
+        size = (oldSize < newSize) ? oldSize : newSize;
+
+        //Copy 8-Bit data given by "Data Descriptor"
+        if (newType == MXCONF_DESC_TYPE_8BIT) {
+            if ((oldOffset + size) > sizeOld) {
+                size = (sizeOld > oldOffset) ? (sizeOld - oldOffset) : 0;
+            }
+            if ((newOffset + size) > sizeNew) {
+                size = (sizeNew > newOffset) ? (sizeNew - newOffset) : 0;
             }
-            pSrc++;
+            memcpy(&pNew[newOffset], &pOld[oldOffset], size);
+        }
+        //Copy 1-Bit data given by "Data Descriptor"
+        else if (newType == MXCONF_DESC_TYPE_1BIT) {
+            for (bit=0; bit<size; bit++) {
+                if (((oldOffset + bit/8) >= sizeOld) || ((newOffset + bit/8) >= sizeNew)) {
+                    break;
+                }
+                if (pOld[oldOffset + bit/8] & (1 << (bit%8))) {
+                    pNew[newOffset + bit/8] |= (1 << (bit%8));
+                }
+                else {
+                    pNew[newOffset + bit/8] &= ~(1 << (bit%8));
+                }
+            }
+        }
+        else {
+            MX_DEBUG("\r\nERR: DataDesc Type NOT supported!");
         }
     }
+}
 
-    //Save "Data Description" if given.
-    if((status != HAL_OK) && (sizeDataDsc!=0)) {
-        //address = EEPROM_START_ADDRESS + adrOffset + sizeData;    //address will already have this value = byte following data(sizeData)
 
-        //Get size of "Data Description". First byte points to number of MxConfDataDesc structures to follow
-        while(sizeDataDsc-- != 0) {
-            //MX_DEBUG("\r\nDD=%d adr=0x%x", *pDataDsc, address);
-            if (eepSaveAndConfirm(address++, *pDataDsc) == false) {
-                status = HAL_ERROR;
-                break;
-            }
-            pDataDsc++;
+bool mxconf_read_struct(uint8_t id, uint8_t* pDest, uint16_t sizeData, uint16_t adrOffset, uint16_t sizeStruct, uint8_t* pDataDsc) {
+    uint8_t desc[MXCONF_MAX_DESC_SIZE];     //"Data Descriptor" in EEPROM
+    uint8_t old[MXCONF_MAX_DATA];           //Structure in EEPROM, if it has old layout
+    uint16_t descLen;
+    uint16_t sizeOld;
+    MxConfHdr hdr;
+
+    MX_DEBUG_INFO("\r\nRead Structure %d!", id);
+    logInit();
+
+    //Compare "Data Descriptor" in EEPROM with current one. If EEPROM has none, it was saved with current layout
+    descLen = logReplayDesc(id, desc, sizeof(desc));
+    if ((pDataDsc == 0) || (descLen == 0)
+            || ((descLen == MXCONF_DESC_SIZE(*pDataDsc)) && (memcmp(desc, pDataDsc, descLen) == 0))) {
+        if (logReplay(id, pDest, 0, sizeData) != 0) {
+            return true;    //OK
         }
     }
+    else {
+        //Saved by firmware with different layout. Only migrate fields, and save in new layout
+        memset(old, 0, sizeof(old));
+        sizeOld = logReplay(id, old, 0, sizeof(old));
+        migrateStruct(desc, (descLen < sizeof(desc)) ? descLen : sizeof(desc), old, sizeOld, pDataDsc, pDest, sizeData);
+        MX_DEBUG("\r\nMxConf%d migrated to new layout", id);
+        mxconf_save_struct(id, pDest, sizeData, adrOffset, sizeStruct, pDataDsc);
+        return true;    //OK
+    }
 
-    //Save "Incrementing number at end of structure"
-    if(status != HAL_OK) {
-        address = EEPROM_START_ADDRESS + adrOffset + sizeStruct - 1;
-        if (eepSaveAndConfirm(address++, endIncNbr) == false) {
-            status = HAL_ERROR;
+    //Log does not contain structure. Check if old firmware saved it at fixed address
+    if(readHeader(id, &hdr, adrOffset, sizeStruct) == false) {
+        MX_DEBUG("\r\nMxConf%d Invalid!", id);
+        //Save structure again. This should save correct version of structure!
+        mxconf_save_struct(id, pDest, sizeData, adrOffset, sizeStruct, pDataDsc);
+        return false;
+    }
+
+    //Copy data following header. Old structure could be smaller than current one
+    memcpy(pDest, (const void*)EEP_PTR(adrOffset + sizeof(MxConfHdr)), (hdr.dataSize < sizeData) ? hdr.dataSize : sizeData);
+
+    //Move it to log
+    MX_DEBUG("\r\nMoving MxConf%d to log", id);
+    mxconf_save_struct(id, pDest, sizeData, adrOffset, sizeStruct, pDataDsc);
+    return true;    //OK
+}
+
+
+bool mxconf_save_struct(uint8_t id, uint8_t* pSrc, uint16_t sizeData, uint16_t adrOffset, uint16_t sizeStruct, uint8_t* pDataDsc) {
+    uint8_t cur[MXCONF_MAX_DESC_SIZE + MXCONF_MAX_DATA];    //Current data in EEPROM
+    uint16_t descLen = 0;   //Size of "Data Descriptor"
+    uint16_t first;
+    uint16_t last;
+    uint16_t i;
+
+    MX_DEBUG_INFO("\r\nSave Struct %d", id);
+
+    if (pDataDsc != 0) {
+        descLen = MXCONF_DESC_SIZE(*pDataDsc);
+    }
+
+    if ((sizeData > MXCONF_MAX_DATA) || (descLen > MXCONF_MAX_DESC_SIZE) || (id >= MXCONF_ID_COUNT)) {
+        MX_DEBUG("\r\nERR: MxConf%d too big!", id);
+        return false;
+    }
+
+    logInit();
+
+    //If "Data Descriptor" in EEPROM differs(or there is none), save it with whole structure in a single record
+    if (descLen != 0) {
+        if ((logReplayDesc(id, cur, MXCONF_MAX_DESC_SIZE) != descLen) || (memcmp(cur, pDataDsc, descLen) != 0)) {
+            memcpy(cur, pDataDsc, descLen);
+            memcpy(&cur[descLen], pSrc, sizeData);
+            return logAppend(MXCONF_REC_DESC, id, 0, descLen + sizeData, cur, sizeData);
         }
     }
 
-    HAL_FLASHEx_DATAEEPROM_Lock();      //Lock again
+    //If log does not contain structure, or it has a different size, save whole structure
+    if (logReplay(id, cur, 0, sizeData) != sizeData) {
+        return logAppend(MXCONF_REC_DATA, id, 0, sizeData, pSrc, sizeData);
+    }
 
-    if (status==HAL_OK) {
-        MX_DEBUG("\r\nSaved MxConfig%d to EEPROM", id);
+    //Only save changed bytes. Changes closer than a record header are saved in the same record
+    i = 0;
+    while (i < sizeData) {
+        if (cur[i] == pSrc[i]) {
+            i++;
+            continue;
+        }
+        first = last = i;
+        for (i++; (i < sizeData) && ((uint16_t)(i - last) <= sizeof(MxConfRec)); i++) {
+            if (cur[i] != pSrc[i]) {
+                last = i;
+            }
+        }
+        if (logAppend(MXCONF_REC_DATA, id, first, last - first + 1, &pSrc[first], sizeData) == false) {
+            return false;
+        }
+        i = last + 1;
     }
 
-    return (status==HAL_OK)?true:false;    //OK
+    MX_DEBUG("\r\nSaved MxConfig%d to EEPROM", id);
+    return true;    //OK
 }
 
+
 /**
- * Read header
+ * Read header of structure saved at fixed address by old firmware
  * @return True if OK, else false
  */
-bool readHeader(uint8_t id, MxConfHdr* pHdr, uint32_t address, uint16_t sizeStruct) {
+bool readHeader(uint8_t id, MxConfHdr* pHdr, uint16_t adrOffset, uint16_t sizeStruct) {
     uint8_t* pEeprom;
     uint8_t* pDst;
     uint8_t endIncNbr;
     //Size of structure in EEPROM. If EEPROM contains data from older firmware, it can be smaller than given sizeStruct!
     uint16_t eepStructSize;
 
-    pEeprom = (uint8_t*)address;
-    MX_DEBUG_INFO("\r\nRead Header at 0x%x", address);
+    pEeprom = (uint8_t*)EEP_PTR(adrOffset);
+    MX_DEBUG_INFO("\r\nRead Header at 0x%x", adrOffset);
 
     //Get header
     pDst = (uint8_t*)pHdr;
@@ -324,8 +715,8 @@ bool readHeader(uint8_t id, MxConfHdr* pHdr, uint32_t address, uint16_t sizeStru
     }
 
     //Increment to "Incrementing number at end of structure"
-    pEeprom = (uint8_t*)(address + eepStructSize - 1);   //Update pointer to point to last byte of structure
-    MX_DEBUG_INFO("\r\nRead endIncNbr at 0x%x", (uint32_t)pEeprom);
+    pEeprom = (uint8_t*)EEP_PTR(adrOffset + eepStructSize - 1);   //Update pointer to point to last byte of structure
+    MX_DEBUG_INFO("\r\nRead endIncNbr at 0x%x", adrOffset + eepStructSize - 1);
     endIncNbr = *pEeprom;
 
     //Check endIncNbr is 1 larger than startIncNbr
@@ -337,43 +728,3 @@ bool readHeader(uint8_t id, MxConfHdr* pHdr, uint32_t address, uint16_t sizeStru
 
     return true;
 }
-
-/**
- * Save and confirm given byte to EEPROM
- * @return True if OK, else false
- */
-bool eepSaveAndConfirm(uint32_t adr, uint8_t value) {
-    HAL_StatusTypeDef status;
-
-    //Check if byte already has requested value
-    if ( *(__IO uint8_t*)adr == value) {
-        return true;    //Nothing to do, return OK
-    }
-
-    //Save byte
-    status = HAL_FLASHEx_DATAEEPROM_Program(FLASH_TYPEPROGRAMDATA_BYTE, adr, value);
-    if(status != HAL_OK) {
-        MX_DEBUG("\r\nEEPROM Save ERR!");
-        return false;
-    }
-
-    //Confirm byte written correctly
-    if ( *(__IO uint8_t*)adr != value) {
-        MX_DEBUG("\r\nEEPROM Save ERR!");
-        return false;
-    }
-    return true;
-}
-
-/**
- * TODO - This function is called when the EEPROM contains "MxConfig Structures" from an older version
- * of firmware. Typically the structures in EEPROM will be smaller than current structures. The following
- * has to be done:
- * - Read last structure from EEPROM
- * - Write last structure to EEPROM. This will be at a higher address than old structure
- * - Do same for all remaining structures (second last, third last, ...., first)
- */
-bool updateAllStructures(void) {
-    MX_DEBUG_INFO("\r\nUpdating all EEPROM Structures!");
-    return true;
-}
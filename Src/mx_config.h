@@ -29,7 +29,7 @@ void infoConfigStructs(void);
 #define MXCONF_DESC_TYPE_8BIT   0xB2
 
 //Type: 0=1bit, 1=8bit, 2=16bit, 3=32bit
-//Offset:
+//Offset: Saved MSB first, see OFFSETOF_MSB() and OFFSETOF_LSB()
 typedef struct MxConfDataDesc_ {
     uint8_t     type;               //0xB1=1bit, 0xB2=8bit - Other possible NOT SUPPORTED types: 0xB3=16bit, 0xB4=32bit
     uint8_t     size;               //Size in 'type'. For example, if type is '1bit', will be number of bit. If size of 8bit, will be number of 8bits...
@@ -44,6 +44,48 @@ typedef struct MxConfHdr_ {
     uint8_t     structID;           //Structure ID = 1(Radio 0), 2, 3, 4 or 5(Radio 5)
 } PACKED MxConfHdr;
 
+//Header of "MxConfig Log" bank. Is written last when bank is made active, bank with highest gen is used.
+typedef struct MxConfBankHdr_ {
+    uint8_t     magic;              //MXCONF_BANK_MAGIC
+    uint8_t     fill;
+    uint16_t    gen;                //Generation, incremented each time log is compacted into other bank
+    uint16_t    genInv;             //Inverted gen, to check header is valid
+    uint16_t    fill2;
+} PACKED MxConfBankHdr;
+
+//Header of "MxConfig Log" record, followed by data padded to multiple of 4 bytes. The first word, containing
+//type, is written last. Erased EEPROM reads 0, so an incomplete record is never seen as valid.
+//A MXCONF_REC_DESC record contains the "Data Descriptor" followed by the whole structure. It is written when the
+//layout of a structure changes, so data and its layout are always committed together.
+typedef struct MxConfRec_ {
+    uint8_t     type;               //MXCONF_REC_DATA or MXCONF_REC_DESC, or 0 if end of log
+    uint8_t     id;                 //Structure ID
+    uint8_t     offset;             //Offset in structure of first data byte
+    uint8_t     len;                //Number of data bytes following header
+    uint16_t    structSize;         //Data size of structure when record was written
+    uint16_t    crc;                //CRC-16 of id, offset, len, structSize and data
+} PACKED MxConfRec;
+
+#define MXCONF_BANK_MAGIC       0xB5
+#define MXCONF_REC_DATA         0xD5
+#define MXCONF_REC_DESC         0xD6
+
+//Size of "Data Descriptor" with given number of MxConfDataDesc structures
+#define MXCONF_DESC_SIZE(count) (1 + ((count) * sizeof(MxConfDataDesc)))
+
+#if defined(MXCONF_EEPROM_SIM)
+//Host simulation of Data EEPROM. Counts program and erase cycles of each 32-bit word
+extern uint8_t  mxconfSimEeprom[EEPROM_SIZE];
+extern uint32_t mxconfSimCycles[EEPROM_SIZE/4];
+extern int32_t  mxconfSimFailAfter;         //Power fails at this word program (0=next), -1 for never
+extern void     (*mxconfSimPowerFail)(void);//Called when power fails, word is half programmed. May not return.
+
+/**
+ * Simulated reboot, state of log in RAM is lost.
+ */
+void mxconfSimReboot(void);
+#endif
+
 //typedef struct MxConfFtr_ {
 //    uint8_t     endIncNbr;          //Incrementing number at end of structure. Must be equal to startIncNbr+1
 //} PACKED MxConfFtr;
@@ -51,13 +93,19 @@ typedef struct MxConfHdr_ {
 
 /**
  * Read "MxConfig Structure" with given ID from Non Volatile Memory. Copies it to given destination.
- * Only 'sizeData' bytes are copied to destination.
+ * Only 'sizeData' bytes are copied to destination. Bytes not contained in EEPROM(for example new members
+ * added by newer firmware) are not modified.
+ * If the "Data Descriptor" saved with the structure differs from pDataDsc, the structure was saved by firmware
+ * with a different layout. Each field given by the old descriptors is then copied to the field given by the
+ * matching new descriptor, and the structure is saved again in the new layout.
+ * If the log does not contain the structure yet, it is read from the fixed address used by old firmware,
+ * and saved to the log.
  *
  * @param id "MxConfig Structure" ID
  * @param pDest Pointer to destination
  * @param sizeData Size of used data in structure. This is NOT the size that is reserved in EEPROM, which is larger.
- * @param adrOffset Offset in Non Volatile memory where structure is located
- * @param sizeStruct Size of structure in Non Volatile memory
+ * @param adrOffset Offset in Non Volatile memory where old firmware saved structure
+ * @param sizeStruct Size of structure in Non Volatile memory used by old firmware
  * @param pDataDsc First byte is number of MxConfDataDesc structures, followed by array of MxConfDataDesc[]
  *
  * @return True if OK, else false
@@ -65,16 +113,24 @@ typedef struct MxConfHdr_ {
 bool mxconf_read_struct(uint8_t id, uint8_t* pDest, uint16_t sizeData, uint16_t adrOffset, uint16_t sizeStruct, uint8_t* pDataDsc = 0);
 
 /**
- * Save given "MxConfig Structure".
+ * Save given "MxConfig Structure". Only bytes that changed are appended to the log. When the log bank is
+ * full, all structures are compacted into the other bank.
  * @param id "MxConfig Structure" ID
  * @param pSrc Pointer to source structure
  * @param sizeData Size of used data in structure. This is NOT the size that is reserved in EEPROM, which is larger.
- * @param adrOffset Offset in Non Volatile memory where structure is located
- * @param sizeStruct Size of structure in Non Volatile memory
+ * @param adrOffset Offset in Non Volatile memory where old firmware saved structure
+ * @param sizeStruct Size of structure in Non Volatile memory used by old firmware
  * @param pDataDsc First byte is number of MxConfDataDesc structures, followed by array of MxConfDataDesc[]
  * @return True if OK, else false
  */
 bool mxconf_save_struct(uint8_t id, uint8_t* pSrc, uint16_t sizeData, uint16_t adrOffset, uint16_t sizeStruct, uint8_t* pDataDsc = 0);
 
+/**
+ * Erase part of the spare log bank, so the next compaction does not have to erase it. Each call erases at most
+ * MXCONF_ERASE_WORDS words, call it regularly from the main loop. Does nothing once the spare bank is erased.
+ * @return True if OK, else false
+ */
+bool mxconf_erase_spare(void);
+
 
 #endif /* MX_APP_CONFIG_H_ */
@@ -29,6 +29,9 @@
 #include "app_defs.h"    //Application defines, must be first include after debugging includes/defines
 #include "mx_usb_cdc.h"
 #include "mx_cmd_buffer.h"
+#include "mx_spsc_buffer.h"
+#include "mx_profile.h"
+#include "mx_metrics.h"
 #include "usb_device.h"
 #include "usbd_cdc_if.h"
 
@@ -40,11 +43,20 @@
 // VARIABLES //////////////////////////////////////////////////////////////////
 uint8_t tempBuf[TEMP_BUF_SIZE];     //Temporary buffer
 
+//Data received by USB interrupt. Is lock free, and moved to rxBufUsb by mx_usbcdc_task() in main loop
+MxSpscBuffer <uint8_t, RX_BUF_USB_ISR_SIZE> rxIsrBufUsb;
+
+static MxCounter mtrUsbRxDrop("usbrxdrop");     //Bytes lost by USB interrupt, rxIsrBufUsb was full
+static MxCounter mtrUsbCmdDrop("usbcmddrop");   //Received commands lost, rxBufUsb was full
+static MxCounter mtrUsbTxDrop("usbtxdrop");     //Replies lost, txBufUsb was full
+static MxCounter mtrUsbTxRetry("usbtxretry");   //CDC_Transmit_FS() failed, is retried
+static MxCounter mtrUsbTxFail("usbtxfail");     //CDC_Transmit_FS() failed all retries, reply lost
+
 
 
 // GLOBAL VARIABLES ///////////////////////////////////////////////////////////
-MxCmdBuffer <RX_BUF_USB_SIZE, RX_BUF_USB_COMMANDS, RX_BUF_USB_COUNTERTYPE> rxBufUsb;
-MxCmdBuffer <TX_BUF_USB_SIZE, TX_BUF_USB_COMMANDS, TX_BUF_USB_COUNTERTYPE> txBufUsb;
+MxCmdBuffer <RX_BUF_USB_SIZE, RX_BUF_USB_COMMANDS> rxBufUsb;
+MxCmdBuffer <TX_BUF_USB_SIZE, TX_BUF_USB_COMMANDS> txBufUsb;
 
 
 /** Initialization
@@ -60,11 +72,15 @@ void mx_usbcdc_init(void) {
 }
 
 
+/**
+ * Called from USB interrupt with received data. Only adds data to rxIsrBufUsb, is moved to rxBufUsb in main loop.
+ */
 void mx_usbcdc_receive(uint8_t* Buf, uint32_t *Len) {
-    uint16_t i;
+    //If buffer full, data that does not fit is lost
+    uint32_t added = rxIsrBufUsb.putArray(Buf, *Len);
 
-    for (i = 0; i < *Len; i++) {
-        rxBufUsb.put(Buf[i]);
+    if (added < *Len) {
+        mtrUsbRxDrop.inc(*Len - added);
     }
 }
 
@@ -77,6 +93,16 @@ void mx_usbcdc_task() {
     static int lenRead;
     static uint8_t usbTransmitAttempts = 0;
     int cmdLen;
+    uint16_t len;
+    uint8_t buf[64];
+    MX_PROFILE_SCOPE(MX_PROF_USBCDC_TASK);
+
+    //Move data received by USB interrupt to rxBufUsb
+    while ((len = rxIsrBufUsb.getArray(buf, sizeof(buf))) != 0) {
+        rxBufUsb.putArray(buf, len);
+    }
+    mtrUsbCmdDrop.inc(rxBufUsb.checkBufferFullCount());
+    mtrUsbTxDrop.inc(txBufUsb.checkBufferFullCount());
 
     if(usbTransmitAttempts == 0) {
         if (txBufUsb.hasCommand()) {
@@ -109,9 +135,11 @@ void mx_usbcdc_task() {
 
             //If still more attempts left, try again later
             if (--usbTransmitAttempts!=0) {
+                mtrUsbTxRetry.inc();
                 return; //Return, and try again later
             }
             else {
+                mtrUsbTxFail.inc();
                 MX_DEBUG("\r\nCDC_Transmit_FS() ERR");
             }
         }
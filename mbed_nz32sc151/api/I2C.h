@@ -135,6 +135,15 @@ public:
      */
     void stop(void);
 
+#if DEVICE_I2C_QUEUE
+
+    /** Get the HAL I2C object, for use with the i2c_queue_xxx() functions
+     */
+    i2c_t* get_hal_obj(void) {
+        return &_i2c;
+    }
+#endif
+
 #if DEVICE_I2C_ASYNCH
 
     /** Start non-blocking I2C transfer.
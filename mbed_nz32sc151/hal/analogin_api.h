@@ -30,6 +30,31 @@ void     analogin_init    (analogin_t *obj, PinName pin);
 float    analogin_read    (analogin_t *obj);
 uint16_t analogin_read_u16(analogin_t *obj);
 
+#if DEVICE_ANALOGIN_ASYNC
+
+/** Called from interrupt when an oversampled read is done. A new read can be started from the handler.
+ *  @param context Context given to analogin_read_oversampled()
+ *  @param sum     Sum of all conversion results, each is 12-bit
+ */
+typedef void (*analogin_handler_t)(void *context, uint32_t sum);
+
+/** Start count conversions of the given input, and return without waiting. Conversions are done back to
+ *  back from the ADC interrupt. The blocking read functions first wait for an ongoing read to complete.
+ *  @param obj     The analogin object
+ *  @param count   Number of conversions, 1 to 65535
+ *  @param handler Called from interrupt when done, can be NULL
+ *  @param context Passed to handler
+ *  @return 0 if started, or -1 if the ADC is busy or the pin is invalid
+ */
+int analogin_read_oversampled(analogin_t *obj, uint16_t count, analogin_handler_t handler, void *context);
+
+/** Check if an oversampled read is in progress
+ *  @return non-zero if busy
+ */
+int analogin_busy(void);
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -214,6 +214,56 @@ void i2c_abort_asynch(i2c_t *obj);
 
 /**@}*/
 
+#if DEVICE_I2C_QUEUE
+
+/**
+ * \defgroup QueueI2C Interrupt driven I2C transmit queue
+ * @{
+ */
+
+/** Called from interrupt when a queued transfer is done
+ *  @param context Context given to i2c_queue_write()
+ *  @param result  0 if success, else I2C_ERROR_NO_SLAVE or I2C_ERROR_BUS_BUSY
+ */
+typedef void (*i2c_queue_handler_t)(void *context, int result);
+
+/** Queue a write transfer, and return without waiting for it. The blocking functions first wait for
+ *  all queued transfers to complete.
+ *  @param obj     The I2C object
+ *  @param address 8-bit I2C slave address
+ *  @param prefix  Byte to send before data, or -1 if none
+ *  @param data    Data to send, must remain valid until the handler is called
+ *  @param length  Number of bytes in data
+ *  @param handler Called from interrupt when the transfer is done, can be NULL
+ *  @param context Passed to handler
+ *  @return 0 if queued, or I2C_ERROR_BUS_BUSY if queue is full
+ */
+int  i2c_queue_write(i2c_t *obj, int address, int prefix, const char *data, int length,
+                     i2c_queue_handler_t handler, void *context);
+
+/** Check if queued transfers are still being sent. A transfer queued directly after another one can only be
+ *  started once the STOP of the previous one completed, this is done by this function. Call it regularly while
+ *  transfers are queued.
+ *  @param obj The I2C object
+ *  @return non-zero if busy
+ */
+int  i2c_queue_busy(i2c_t *obj);
+
+/** Wait for all queued transfers to complete. Queue is aborted on timeout.
+ *  @param obj The I2C object
+ *  @return 0 if success, else -1 on timeout
+ */
+int  i2c_queue_wait(i2c_t *obj);
+
+/** Remove all queued transfers, their handlers are called with I2C_ERROR_BUS_BUSY. Also called by i2c_reset().
+ *  @param obj The I2C object
+ */
+void i2c_queue_abort(i2c_t *obj);
+
+/**@}*/
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -46,12 +46,14 @@
 #define DEVICE_INTERRUPTIN      1
 
 #define DEVICE_ANALOGIN         1
+#define DEVICE_ANALOGIN_ASYNC   1
 #define DEVICE_ANALOGOUT        1
 
 #define DEVICE_SERIAL           1
 
 #define DEVICE_I2C              1
 #define DEVICE_I2CSLAVE         1
+#define DEVICE_I2C_QUEUE        1
 
 #define DEVICE_SPI              1
 #define DEVICE_SPISLAVE         1
@@ -89,7 +89,15 @@ void analogin_init(analogin_t *obj, PinName pin)
     }
 }
 
-static inline uint16_t adc_read(analogin_t *obj)
+#if DEVICE_ANALOGIN_ASYNC
+static volatile uint16_t   async_remaining;    // Conversions left of oversampled read, 0 if idle
+static uint32_t            async_sum;
+static analogin_handler_t  async_handler;
+static void               *async_context;
+#endif
+
+// Configure the channel of obj as regular rank 1. Returns 0 if success, -1 if pin has no ADC channel
+static int adc_config_channel(analogin_t *obj)
 {
     ADC_ChannelConfTypeDef sConfig;
 
@@ -158,13 +166,26 @@ static inline uint16_t adc_read(analogin_t *obj)
             sConfig.Channel = ADC_CHANNEL_21;
             break;
         default:
-            return 0;
+            return -1;
     }
 
     sConfig.Rank         = ADC_REGULAR_RANK_1;
     sConfig.SamplingTime = ADC_SAMPLETIME_16CYCLES;
 
     HAL_ADC_ConfigChannel(&AdcHandle, &sConfig);
+    return 0;
+}
+
+static inline uint16_t adc_read(analogin_t *obj)
+{
+#if DEVICE_ANALOGIN_ASYNC
+    // Wait for oversampled read to complete, takes less than a ms
+    while (async_remaining != 0);
+#endif
+
+    if (adc_config_channel(obj) != 0) {
+        return 0;
+    }
 
     HAL_ADC_Start(&AdcHandle); // Start conversion
 
@@ -190,4 +211,57 @@ float analogin_read(analogin_t *obj)
     return (float)value * (1.0f / (float)0xFFF); // 12 bits range
 }
 
+#if DEVICE_ANALOGIN_ASYNC
+
+static void adc_irq(void)
+{
+    ADC_TypeDef *adc = AdcHandle.Instance;
+
+    if ((adc->SR & ADC_SR_EOC) == 0) {
+        return;
+    }
+
+    async_sum += adc->DR;   // Reading DR clears EOC
+
+    if (--async_remaining != 0) {
+        adc->CR2 |= ADC_CR2_SWSTART;    // Start next conversion
+        return;
+    }
+
+    __HAL_ADC_DISABLE_IT(&AdcHandle, ADC_IT_EOC);
+    if (async_handler != NULL) {
+        async_handler(async_context, async_sum);
+    }
+}
+
+int analogin_read_oversampled(analogin_t *obj, uint16_t count, analogin_handler_t handler, void *context)
+{
+    if ((async_remaining != 0) || (count == 0)) {
+        return -1;
+    }
+
+    if (adc_config_channel(obj) != 0) {
+        return -1;
+    }
+
+    async_sum       = 0;
+    async_handler   = handler;
+    async_context   = context;
+    async_remaining = count;
+
+    NVIC_SetVector(ADC1_IRQn, (uint32_t)adc_irq);
+    NVIC_EnableIRQ(ADC1_IRQn);
+    __HAL_ADC_ENABLE_IT(&AdcHandle, ADC_IT_EOC);
+
+    HAL_ADC_Start(&AdcHandle); // Start first conversion
+    return 0;
+}
+
+int analogin_busy(void)
+{
+    return (async_remaining != 0);
+}
+
+#endif // DEVICE_ANALOGIN_ASYNC
+
 #endif
@@ -47,6 +47,263 @@ I2C_HandleTypeDef I2cHandle;
 int i2c1_inited = 0;
 int i2c2_inited = 0;
 
+#if DEVICE_I2C_QUEUE
+
+#include "us_ticker_api.h"
+
+/* Number of queued transfers per I2C bus, must be a power of 2 */
+#define I2C_QUEUE_SIZE      8
+#define I2C_QUEUE_MASK      (I2C_QUEUE_SIZE-1)
+
+/* Maximum time i2c_queue_wait() waits for all queued transfers to be sent, in us */
+#define I2C_QUEUE_TIMEOUT   250000
+
+/* Interrupt driven transmit queue. The transfer at 'tail' is active, new transfers are put at 'head'.
+   Transfers are only added in thread mode, and removed in the I2C interrupts. */
+typedef struct {
+    const char          *data;
+    uint16_t            length;     // Length of data, excluding prefix
+    int16_t             prefix;     // Byte sent before data (SSD1306 control byte for example), or -1 if none
+    uint8_t             address;
+    i2c_queue_handler_t handler;
+    void                *context;
+} i2c_queue_item_t;
+
+typedef struct {
+    i2c_queue_item_t    items[I2C_QUEUE_SIZE];
+    I2C_TypeDef         *i2c;
+    volatile uint8_t    head;
+    volatile uint8_t    tail;
+    volatile uint8_t    active;     // Set while transfer at 'tail' is on the bus, or waiting to be started
+    volatile uint8_t    startPending;   // Transfer at 'tail' waits for STOP of previous transfer to complete
+    uint8_t             inited;
+    uint16_t            pos;        // Bytes of active transfer written to DR, including prefix
+} i2c_queue_t;
+
+static i2c_queue_t i2cQueue[2];
+
+static i2c_queue_t *i2c_queue_get(i2c_t *obj)
+{
+    return &i2cQueue[(obj->i2c == I2C_2) ? 1 : 0];
+}
+
+/* Start transfer at 'tail'. Called with I2C interrupts disabled, or from I2C interrupt.
+   The STOP of the previous transfer has to complete before generating a new START. If it has not, the START is
+   deferred, and generated by i2c_queue_poll(). There is no interrupt for a completed STOP, so it is not waited
+   for here. BTF stays set until the STOP is generated, interrupts are disabled until then. */
+static void i2c_queue_start(i2c_queue_t *q)
+{
+    q->pos = 0;
+    q->active = 1;
+
+    if (q->i2c->CR1 & I2C_CR1_STOP) {
+        q->startPending = 1;
+        q->i2c->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITBUFEN | I2C_CR2_ITERREN);
+        return;
+    }
+    q->startPending = 0;
+    q->i2c->SR1 &= ~I2C_SR1_AF;
+    q->i2c->CR2 |= I2C_CR2_ITEVTEN | I2C_CR2_ITBUFEN | I2C_CR2_ITERREN;
+    q->i2c->CR1 |= I2C_CR1_START;
+}
+
+/* Generate deferred START, if the STOP of the previous transfer has completed. Called in thread mode */
+static void i2c_queue_poll(i2c_queue_t *q)
+{
+    uint32_t primask;
+
+    if (q->startPending == 0) {
+        return;
+    }
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (q->startPending != 0) {
+        i2c_queue_start(q);
+    }
+    __set_PRIMASK(primask);
+}
+
+/* Remove transfer at 'tail' and call it's handler. On error all following transfers are removed too, they
+   most likely depend on this one (SSD1306 window command followed by data for example). */
+static void i2c_queue_complete(i2c_queue_t *q, int result)
+{
+    i2c_queue_item_t *item;
+
+    do {
+        item = &q->items[q->tail];
+        q->tail = (q->tail + 1) & I2C_QUEUE_MASK;
+        if (item->handler != NULL) {
+            item->handler(item->context, result);
+        }
+    } while ((result != 0) && (q->tail != q->head));
+
+    if (q->tail != q->head) {
+        i2c_queue_start(q);
+    } else {
+        q->active = 0;
+        q->startPending = 0;
+        q->i2c->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITBUFEN | I2C_CR2_ITERREN);
+    }
+}
+
+static void i2c_queue_ev_irq(i2c_queue_t *q)
+{
+    I2C_TypeDef *i2c = q->i2c;
+    i2c_queue_item_t *item = &q->items[q->tail];
+    uint32_t sr1 = i2c->SR1;
+    uint16_t total = item->length + ((item->prefix >= 0) ? 1 : 0);
+
+    // EV5 - START sent. Reading SR1 and writing DR clears SB
+    if (sr1 & I2C_SR1_SB) {
+        i2c->DR = I2C_7BIT_ADD_WRITE(item->address);
+        return;
+    }
+
+    // EV6 - Address acknowledged. Reading SR1 and SR2 clears ADDR
+    if (sr1 & I2C_SR1_ADDR) {
+        (void)i2c->SR2;
+        return;
+    }
+
+    // EV8 - DR empty, write next byte
+    if (sr1 & (I2C_SR1_TXE | I2C_SR1_BTF)) {
+        if (q->pos < total) {
+            if ((q->pos == 0) && (item->prefix >= 0)) {
+                i2c->DR = (uint8_t)item->prefix;
+            } else {
+                i2c->DR = (uint8_t)item->data[q->pos - (total - item->length)];
+            }
+            q->pos++;
+        }
+        // EV8_2 - Last byte shifted out
+        else if (sr1 & I2C_SR1_BTF) {
+            i2c->CR1 |= I2C_CR1_STOP;
+            i2c_queue_complete(q, 0);
+        }
+        // Last byte in DR, only BTF interrupt required now
+        else {
+            i2c->CR2 &= ~I2C_CR2_ITBUFEN;
+        }
+    }
+}
+
+static void i2c_queue_er_irq(i2c_queue_t *q)
+{
+    I2C_TypeDef *i2c = q->i2c;
+    uint32_t sr1 = i2c->SR1;
+
+    // Clear error flags
+    i2c->SR1 &= ~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR | I2C_SR1_TIMEOUT);
+
+    if (q->active == 0) {
+        return;
+    }
+
+    // Bus is released after arbitration lost, else generate STOP
+    if ((sr1 & I2C_SR1_ARLO) == 0) {
+        i2c->CR1 |= I2C_CR1_STOP;
+    }
+    i2c_queue_complete(q, (sr1 & I2C_SR1_AF) ? I2C_ERROR_NO_SLAVE : I2C_ERROR_BUS_BUSY);
+}
+
+static void i2c1_ev_irq(void) {i2c_queue_ev_irq(&i2cQueue[0]);}
+static void i2c1_er_irq(void) {i2c_queue_er_irq(&i2cQueue[0]);}
+static void i2c2_ev_irq(void) {i2c_queue_ev_irq(&i2cQueue[1]);}
+static void i2c2_er_irq(void) {i2c_queue_er_irq(&i2cQueue[1]);}
+
+int i2c_queue_write(i2c_t *obj, int address, int prefix, const char *data, int length,
+                    i2c_queue_handler_t handler, void *context)
+{
+    i2c_queue_t *q = i2c_queue_get(obj);
+    i2c_queue_item_t *item;
+    uint32_t primask;
+
+    if (!q->inited) {
+        q->inited = 1;
+        q->i2c = (I2C_TypeDef *)(obj->i2c);
+        if (obj->i2c == I2C_2) {
+            NVIC_SetVector(I2C2_EV_IRQn, (uint32_t)&i2c2_ev_irq);
+            NVIC_SetVector(I2C2_ER_IRQn, (uint32_t)&i2c2_er_irq);
+            NVIC_EnableIRQ(I2C2_EV_IRQn);
+            NVIC_EnableIRQ(I2C2_ER_IRQn);
+        } else {
+            NVIC_SetVector(I2C1_EV_IRQn, (uint32_t)&i2c1_ev_irq);
+            NVIC_SetVector(I2C1_ER_IRQn, (uint32_t)&i2c1_er_irq);
+            NVIC_EnableIRQ(I2C1_EV_IRQn);
+            NVIC_EnableIRQ(I2C1_ER_IRQn);
+        }
+    }
+
+    // Queue full
+    if (((q->head + 1) & I2C_QUEUE_MASK) == q->tail) {
+        return I2C_ERROR_BUS_BUSY;
+    }
+
+    item = &q->items[q->head];
+    item->data = data;
+    item->length = (uint16_t)length;
+    item->prefix = (int16_t)prefix;
+    item->address = (uint8_t)address;
+    item->handler = handler;
+    item->context = context;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    q->head = (q->head + 1) & I2C_QUEUE_MASK;
+    if (q->active == 0) {
+        i2c_queue_start(q);
+    }
+    __set_PRIMASK(primask);
+    i2c_queue_poll(q);
+
+    return 0;
+}
+
+int i2c_queue_busy(i2c_t *obj)
+{
+    i2c_queue_t *q = i2c_queue_get(obj);
+
+    i2c_queue_poll(q);
+    return q->active;
+}
+
+void i2c_queue_abort(i2c_t *obj)
+{
+    i2c_queue_t *q = i2c_queue_get(obj);
+    uint32_t primask;
+
+    if (!q->inited) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (q->active != 0) {
+        if (q->startPending == 0) {
+            q->i2c->CR1 |= I2C_CR1_STOP;
+        }
+        i2c_queue_complete(q, I2C_ERROR_BUS_BUSY);  // Removes all queued transfers
+    }
+    __set_PRIMASK(primask);
+}
+
+int i2c_queue_wait(i2c_t *obj)
+{
+    i2c_queue_t *q = i2c_queue_get(obj);
+    uint32_t start = us_ticker_read();
+
+    while (q->active) {
+        i2c_queue_poll(q);
+        if ((us_ticker_read() - start) > I2C_QUEUE_TIMEOUT) {
+            i2c_queue_abort(obj);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#endif // DEVICE_I2C_QUEUE
+
 void i2c_init(i2c_t *obj, PinName sda, PinName scl)
 {
     // Determine the I2C to use
@@ -93,6 +350,10 @@ void i2c_frequency(i2c_t *obj, int hz)
     I2cHandle.Instance = (I2C_TypeDef *)(obj->i2c);
     int timeout;
 
+#if DEVICE_I2C_QUEUE
+    i2c_queue_wait(obj);
+#endif
+
     // wait before init
     timeout = LONG_TIMEOUT;
     while ((__HAL_I2C_GET_FLAG(&I2cHandle, I2C_FLAG_BUSY)) && (timeout-- != 0));
@@ -156,6 +417,11 @@ int i2c_read(i2c_t *obj, int address, char *data, int length, int stop)
     int count;
     int value;
 
+#if DEVICE_I2C_QUEUE
+    // Queued transfers are sent first
+    i2c_queue_wait(obj);
+#endif
+
     i2c_start(obj);
 
     // Wait until SB flag is set
@@ -206,6 +472,11 @@ int i2c_write(i2c_t *obj, int address, const char *data, int length, int stop)
     int timeout;
     int count;
 
+#if DEVICE_I2C_QUEUE
+    // Queued transfers are sent first
+    i2c_queue_wait(obj);
+#endif
+
     i2c_start(obj);
 
     // Wait until SB flag is set
@@ -292,6 +563,11 @@ void i2c_reset(i2c_t *obj)
 {
     int timeout;
 
+#if DEVICE_I2C_QUEUE
+    // Remove all queued transfers, their handlers are called with an error
+    i2c_queue_abort(obj);
+#endif
+
     // wait before reset
     timeout = LONG_TIMEOUT;
     while ((__HAL_I2C_GET_FLAG(&I2cHandle, I2C_FLAG_BUSY)) && (timeout-- != 0));
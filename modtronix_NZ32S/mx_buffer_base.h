@@ -21,6 +21,72 @@
 #ifndef SRC_MX_BUFFER_BASE_H_
 #define SRC_MX_BUFFER_BASE_H_
 
+#include <stdint.h>
+
+//Returns true if given value is a power of 2
+#define MX_IS_POWER_OF_2(x)     (((x) != 0) && (((x) & ((x) - 1)) == 0))
+
+//Compile time assert. Uses static_assert if available (C++11), else a negative array size causes a compile error.
+#if (__cplusplus >= 201103L)
+    #define MX_STATIC_ASSERT(expr, msg)     static_assert(expr, msg)
+#else
+    #define MX_STATIC_ASSERT_CAT2(a, b)     a##b
+    #define MX_STATIC_ASSERT_CAT(a, b)      MX_STATIC_ASSERT_CAT2(a, b)
+    #define MX_STATIC_ASSERT(expr, msg)     typedef char MX_STATIC_ASSERT_CAT(mx_static_assert_, __LINE__)[(expr) ? 1 : -1] __attribute__((unused))
+#endif
+
+
+/** Selects type A if Cond is true, else type B
+ */
+template<bool Cond, typename A, typename B> struct MxSelectType { typedef A type; };
+template<typename A, typename B> struct MxSelectType<false, A, B> { typedef B type; };
+
+
+/** Smallest unsigned type that can hold given value. For example MxUintFor<256>::type is uint16_t.
+ */
+template<uint32_t MaxValue> struct MxUintFor {
+    typedef typename MxSelectType<(MaxValue <= 0xFFUL), uint8_t,
+            typename MxSelectType<(MaxValue <= 0xFFFFUL), uint16_t, uint32_t>::type>::type type;
+};
+
+
+/** Index arithmetic for a buffer of given size. Uses a divide(modulo) if size is not a power of 2.
+ */
+template<uint32_t BufferSize, bool IsPowerOf2 = MX_IS_POWER_OF_2(BufferSize)>
+struct MxBufferIndex {
+#if (MX_BUFFER_POW2_ONLY == 1)
+    MX_STATIC_ASSERT(IsPowerOf2, "Buffer size must be a power of 2, see MX_BUFFER_POW2_ONLY");
+#endif
+
+    /** Wrap given value to a value from 0 to (BufferSize-1) */
+    static inline uint32_t wrap(uint32_t i) {
+        return i % BufferSize;
+    }
+
+    /** Get number of objects from tail to head. Both must be values from 0 to (BufferSize-1) */
+    static inline uint32_t distance(uint32_t head, uint32_t tail) {
+        //Add BufferSize to prevent unsigned underflow when head has wrapped around
+        return (BufferSize + head - tail) % BufferSize;
+    }
+};
+
+
+/** Index arithmetic for a buffer with a size that is a power of 2. Uses masks.
+ */
+template<uint32_t BufferSize>
+struct MxBufferIndex<BufferSize, true> {
+    MX_STATIC_ASSERT(MX_IS_POWER_OF_2(BufferSize), "Buffer size must be a power of 2");
+
+    static inline uint32_t wrap(uint32_t i) {
+        return i & (BufferSize - 1);
+    }
+
+    static inline uint32_t distance(uint32_t head, uint32_t tail) {
+        return (head - tail) & (BufferSize - 1);
+    }
+};
+
+
 class MxBuffer {
 
 public:
@@ -21,13 +21,20 @@
 #ifndef SRC_MX_CIRCULAR_BUFFER_H_
 #define SRC_MX_CIRCULAR_BUFFER_H_
 
+#include <string.h>
 #include "nz32s_default_config.h"
 #include "mx_buffer_base.h"
 
 /** Templated Circular buffer class
+ *
+ * If BufferSize is a power of 2, all index arithmetic uses masks, else a divide is used. The default CounterType is
+ * the smallest unsigned type that can hold BufferSize.
  */
-template<typename T, uint32_t BufferSize, typename CounterType = uint32_t>
+template<typename T, uint32_t BufferSize, typename CounterType = typename MxUintFor<BufferSize>::type>
 class MxCircularBuffer : public MxBuffer {
+    MX_STATIC_ASSERT(BufferSize <= (CounterType)~((CounterType)0), "MxCircularBuffer CounterType too small for BufferSize");
+    typedef MxBufferIndex<BufferSize> Index;
+
 public:
     MxCircularBuffer() : _head(0), _tail(0), _full(false) {
     }
@@ -48,8 +55,8 @@ public:
         if (isFull()) {
             return false;
         }
-        _pool[_head++] = data;
-        _head %= BufferSize;
+        _pool[_head] = data;
+        _head = Index::wrap(_head + 1);
         if (_head == _tail) {
             _full = true;
         }
@@ -59,24 +66,65 @@ public:
 
     /** Adds given array to the buffer. This function checks if buffer has enough space.
      * If not enough space available, nothing is added, and this function returns 0.
+     * Data is copied with at most 2 memcpy() calls, one up to the end of the buffer, and one for any remaining
+     * data at the start of the buffer.
      *
      * @param buf Source buffer containing array to add to buffer
      * @param bufSize Size of array to add to buffer
      *
-     * @return Returns true if character added to buffer, else false
+     * @return Returns true if array added to buffer, else false
      */
-    bool putArray(uint8_t* buf, uint16_t bufSize) {
-        bool retVal = false;
-        int i;
+    bool putArray(const T* buf, uint16_t bufSize) {
+        CounterType len1;
 
-        if (getFree() < bufSize) {
+        if ((bufSize == 0) || (getFree() < bufSize)) {
             return false;
         }
 
-        for(i=0; i<bufSize; i++) {
-            retVal = retVal | put(buf[i]);
+        len1 = BufferSize - _head;      //Space till end of buffer
+        if (len1 > bufSize) {
+            len1 = bufSize;
+        }
+        memcpy(&_pool[_head], buf, len1 * sizeof(T));
+        memcpy(&_pool[0], &buf[len1], (bufSize - len1) * sizeof(T));
+
+        _head = Index::wrap(_head + bufSize);
+        if (_head == _tail) {
+            _full = true;
+        }
+        return true;
+    }
+
+
+    /** Gets and removes up to given number of objects from the buffer, and writes them to given array.
+     * Data is copied with at most 2 memcpy() calls.
+     *
+     * @param buf Destination buffer
+     * @param bufSize Maximum number of objects to write to destination buffer
+     *
+     * @return Number of objects written to destination buffer
+     */
+    CounterType getArray(T* buf, CounterType bufSize) {
+        CounterType len = getAvailable();
+        CounterType len1;
+
+        if (len > bufSize) {
+            len = bufSize;
+        }
+        if (len == 0) {
+            return 0;
+        }
+
+        len1 = BufferSize - _tail;      //Data till end of buffer
+        if (len1 > len) {
+            len1 = len;
         }
-        return retVal;
+        memcpy(buf, &_pool[_tail], len1 * sizeof(T));
+        memcpy(&buf[len1], &_pool[0], (len - len1) * sizeof(T));
+
+        _tail = Index::wrap(_tail + len);
+        _full = false;
+        return len;
     }
 
 
@@ -87,8 +135,8 @@ public:
     T get() {
         if (!isEmpty()) {
             T retData;
-            retData = _pool[_tail++];
-            _tail %= BufferSize;
+            retData = _pool[_tail];
+            _tail = Index::wrap(_tail + 1);
             _full = false;
             return retData;
         }
@@ -114,7 +162,7 @@ public:
      * @return Object at given offset
      */
     T peekAt(CounterType offset) {
-        return _pool[(offset+_tail)%BufferSize];
+        return _pool[Index::wrap(offset + _tail)];
     }
 
 
@@ -123,7 +171,7 @@ public:
      * @return Object at given offset
      */
     T peekLastAdded() {
-        return _pool[(_head-1)%BufferSize];
+        return _pool[Index::wrap(_head + BufferSize - 1)];
     }
 
 
@@ -134,8 +182,8 @@ public:
      */
     bool getAndCheck(T& data) {
         if (!isEmpty()) {
-            data = _pool[_tail++];
-            _tail %= BufferSize;
+            data = _pool[_tail];
+            _tail = Index::wrap(_tail + 1);
             _full = false;
             return true;
         }
@@ -166,10 +214,7 @@ public:
      */
     CounterType getAvailable() {
         if (_head != _tail) {
-            CounterType avail;
-            avail = _head - _tail;
-            avail %= BufferSize;
-            return avail;
+            return (CounterType)Index::distance(_head, _tail);
         }
 
         //Head=Tail. Can be full or empty
@@ -186,7 +231,6 @@ public:
      * @return Number of free bytes in buffer available for writing data to.
      */
     CounterType getFree() {
-        CounterType free;
         //Full
         if (_full==true) {
             return 0;
@@ -195,9 +239,7 @@ public:
         if(_head == _tail) {
             return BufferSize;
         }
-        free = _tail - _head;
-        free %= BufferSize;
-        return free;
+        return (CounterType)Index::distance(_tail, _head);
     }
 
 
@@ -65,6 +65,7 @@
 // 'Hi^'; is decoded as:
 //  H, i, ^, ^
 
+#include <string.h>
 #include "nz32s_default_config.h"
 #include "mx_buffer_base.h"
 #include "mx_circular_buffer.h"
@@ -100,12 +101,72 @@
 
 
 /** Templated Circular buffer class
+ *
+ * If BufferSize is a power of 2, all index arithmetic uses masks, else a divide is used. The default CounterType is
+ * the smallest unsigned type that can hold BufferSize.
  */
-template<uint32_t BufferSize, uint8_t Commands = 16, typename CounterType = uint32_t>
+template<uint32_t BufferSize, uint8_t Commands = 16, typename CounterType = typename MxUintFor<BufferSize>::type>
 class MxCmdBuffer : public MxBuffer {
+    MX_STATIC_ASSERT(BufferSize <= (CounterType)~((CounterType)0), "MxCmdBuffer CounterType too small for BufferSize");
+    MX_STATIC_ASSERT(BufferSize <= 0x10000UL, "MxCmdBuffer BufferSize too large, command ends are stored as uint16_t");
+    typedef MxBufferIndex<BufferSize> Index;
+
 public:
+    static const uint16_t EQ_OFFSET_NONE = 0xffff;  /* Command does not contain a '=' character */
+    static const uint8_t NAME_DIGIT_NONE = 0xff;    /* Command name does not end with a digit */
+
+    /** Information about a command in the buffer. Is recorded by put() while command is added, so parsing a
+     * command does not have to search the buffer.
+     */
+    struct CmdInfo {
+        uint16_t    eoc;        //Offset in buffer of "end of command" character
+        uint16_t    eqOffset;   //Offset from start of command of first '=' character, or EQ_OFFSET_NONE
+        uint8_t     nameDigit;  //Value(0-9) of last digit of 'name' part, or NAME_DIGIT_NONE
+    };
+
+    /** View of part of a command in the buffer, without copying it. Because buffer is circular, the data can wrap
+     * around the end of the buffer, so is given as 2 spans. The second span is empty(len2=0) if data does not wrap.
+     * Is only valid until the command is removed from the buffer!
+     */
+    struct View {
+        const uint8_t*  p1;
+        uint16_t        len1;
+        const uint8_t*  p2;
+        uint16_t        len2;
+
+        /** Get total length of view */
+        uint16_t length() const {
+            return len1 + len2;
+        }
+
+        /** Get byte at given offset, must be less than length() */
+        uint8_t at(uint16_t offset) const {
+            return (offset < len1) ? p1[offset] : p2[offset - len1];
+        }
+
+        /** Copy view to given buffer, returns number of bytes copied */
+        uint16_t copy(uint8_t* buf, uint16_t bufSize) const {
+            uint16_t n1 = (len1 < bufSize) ? len1 : bufSize;
+            uint16_t n2 = ((len1 + len2) < bufSize) ? len2 : (bufSize - n1);
+            uint16_t i;
+
+            //Names and values are usually short, for these a loop is faster than calling memcpy()
+            if ((n1 + n2) < 16) {
+                for (i = 0; i < (n1 + n2); i++) {
+                    buf[i] = at(i);
+                }
+            }
+            else {
+                memcpy(buf, p1, n1);
+                memcpy(&buf[n1], p2, n2);
+            }
+            return n1 + n2;
+        }
+    };
+
     MxCmdBuffer() : _head(0), _tail(0), _full(false),
-            _errBufFull(0), _dontSaveCurrentCommand(0), _lastCharWasEOF(0), flags(0)
+            _errBufFull(0), _errBufFullCount(0), _dontSaveCurrentCommand(0), _lastCharWasEOF(0),
+            _curLen(0), _curEqOffset(EQ_OFFSET_NONE), _curNameLast(0), flags(0)
     {
         //flags.Val = 0;
     }
@@ -136,24 +197,11 @@ public:
         if (isFull() && (_dontSaveCurrentCommand==false)) {
             _dontSaveCurrentCommand = true;
             _errBufFull = true;
+            _errBufFullCount++;
             MXH_DEBUG("\r\nBuffer full, cmd LOST!");
 
             //Remove all character added for this command. Restore head to last "End of Command" pointer
-            if (cmdEndsBuf.isEmpty() == false) {
-                //Restore head to byte following last "End of Command" pointer
-                CounterType oldHead;
-                oldHead = ((cmdEndsBuf.peekLastAdded()+1) % BufferSize);
-                //Ensure buffer not still full
-                if (oldHead != _head) {
-                    _head = oldHead;
-                    _full = false;
-                }
-            }
-            //If no commands in buffer, set head=tail
-            else {
-                _head = _tail;
-                _full = false;
-            }
+            removeCurrentCommand();
         }
 
         //Check if "End of Command" byte. A command string is terminated with a ';', CR(0x0a='\r') or LF(0x0d='\n') character
@@ -173,16 +221,47 @@ public:
             //Current command is now finished, so reset _dontSaveCurrentCommand
             if (_dontSaveCurrentCommand == true) {
                 _dontSaveCurrentCommand = false;
+                resetCurrentCommandInfo();
                 return false;   //Nothing added
             }
 
-            //Add pointer to "end of command" character
-            cmdEndsBuf.put(_head);
+            //No space to store another command, all data for this command is lost
+            if (cmdInfoBuf.isFull()) {
+                _errBufFull = true;
+                _errBufFullCount++;
+                MXH_DEBUG("\r\nToo many cmds, cmd LOST!");
+                removeCurrentCommand();
+                resetCurrentCommandInfo();
+                return false;   //Nothing added
+            }
+
+            //Add pointer to "end of command" character, and information recorded while adding command
+            CmdInfo info;
+            info.eoc = (uint16_t)_head;
+            info.eqOffset = _curEqOffset;
+            info.nameDigit = ((_curNameLast >= '0') && (_curNameLast <= '9')) ? (_curNameLast - '0') : NAME_DIGIT_NONE;
+            cmdInfoBuf.put(info);
+            resetCurrentCommandInfo();
             //End of command character will be added to buffer below at current _head pointer
             MXH_DEBUG_INFO("\r\nAdded Cmd, EOC=%d", _head);
         }
         else {
             _lastCharWasEOF = false;
+
+            if (_dontSaveCurrentCommand) {
+                return false;
+            }
+
+            //Same as recordCurrentCommandInfo(&c, 1), without the loop
+            if (_curEqOffset == EQ_OFFSET_NONE) {
+                if (c == '=') {
+                    _curEqOffset = _curLen;
+                }
+                else {
+                    _curNameLast = c;
+                }
+            }
+            _curLen++;
         }
 
         if (_dontSaveCurrentCommand) {
@@ -190,8 +269,8 @@ public:
         }
 
         //Add byte to buffer
-        _pool[_head++] = c;
-        _head %= BufferSize;
+        _pool[_head] = c;
+        _head = Index::wrap(_head + 1);
         if (_head == _tail) {
             _full = true;
         }
@@ -239,16 +318,21 @@ public:
      *
      * The checkBufferFullError() function can be used to check if this function caused an error, and command was
      * not added to buffer.
-
+     *
+     * Each run of bytes up to the next "End of Command" character is copied in one go (at most 2 memcpy() calls) if
+     * there is enough space in the buffer. Only the "End of Command" characters, and runs that do not fit, are
+     * added with put().
+     *
      * @param buf Source buffer containing array to add to buffer
      * @param bufSize Size of array to add to buffer
      *
      * @return Returns true if something added to buffer, else false. Important to note that all characters added to
      *      current command CAN BE REMOVED if buffer gets full before "End of Command" added to buffer!
      */
-    bool putArray(uint8_t* buf, uint16_t bufSize) {
+    bool putArray(const uint8_t* buf, uint16_t bufSize) {
         bool retVal = 0;
-        int i;
+        uint16_t i = 0;
+        uint16_t run;
 
         //DO NOT DO this check here! This check MUST be done by put() function, because if buffer becomes full before
         //"End of Command" character received, the put() function will remove all current command characters added!
@@ -256,8 +340,36 @@ public:
         //    return 0;
         //}
 
-        for(i=0; i<bufSize; i++) {
-            retVal = retVal | put(buf[i]);
+        while (i < bufSize) {
+            //Get number of bytes till next "End of Command" character
+            run = findEoc(&buf[i], bufSize - i);
+
+            if (run != 0) {
+                _lastCharWasEOF = false;
+
+                //Ignore all data till next "End of Command" character
+                if (_dontSaveCurrentCommand) {
+                    i += run;
+                }
+                //Enough space, copy whole run. The put() function will detect full buffer when next byte is added
+                else if (getFree() >= run) {
+                    recordCurrentCommandInfo(&buf[i], run);
+                    copyIn(&buf[i], run);
+                    i += run;
+                    retVal = true;
+                }
+                //Not enough space, let put() remove current command
+                else {
+                    while (run-- != 0) {
+                        retVal = retVal | put(buf[i++]);
+                    }
+                }
+            }
+
+            //Add "End of Command" character
+            if (i < bufSize) {
+                retVal = retVal | put(buf[i++]);
+            }
         }
         return retVal;
     }
@@ -269,8 +381,8 @@ public:
     uint8_t get() {
         if (!isEmpty()) {
             uint8_t retData;
-            retData = _pool[_tail++];
-            _tail %= BufferSize;
+            retData = _pool[_tail];
+            _tail = Index::wrap(_tail + 1);
             _full = false;
             return retData;
         }
@@ -284,8 +396,8 @@ public:
      */
     bool getAndCheck(uint8_t& data) {
         if (!isEmpty()) {
-            data = _pool[_tail++];
-            _tail %= BufferSize;
+            data = _pool[_tail];
+            _tail = Index::wrap(_tail + 1);
             _full = false;
             return true;
         }
@@ -310,7 +422,7 @@ public:
      * @return Object at given offset
      */
     uint8_t peekAt(CounterType offset) {
-        return _pool[(offset+_tail)%BufferSize];
+        return _pool[Index::wrap(offset + _tail)];
     }
 
     /** Gets the last object added to the buffer, but do NOT remove it.
@@ -318,7 +430,7 @@ public:
      * @return Object at given offset
      */
     uint8_t peekLastAdded() {
-        return _pool[(_head-1)%BufferSize];
+        return _pool[Index::wrap(_head + BufferSize - 1)];
     }
 
     /** Gets and array of given size, and write it to given buffer.
@@ -336,16 +448,19 @@ public:
         CounterType currTail;
         currTail = _tail;
 
+        uint16_t len1;
+
         //Some checks
         if (isEmpty() || (bufSize==0) || (lenReq==0)) {
             return 0;
         }
 
-        do  {
-            buf[lenWritten++] = _pool[currTail];
-            currTail = ((currTail+1)%BufferSize);
-        } while((lenWritten<bufSize) && (lenWritten<lenReq));
+        lenWritten = (lenReq < bufSize) ? (uint16_t)lenReq : bufSize;
 
+        //Copy with at most 2 memcpy() calls, one till end of buffer, and one from start of buffer
+        len1 = ((BufferSize - currTail) < lenWritten) ? (uint16_t)(BufferSize - currTail) : lenWritten;
+        memcpy(buf, &_pool[currTail], len1);
+        memcpy(&buf[len1], &_pool[0], lenWritten - len1);
 
         return lenWritten;
     }
@@ -355,7 +470,7 @@ public:
      * @return True if the buffer has a command, false if not
      */
     bool hasCommand() {
-        return !cmdEndsBuf.isEmpty();
+        return !cmdInfoBuf.isEmpty();
     }
 
     /** Get length of next command in buffer, excluding "end of command" character! For example,
@@ -363,23 +478,77 @@ public:
      * @return Length of next command in buffer
      */
     uint8_t getCommandLength() {
-        CounterType offsetEOC;
-
-        if (cmdEndsBuf.isEmpty()) {
+        if (cmdInfoBuf.isEmpty()) {
             return 0;
         }
 
         //Get offset of "end of command" character of current command in buffer
-        offsetEOC = cmdEndsBuf.peek();
-
-        return ((offsetEOC-_tail) % BufferSize);
+        return Index::distance(cmdInfoBuf.peek().eoc, _tail);
     }
 
     /** Get number of commands waiting in buffer
      * @return Number of commands waiting in buffer
      */
     uint8_t getCommandsAvailable() {
-        return cmdEndsBuf.getAvailable();
+        return cmdInfoBuf.getAvailable();
+    }
+
+    /** Get length of 'name' part of current command. If command has "name=value" format, this is the length of
+     * the 'name' part, else length of whole command(excluding a possible trailing '=' character).
+     *
+     * @return Length of 'name' part of current command
+     */
+    uint16_t getCommandNameLength() {
+        uint16_t eqOffset;
+
+        if (cmdInfoBuf.isEmpty()) {
+            return 0;
+        }
+        eqOffset = cmdInfoBuf.peek().eqOffset;
+        return (eqOffset == EQ_OFFSET_NONE) ? getCommandLength() : eqOffset;
+    }
+
+    /** Check if current command has "name=value" format, with a 'name' and 'value' part of at least 1 character.
+     *
+     * @return True if current command has "name=value" format
+     */
+    bool isCommandNameValue() {
+        if (cmdInfoBuf.isEmpty()) {
+            return false;
+        }
+        return getValueOffset(cmdInfoBuf.peek()) != 0;
+    }
+
+    /** If last character of 'name' part of current command is a digit, returns it's value(0-9).
+     *
+     * @return Value of last digit of 'name' part(0-9), or NAME_DIGIT_NONE if it is not a digit
+     */
+    uint8_t getCommandNameDigit() {
+        if (cmdInfoBuf.isEmpty()) {
+            return NAME_DIGIT_NONE;
+        }
+        return cmdInfoBuf.peek().nameDigit;
+    }
+
+    /** Get view of 'name' part of current command, see getCommandNameLength(). Nothing is copied or removed
+     * from the buffer.
+     *
+     * @return View of 'name' part of current command
+     */
+    View getCommandNameView() {
+        return getView(0, getCommandNameLength());
+    }
+
+    /** Get view of 'value' part of current command. Is empty if current command does not have "name=value"
+     * format. Nothing is copied or removed from the buffer.
+     *
+     * @return View of 'value' part of current command
+     */
+    View getCommandValueView() {
+        if (cmdInfoBuf.isEmpty()) {
+            return getView(0, 0);
+        }
+        return getValueView(cmdInfoBuf.peek());
     }
 
     /** If current command has "name=value" format, the 'name' part is returned.
@@ -406,34 +575,18 @@ public:
      *         If false is returned in 'isNameValue', 'buf' contains the whole command string(excluding possible trailing '=' character).
      */
     uint16_t getCommandName(uint8_t* buf, uint16_t bufSize, bool& isNameValue, bool nullTerminate = true) {
-        CounterType offsetEOC;
-        CounterType currTail;
-        uint16_t nameLen = 0;
+        uint16_t nameLen;
         isNameValue=false;
 
         //Some checks
-        if (cmdEndsBuf.isEmpty() || (bufSize==0) || (_pool[_tail]=='=')) {
+        if (cmdInfoBuf.isEmpty() || (bufSize==0)) {
             return 0;
         }
-        offsetEOC = cmdEndsBuf.peek();
-        currTail = _tail;
-
-        //Copy current command string to given buffer, until '=' reached
-        do {
-            buf[nameLen++] = _pool[currTail];
-            currTail = ((currTail+1)%BufferSize);
-            //If next character is '='
-            if(_pool[currTail] == '=') {
-                //Check at least 1 character following '='
-                //Get pointer of character following '=', and ensure it is not "end of command"(offsetEOC). Meaning there is
-                //still at least 1 more character following '='
-                if(((currTail+1)%BufferSize) != offsetEOC) {
-                    isNameValue = true;
-                }
-                break;
-            }
-        } while((currTail!=offsetEOC) && (nameLen<bufSize));
 
+        //Only read command information once, this function is called for each command received
+        CmdInfo info = cmdInfoBuf.peek();
+        isNameValue = (getValueOffset(info) != 0);
+        nameLen = getView(0, (info.eqOffset == EQ_OFFSET_NONE) ? getLength(info) : info.eqOffset).copy(buf, bufSize);
 
         if (nullTerminate) {
             if(nameLen<bufSize) {
@@ -449,61 +602,22 @@ public:
      * Returned string is NULL terminated by default.
      * Nothing is removed from the buffer!
      *
-     * To optimize this function, call getCommandName() before calling this function. The getCommandName() return value(+1)
-     * can be used as 'offset' parameter to this function. This will save this function from searching for '=' character.
-     *
-     *
      * @param buf Destination buffer to write string to
      * @param bufSize Maximum size to write to destination buffer
-     * @param offset Gives offset of value string if known. This can be value(+1) returned by
-     *        getCommandName() function. Use -1 if unknown.
+     * @param offset Not used, offset of 'value' is recorded when command is added to buffer. Is only kept for
+     *        compatibility.
      *
      * @return Size in bytes of returned string
      */
     uint16_t getCommandValue(uint8_t* buf, uint16_t bufSize, uint16_t offset = -1, bool nullTerminate = true) {
-        CounterType offsetEOC;
-        CounterType currTail;
-        uint16_t valueLen = 0;
-        bool foundEq=false;     //'=' character found
+        uint16_t valueLen;
 
         //Some checks
-        if (cmdEndsBuf.isEmpty() || (bufSize==0)) {
+        if (cmdInfoBuf.isEmpty() || (bufSize==0)) {
             return 0;
         }
-        offsetEOC = cmdEndsBuf.peek();  //offset of "end of command" character
-
-        currTail = _tail;
-
-        //If offset was given, it will point to first character of value string
-        if (offset != -1) {
-            //Check offset point somewhere inside current command! Where ((offsetEOC-_tail) % BufferSize) = command length
-            if (offset < ((offsetEOC-_tail)%BufferSize)) {
-                currTail = ((currTail + offset)%BufferSize);    //Add offset to tail
-
-                //If given offset was for first character of 'value', it will NOT point to '='. It will be next character.
-                if(_pool[currTail] != '=') {
-                    //Points to character after '=', indicate '=' has already been found.
-                    foundEq=true;
-                }
-                //ELSE, assume offset for for '=' character. It will be found in step below
-            }
-            else {
-                //currTail = _tail; //Ignore given offset, and search whole command for '='
-                MXH_DEBUG("\r\ngetCommandValue() Offset error!");
-            }
-        }
 
-        do {
-            if (foundEq) {
-                buf[valueLen++] = _pool[currTail];
-            }
-            else {
-                if(_pool[currTail] == '=') {
-                    foundEq=true;
-                }
-            }
-            currTail = ((currTail+1)%BufferSize);
-        } while((currTail != offsetEOC) && (valueLen<bufSize));
+        valueLen = getValueView(cmdInfoBuf.peek()).copy(buf, bufSize);
 
         if (nullTerminate) {
             if(valueLen<bufSize) {
@@ -522,35 +636,32 @@ public:
      * @return Returns true if found, else false
      */
     bool search(uint8_t c, uint16_t* offsetFound) {
-        CounterType offsetEOF;
-        CounterType currTail;
+        const uint8_t* p;
+        View view;
 
         //Get command length
-        if (cmdEndsBuf.isEmpty()) {
+        if (cmdInfoBuf.isEmpty()) {
             return false;
         }
-        offsetEOF = cmdEndsBuf.peek();
-        currTail = _tail;
-        do {
-            if(_pool[currTail] == c) {
-                if (offsetFound!=NULL) {
-                    *offsetFound = (uint16_t)currTail;
-                }
-                return true;
+
+        //Searching for '=' does not require searching buffer
+        if ((c == '=') && (cmdInfoBuf.peek().eqOffset != EQ_OFFSET_NONE)) {
+            if (offsetFound!=NULL) {
+                *offsetFound = (uint16_t)Index::wrap(_tail + cmdInfoBuf.peek().eqOffset);
+            }
+            return true;
+        }
+
+        view = getView(0, getCommandLength());
+        if ((p = (const uint8_t*)memchr(view.p1, c, view.len1)) == NULL) {
+            p = (const uint8_t*)memchr(view.p2, c, view.len2);
+        }
+        if (p != NULL) {
+            if (offsetFound!=NULL) {
+                *offsetFound = (uint16_t)(p - _pool);
             }
-            currTail = ((currTail+1)%BufferSize);
-        } while(currTail != offsetEOF);
-
-//        CounterType i;
-//        CounterType cmdLen;
-//        cmdLen = (offsetEOF-_tail) % BufferSize;
-//        for (i=0; i<cmdLen; i++) {
-//            if(_pool[(i+_tail)%BufferSize] == c) {
-//            //if(peekAt(i)==c) {
-//                offsetFound = (uint16_t)i;
-//                return true;
-//            }
-//        }
+            return true;
+        }
         return false;
     }
 
@@ -575,10 +686,7 @@ public:
      */
     CounterType getAvailable() {
         if (_head != _tail) {
-            CounterType avail;
-            avail = _head - _tail;
-            avail %= BufferSize;
-            return avail;
+            return (CounterType)Index::distance(_head, _tail);
         }
 
         //Head=Tail. Can be full or empty
@@ -595,7 +703,6 @@ public:
      * @return Number of free bytes in buffer available for writing data to.
      */
     CounterType getFree() {
-        CounterType free;
         //Full
         if (_full==true) {
             return 0;
@@ -604,9 +711,7 @@ public:
         if(_head == _tail) {
             return BufferSize;
         }
-        free = _tail - _head;
-        free %= BufferSize;
-        return free;
+        return (CounterType)Index::distance(_tail, _head);
     }
 
     /** Replaces any LF or CR characters with an "End of Command" character = ';'
@@ -630,6 +735,15 @@ public:
         return retVal;
     }
 
+    /** Get number of commands lost because buffer was full. It resets the count
+     * @return Number of commands lost since last time this function was called
+     */
+    uint16_t checkBufferFullCount() {
+        uint16_t retVal = _errBufFullCount;
+        _errBufFullCount = 0;
+        return retVal;
+    }
+
     /** Reset the buffer
      */
     void reset() {
@@ -637,32 +751,194 @@ public:
         _tail = 0;
         _full = false;
         _errBufFull = false;
+        _errBufFullCount = 0;
         _dontSaveCurrentCommand = false;
+        resetCurrentCommandInfo();
+        cmdInfoBuf.reset();
     }
 
     /** Remove a command from buffer
      */
     void removeCommand() {
-        if (cmdEndsBuf.isEmpty()) {
+        CmdInfo info;
+
+        if (cmdInfoBuf.getAndCheck(info) == false) {
             return;
         }
 
         //MXH_DEBUG("\r\nRemoving Cmd");
 
         //Set tail = "end of command" character + 1. This is first character of next command
-        _tail = (cmdEndsBuf.get()+1) % BufferSize;
+        _tail = Index::wrap(info.eoc + 1);
         _full = false;
     }
 
 private:
+    /** Record information about current command for given bytes added to it. Must not contain "End of Command"
+     * characters.
+     *
+     * @param buf Bytes added to current command
+     * @param len Number of bytes
+     */
+    void recordCurrentCommandInfo(const uint8_t* buf, uint16_t len) {
+        uint16_t i;
+
+        //Names are short, a loop is faster than calling memchr()
+        if (_curEqOffset == EQ_OFFSET_NONE) {
+            for (i = 0; i < len; i++) {
+                if (buf[i] == '=') {
+                    _curEqOffset = _curLen + i;
+                    break;
+                }
+                _curNameLast = buf[i];
+            }
+        }
+        _curLen += len;
+    }
+
+    /** Get length of given command, excluding "end of command" character. Must be the current command.
+     */
+    uint16_t getLength(const CmdInfo& info) {
+        return (uint16_t)Index::distance(info.eoc, _tail);
+    }
+
+    /** Get offset of 'value' part of given command. Is 0 if command does not have "name=value" format, with a
+     * 'name' and 'value' part of at least 1 character. Must be the current command.
+     */
+    uint16_t getValueOffset(const CmdInfo& info) {
+        if ((info.eqOffset == EQ_OFFSET_NONE) || (info.eqOffset == 0) || ((info.eqOffset + 1) >= getLength(info))) {
+            return 0;
+        }
+        return info.eqOffset + 1;
+    }
+
+    /** Get view of 'value' part of given command, is empty if it has none. Must be the current command.
+     */
+    View getValueView(const CmdInfo& info) {
+        uint16_t offset = getValueOffset(info);
+
+        if (offset == 0) {
+            return getView(0, 0);
+        }
+        return getView(offset, getLength(info) - offset);
+    }
+
+    /** Remove all characters added for current command. Restores head to byte following last "End of Command"
+     */
+    void removeCurrentCommand() {
+        if (cmdInfoBuf.isEmpty() == false) {
+            //Restore head to byte following last "End of Command" pointer
+            CounterType oldHead;
+            oldHead = Index::wrap(cmdInfoBuf.peekLastAdded().eoc + 1);
+            //Ensure buffer not still full
+            if (oldHead != _head) {
+                _head = oldHead;
+                _full = false;
+            }
+        }
+        //If no commands in buffer, set head=tail
+        else {
+            _head = _tail;
+            _full = false;
+        }
+    }
+
+    /** Reset information recorded about current command
+     */
+    void resetCurrentCommandInfo() {
+        _curLen = 0;
+        _curEqOffset = EQ_OFFSET_NONE;
+        _curNameLast = 0;
+    }
+
+    /** Get view of given part of current command
+     *
+     * @param offset Offset from start of command
+     * @param len Length
+     */
+    View getView(uint16_t offset, uint16_t len) {
+        View view;
+        CounterType start = Index::wrap(_tail + offset);
+
+        view.p1 = &_pool[start];
+        view.len1 = ((BufferSize - start) < len) ? (uint16_t)(BufferSize - start) : len;
+        view.p2 = &_pool[0];
+        view.len2 = len - view.len1;
+        return view;
+    }
+
+    /** Get number of bytes in given array before the first "End of Command" character(';', CR or LF).
+     * Checks 4 bytes at a time, see "Determine if a word has a zero byte" in Bit Twiddling Hacks.
+     *
+     * @param buf Array to search
+     * @param len Size of array
+     *
+     * @return Offset of first "End of Command" character, or len if none found
+     */
+    static uint16_t findEoc(const uint8_t* buf, uint16_t len) {
+        uint16_t i = 0;
+        uint32_t x;
+
+        #define MX_HASZERO(v) (((v) - 0x01010101UL) & ~(v) & 0x80808080UL)
+        while ((uint16_t)(i + 4) <= len) {
+            memcpy(&x, &buf[i], 4);     //Unaligned safe, compiles to a single load on Cortex-M3
+            if (MX_HASZERO(x ^ 0x3B3B3B3BUL) | MX_HASZERO(x ^ 0x0D0D0D0DUL) | MX_HASZERO(x ^ 0x0A0A0A0AUL)) {
+                break;
+            }
+            i += 4;
+        }
+        #undef MX_HASZERO
+
+        for ( ; i < len; i++) {
+            if ((buf[i] == ';') || (buf[i] == 0x0d) || (buf[i] == 0x0a)) {
+                break;
+            }
+        }
+        return i;
+    }
+
+    /** Copy given array to buffer, there must be enough space! Does NOT check for "End of Command" characters.
+     *
+     * @param buf Source buffer containing array to add to buffer
+     * @param len Size of array to add to buffer
+     */
+    void copyIn(const uint8_t* buf, uint16_t len) {
+        CounterType head = _head;
+        uint16_t len1;
+
+        //Most commands are short, for these a loop is faster than calling memcpy()
+        if (len < 16) {
+            for (len1 = 0; len1 < len; len1++) {
+                _pool[Index::wrap(head + len1)] = buf[len1];
+            }
+        }
+        else {
+            len1 = ((BufferSize - head) < len) ? (uint16_t)(BufferSize - head) : len;
+            memcpy(&_pool[head], buf, len1);
+            memcpy(&_pool[0], &buf[len1], len - len1);
+        }
+
+        head = Index::wrap(head + len);
+        _head = head;
+        if (head == _tail) {
+            _full = true;
+        }
+    }
+
     uint8_t _pool[BufferSize];
     volatile CounterType _head;
     volatile CounterType _tail;
     volatile bool _full;
     volatile bool _errBufFull;
+    volatile uint16_t _errBufFullCount;     //Number of commands lost because buffer was full
     volatile bool _dontSaveCurrentCommand;
     volatile bool _lastCharWasEOF;
 
+    //Information about command currently being added
+    uint16_t _curLen;           //Length of current command
+    uint16_t _curEqOffset;      //Offset of first '=' in current command, or EQ_OFFSET_NONE
+    uint8_t  _curNameLast;      //Last character of 'name' part of current command
+
     union Flags {
         struct {
             uint8_t replaceCrLfWithEoc : 1;         //Replace CR and LF with "End of Command" character = ';'
@@ -673,9 +949,8 @@ private:
     } flags;
 
 public:
-    //Buffer for storing "end of command" locations
-    MxCircularBuffer <uint16_t, Commands, CounterType> cmdEndsBuf;
-    //MxCircularBuffer <uint16_t, Commands, uint16_t> cmdEndsBuf;   //Creates larger code
+    //Buffer for storing "end of command" locations, and information about each command
+    MxCircularBuffer <CmdInfo, Commands> cmdInfoBuf;
 };
 
 #if defined(MXH_DEBUG)
@@ -60,6 +60,96 @@ uint8_t MxHelpers::ascii_hex_nibble_to_byte(uint8_t c) {
 }
 
 
+//Each byte of returned value has bit 7 set if that byte of x is > m and < n. Each byte of x must be < 128.
+//See "Determine if a word has a byte between m and n" in Bit Twiddling Hacks.
+#define SWAR_BETWEEN(x, m, n)   (((0x01010101UL*(127+(n)) - ((x) & 0x7F7F7F7FUL)) & ~(x) & (((x) & 0x7F7F7F7FUL) + 0x01010101UL*(127-(m)))) & 0x80808080UL)
+
+uint16_t MxHelpers::ascii_hex_to_bytes(const uint8_t* src, uint16_t count, uint8_t* dst, bool allowLower) {
+    uint32_t w[2];
+    uint32_t valid;
+    uint32_t lowerMask = allowLower ? 0xFFFFFFFFUL : 0;
+    uint16_t i = 0;
+    uint8_t hi, lo;
+    int j;
+
+    //Process 8 characters(4 bytes) at a time
+    while ((count - i) >= 4) {
+        memcpy(w, &src[i*2], 8);
+
+        //Check all 8 characters are '0'-'9', 'A'-'F' or 'a'-'f'. Without branches, each byte with a valid character
+        //has bit 7 set. Characters >= 128 are invalid.
+        for (j=0; j<2; j++) {
+            valid = SWAR_BETWEEN(w[j], '0'-1, '9'+1) | SWAR_BETWEEN(w[j], 'A'-1, 'F'+1)
+                    | (SWAR_BETWEEN(w[j], 'a'-1, 'f'+1) & lowerMask);
+            valid &= ~w[j];
+            if (valid != 0x80808080UL) {
+                break;
+            }
+        }
+        if (j != 2) {
+            break;  //Process remaining characters one at a time
+        }
+
+        for (j=0; j<2; j++) {
+            //Convert each character to it's value. 'A'-'F' and 'a'-'f' have bit 6 set, and low nibble = value - 9
+            w[j] = (w[j] & 0x0F0F0F0FUL) + ((w[j] >> 6) & 0x01010101UL) * 9;
+            //Combine nibbles, is little endian so first character is in LSB. Results are in byte 0 and 2
+            w[j] = ((w[j] & 0x000F000FUL) << 4) | ((w[j] >> 8) & 0x000F000FUL);
+            dst[i++] = (uint8_t)w[j];
+            dst[i++] = (uint8_t)(w[j] >> 16);
+        }
+    }
+
+    //Remaining characters
+    for ( ; i < count; i++) {
+        if (!allowLower && ((src[i*2] > 'F') || (src[i*2+1] > 'F'))) {
+            break;
+        }
+        hi = ascii_hex_nibble_to_byte(src[i*2]);
+        if (hi == 0xff) {
+            break;
+        }
+        lo = ascii_hex_nibble_to_byte(src[i*2+1]);
+        if (lo == 0xff) {
+            break;
+        }
+        dst[i] = (hi << 4) | lo;
+    }
+    return i;
+}
+
+
+void MxHelpers::bytes_to_ascii_hex(const uint8_t* src, uint16_t len, uint8_t* dst) {
+    uint32_t x, hi, lo, out;
+    uint16_t i = 0;
+
+    //Process 4 bytes at a time
+    for ( ; (uint16_t)(len - i) >= 4; i += 4) {
+        memcpy(&x, &src[i], 4);
+        hi = (x >> 4) & 0x0F0F0F0FUL;
+        lo = x & 0x0F0F0F0FUL;
+
+        //Convert nibbles to ASCII. Adding 6 sets bit 4 for values 10 to 15, they get an extra ('A' - '9' - 1) = 7
+        hi = hi + 0x30303030UL + (((hi + 0x06060606UL) >> 4) & 0x01010101UL) * 7;
+        lo = lo + 0x30303030UL + (((lo + 0x06060606UL) >> 4) & 0x01010101UL) * 7;
+
+        //Interleave, is little endian so first character must be in LSB
+        out = ((hi & 0xFF) | ((hi & 0xFF00) << 8)) | (((lo & 0xFF) | ((lo & 0xFF00) << 8)) << 8);
+        memcpy(&dst[i*2], &out, 4);
+        hi >>= 16;
+        lo >>= 16;
+        out = ((hi & 0xFF) | ((hi & 0xFF00) << 8)) | (((lo & 0xFF) | ((lo & 0xFF00) << 8)) << 8);
+        memcpy(&dst[i*2 + 4], &out, 4);
+    }
+
+    //Remaining bytes
+    for ( ; i < len; i++) {
+        dst[i*2] = high_nibble_to_ascii_hex(src[i]);
+        dst[i*2+1] = low_nibble_to_ascii_hex(src[i]);
+    }
+}
+
+
 uint16_t MxHelpers::cvt_ascii_dec_to_uint16(const char* str, uint8_t* retFlags) {
     uint16_t val = 0;   //Returned value
     uint8_t ret = 0;   //Return retFlags value
@@ -55,7 +55,7 @@
 typedef union
 {
     uint16_t    Val;
-    uint8_t     v[2] __packed;
+    uint8_t     v[2];
     struct
     {
         uint8_t LB;
@@ -211,6 +211,30 @@ public:
      */
     static uint8_t ascii_hex_nibble_to_byte(uint8_t c);
 
+    /**
+     * Converts a "2 character ASCII hex" string to an array of bytes. For example "A1B2" will return 0xA1, 0xB2.
+     * Stops at the first pair of characters that is not a valid "2 character ASCII hex" value.
+     * Processes 4 bytes(8 characters) at a time, using 32-bit operations.
+     *
+     * @param src Source string, must contain at least (2 * count) characters
+     * @param count Maximum number of bytes to write to dst
+     * @param dst Destination buffer
+     * @param allowLower If true, 'a' to 'f' are also valid hex characters. Else only '0'-'9' and 'A'-'F'.
+     *
+     * @return Number of bytes written to dst
+     */
+    static uint16_t ascii_hex_to_bytes(const uint8_t* src, uint16_t count, uint8_t* dst, bool allowLower = true);
+
+    /**
+     * Converts an array of bytes to a "2-character uppercase ASCII hex" string. For example 0xA1, 0xB2 will return
+     * "A1B2". A NULL termination is NOT added. Processes 4 bytes at a time, using 32-bit operations.
+     *
+     * @param src Source array
+     * @param len Number of bytes to convert
+     * @param dst Destination buffer, (2 * len) characters are written to it
+     */
+    static void bytes_to_ascii_hex(const uint8_t* src, uint16_t len, uint8_t* dst);
+
     /**
      * Converts a byte to a "2-character uppercase ASCII hex" value. The 2 bytes
      * are returned in the bytes of the returned WORD_VAL.
@@ -0,0 +1,136 @@
+/**
+ * File:      mx_metrics.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+
+#include "mbed.h"
+#include "mx_metrics.h"
+
+#if (NZ32S_USE_METRICS==1)
+
+#include "mx_tick.h"
+#include "mx_helpers.h"
+
+MxMetric*   MxMetrics::head     = NULL;
+MxMetric*   MxMetrics::tail     = NULL;
+uint16_t    MxMetrics::seq      = 0;
+int         MxMetrics::tmrReset = 0;
+
+
+MxMetric::MxMetric(const char* name, uint8_t type) : name(name), type(type), next(NULL) {
+    //Add to end of registry, so snapshot order is the order of construction
+    if (MxMetrics::head == NULL) {
+        MxMetrics::head = this;
+    }
+    else {
+        MxMetrics::tail->next = this;
+    }
+    MxMetrics::tail = this;
+}
+
+
+void MxHistogram::add(uint32_t val) {
+    uint8_t i = 0;
+    uint32_t primask;
+
+    if (val != 0) {
+        i = 32 - MxHelpers::count_leading_zeros(val);
+        if (i >= MX_METRICS_HIST_BUCKETS) {
+            i = MX_METRICS_HIST_BUCKETS - 1;
+        }
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    buckets[i]++;
+    __set_PRIMASK(primask);
+}
+
+
+uint16_t MxMetrics::header(char* buf, uint16_t size, bool reset) {
+    int len;
+
+    len = snprintf(buf, size, "mtr=%u,%d;", seq, MxTick::elapsed_ms(tmrReset));
+    if (reset) {
+        seq++;
+        tmrReset = MxTick::read_ms();
+    }
+    if (len < 0) {
+        return 0;
+    }
+    return (len < size) ? len : (size - 1);
+}
+
+
+uint16_t MxMetrics::snapshot(MxMetric* m, char* buf, uint16_t size, bool reset) {
+    uint32_t values[MX_METRICS_HIST_BUCKETS];
+    uint8_t count = 1;
+    uint8_t i;
+    uint32_t primask;
+    int len;
+    int n;
+
+    //Copy, and reset if requested. Is done with interrupts disabled, so no events are lost
+    primask = __get_PRIMASK();
+    __disable_irq();
+    switch (m->type) {
+    case MxMetric::COUNTER:
+        values[0] = ((MxCounter*)m)->value;
+        if (reset) {
+            ((MxCounter*)m)->value = 0;
+        }
+        break;
+    case MxMetric::GAUGE:
+        values[0] = (uint32_t)((MxGauge*)m)->value;
+        break;
+    case MxMetric::HISTOGRAM:
+        count = MX_METRICS_HIST_BUCKETS;
+        memcpy(values, ((MxHistogram*)m)->buckets, sizeof(values));
+        if (reset) {
+            memset(((MxHistogram*)m)->buckets, 0, sizeof(values));
+        }
+        break;
+    }
+    __set_PRIMASK(primask);
+
+    len = snprintf(buf, size, "mtr%s=", m->name);
+    for (i=0; (i<count) && (len>=0) && (len<size); i++) {
+        if (m->type == MxMetric::GAUGE) {
+            n = snprintf(&buf[len], size - len, "%ld", (long)(int32_t)values[0]);
+        }
+        else {
+            n = snprintf(&buf[len], size - len, (i==0) ? "%lu" : ",%lu", (unsigned long)values[i]);
+        }
+        len = (n < 0) ? -1 : (len + n);
+    }
+    if ((len >= 0) && (len < size)) {
+        len += snprintf(&buf[len], size - len, ";");
+    }
+
+    //Error, or does not fit in buffer
+    if ((len < 0) || (len >= size)) {
+        if (size != 0) {
+            buf[0] = 0;
+        }
+        return 0;
+    }
+    return len;
+}
+
+#endif  //#if (NZ32S_USE_METRICS==1)
@@ -0,0 +1,220 @@
+/**
+ * File:      mx_metrics.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef MODTRONIX_NZ32S_MX_METRICS_H_
+#define MODTRONIX_NZ32S_MX_METRICS_H_
+
+#include "mbed.h"
+#include "nz32s_default_config.h"
+
+#if (NZ32S_USE_METRICS==1)
+
+/** Base class of all metrics. Each metric is added to the MxMetrics registry when it is constructed, and must
+ * exist for the whole time the program runs(global or static object).
+ */
+class MxMetric {
+public:
+    enum Type {
+        COUNTER = 0,
+        GAUGE,
+        HISTOGRAM
+    };
+
+    /** Constructor
+     * @param name Name used in MxMetrics::snapshot(). Must be a string constant
+     * @param type Type of metric
+     */
+    MxMetric(const char* name, uint8_t type);
+
+    /** Get next metric in registry, or NULL if this is the last one
+     */
+    inline MxMetric* getNext() {
+        return next;
+    }
+
+    inline const char* getName() {
+        return name;
+    }
+
+    inline uint8_t getType() {
+        return type;
+    }
+
+protected:
+    friend class MxMetrics;
+
+    const char*     name;
+    uint8_t         type;
+    MxMetric*       next;
+};
+
+
+/** Counter, counts events. Is reset to 0 by MxMetrics::snapshot() if reset is requested.
+ */
+class MxCounter : public MxMetric {
+public:
+    MxCounter(const char* name) : MxMetric(name, COUNTER), value(0) {
+    }
+
+    /** Add given value to counter. Can be called from interrupts.
+     */
+    inline void inc(uint32_t n = 1) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        value += n;
+        __set_PRIMASK(primask);
+    }
+
+protected:
+    friend class MxMetrics;
+    uint32_t    value;
+};
+
+
+/** Gauge, the last value set. Is not reset by MxMetrics::snapshot().
+ */
+class MxGauge : public MxMetric {
+public:
+    MxGauge(const char* name) : MxMetric(name, GAUGE), value(0) {
+    }
+
+    /** Set current value. Can be called from interrupts.
+     */
+    inline void set(int32_t val) {
+        value = val;
+    }
+
+protected:
+    friend class MxMetrics;
+    volatile int32_t    value;
+};
+
+
+/** Histogram with MX_METRICS_HIST_BUCKETS buckets. Bucket 0 counts 0 values, bucket n counts values from 2^(n-1)
+ * to 2^n-1. The last bucket also counts all larger values. For example bucket 3 counts 4 to 7. Is reset by
+ * MxMetrics::snapshot() if reset is requested.
+ */
+class MxHistogram : public MxMetric {
+public:
+    MxHistogram(const char* name) : MxMetric(name, HISTOGRAM) {
+        memset(buckets, 0, sizeof(buckets));
+    }
+
+    /** Add given value to histogram. Can be called from interrupts.
+     */
+    void add(uint32_t val);
+
+protected:
+    friend class MxMetrics;
+    uint32_t    buckets[MX_METRICS_HIST_BUCKETS];
+};
+
+
+/** Registry of all MxMetric objects. Metrics are read with snapshot(), as ASCII strings that can be sent on the
+ * USB port. If reset is requested, each metric is read and reset in a single interrupt disabled section, so
+ * events are never lost between two snapshots. Interrupts are only disabled while a single metric is copied.
+ *
+ * Example:
+ * @code
+ * static MxCounter mtrTxDone("tx");
+ *
+ * void OnTxDone() {
+ *     mtrTxDone.inc();
+ * }
+ *
+ * void sendMetrics(bool reset) {
+ *     char buf[128];
+ *     MxMetric* m;
+ *     uint16_t len;
+ *
+ *     len = MxMetrics::header(buf, sizeof(buf), reset);     //"mtr=seq,ms;"
+ *     ....
+ *     for (m = MxMetrics::first(); m != NULL; m = m->getNext()) {
+ *         len = MxMetrics::snapshot(m, buf, sizeof(buf), reset);  //For example "mtrtx=12;"
+ *         ....
+ *     }
+ * }
+ * @endcode
+ */
+class MxMetrics {
+public:
+    /** Get first metric in registry, or NULL if none
+     */
+    static inline MxMetric* first() {
+        return head;
+    }
+
+    /** Write snapshot header as NULL terminated string "mtr=<seq>,<ms>;". The seq value is incremented each time
+     * metrics are reset, and ms is the time since the last reset. A host can use it to calculate rates, and to
+     * detect if another client reset the metrics.
+     *
+     * @param buf Destination buffer
+     * @param size Size of buf
+     * @param reset If true, seq is incremented, and ms restarted
+     *
+     * @return Length of string written to buf, excluding NULL terminator
+     */
+    static uint16_t header(char* buf, uint16_t size, bool reset);
+
+    /** Write given metric as NULL terminated string "mtr<name>=<value>;". For histograms, value is a comma
+     * separated list of all buckets.
+     *
+     * @param m Metric to write
+     * @param buf Destination buffer
+     * @param size Size of buf
+     * @param reset If true, counters and histograms are reset
+     *
+     * @return Length of string written to buf, excluding NULL terminator
+     */
+    static uint16_t snapshot(MxMetric* m, char* buf, uint16_t size, bool reset);
+
+protected:
+    friend class MxMetric;
+
+    static MxMetric*    head;
+    static MxMetric*    tail;
+    static uint16_t     seq;
+    static int          tmrReset;
+};
+
+#else   //#if (NZ32S_USE_METRICS==1)
+
+//Metrics disabled, all functions compile to nothing
+class MxCounter {
+public:
+    MxCounter(const char* name) {}
+    inline void inc(uint32_t n = 1) {}
+};
+
+class MxGauge {
+public:
+    MxGauge(const char* name) {}
+    inline void set(int32_t val) {}
+};
+
+class MxHistogram {
+public:
+    MxHistogram(const char* name) {}
+    inline void add(uint32_t val) {}
+};
+
+#endif  //#if (NZ32S_USE_METRICS==1)
+
+#endif /* MODTRONIX_NZ32S_MX_METRICS_H_ */
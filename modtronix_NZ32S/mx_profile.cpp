@@ -0,0 +1,118 @@
+/**
+ * File:      mx_profile.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+
+#include "mx_profile.h"
+
+#if (NZ32S_USE_PROFILER==1)
+
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(MX_PROFILE_HOST)
+#include "mbed.h"
+#endif
+
+//Names of MxProfRegion regions, used in dump()
+static const char* const mxProfNames[MX_PROF_COUNT] = {
+    "dio0",
+    "radio",
+    "usbcmd",
+    "usbcdc",
+    "oled",
+    "menu"
+};
+
+MxProfile::Stats MxProfile::stats[MX_PROF_COUNT];
+
+
+void MxProfile::init() {
+#if !defined(MX_PROFILE_HOST)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    reset();
+}
+
+
+void MxProfile::reset() {
+#if !defined(MX_PROFILE_HOST)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+#endif
+    memset(stats, 0, sizeof(stats));
+#if !defined(MX_PROFILE_HOST)
+    __set_PRIMASK(primask);
+#endif
+}
+
+
+void MxProfile::add(uint8_t region, uint32_t cycles) {
+    Stats* p = &stats[region];
+#if !defined(MX_PROFILE_HOST)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+#endif
+    if ((p->count == 0) || (cycles < p->min)) {
+        p->min = cycles;
+    }
+    if (cycles > p->max) {
+        p->max = cycles;
+    }
+    p->count++;
+    p->total += cycles;
+#if !defined(MX_PROFILE_HOST)
+    __set_PRIMASK(primask);
+#endif
+}
+
+
+uint16_t MxProfile::dump(uint8_t region, char* buf, uint16_t size) {
+    Stats s;
+    int len;
+
+    if (size != 0) {
+        buf[0] = 0;
+    }
+
+    //Take copy, region could be updated by an interrupt
+#if !defined(MX_PROFILE_HOST)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+#endif
+    s = stats[region];
+#if !defined(MX_PROFILE_HOST)
+    __set_PRIMASK(primask);
+#endif
+
+    if (s.count == 0) {
+        return 0;
+    }
+
+    len = snprintf(buf, size, "prf%s=%lu,%lu,%lu,%lu;", mxProfNames[region], (unsigned long)s.count,
+            (unsigned long)s.min, (unsigned long)s.max, (unsigned long)(s.total / s.count));
+    if (len < 0) {
+        return 0;
+    }
+    return (len < size) ? len : (size - 1);
+}
+
+#endif  //#if (NZ32S_USE_PROFILER==1)
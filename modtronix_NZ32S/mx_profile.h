@@ -0,0 +1,138 @@
+/**
+ * File:      mx_profile.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef MODTRONIX_NZ32S_MX_PROFILE_H_
+#define MODTRONIX_NZ32S_MX_PROFILE_H_
+
+#include "nz32s_default_config.h"
+
+//Profiled regions. To add a region, add it before MX_PROF_COUNT, and it's name to mxProfNames[] in mx_profile.cpp
+enum MxProfRegion {
+    MX_PROF_DIO0_IRQ = 0,       //InAir::OnDio0Irq()
+    MX_PROF_RADIO_TASK,         //radioTask() in main.cpp
+    MX_PROF_USB_CMDS,           //processUsbCmds() in main.cpp
+    MX_PROF_USBCDC_TASK,        //mx_usbcdc_task()
+    MX_PROF_OLED_DISPLAY,       //MxSSD1306::display()
+    MX_PROF_MENU_TASK,          //mx_menu_task()
+    MX_PROF_COUNT
+};
+
+#if (NZ32S_USE_PROFILER==1)
+
+#include <stdint.h>
+#if defined(MX_PROFILE_HOST)
+#include <time.h>
+#else
+#include "cmsis.h"
+#endif
+
+/** Cycle counter profiler. Measures the time spent in named regions of code, and keeps the minimum, maximum, mean
+ * and count for each region in a fixed table.
+ *
+ * On the target, the time is measured with the Cortex-M3 DWT cycle counter(CYCCNT), and is given in CPU cycles.
+ * If MX_PROFILE_HOST is defined, clock_gettime() is used, and time is given in nano-seconds.
+ *
+ * Time spent in interrupts that occur inside a region is included in that region's time.
+ *
+ * Example:
+ * @code
+ * void radioTask(uint8_t iRadio) {
+ *     MX_PROFILE_SCOPE(MX_PROF_RADIO_TASK);   //Time until function returns is added to MX_PROF_RADIO_TASK
+ *     ....
+ * }
+ * @endcode
+ */
+class MxProfile {
+public:
+    /** Enable cycle counter, and reset all statistics. Must be called before any region is measured
+     */
+    static void init();
+
+    /** Reset statistics of all regions
+     */
+    static void reset();
+
+    /** Get current cycle counter value. It is a 32-bit counter, use unsigned subtraction to get a time
+     */
+    static inline uint32_t read_cycles() {
+#if defined(MX_PROFILE_HOST)
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint32_t)((ts.tv_sec * 1000000000ULL) + ts.tv_nsec);
+#else
+        return DWT->CYCCNT;
+#endif
+    }
+
+    /** Add given measurement to statistics of given region. Can be called from interrupts.
+     * @param region A MX_PROF_xx define
+     * @param cycles Measured time in cycles
+     */
+    static void add(uint8_t region, uint32_t cycles);
+
+    /** Write statistics of given region to given buffer, as a NULL terminated string with format
+     * "prf<name>=<count>,<min>,<max>,<mean>;". Nothing is written if region was not measured yet.
+     *
+     * @param region A MX_PROF_xx define
+     * @param buf Destination buffer
+     * @param size Size of buf
+     *
+     * @return Length of string written to buf, excluding NULL terminator
+     */
+    static uint16_t dump(uint8_t region, char* buf, uint16_t size);
+
+protected:
+    typedef struct Stats_ {
+        uint32_t    min;
+        uint32_t    max;
+        uint32_t    count;
+        uint64_t    total;
+    } Stats;
+
+    static Stats stats[MX_PROF_COUNT];
+};
+
+
+/** Measures time from construction until it goes out of scope, and adds it to a region. Use MX_PROFILE_SCOPE()
+ * so it compiles to nothing when profiler is disabled.
+ */
+class MxProfileScope {
+public:
+    MxProfileScope(uint8_t region) : region(region), start(MxProfile::read_cycles()) {
+    }
+
+    ~MxProfileScope() {
+        MxProfile::add(region, MxProfile::read_cycles() - start);
+    }
+
+protected:
+    uint8_t     region;
+    uint32_t    start;
+};
+
+#define MX_PROFILE_SCOPE(region) MxProfileScope mxProfileScope_(region)
+
+#else   //#if (NZ32S_USE_PROFILER==1)
+
+#define MX_PROFILE_SCOPE(region)
+
+#endif  //#if (NZ32S_USE_PROFILER==1)
+
+#endif /* MODTRONIX_NZ32S_MX_PROFILE_H_ */
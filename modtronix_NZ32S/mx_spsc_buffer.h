@@ -0,0 +1,248 @@
+/**
+ * File:      mx_spsc_buffer.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef SRC_MX_SPSC_BUFFER_H_
+#define SRC_MX_SPSC_BUFFER_H_
+
+#include <string.h>
+#include "nz32s_default_config.h"
+#include "mx_buffer_base.h"
+
+/** Templated single producer, single consumer circular buffer. It is lock free, and can be written from an
+ * interrupt and read from the main loop (or the other way round) without disabling interrupts.
+ *
+ * - Only the producer may call put() and putArray()
+ * - Only the consumer may call get(), getAndCheck(), getArray(), peek() and peekAt()
+ * - reset() may only be called when producer and consumer are not active
+ *
+ * The head and tail counters are free running, and are only written by the producer and consumer respectively.
+ * BufferSize must be a power of 2, and less than the maximum value of CounterType. The default CounterType is the
+ * smallest unsigned type that can hold (2*BufferSize - 1).
+ *
+ * Example:
+ * @code
+ * MxSpscBuffer<uint8_t, 128> buf;
+ *
+ * void usbRxIsr(uint8_t* pData, uint32_t len) {
+ *     buf.putArray(pData, len);    //Producer, data that does not fit is lost
+ * }
+ *
+ * int main() {
+ *     uint8_t c;
+ *     while(1) {
+ *         while (buf.getAndCheck(c)) {     //Consumer
+ *             ...
+ *         }
+ *     }
+ * }
+ * @endcode
+ */
+template<typename T, uint32_t BufferSize, typename CounterType = typename MxUintFor<BufferSize * 2 - 1>::type>
+class MxSpscBuffer : public MxBuffer {
+    MX_STATIC_ASSERT(MX_IS_POWER_OF_2(BufferSize), "MxSpscBuffer BufferSize must be a power of 2");
+    MX_STATIC_ASSERT(BufferSize <= ((CounterType)~((CounterType)0) / 2 + 1), "MxSpscBuffer CounterType too small for BufferSize");
+
+public:
+    MxSpscBuffer() : _head(0), _tail(0) {
+    }
+
+    ~MxSpscBuffer() {
+    }
+
+
+    /** Adds an object to the buffer. Producer only!
+     *
+     * @param data Data to be pushed to the buffer
+     *
+     * @return Returns true if added to buffer, else false if buffer full
+     */
+    bool put(const T& data) {
+        CounterType head = _head;
+        if ((CounterType)(head - _tail) >= BufferSize) {
+            return false;
+        }
+        _pool[head & (BufferSize-1)] = data;
+        __DMB();    //Data must be written before consumer sees new head
+        _head = head + 1;
+        return true;
+    }
+
+
+    /** Adds given array to the buffer. Producer only! If not enough space available, only the part that fits
+     * is added. Data is copied with at most 2 memcpy() calls.
+     *
+     * @param buf Source buffer containing array to add to buffer
+     * @param bufSize Size of array to add to buffer
+     *
+     * @return Number of objects added to buffer, is less than bufSize if buffer became full
+     */
+    uint32_t putArray(const T* buf, uint32_t bufSize) {
+        CounterType head = _head;
+        uint32_t idx = head & (BufferSize-1);
+        uint32_t len = BufferSize - (CounterType)(head - _tail);
+        uint32_t len1;
+
+        if (len > bufSize) {
+            len = bufSize;
+        }
+        if (len == 0) {
+            return 0;
+        }
+        len1 = ((BufferSize - idx) < len) ? (BufferSize - idx) : len;
+        memcpy(&_pool[idx], buf, len1 * sizeof(T));
+        memcpy(&_pool[0], &buf[len1], (len - len1) * sizeof(T));
+        __DMB();    //Data must be written before consumer sees new head
+        _head = head + (CounterType)len;
+        return len;
+    }
+
+
+    /** Gets and removes an object from the buffer. Consumer only!
+     *
+     * @param data Variable to put read data into
+     * @return True if data was read, false if buffer empty
+     */
+    bool getAndCheck(T& data) {
+        CounterType tail = _tail;
+        if (tail == _head) {
+            return false;
+        }
+        __DMB();    //Read head before reading data
+        data = _pool[tail & (BufferSize-1)];
+        __DMB();    //Data must be read before producer sees new tail
+        _tail = tail + 1;
+        return true;
+    }
+
+
+    /** Gets and removes up to given number of objects from the buffer. Consumer only!
+     * Data is copied with at most 2 memcpy() calls.
+     *
+     * @param buf Destination buffer
+     * @param bufSize Maximum number of objects to write to destination buffer
+     *
+     * @return Number of objects written to destination buffer
+     */
+    uint32_t getArray(T* buf, uint32_t bufSize) {
+        CounterType tail = _tail;
+        uint32_t idx = tail & (BufferSize-1);
+        uint32_t len = (CounterType)(_head - tail);
+        uint32_t len1;
+
+        if (len > bufSize) {
+            len = bufSize;
+        }
+        if (len == 0) {
+            return 0;
+        }
+        __DMB();    //Read head before reading data
+        len1 = ((BufferSize - idx) < len) ? (BufferSize - idx) : len;
+        memcpy(buf, &_pool[idx], len1 * sizeof(T));
+        memcpy(&buf[len1], &_pool[0], (len - len1) * sizeof(T));
+        __DMB();    //Data must be read before producer sees new tail
+        _tail = tail + (CounterType)len;
+        return len;
+    }
+
+
+    /** Gets and removes an object from the buffer. Consumer only! Ensure buffer is NOT empty before calling
+     * this function, if it is, 0 is returned.
+     *
+     * @return Read data
+     */
+    T get() {
+        T data = 0;
+        getAndCheck(data);
+        return data;
+    }
+
+
+    /** Gets an object from the buffer, but do NOT remove it. Consumer only! Ensure buffer is NOT empty before
+     * calling this function!
+     *
+     * @return Read data
+     */
+    T peek() {
+        return _pool[_tail & (BufferSize-1)];
+    }
+
+
+    /** Gets an object from the buffer at given offset, but do NOT remove it. Consumer only! Ensure buffer has
+     * as many objects as the offset requested!
+     *
+     * @param offset Offset of requested object. A value from 0-n, where (n+1) = available objects = getAvailable()
+     * @return Object at given offset
+     */
+    T peekAt(CounterType offset) {
+        return _pool[(CounterType)(_tail + offset) & (BufferSize-1)];
+    }
+
+
+    /** Check if the buffer is empty
+     *
+     * @return True if the buffer is empty, false if not
+     */
+    bool isEmpty() {
+        return _head == _tail;
+    }
+
+
+    /** Check if the buffer is full
+     *
+     * @return True if the buffer is full, false if not
+     */
+    bool isFull() {
+        return (CounterType)(_head - _tail) >= BufferSize;
+    }
+
+
+    /** Get number of available objects in buffer. If called by producer, there might be less. If called by
+     * consumer, there might be more.
+     * @return Number of available objects in buffer
+     */
+    CounterType getAvailable() {
+        return (CounterType)(_head - _tail);
+    }
+
+
+    /** Get number of free objects in buffer. If called by consumer, there might be less. If called by
+     * producer, there might be more.
+     * @return Number of free objects in buffer
+     */
+    CounterType getFree() {
+        return BufferSize - (CounterType)(_head - _tail);
+    }
+
+
+    /** Reset the buffer. Producer and consumer must not be active!
+     */
+    void reset() {
+        _head = 0;
+        _tail = 0;
+    }
+
+
+private:
+    T _pool[BufferSize];
+    volatile CounterType _head;     //Only written by producer
+    volatile CounterType _tail;     //Only written by consumer
+};
+
+#endif /* SRC_MX_SPSC_BUFFER_H_ */
@@ -21,19 +21,100 @@
 
 #include "mbed.h"
 #include "mx_tick.h"
+#include "us_ticker_api.h"
 
-uint16_t    MxTick::countMs     = 1000;
-int32_t     MxTick::tickSec     = 0;
-int32_t     MxTick::tickMs      = 0;
+uint64_t    MxTick::tickUs64    = 0;
+uint64_t    MxTick::tickMs64    = 0;
+uint32_t    MxTick::tickSec     = 0;
+uint32_t    MxTick::lastUs      = 0;
+uint32_t    MxTick::usInMs      = 0;
+uint32_t    MxTick::msInSec     = 0;
 bool        MxTick::running     = 0;
 
 MxTick::MxTick(bool autoInc) {
     if(running==false) {
         running = true;
+        lastUs = us_ticker_read();
         if(autoInc == true) {
+            //Only to catch us_ticker overflows while nothing reads the time
             static Ticker tcr;
-            tcr.attach_us(&MxTick::increment, 1000);
+            tcr.attach_us(&MxTick::update, NZ32S_TICK_KEEPALIVE_US);
         }
     }
 }
 
+
+void MxTick::update() {
+    uint32_t primask = __get_PRIMASK();
+    uint32_t now;
+    uint32_t delta;
+    uint32_t ms;
+
+    __disable_irq();
+    now = us_ticker_read();
+    delta = now - lastUs;   //Correct when us_ticker wraps
+    lastUs = now;
+    tickUs64 += delta;
+
+    //Divisions are only done once every ms, or once for whole time slept
+    usInMs += delta;
+    if (usInMs >= 1000) {
+        ms = usInMs / 1000;
+        usInMs -= ms * 1000;
+        tickMs64 += ms;
+        msInSec += ms;
+        if (msInSec >= 1000) {
+            tickSec += msInSec / 1000;
+            msInSec = msInSec % 1000;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+
+uint64_t MxTick::read_us64() {
+    uint32_t primask = __get_PRIMASK();
+    uint64_t ret;
+
+    __disable_irq();
+    update();
+    ret = tickUs64;
+    __set_PRIMASK(primask);
+    return ret;
+}
+
+
+uint64_t MxTick::read_ms64() {
+    uint32_t primask = __get_PRIMASK();
+    uint64_t ret;
+
+    __disable_irq();
+    update();
+    ret = tickMs64;
+    __set_PRIMASK(primask);
+    return ret;
+}
+
+
+int MxTick::read_ms10() {
+    uint32_t primask = __get_PRIMASK();
+    int ret;
+
+    __disable_irq();
+    update();
+    ret = (int)((tickSec * 100) + (msInSec / 10));
+    __set_PRIMASK(primask);
+    return ret;
+}
+
+
+int MxTick::read_ms100() {
+    uint32_t primask = __get_PRIMASK();
+    int ret;
+
+    __disable_irq();
+    update();
+    ret = (int)((tickSec * 10) + (msInSec / 100));
+    __set_PRIMASK(primask);
+    return ret;
+}
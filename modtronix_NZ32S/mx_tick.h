@@ -22,13 +22,20 @@
 #define MODTRONIX_NZ32S_MX_TICK_H_
 
 #include "nz32s_default_config.h"
+#include "mx_timer_wheel.h"
 
-#define MODTRONIX_NZ32S_MX_TICK_INC MxTick::increment()
+#define MODTRONIX_NZ32S_MX_TICK_INC MxTick::update()
 
-/** A general purpose milli-second and second timer.
+/** A general purpose micro-second, milli-second and second timer.
  *
- * Because the read_ms() function return a 32 bit value, it can be used to time up
- * to a maximum of 2^31-1 millseconds = 596 Hours = 24.8 Days
+ * The time is derived from the 32-bit hardware us_ticker, and extended to a 64-bit monotonic value in software.
+ * There is no periodic interrupt, the time is brought up to date each time it is read. This allows the CPU to
+ * sleep between events. A single keep-alive interrupt every NZ32S_TICK_KEEPALIVE_US ensures a us_ticker overflow
+ * (every 71 minutes) is never missed.
+ *
+ * The 32-bit read_ms() value wraps after 2^31-1 millseconds = 596 Hours = 24.8 Days. Use the expired_ms() and
+ * elapsed_ms() functions to compare times, they give the correct result when read_ms() wraps. Times are then only
+ * limited to 24.8 Days in the future or past. Use read_ms64() for absolute time stamps.
  *
  * Example:
  * @code
@@ -37,7 +44,7 @@
  * #include "mbed.h"
  * #include "mx_tick.h"
  *
- * MxTimer mxTmr;
+ * MxTick mxTick;
  * int tmrLED = 0;
  * DigitalOut led(LED1);
  *
@@ -46,7 +53,7 @@ int main() {
     //Main loop
     while(1) {
         //Flash LED
-        if (mxTmr.read_ms() >= tmrLED) {
+        if (mxTick.expired_ms(tmrLED)) {
             tmrLED += 1000;         //Wait 1000mS before next LED toggle
             led = !led;
         }
@@ -57,66 +64,66 @@ int main() {
 class MxTick {
 
 public:
+    /** Constructor
+     * @param autoInc If true, the keep-alive interrupt is started. If false, update() must be called at least
+     *        once every 71 minutes.
+     */
     MxTick(bool autoInc = true);
 
-    static inline void increment() {
-        tickMs++;
-        if (--countMs == 0) {
-            countMs = 1000;
-            tickSec++;
-        }
-    }
+    /** Bring time up to date with the us_ticker. Is called by all read functions.
+     *
+     * This function is thread save!
+     */
+    static void update();
+
+    /** Get the current 64-bit micro-second time. Does not wrap.
+     *
+     * This function is thread save!
+     *
+     * @return The time in micro-seconds since startup
+     */
+    static uint64_t read_us64();
 
+    /** Get the current 64-bit milli-second time. Does not wrap.
+     *
+     * This function is thread save!
+     *
+     * @return The time in milli-seconds since startup
+     */
+    static uint64_t read_ms64();
 
     /** Get the current 32-bit milli-second tick value.
-     * Because the read_ms() function return a 32 bit value, it can be used to time up
-     * to a maximum of 2^31-1 millseconds = 596 Hours = 24.8 Days
+     * Because the read_ms() function return a 32 bit value, it wraps after 2^31-1 millseconds = 24.8 Days. Use
+     * expired_ms() and elapsed_ms() to compare values.
      *
      * This function is thread save!
      *
      * @return The tick value in milli-seconds
      */
     static inline int read_ms() {
-        return (int)tickMs;
+        update();
+        return (int)(uint32_t)tickMs64;
     }
 
     /** Get the current 32-bit "10 milli-second" tick value. It is incremented each 10ms.
      * Because the read_ms() function return a 32 bit value, it can be used to time up
      * to a maximum of 2^31-1 * 10 millseconds = 5960 Hours = 248 Days
      *
-     * This function is NOT thread save. Takes multiple cycles to calculate value.
-     *
-     * Note this function takes MUCH longer than read_ms() and read_sec().
+     * This function is thread save!
      *
      * @return The tick value in 10 x milli-seconds
      */
-    static int read_ms10() {
-        //For example, if tickMs was 456789, we only want to use the 78 part.
-        //The 456 is seconds, and we get that from tickSec, so don't use it
-        //The 9 is 1xms, and don't need that
-        // 456789 / 10 = 45678
-        // 45678 % 100 = 89
-        return (int)( ((tickMs/10)%100) + (tickSec*100) );
-    }
+    static int read_ms10();
 
     /** Get the current 32-bit "100 milli-second" tick value. It is incremented each 100ms.
      * Because the read_ms() function return a 32 bit value, it can be used to time up
      * to a maximum of 2^31-1 * 100 millseconds = 59600 Hours = 2480 Days = 6.79 Years
      *
-     * This function is NOT thread save. Takes multiple cycles to calculate value.
-     *
-     * Note this function takes MUCH longer than read_ms() and read_sec().
+     * This function is thread save!
      *
      * @return The tick value in 100 x milli-seconds
      */
-    static int read_ms100() {
-        //For example, if tickMs was 456789, we only want to use the 7 part(100 x Ms).
-        //The 456 is seconds, and we get that from tickSec, so don't use it
-        //The 8 is 1xMs, the 7 is 10xMs, and we don't need them
-        // 456789 / 100 = 4567
-        // 45678 % 10 = 7
-        return (int)( ((tickMs/100)%10) + (tickSec*10) );
-    }
+    static int read_ms100();
 
     /** Get the current 32-bit second tick value.
      * Because the read_sec() function return a 32 bit value, it can be used to time up
@@ -127,13 +134,45 @@ public:
      * @return The tick value in seconds
      */
     static inline int read_sec() {
+        update();
         return (int)tickSec;
     }
 
+    /** Check if given read_ms() time has been reached. Is correct when read_ms() wraps, if given time is less
+     * than 24.8 Days in the future.
+     *
+     * @param tmr Time to check, a read_ms() value
+     * @return True if read_ms() is equal to or after given time
+     */
+    static inline bool expired_ms(int tmr) {
+        return (int32_t)((uint32_t)read_ms() - (uint32_t)tmr) >= 0;
+    }
+
+    /** Get milli-seconds elapsed since given read_ms() time. Is correct when read_ms() wraps.
+     *
+     * @param tmr Start time, a read_ms() value
+     * @return Milli-seconds since given time, negative if it is in the future
+     */
+    static inline int elapsed_ms(int tmr) {
+        return (int32_t)((uint32_t)read_ms() - (uint32_t)tmr);
+    }
+
+    /** Get seconds elapsed since given read_sec() time.
+     *
+     * @param tmr Start time, a read_sec() value
+     * @return Seconds since given time, negative if it is in the future
+     */
+    static inline int elapsed_sec(int tmr) {
+        return (int32_t)((uint32_t)read_sec() - (uint32_t)tmr);
+    }
+
 protected:
-    static uint16_t countMs;
-    static int32_t  tickSec;
-    static int32_t  tickMs;
+    static uint64_t tickUs64;   //Time in us
+    static uint64_t tickMs64;   //Time in ms
+    static uint32_t tickSec;    //Time in seconds
+    static uint32_t lastUs;     //us_ticker value of last update()
+    static uint32_t usInMs;     //us not yet added to tickMs64
+    static uint32_t msInSec;    //ms not yet added to tickSec
     static bool     running;
 };
 
@@ -0,0 +1,111 @@
+/**
+ * File:      mx_timer_wheel.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+
+#include "mbed.h"
+#include "mx_timer_wheel.h"
+
+#if (NZ32S_USE_TIMER_WHEEL==1)
+
+#if ((MX_TIMER_WHEEL_SLOTS & (MX_TIMER_WHEEL_SLOTS-1)) != 0)
+#error "MX_TIMER_WHEEL_SLOTS must be a power of 2"
+#endif
+
+MxTimeout*  MxTimerWheel::slots[MX_TIMER_WHEEL_SLOTS];
+uint32_t    MxTimerWheel::current = 0;
+uint16_t    MxTimerWheel::count = 0;
+Ticker      MxTimerWheel::tcr;
+
+
+void MxTimerWheel::insert(MxTimeout* t, uint32_t ms) {
+    MxTimeout** pSlot;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    //If the ticker is running, we are somewhere between two ticks, and the next tick can come at any time. Add
+    //a tick, so the timeout is never called early. If it is not running, it is started below, with the first
+    //tick exactly 1ms from now.
+    t->expires = current + ms + (count==0 ? 0 : 1);
+    pSlot = &slots[t->expires & (MX_TIMER_WHEEL_SLOTS-1)];
+    t->prev = NULL;
+    t->next = *pSlot;
+    if (t->next != NULL) {
+        t->next->prev = t;
+    }
+    *pSlot = t;
+    t->active = true;
+
+    //Start ticker for first timeout. Is stopped in tick() when wheel is empty
+    if (count++ == 0) {
+        tcr.attach_us(&MxTimerWheel::tick, 1000);
+    }
+    __set_PRIMASK(primask);
+}
+
+
+void MxTimerWheel::remove(MxTimeout* t) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (t->active) {
+        if (t->prev != NULL) {
+            t->prev->next = t->next;
+        }
+        else {
+            slots[t->expires & (MX_TIMER_WHEEL_SLOTS-1)] = t->next;
+        }
+        if (t->next != NULL) {
+            t->next->prev = t->prev;
+        }
+        t->next = NULL;
+        t->prev = NULL;
+        t->active = false;
+        count--;
+    }
+    __set_PRIMASK(primask);
+}
+
+
+void MxTimerWheel::tick() {
+    MxTimeout* t;
+
+    current++;
+
+    //Only timeouts in this slot can expire. Timeouts longer than a full rotation stay in slot until they expire.
+    //Search slot again after each callback, because callback could have attached or detached other timeouts.
+    do {
+        for (t = slots[current & (MX_TIMER_WHEEL_SLOTS-1)]; t != NULL; t = t->next) {
+            if ((int32_t)(t->expires - current) <= 0) {
+                break;
+            }
+        }
+        if (t != NULL) {
+            remove(t);
+            t->function.call();
+        }
+    } while (t != NULL);
+
+    //No more timeouts, stop ticker until next insert()
+    if (count == 0) {
+        tcr.detach();
+    }
+}
+
+#endif  //#if (NZ32S_USE_TIMER_WHEEL==1)
@@ -0,0 +1,230 @@
+/**
+ * File:      mx_timer_wheel.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef MODTRONIX_NZ32S_MX_TIMER_WHEEL_H_
+#define MODTRONIX_NZ32S_MX_TIMER_WHEEL_H_
+
+#include "mbed.h"
+#include "nz32s_default_config.h"
+
+#if (NZ32S_USE_TIMER_WHEEL==1)
+
+class MxTimeout;
+
+/** Timer wheel, with MX_TIMER_WHEEL_SLOTS slots of 1ms. Each slot contains a list of MxTimeout objects. Adding
+ * and removing a timeout takes a constant time, independent of the number of active timeouts.
+ *
+ * The tick() function is called every 1ms by a mbed Ticker, that is only running while the wheel contains
+ * timeouts. When no timeouts are attached, the wheel causes no interrupts. All MxTimeout callbacks are called
+ * from this interrupt.
+ */
+class MxTimerWheel {
+public:
+    /** Add given timeout to the wheel. Must not already be in the wheel!
+     * @param t Timeout to add
+     * @param ms Time in milli-seconds, minimum 1. Timeout is called after at least this time.
+     */
+    static void insert(MxTimeout* t, uint32_t ms);
+
+    /** Remove given timeout from the wheel. Does nothing if not in the wheel.
+     * @param t Timeout to remove
+     */
+    static void remove(MxTimeout* t);
+
+    /** Advance the wheel by 1ms, and call all timeouts that expired. Is called by the wheel Ticker
+     */
+    static void tick();
+
+    /** Get the current wheel time, in milli-seconds
+     */
+    static inline uint32_t now() {
+        return current;
+    }
+
+protected:
+    static MxTimeout*   slots[MX_TIMER_WHEEL_SLOTS];
+    static uint32_t     current;
+    static uint16_t     count;      //Number of timeouts in wheel
+    static Ticker       tcr;
+};
+
+
+/** A timeout, with the same interface as the mbed Timeout class. It uses the MxTimerWheel, and has a 1ms
+ * resolution. Times given in micro seconds are rounded up to the next milli-second. A timeout is never called
+ * early, but can be called up to 1ms late.
+ *
+ * Example:
+ * @code
+ * MxTimeout tmo;
+ *
+ * void onTimeout() {
+ *     //Called from interrupt 100ms after attach
+ * }
+ *
+ * tmo.attach_ms(&onTimeout, 100);
+ * @endcode
+ */
+class MxTimeout {
+public:
+    MxTimeout() : next(NULL), prev(NULL), expires(0), active(false) {
+    }
+
+    virtual ~MxTimeout() {
+        detach();
+    }
+
+    /** Attach a function to be called after given time. If already attached, it is rescheduled.
+     * @param fptr Function to call
+     * @param ms Time in milli-seconds
+     */
+    void attach_ms(void (*fptr)(void), uint32_t ms) {
+        detach();
+        function.attach(fptr);
+        schedule(ms);
+    }
+
+    /** Attach a member function to be called after given time. If already attached, it is rescheduled.
+     * @param tptr Pointer to object to call the member function on
+     * @param mptr Pointer to member function to call
+     * @param ms Time in milli-seconds
+     */
+    template<typename T>
+    void attach_ms(T* tptr, void (T::*mptr)(void), uint32_t ms) {
+        detach();
+        function.attach(tptr, mptr);
+        schedule(ms);
+    }
+
+    /** Same as attach_ms(), but time is given in micro-seconds. Is rounded up to next milli-second.
+     */
+    void attach_us(void (*fptr)(void), uint32_t us) {
+        attach_ms(fptr, us_to_ms(us));
+    }
+
+    /** Same as attach_ms(), but time is given in micro-seconds. Is rounded up to next milli-second.
+     */
+    template<typename T>
+    void attach_us(T* tptr, void (T::*mptr)(void), uint32_t us) {
+        attach_ms(tptr, mptr, us_to_ms(us));
+    }
+
+    /** Cancel the timeout. Does nothing if not attached.
+     */
+    void detach() {
+        MxTimerWheel::remove(this);
+    }
+
+    /** Returns true if timeout is attached, and has not expired yet
+     */
+    bool isActive() {
+        return active;
+    }
+
+protected:
+    friend class MxTimerWheel;
+
+    void schedule(uint32_t ms) {
+        //Minimum of 1ms, else it will only be called after a full wheel rotation
+        MxTimerWheel::insert(this, (ms==0 ? 1 : ms));
+    }
+
+    static inline uint32_t us_to_ms(uint32_t us) {
+        return (us / 1000) + ((us % 1000) != 0 ? 1 : 0);
+    }
+
+    MxTimeout*      next;
+    MxTimeout*      prev;
+    uint32_t        expires;    //MxTimerWheel::now() value when this timeout expires
+    volatile bool   active;
+    FunctionPointer function;
+};
+
+
+
+/** A polled timer, for main loop code. Uses the MxTimerWheel, so no time has to be read when checking it.
+ *
+ * Example:
+ * @code
+ * MxPollTimer tmr;
+ *
+ * tmr.start_ms(250);
+ * ...
+ * if (tmr.expired()) {
+ *     //At least 250ms passed
+ * }
+ * @endcode
+ */
+class MxPollTimer : protected MxTimeout {
+public:
+    /** Start timer, expired() will return true after given time. If already running, it is restarted.
+     * @param ms Time in milli-seconds
+     */
+    void start_ms(uint32_t ms) {
+        detach();
+        schedule(ms);
+    }
+
+    /** Stop timer, expired() will return true
+     */
+    void stop() {
+        detach();
+    }
+
+    /** Returns true if timer expired, or was never started
+     */
+    bool expired() {
+        return !active;
+    }
+};
+
+#else   //#if (NZ32S_USE_TIMER_WHEEL==1)
+
+/** A polled timer, for main loop code. Timer wheel is disabled, so this version reads the us_ticker.
+ * Maximum time is about 35 minutes.
+ */
+class MxPollTimer {
+public:
+    MxPollTimer() : expires(0), running(false) {
+    }
+
+    void start_ms(uint32_t ms) {
+        expires = us_ticker_read() + (ms * 1000);
+        running = true;
+    }
+
+    void stop() {
+        running = false;
+    }
+
+    bool expired() {
+        if (running && ((int32_t)(us_ticker_read() - expires) >= 0)) {
+            running = false;
+        }
+        return !running;
+    }
+
+protected:
+    uint32_t    expires;
+    bool        running;
+};
+
+#endif  //#if (NZ32S_USE_TIMER_WHEEL==1)
+
+#endif /* MODTRONIX_NZ32S_MX_TIMER_WHEEL_H_ */
@@ -34,6 +34,13 @@
 
 
 // DEFINES ////////////////////////////////////////////////////////////////////
+#define BATT_INIT           0
+#define BATT_IDLE           1
+#define BATT_SETTLE         2
+#define BATT_CONVERT        3
+
+//Convert sum of NZ32S_BATT_OVERSAMPLE 12-bit conversions to 16-bit value
+#define BATT_SUM_TO_U16(sum)    ((uint16_t)(((sum) << 4) / NZ32S_BATT_OVERSAMPLE))
 
 
 // GLOBAL VARIABLES ///////////////////////////////////////////////////////////
@@ -50,6 +57,22 @@ IWDG_HandleTypeDef NZ32S::hiwdg;    //Independent Watchdog Timer, is NOT stopped
 #if (NZ32S_USE_A13_A14 == 1)
 DigitalInOut NZ32S::enableFastCharge(PA_14, PIN_INPUT, PullNone, 0);
 #endif
+#if (NZ32S_USE_BATT_MONITOR == 1)
+uint8_t             NZ32S::battState = BATT_INIT;
+int                 NZ32S::tmrBatt;
+int                 NZ32S::tmrBattSettle;
+uint32_t            NZ32S::battAvg;
+uint16_t            NZ32S::supplyAdc;
+uint32_t            NZ32S::battSumVBatt;
+uint32_t            NZ32S::battSumVSense;
+volatile bool       NZ32S::battDone;
+
+static analogin_t   adcVBatt;
+static analogin_t   adcVSense;
+#if (NZ32S_USE_A13_A14 == 1)
+static DigitalInOut ctrVBatt(PA_13);
+#endif
+#endif
 
 
 // Function Prototypes ////////////////////////////////////////////////////////
@@ -62,29 +85,108 @@ NZ32S::NZ32S() {
 }
 
 
+#if (NZ32S_USE_BATT_MONITOR == 1)
+
+/** Battery monitor task
+ */
+void NZ32S::batt_task(void) {
+    uint16_t adc;
+
+    switch (battState) {
+    case BATT_INIT:
+        analogin_init(&adcVBatt, PC_5);
+        #ifdef NZ32_ST1L_REV1
+        analogin_init(&adcVSense, PB_12);
+        #else
+        analogin_init(&adcVSense, PC_4);
+        #endif
+        tmrBatt = MxTick::read_ms();
+        battState = BATT_IDLE;
+        break;
+    case BATT_IDLE:
+        if (!MxTick::expired_ms(tmrBatt)) {
+            break;
+        }
+        tmrBatt += NZ32S_BATT_INTERVAL;
+        //Measure Vbatt. It doesn't seem to make lots of a difference if we disable the DC/DC converter!
+        #if (NZ32S_USE_A13_A14 == 1)
+        ctrVBatt = 0;
+        ctrVBatt.output();
+        #endif
+        tmrBattSettle = MxTick::read_ms() + NZ32S_BATT_SETTLE;
+        battState = BATT_SETTLE;
+        break;
+    case BATT_SETTLE:
+        #if (NZ32S_USE_A13_A14 == 1)
+        if (!MxTick::expired_ms(tmrBattSettle)) {
+            break;
+        }
+        #endif
+        battDone = false;
+        //If ADC is busy with other oversampled read, try again next call
+        if (analogin_read_oversampled(&adcVBatt, NZ32S_BATT_OVERSAMPLE, NZ32S::batt_adc_done, &adcVBatt) == 0) {
+            battState = BATT_CONVERT;
+        }
+        break;
+    case BATT_CONVERT:
+        if (battDone == false) {
+            break;
+        }
+        #if (NZ32S_USE_A13_A14 == 1)
+        ctrVBatt.input();
+        #endif
+
+        adc = BATT_SUM_TO_U16(battSumVBatt);
+        if (battAvg == 0) {
+            battAvg = (uint32_t)adc << NZ32S_BATT_AVG_SHIFT;  //First measurement, use as average
+        }
+        else {
+            battAvg = battAvg - (battAvg >> NZ32S_BATT_AVG_SHIFT) + adc;
+        }
+        supplyAdc = BATT_SUM_TO_U16(battSumVSense);
+        battState = BATT_IDLE;
+        break;
+    }
+}
+
+
+/** Called from ADC interrupt when oversampled read is done. Start supply measurement after battery.
+ */
+void NZ32S::batt_adc_done(void* context, uint32_t sum) {
+    if (context == &adcVBatt) {
+        battSumVBatt = sum;
+        if (analogin_read_oversampled(&adcVSense, NZ32S_BATT_OVERSAMPLE, NZ32S::batt_adc_done, &adcVSense) == 0) {
+            return;
+        }
+        battSumVSense = 0;
+    }
+    else {
+        battSumVSense = sum;
+    }
+    battDone = true;
+}
+
+
 /** Get the battery voltage.
  */
 uint16_t NZ32S::get_batt_mv() {
-    MX_DEBUG("\r\nnz32s_getBattMV()");
+    //6600 = 3300*2, because resistor divider = 2
+    return (uint16_t)(((battAvg >> NZ32S_BATT_AVG_SHIFT) * 6600) >> 16);
+}
 
-    //uint16_t getBattMV(void) {
-    //    float fval = 0;
-    //
-    //#if (NZ32S_USE_A13_A14 == 1)
-    ////    uint16_t meas;
-    ////
-    ////    //Measure Vbatt. It doesn't seem to make lots of a difference if we disable the DC/DC converter!
-    ////    ctrVBatt = 0;
-    ////    ctrVBatt.output();
-    ////    wait_ms(150);
-    ////    meas = ainVBatt.read_u16(); // Converts and read the analog input value
-    ////    ctrVBatt.input();
-    ////    //fval = ((float)meas / (float)0xffff) * 6600;  //6600 = 3300*2, because resistor divider = 2
-    ////    fval = meas * ((float)6600.0 / (float)65535.0);
-    //#endif
-    //
-    //    return (uint16_t) fval;
-    return 0;
+
+/** Get the battery charge in percent.
+ */
+uint8_t NZ32S::get_batt_percent(void) {
+    uint16_t mvBatt = get_batt_mv();
+
+    if (mvBatt < 3200) {
+        return 0;
+    }
+    if (mvBatt >= 4200) {
+        return 100; //Not more than 100%
+    }
+    return (mvBatt - 3200)/10;  //Convert to value from 0 to 1000, then divide by 10 to get 0-100 percentage
 }
 
 
@@ -92,34 +194,44 @@ uint16_t NZ32S::get_batt_mv() {
  * Get Vusb or 5V supply voltage in millivolts.
  */
 uint16_t NZ32S::get_supply_mv(void) {
-    //    float fval;
-    //    uint16_t meas;
+    //Following voltages were measured at input of ADC:
     //
-    //    //Following voltages were measured at input of ADC:
-    //    //
-    //    //----- Vusb=0V  &  5V supply=0V -----
-    //    //Value is typically 4mV
-    //    //
-    //    //----- Vusb=5V  &  5V supply=0V -----
-    //    //When only VUSB is supplied, the value is typically 1.95V
-    //    //
-    //    //----- Vusb=0V  &  5V supply=5V -----
-    //    //When only VUSB is supplied, the value is typically 1.95V
-    //    //
-    //    //The reason this circuit does not work, is because of the reverse voltage of the diodes. It is given
-    //    //as about 40 to 80uA. With a resistor value of 470K, this will put 5V on other side of diode.
-    //    //Thus, no matter if 5V is at Vusb, Vsupply, or both, the read value will always be 1.95V.
-    //    //To solve problem, resistors must be lowered to value where 80uA will no longer give more than 5V
-    //    //voltage drop = 62k. Using two 47k resistors should work.
+    //----- Vusb=0V  &  5V supply=0V -----
+    //Value is typically 4mV
     //
-    //    //Measure Vusb/5V sense input
-    //    meas = ainVSense.read_u16(); // Converts and read the analog input value
-    //    fval = ((float) meas / (float) 0xffff) * 3300;
+    //----- Vusb=5V  &  5V supply=0V -----
+    //When only VUSB is supplied, the value is typically 1.95V
     //
-    //    return (uint16_t) fval;
+    //----- Vusb=0V  &  5V supply=5V -----
+    //When only VUSB is supplied, the value is typically 1.95V
+    //
+    //The reason this circuit does not work, is because of the reverse voltage of the diodes. It is given
+    //as about 40 to 80uA. With a resistor value of 470K, this will put 5V on other side of diode.
+    //Thus, no matter if 5V is at Vusb, Vsupply, or both, the read value will always be 1.95V.
+    //To solve problem, resistors must be lowered to value where 80uA will no longer give more than 5V
+    //voltage drop = 62k. Using two 47k resistors should work.
+    return (uint16_t)(((uint32_t)supplyAdc * 3300) >> 16);
+}
+
+#else   //#if (NZ32S_USE_BATT_MONITOR == 1)
+
+void NZ32S::batt_task(void) {
+}
+
+uint16_t NZ32S::get_batt_mv() {
+    return 0;
+}
+
+uint8_t NZ32S::get_batt_percent(void) {
     return 0;
 }
 
+uint16_t NZ32S::get_supply_mv(void) {
+    return 0;
+}
+
+#endif  //#if (NZ32S_USE_BATT_MONITOR == 1)
+
 
 /**
  * Reset I2C bus
@@ -136,7 +248,7 @@ void NZ32S::i2c_reset(uint8_t busNumber, PinName sda, PinName scl) {
     }
 
     objI2C.slave = 0;
-    i2c_init(&objI2C, sda, scl);
+    i2c_init(&objI2C, sda, scl);    //Also aborts any queued transfers (DEVICE_I2C_QUEUE), with error
     //i2c_reset(&objI2C);       //i2c_init() above calls i2c_reset()
     //pc.printf("\r\nI2C1 Reset");
 
@@ -23,8 +23,12 @@
 
 #include "nz32s_default_config.h"
 #include "mx_tick.h"
+#include "mx_timer_wheel.h"
+#include "mx_profile.h"
+#include "mx_metrics.h"
 #include "mx_helpers.h"
 #include "mx_circular_buffer.h"
+#include "mx_spsc_buffer.h"
 #include "mx_cmd_buffer.h"
 
 
@@ -134,12 +138,23 @@ public:
         #endif
     }
 
-    /** Get the battery voltage.
+    /** Battery monitor task, must be called from main loop if NZ32S_USE_BATT_MONITOR is 1. Never blocks.
+     * Starts a battery and supply measurement every NZ32S_BATT_INTERVAL ms, and updates the running
+     * average when the ADC interrupt has completed it.
+     */
+    static void batt_task(void);
+
+    /** Get the battery voltage in millivolts. This is the running average of measurements done by
+     * batt_task(), returns 0 if no measurement has completed yet.
      */
     static uint16_t get_batt_mv();
 
+    /** Get the battery charge in percent, 0 to 100. Assumes voltage decreases linearly from 4.2 to 3.2V.
+     */
+    static uint8_t get_batt_percent(void);
+
     /**
-     * Get Vusb or 5V supply voltage in millivolts.
+     * Get Vusb or 5V supply voltage in millivolts, as measured by last batt_task() measurement.
      */
     static uint16_t get_supply_mv(void);
 
@@ -260,6 +275,20 @@ public:
     #if (NZ32S_USE_A13_A14 == 1)
     static DigitalInOut enableFastCharge;
     #endif
+
+protected:
+    #if (NZ32S_USE_BATT_MONITOR == 1)
+    static void batt_adc_done(void* context, uint32_t sum);
+
+    static uint8_t           battState;
+    static int               tmrBatt;
+    static int               tmrBattSettle;
+    static uint32_t          battAvg;       //Running average of 16-bit ADC value, scaled by 2^NZ32S_BATT_AVG_SHIFT
+    static uint16_t          supplyAdc;     //16-bit ADC value of last supply measurement
+    static uint32_t          battSumVBatt;  //Written by ADC interrupt
+    static uint32_t          battSumVSense; //Written by ADC interrupt
+    static volatile bool     battDone;      //Set by ADC interrupt when both sums have been written
+    #endif
 };
 
 #ifdef __cplusplus
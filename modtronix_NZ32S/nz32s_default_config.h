@@ -44,6 +44,76 @@
 #define     NZ32S_USE_WWDG    1
 #endif
 
+//Set to 1 to enable the battery monitor. NZ32S::batt_task() must then be called from the main loop. It measures
+//the battery and supply voltage in the background, using an interrupt driven oversampled ADC read.
+#if !defined(NZ32S_USE_BATT_MONITOR)
+#define     NZ32S_USE_BATT_MONITOR    1
+#endif
+
+//Time in ms between battery measurements
+#if !defined(NZ32S_BATT_INTERVAL)
+#define     NZ32S_BATT_INTERVAL    1000
+#endif
+
+//Time in ms to wait after enabling battery divider (A13) before measuring. Only used if NZ32S_USE_A13_A14 is 1
+#if !defined(NZ32S_BATT_SETTLE)
+#define     NZ32S_BATT_SETTLE    150
+#endif
+
+//Number of ADC conversions per measurement, must be a power of 2 from 1 to 4096
+#if !defined(NZ32S_BATT_OVERSAMPLE)
+#define     NZ32S_BATT_OVERSAMPLE    64
+#endif
+
+//Battery voltage is a running average over 2^NZ32S_BATT_AVG_SHIFT measurements. For example 5 = 32 measurements
+#if !defined(NZ32S_BATT_AVG_SHIFT)
+#define     NZ32S_BATT_AVG_SHIFT    5
+#endif
+
+//Period of MxTick keep-alive interrupt, in us. MxTick has no periodic tick, this interrupt only ensures an
+//overflow of the 32-bit us_ticker is not missed. Must be less than 2^32us = 71 minutes.
+#if !defined(NZ32S_TICK_KEEPALIVE_US)
+#define     NZ32S_TICK_KEEPALIVE_US    0x40000000
+#endif
+
+//Set to 1 to enable the MxTimerWheel timer service. All MxTimeout objects share a single 1ms mbed Ticker, that is
+//only running while a MxTimeout is attached.
+#if !defined(NZ32S_USE_TIMER_WHEEL)
+#define     NZ32S_USE_TIMER_WHEEL    1
+#endif
+
+//Number of slots in MxTimerWheel, must be a power of 2. Each slot is 1ms. Timeouts longer than this are supported,
+//but are checked once every MX_TIMER_WHEEL_SLOTS ms until they expire.
+#if !defined(MX_TIMER_WHEEL_SLOTS)
+#define     MX_TIMER_WHEEL_SLOTS    64
+#endif
+
+//Set to 1 to enable the MxProfile cycle counter profiler. If 0, all MX_PROFILE_SCOPE() regions compile to nothing.
+#if !defined(NZ32S_USE_PROFILER)
+#define     NZ32S_USE_PROFILER    0
+#endif
+
+//Host build (MX_HOST_SIM defined), profiler uses clock_gettime() instead of DWT cycle counter
+#if defined(MX_HOST_SIM) && !defined(MX_PROFILE_HOST)
+#define     MX_PROFILE_HOST
+#endif
+
+//Set to 1 to enable the MxMetrics registry of counters, gauges and histograms
+#if !defined(NZ32S_USE_METRICS)
+#define     NZ32S_USE_METRICS    1
+#endif
+
+//Number of buckets in each MxHistogram. Bucket n counts values from 2^(n-1) to 2^n-1
+#if !defined(MX_METRICS_HIST_BUCKETS)
+#define     MX_METRICS_HIST_BUCKETS    8
+#endif
+
+//Set to 1 to only allow buffer sizes(MxCircularBuffer, MxCmdBuffer) that are a power of 2. Index arithmetic then
+//always uses masks. If 0, other sizes are allowed, but use a divide for every index calculation.
+#if !defined(MX_BUFFER_POW2_ONLY)
+#define     MX_BUFFER_POW2_ONLY    0
+#endif
+
 
 // End of contents to copy to custom nz32s_defines.h file /////////////////////
 
@@ -57,4 +57,16 @@
 #define GFX_SIZEABLE_TEXT       1
 #endif
 
+//Set to 1 to send display data with the interrupt driven I2C queue, if the target HAL has one (DEVICE_I2C_QUEUE).
+//display() then returns without waiting for the data to be sent. Is tested on the host with a model of the STM32 I2C
+//peripheral (tests/test_i2c_queue.cpp).
+#if !defined(OLED_I2C_QUEUE)
+#define OLED_I2C_QUEUE          1
+#endif
+
+//Queued display data not sent after this time is aborted, and display() returns an error. In ms.
+#if !defined(OLED_I2C_QUEUE_TIMEOUT)
+#define OLED_I2C_QUEUE_TIMEOUT  100
+#endif
+
 #endif
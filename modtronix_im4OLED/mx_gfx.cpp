@@ -405,6 +405,10 @@ void MxGfx::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint
         ((y + 8 * size - 1) < 0)    // Clip top
         )
     return;
+
+    // Let driver blit whole glyph if it can
+    if ((size == 1) && blitChar(x, y, &font5x7[c*5], color, bg))
+        return;
     
     for (int8_t i=0; i<6; i++ )
     {
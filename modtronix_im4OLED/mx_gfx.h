@@ -181,6 +181,13 @@ class MxGfx : public Stream
     inline uint8_t getRotation(void) { rotation %= 4; return rotation; };
 
 protected:
+    /** Draw a size 1 character from its glyph. Drivers with a page packed display buffer can override this to
+     * write the glyph columns directly, instead of drawing each pixel.
+     * @param glyph The 5 columns of the character, bit 0 is top row. Sixth column is empty
+     * @return true if drawn, false if not supported. drawChar() then draws each pixel
+     */
+    virtual bool blitChar(int16_t x, int16_t y, const uint8_t* glyph, uint16_t color, uint16_t bg) { return false; };
+
     int16_t  _rawWidth, _rawHeight;   // this is the 'raw' display w/h - never changes
     int16_t  _width, _height; // dependent on rotation
     int16_t  cursor_x, cursor_y;
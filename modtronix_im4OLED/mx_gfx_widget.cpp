@@ -0,0 +1,130 @@
+/**
+ * File:      mx_gfx_widget.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include "mbed.h"
+#include "mx_gfx_widget.h"
+
+bool MxTextWidget::update(MxGfx& gfx) {
+    char text[MX_WIDGET_MAX_CHARS + 1];
+    uint8_t len;
+    bool changed = false;
+
+    if (format != NULL) {
+        text[0] = 0;
+        format(text, chars + 1);
+    }
+    else {
+        strncpy(text, label, chars + 1);
+    }
+    text[chars] = 0;
+
+    //Pad with spaces, so old characters are cleared when text gets shorter
+    for (len = strlen(text); len < chars; len++) {
+        text[len] = ' ';
+    }
+
+    for (uint8_t i = 0; i < chars; i++) {
+        if (!valid || (drawn[i] != text[i])) {
+            drawn[i] = text[i];
+            gfx.drawChar(x + (i * textSize * 6), y, text[i], WHITE, BLACK, textSize);
+            changed = true;
+        }
+    }
+    valid = true;
+    return changed;
+}
+
+void MxTextWidget::invalidateAll(MxTextWidget* const* widgets, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        widgets[i]->invalidate();
+    }
+}
+
+bool MxTextWidget::updateAll(MxGfx& gfx, MxTextWidget* const* widgets, uint8_t count) {
+    bool changed = false;
+    for (uint8_t i = 0; i < count; i++) {
+        changed |= widgets[i]->update(gfx);
+    }
+    return changed;
+}
+
+void MxSelectWidget::setRows(uint8_t rows) {
+    this->rows = (rows != 0) ? rows : 1;
+    row = 0;
+    on = false;
+    valid = false;
+}
+
+void MxSelectWidget::setPos(int16_t x, int16_t y) {
+    if ((x != this->x) || (y != this->y)) {
+        this->x = x;
+        this->y = y;
+        on = true;
+        valid = false;
+    }
+}
+
+void MxSelectWidget::up() {
+    if (row-- == 0) {
+        row = rows - 1;
+    }
+}
+
+void MxSelectWidget::down() {
+    if (++row >= rows) {
+        row = 0;
+    }
+}
+
+void MxSelectWidget::restore(MxGfx& gfx) {
+    if (valid && (drawnRow == ROW_NONE)) {
+        gfx.drawChar(x, y, c, WHITE, BLACK, 1);
+    }
+    on = true;
+    valid = false;
+}
+
+bool MxSelectWidget::update(MxGfx& gfx) {
+    uint8_t screenRows;
+    uint8_t newRow = on ? (row % rowsPerScreen) : (uint8_t)ROW_NONE;
+
+    if (valid && (newRow == drawnRow)) {
+        return false;
+    }
+
+    if (!valid) {
+        //Draw all rows, clears cursor of rows not selected
+        screenRows = (rows < rowsPerScreen) ? rows : rowsPerScreen;
+        for (uint8_t i = 0; i < screenRows; i++) {
+            gfx.drawChar(x, y + (i * rowHeight), (i == newRow) ? c : ' ', WHITE, BLACK, 1);
+        }
+    }
+    else {
+        if (drawnRow != ROW_NONE) {
+            gfx.drawChar(x, y + (drawnRow * rowHeight), ' ', WHITE, BLACK, 1);
+        }
+        if (newRow != ROW_NONE) {
+            gfx.drawChar(x, y + (newRow * rowHeight), c, WHITE, BLACK, 1);
+        }
+    }
+    drawnRow = newRow;
+    valid = true;
+    return true;
+}
@@ -0,0 +1,175 @@
+/**
+ * File:      mx_gfx_widget.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description: Retained mode text widgets for MxGfx displays. A widget remembers the text it
+ *              last drew, and only redraws characters that changed. MxSelectWidget is the blinking
+ *              cursor of a select menu.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef _MX_GFX_WIDGET_H_
+#define _MX_GFX_WIDGET_H_
+#include "im4oled_default_config.h"
+#include "mx_gfx.h"
+
+//Maximum characters of a widget. 21 characters of size 1 fill a 128 pixel wide line
+#if !defined(MX_WIDGET_MAX_CHARS)
+#define MX_WIDGET_MAX_CHARS     21
+#endif
+
+/** Writes the current value of a widget to buf, as a NULL terminated string.
+ * @param buf Buffer to write to
+ * @param size Size of buf, including NULL terminator
+ */
+typedef void (*MxWidgetFormat)(char* buf, uint8_t size);
+
+/** Single line text widget, a label or a value field bound to a data source via its format function.
+ * A widget is drawn with a fixed number of characters, shorter text is padded with spaces. Only characters
+ * that changed since the last update() are drawn, so only their part of the display is marked dirty.
+ */
+class MxTextWidget
+{
+public:
+    /** Create value field, text is obtained from format function each time it is updated
+     * @param x X coordinate of top left corner
+     * @param y Y coordinate of top left corner
+     * @param chars Width in characters, maximum is MX_WIDGET_MAX_CHARS
+     * @param format Function to get text
+     * @param textSize Text size
+     */
+    MxTextWidget(int16_t x, int16_t y, uint8_t chars, MxWidgetFormat format, uint8_t textSize = 1)
+        : x(x), y(y), chars((chars < MX_WIDGET_MAX_CHARS) ? chars : MX_WIDGET_MAX_CHARS)
+        , textSize(textSize), format(format), label(NULL), valid(false)
+    {
+    };
+
+    /** Create label with constant text
+     * @param x X coordinate of top left corner
+     * @param y Y coordinate of top left corner
+     * @param label Text, maximum length is MX_WIDGET_MAX_CHARS
+     * @param textSize Text size
+     */
+    MxTextWidget(int16_t x, int16_t y, const char* label, uint8_t textSize = 1)
+        : x(x), y(y), chars((strlen(label) < MX_WIDGET_MAX_CHARS) ? strlen(label) : MX_WIDGET_MAX_CHARS)
+        , textSize(textSize), format(NULL), label(label), valid(false)
+    {
+    };
+
+    /** Redraw all characters on next update(). Use after display was cleared.
+     */
+    inline void invalidate() { valid = false; };
+
+    /** Get current text, and draw all characters that changed.
+     * @return true if anything was drawn
+     */
+    bool update(MxGfx& gfx);
+
+    /** Invalidate all given widgets
+     */
+    static void invalidateAll(MxTextWidget* const* widgets, uint8_t count);
+
+    /** Update all given widgets
+     * @return true if anything was drawn
+     */
+    static bool updateAll(MxGfx& gfx, MxTextWidget* const* widgets, uint8_t count);
+
+protected:
+    int16_t         x, y;
+    uint8_t         chars;
+    uint8_t         textSize;
+    MxWidgetFormat  format;
+    const char*     label;
+    bool            valid;                      //If false, drawn[] is not valid and all characters are drawn
+    char            drawn[MX_WIDGET_MAX_CHARS]; //Characters currently on display
+};
+
+
+/** Blinking cursor character in front of the rows of a select menu. Only one row is shown at a time, a screen
+ * shows rowsPerScreen rows, rowHeight pixels apart. Blinking is done by calling blink() from a timer. Only
+ * the cursor position that changed is drawn by update().
+ * With a single row, it can also be used to blink a single character, like the '=' of a value being edited.
+ */
+class MxSelectWidget
+{
+public:
+    /** Create select cursor
+     * @param x X coordinate of top left corner of first row
+     * @param y Y coordinate of top left corner of first row
+     * @param c Cursor character
+     * @param rowsPerScreen Rows shown on one screen. Row n is shown at row (n % rowsPerScreen)
+     * @param rowHeight Pixels between rows
+     */
+    MxSelectWidget(int16_t x, int16_t y, char c, uint8_t rowsPerScreen = 4, uint8_t rowHeight = 11)
+        : x(x), y(y), c(c), rowsPerScreen(rowsPerScreen), rowHeight(rowHeight)
+        , rows(1), row(0), on(true), valid(false), drawnRow(0)
+    {
+    };
+
+    /** Set number of rows, and select first row. Cursor is shown on first blink().
+     */
+    void setRows(uint8_t rows);
+
+    /** Move cursor to given position. If it changed, the cursor is shown and drawn on next update().
+     */
+    void setPos(int16_t x, int16_t y);
+
+    /** Select previous row, or last row if first row is selected
+     */
+    void up();
+
+    /** Select next row, or first row if last row is selected
+     */
+    void down();
+
+    /** Get selected row, a value from 0 to rows-1
+     */
+    inline uint8_t getRow() { return row; };
+
+    /** Toggle cursor between shown and hidden
+     */
+    inline void blink() { on = !on; };
+
+    /** Redraw all rows on next update(). Use after display was cleared.
+     */
+    inline void invalidate() { valid = false; };
+
+    /** Draw cursor if it is hidden, and stop tracking it until next update(). Use before leaving a screen
+     * where the cursor character is part of the text, like a blinking '='.
+     */
+    void restore(MxGfx& gfx);
+
+    /** Draw rows of which the cursor changed.
+     * @return true if anything was drawn
+     */
+    bool update(MxGfx& gfx);
+
+protected:
+    enum {
+        ROW_NONE = 0xff                         //drawnRow value when cursor is hidden
+    };
+
+    int16_t         x, y;
+    char            c;
+    uint8_t         rowsPerScreen;
+    uint8_t         rowHeight;
+    uint8_t         rows;
+    uint8_t         row;
+    bool            on;                         //Cursor shown
+    bool            valid;                      //If false, drawnRow is not valid and all rows are drawn
+    uint8_t         drawnRow;                   //Screen row cursor is currently drawn at, or ROW_NONE
+};
+
+#endif
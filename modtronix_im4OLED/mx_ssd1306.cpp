@@ -21,6 +21,7 @@ All text above, and the splash screen below must be included in any redistributi
  */
 #include "mbed.h"
 #include "mx_ssd1306.h"
+#include "mx_profile.h"
 
 //MODTRONIX BEGIN /////////////////////////////////////////////////////////////
 #define DEBUG_ENABLE            0
@@ -98,8 +99,8 @@ uint8_t MxSSD1306::begin(uint8_t vccstate)
     command(SSD1306_CHARGEPUMP);
     command((vccstate == SSD1306_EXTERNALVCC) ? 0x10 : 0x14);
 
-    command(SSD1306_MEMORYMODE);                    // Set for "Page addressing mode"
-    command(0x02);                                  // 2 = Page addressing mode
+    command(SSD1306_MEMORYMODE);                    // Set for "Horizontal addressing mode"
+    command(0x00);                                  // 0 = Horizontal addressing mode
 
     command(SSD1306_SEGREMAP | 0x1);
 
@@ -191,6 +192,171 @@ void MxSSD1306::drawPixel(int16_t x, int16_t y, uint16_t color)
     }
 }
 
+#if (GFX_ENABLE_ABSTRACTS==1) || (GFX_SIZEABLE_TEXT==1)
+/** Draw and fill a rectangle. Clips it to the display, and converts to raw coordinates
+ */
+void MxSSD1306::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    int16_t tmp;
+
+    //Clip to display
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if ((x + w) > width())
+        w = width() - x;
+    if ((y + h) > height())
+        h = height() - y;
+    if ((w <= 0) || (h <= 0))
+        return;
+
+    // check rotation, move rectangle around if necessary. Same as drawPixel(), for top left corner
+    switch (getRotation())
+    {
+        case 1:
+            tmp = x;
+            x = _rawWidth - y - h;
+            y = tmp;
+            swap(w, h);
+            break;
+        case 2:
+            x = _rawWidth - x - w;
+            y = _rawHeight - y - h;
+            break;
+        case 3:
+            tmp = y;
+            y = _rawHeight - x - w;
+            x = tmp;
+            swap(w, h);
+            break;
+    }
+
+    fillRawRect(x, y, w, h, color);
+}
+
+void MxSSD1306::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    fillRect(x, y, 1, h, color);
+}
+#endif
+
+#if (GFX_ENABLE_ABSTRACTS==1)
+void MxSSD1306::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    fillRect(x, y, w, 1, color);
+}
+
+void MxSSD1306::fillScreen(uint16_t color)
+{
+    fillRect(0, 0, width(), height(), color);
+}
+#endif
+
+void MxSSD1306::fillRawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    uint8_t page = y/8;
+    uint8_t lastPage = (y+h-1)/8;
+
+    //Each byte of buffer contains 8 rows(one page) of a single column. A rectangle is written as a horizontal
+    //span of bytes for each page, with the mask of rows in that page.
+    for (; page<=lastPage; page++) {
+        uint8_t mask = 0xff;
+        uint8_t* pBuf = &buffer[(page*_rawWidth) + x];
+        int16_t first = -1;
+        int16_t last = 0;
+
+        if (page == (y/8)) {
+            mask &= 0xff << (y%8);                      //Top rows of first page not part of rectangle
+        }
+        if (page == lastPage) {
+            mask &= 0xff >> (7 - ((y+h-1)%8));          //Bottom rows of last page not part of rectangle
+        }
+
+        for (int16_t i=0; i<w; i++) {
+            uint8_t val = (color == WHITE) ? (pBuf[i] | mask) : (pBuf[i] & ~mask);
+            //Only write and mark dirty if changed
+            if (val != pBuf[i]) {
+                pBuf[i] = val;
+                if (first < 0) {
+                    first = i;
+                }
+                last = i;
+            }
+        }
+
+        if (first >= 0) {
+            setDirty(page, x + first, x + last);
+        }
+    }
+}
+
+bool MxSSD1306::blitChar(int16_t x, int16_t y, const uint8_t* glyph, uint16_t color, uint16_t bg)
+{
+    uint8_t shift;
+
+    //Rotated, or clipped at top or bottom. Let drawChar() draw each pixel
+    if ((getRotation() != 0) || (y < 0) || ((y + 8) > _rawHeight)) {
+        return false;
+    }
+
+    //Character in a single page if y is aligned to page, else it's split over two pages
+    shift = y % 8;
+    blitCharPage(y/8, x, glyph, shift, 0xff << shift, color, bg);
+    if (shift != 0) {
+        blitCharPage((y/8) + 1, x, glyph, shift - 8, 0xff >> (8 - shift), color, bg);
+    }
+    return true;
+}
+
+void MxSSD1306::blitCharPage(uint8_t page, int16_t x, const uint8_t* glyph, int8_t shift, uint8_t mask, uint16_t color, uint16_t bg)
+{
+    uint8_t* pBuf = &buffer[page*_rawWidth];
+    int16_t first = -1;
+    int16_t last = 0;
+
+    //Character is 5 glyph columns, and an empty 6th column
+    for (int16_t i=0; i<6; i++) {
+        uint8_t bits;
+        uint8_t val;
+        int16_t col = x + i;
+
+        //Clip left and right
+        if ((col < 0) || (col >= _rawWidth)) {
+            continue;
+        }
+
+        bits = (i < 5) ? glyph[i] : 0;
+        bits = (shift >= 0) ? (bits << shift) : (bits >> (-shift));
+
+        //Set pixels of glyph to color. If background differs, all other pixels are set to background
+        val = pBuf[col];
+        if (bg != color) {
+            val = (val & ~mask) | (((color == WHITE) ? bits : ~bits) & mask);
+        }
+        else {
+            val = (color == WHITE) ? (val | (bits & mask)) : (val & ~(bits & mask));
+        }
+
+        //Only write and mark dirty if changed
+        if (val != pBuf[col]) {
+            pBuf[col] = val;
+            if (first < 0) {
+                first = col;
+            }
+            last = col;
+        }
+    }
+
+    if (first >= 0) {
+        setDirty(page, first, last);
+    }
+}
+
 /** Set display contrast
  * @return 0 if success, else I2C or SPI error code
  */
@@ -220,31 +386,40 @@ uint8_t MxSSD1306::invertDisplay(bool i)
 uint8_t MxSSD1306::display(void)
 {
     uint8_t retVal;
-    static uint8_t oldColBlock = 0xfe;  //Do NOT use 0xff, seeing that is incremented by 1 below for test!
-    static uint8_t oldRowBlock = 0xfe;
+    uint8_t win[6];
+    MX_PROFILE_SCOPE(MX_PROF_OLED_DISPLAY);
 
-    // Page Address Mode //////////////////////////////////////////////////////
-    // Set "Page Address Mode". This mode requires SSD1306_SETLOWCOLUMN, SSD1306_SETHIGHCOLUMN and
-    // Only do this after setAllDirty() is called, which sets rowBlock to 0xf0
+    //Previous display data still being sent, or error
+    if ((retVal=pollTransfers()) != 0) {
+        if (retVal==SSD1306_BUSY) {
+            return 0;
+        }
+        setAllDirty();  //Dirty bits of failed data were already cleared, resend all after bus is reset
+        return retVal;
+    }
+
+    // Horizontal Address Mode ////////////////////////////////////////////////
+    // Display data is written to a column/page window set with SSD1306_SET_COLUMN_ADR and SSD1306_SET_PAGE_ADR.
+    // The column is auto incremented, so each run of dirty blocks is sent with a single data transfer.
+    // Only send memory mode after setAllDirty() is called, which sets rowBlock to 0xf0
     if(rowBlock==0xf0) {
         rowBlock = 0;
-        if ((retVal=command(SSD1306_MEMORYMODE)) != 0) {return retVal;}     //Set "Page Address Mode"
-        if ((retVal=command(2)) != 0) {return retVal;}
-        oldColBlock = oldRowBlock = 0xfe;   //Cause column and row command to be sent to OLED again
+        if ((retVal=command(SSD1306_MEMORYMODE)) != 0) {return retVal;}     //Set "Horizontal Address Mode"
+        if ((retVal=command(0)) != 0) {return retVal;}
     }
 
 //dirty is array of 8 x uint8_t elements
 #if ((OLED_WIDTH == 128 ) && (OLED_HEIGHT==64))
-    uint8_t colMask;    //Width is 128 or less. Required 8 bits or less for colMask. Each bit = 16 columns. 8 bits = 128 columns.
+    uint8_t dirtyRow;   //Width is 128 or less. Required 8 bits or less. Each bit = 16 columns. 8 bits = 128 columns.
     uint32_t * pDirty = (uint32_t*)&dirty[0];
     //Nothing to do
     if ((pDirty[0]==0) && (pDirty[1]==0)) {
-        colBlock = rowBlock = 0;    //Reset
+        rowBlock = 0;   //Reset
         return 0;   //Return OK
     }
 
 #elif (OLED_WIDTH <= 256 )
-    uint16_t colMask;    //Width is 256 or less. Required 16 bits or less for colMask. Each bit = 16 columns. 16 bits = 256 columns.
+    uint16_t dirtyRow;  //Width is 256 or less. Required 16 bits or less. Each bit = 16 columns. 16 bits = 256 columns.
     bool isDirty = false;
     for(int iDirty=0; iDirty<(OLED_HEIGHT/8); iDirty++) {
         if(dirty[iDirty] != 0) {
@@ -254,86 +429,82 @@ uint8_t MxSSD1306::display(void)
     }
     //Nothing to do
     if (isDirty == false) {
-        colBlock = rowBlock = 0;    //Reset
+        rowBlock = 0;   //Reset
         return 0;   //Return OK
     }
 #else
     #error "OLED width and height not supported yet!"
 #endif
 
-    //Find dirty block!
-    //Check if current block of display data is dirty. Each dirty[] element contains bits for whole
-    //row(all columns). Each bit of dirty = 16 columns. For example:
+    //Find next dirty row block (page). Each dirty[] element contains bits for whole row(all columns).
+    //Each bit of dirty = 16 columns. For example:
     // - bit 0 of dirty[0] will be "Rows 0-7, and Columns 0-15"
     // - bit 1 of dirty[0] will be "Rows 0-7, and Columns 16-31"
     // - bit 7 of dirty[0] will be "Rows 0-7, and Columns 112-127"
     // - bit 0 of dirty[1] will be "Rows 8-15, and Columns 0-15"
-    while(1) {
-        colMask = 0x01 << colBlock; //Get current column
-        //Found the dirty bit, break!
-        if((dirty[rowBlock] & colMask) != 0) {
-            //Clear the dirty bit
-            dirty[rowBlock] = dirty[rowBlock] & (~colMask);
-            break;
-        }
-        //Increment colBlock and rowBlock
-        if (++colBlock >= (OLED_WIDTH/16)) {
-            colBlock = 0;
-            rowBlock = (rowBlock+1) % (OLED_HEIGHT/8);
-        }
+    while(dirty[rowBlock] == 0) {
+        rowBlock = (rowBlock+1) % (OLED_HEIGHT/8);
     }
 
-    MX_DEBUG("\r\nOLED.display %d,%d", rowBlock, colBlock);
+    //Dirty bits of each run are only cleared after it was sent. If sending fails, the rest of the page stays dirty
+    dirtyRow = dirty[rowBlock];
 
-    //Set "Current Page" -  Required by "Page Addressing Mode" (Page is NOT auto incremented in "Page Mode")
-    if (rowBlock != oldRowBlock) {
-        oldRowBlock = rowBlock;
-        // Set current Page. Each page = 8 rows
-        if ((retVal=command(SSD1306_SET_PAGE_START_ADR | rowBlock)) != 0) {return retVal;}
-    }
+    //Send each run of consecutive dirty column blocks of this page with a single data transfer
+    for(uint8_t colStart=0; dirtyRow!=0; ) {
+        uint8_t colEnd;
 
-    //Set "Current Column" - Required by "Page Addressing Mode"
-    //Not required if last written colBlock was previous one. In that case, will automatically increments (columns are auto incremented in "Page Mode")
-    if (colBlock != (oldColBlock+1)) {
-        uint8_t column  = colBlock * 16;
-        // Column Low nibble (bits 0-3) = 0
-        if ((retVal=command(SSD1306_SETLOWCOLUMN | (column & 0x0f))) != 0) {return retVal;}
-        // Column High nibble (bits 4-7) = 0
-        if ((retVal=command(SSD1306_SETHIGHCOLUMN | ((column>>4) & 0x0f))) != 0) {return retVal;}
-    }
-    oldColBlock = colBlock;
+        //Skip clean blocks
+        while((dirtyRow & 0x01) == 0) {
+            dirtyRow >>= 1;
+            colStart++;
+        }
+        //Find end of run
+        colEnd = colStart;
+        while((dirtyRow & 0x02) != 0) {
+            dirtyRow >>= 1;
+            colEnd++;
+        }
+        dirtyRow >>= 1;
+
+        MX_DEBUG("\r\nOLED.display %d,%d-%d", rowBlock, colStart, colEnd);
+
+        //Set column and page window - used for "Horizontal Address Mode"
+        win[0] = SSD1306_SET_COLUMN_ADR;
+        win[1] = colStart * 16;             //Column Start
+        win[2] = (colEnd * 16) + 15;        //Column End
+        win[3] = SSD1306_SET_PAGE_ADR;
+        win[4] = rowBlock;                  //Page Start. Each page = 8 rows
+        win[5] = rowBlock;                  //Page End
+        if ((retVal=commands(win, sizeof(win))) != 0) {return retVal;}
+
+        //Each byte of buffer contains 8pixels for single column, and 8 rows. For example:
+        //buffer[0] contains row 0-7 for column 0
+        //buffer[1] contains row 0-7 for column 1
+        if ((retVal=sendDisplayData(&buffer[(rowBlock*_rawWidth) + (colStart*16)], (colEnd-colStart+1)*16)) != 0) {
+            return retVal;  //Return error
+        }
+        dirty[rowBlock] &= ~(((uint32_t)2 << colEnd) - ((uint32_t)1 << colStart));
 
-    if ((retVal=sendDisplayBuffer(rowBlock, colBlock)) != 0) {
-        return retVal;  //Return error
+        colStart = colEnd + 1;
     }
 
+    rowBlock = (rowBlock+1) % (OLED_HEIGHT/8);
+
     return 0;   //Success
+}
 
-    //----- Alternative Method -----
-    //If used, MUST ALSO update begin() function to initialize with "Horizontal Address Mode"
-//    // Horizontal Address Mode ////////////////////////////////////////////////
-//    //Set "Horizontal Address Mode". This mode requires SSD1306_SET_COLUMN_ADR and SSD1306_SET_PAGE_ADR
-//    //commands to set start/stop column & page
-//    if ((retVal=command(SSD1306_MEMORYMODE)) != 0) {return retVal;}     //Set "Horizontal Address Mode"
-//    if ((retVal=command(0)) != 0) {return retVal;}
-//
-//    //Set column Start and End, used for "Horizontal Address Mode".
-//    if ((retVal=command(SSD1306_SET_COLUMN_ADR)) != 0) {return retVal;}
-//    if ((retVal=command(0)) != 0) {return retVal;}    //Column 0 - first column
-//    if ((retVal=command(127)) != 0) {return retVal;}  //Column 7 - last column
-//
-//    //Set page Start and End, used for "Horizontal Address Mode".
-//    if ((retVal=command(SSD1306_SET_PAGE_ADR)) != 0) {return retVal;}
-//    if ((retVal=command(0)) != 0) {return retVal;}    //Page 0 - first page
-//    if ((retVal=command(7)) != 0) {return retVal;}    //Page 7 - last page
-//
-//    for(rowBlock=0; rowBlock<8; rowBlock++) {
-//        for(colBlock=0; colBlock<8; colBlock++) {
-//            if ((retVal=sendDisplayBuffer(rowBlock, colBlock)) != 0) {
-//                return retVal;  //Return error
-//            }
-//        }
-//    }
+/** Send multiple commands. Default implementation sends them one at a time.
+ * @return 0 if success, else I2C or SPI error code
+ */
+uint8_t MxSSD1306::commands(const uint8_t* c, uint8_t len)
+{
+    uint8_t retVal;
+    for(uint8_t i=0; i<len; i++) {
+        if ((retVal=command(c[i])) != 0) {
+            return retVal;
+        }
+    }
+    return 0;
 }
 
 
@@ -352,7 +523,6 @@ void MxSSD1306::clearDisplay(void)
 
 // Set whole display as being dirty
 void MxSSD1306::setAllDirty(void) {
-    colBlock = 0;
     rowBlock = 0xf0;    //Mark with 0xf0 so SSD1306_MEMORYMODE command is sent again in display() function
     //Set whole display as Dirty
 #if (OLED_WIDTH == 128) //Each entry of dirty[] is a UINT8, and each bit is 16 columns
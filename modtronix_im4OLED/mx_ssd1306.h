@@ -32,6 +32,14 @@ All text above, and the splash screen must be included in any redistribution
 
 #define OLED_HAS_RESET      0
 
+//Use interrupt driven I2C queue of HAL for MxSSD1306_I2C
+#if (OLED_I2C_QUEUE==1) && defined(DEVICE_I2C_QUEUE) && (DEVICE_I2C_QUEUE==1)
+#define MX_SSD1306_I2C_QUEUE    1
+#include "us_ticker_api.h"
+#else
+#define MX_SSD1306_I2C_QUEUE    0
+#endif
+
 // A DigitalOut sub-class that provides a constructed default state
 class DigitalOut2 : public DigitalOut
 {
@@ -45,6 +53,9 @@ public:
 #define SSD1306_EXTERNALVCC 0x1
 #define SSD1306_SWITCHCAPVCC 0x2
 
+//Returned by pollTransfers() while display data is still being sent
+#define SSD1306_BUSY        0xff
+
 /** The pure base class for the SSD1306 display driver.
  *
  * You should derive from this for a new transport interface type,
@@ -56,13 +67,11 @@ public:
 #if (OLED_HAS_RESET==1)
 	MxSSD1306(PinName RST, uint8_t rawHeight = 32, uint8_t rawWidth = 128)
 		: MxGfx(rawWidth,rawHeight)
-        , colBlock(0)
         , rowBlock(0)
 		, rst(RST,false)
 #else
     MxSSD1306(uint8_t rawHeight = 32, uint8_t rawWidth = 128)
         : MxGfx(rawWidth,rawHeight)
-        , colBlock(0)
         , rowBlock(0)
 #endif
 	{
@@ -84,8 +93,33 @@ public:
 	// These must be implemented in the derived transport driver
 	virtual uint8_t command(uint8_t c) = 0;
 	virtual uint8_t data(uint8_t c) = 0;
+
+    /** Send multiple commands. Default implementation calls command() for each, override to send them in a
+     * single transfer.
+     * @return 0 if success, else I2C or SPI error code
+     */
+	virtual uint8_t commands(const uint8_t* c, uint8_t len);
+
 	virtual void drawPixel(int16_t x, int16_t y, uint16_t color);
 
+#if (GFX_ENABLE_ABSTRACTS==1) || (GFX_SIZEABLE_TEXT==1)
+    /** Draw and fill a rectangle. Writes whole bytes of each page of the display buffer, and marks changed
+     * blocks dirty once per page. See MxGfx::fillRect() for parameters.
+     */
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    /// Draw a vertical line, see fillRect()
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+#endif
+
+#if (GFX_ENABLE_ABSTRACTS==1)
+    /// Draw a horizontal line, see fillRect()
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+
+    /// Fill the entire display, see fillRect()
+    virtual void fillScreen(uint16_t color);
+#endif
+
 	/**
 	 * Clear the display buffer. Requires a display() call at some point afterwards.
 	 * NOTE that this function will make the WHOLE display as dirty! The next display() call will update the
@@ -117,22 +151,52 @@ public:
 	virtual void splash();
     
 protected:
+    /** Check if display data sent by previous display() call is done. Only transports that send data without
+     * waiting for it (for example with interrupts) have to implement this.
+     * @return 0 if done, SSD1306_BUSY if still sending, else I2C or SPI error code
+     */
+    virtual uint8_t pollTransfers() { return 0; }
+
     /** Write contents of display buffer to OLED display.
      * @return 0 if success, else I2C or SPI error code
      */
 	virtual uint8_t sendDisplayBuffer() = 0;
 
-    /** Write a block of display data. The 128x64 pixels are divided into:
-     * - 8 RowBlocks, each with 8 rows. This is 1 page of the SSD1206
-     * - 8 ColBlocks, each with 16 columns.
+    /** Write display data to the current column/page window, as a single transfer. The display must be in
+     * "Horizontal Address Mode", with the window set by display(). The transfer might complete after returning,
+     * pData points to the display buffer and remains valid.
      *
-     * @param rowBlock Value 0-7 indicating what block of 8 rows to write. 0=0-7,
-     *        1=8-15, ...., 7=56-63
-     * @param colBlock Value 0-7 indicating what block of 16 columns to write. 0=0-15,
-     *        1=16-31, ...., 7=112-127
+     * @param pData Display data, each byte is 8 rows of a single column
+     * @param len Number of bytes to write, maximum is OLED_WIDTH
      * @return 0 if success, else I2C or SPI error code
      */
-    virtual uint8_t sendDisplayBuffer(uint8_t rowBlock, uint8_t colBlock) = 0;
+    virtual uint8_t sendDisplayData(const uint8_t* pData, uint16_t len) = 0;
+
+    /** Fill rectangle given in raw (not rotated) coordinates, that has already been clipped to the display.
+     * Only changed bytes are written, and their blocks marked dirty.
+     */
+    void fillRawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    /** Write the glyph columns of a character directly to the display buffer. Only supports rotation 0, and
+     * characters fully inside the display vertically.
+     */
+    virtual bool blitChar(int16_t x, int16_t y, const uint8_t* glyph, uint16_t color, uint16_t bg);
+
+    /** Write part of character glyph that is in given page
+     * @param shift Rows to shift glyph down (positive) or up (negative) to get the part in this page
+     * @param mask Rows of page that are part of the character
+     */
+    void blitCharPage(uint8_t page, int16_t x, const uint8_t* glyph, int8_t shift, uint8_t mask, uint16_t color, uint16_t bg);
+
+    /** Mark dirty blocks of a page containing given raw columns
+     * @param page Page (block of 8 rows) of display
+     * @param xFirst First column
+     * @param xLast Last column
+     */
+    inline void setDirty(uint8_t page, int16_t xFirst, int16_t xLast) {
+        //Set all bits from block of xFirst to block of xLast. Each bit is 16 columns
+        dirty[page] |= (((uint32_t)2 << (xLast/16)) - ((uint32_t)1 << (xFirst/16)));
+    }
 
 public:
     // Set whole display as being dirty
@@ -140,7 +204,7 @@ public:
 
     // Protected Data
 protected:
-    uint8_t colBlock, rowBlock;
+    uint8_t rowBlock;   //Next page (block of 8 rows) to check for dirty blocks
 
 #if (OLED_WIDTH <= 128 )
     uint8_t dirty[OLED_HEIGHT/8];   //Each bit marks block of "8 Rows x 16 Columns". So, a single byte is enough for up to 128col. One byte for each 8 rows.
@@ -260,6 +324,22 @@ protected:
 		return 0;
 	};
 
+	virtual uint8_t sendDisplayData(const uint8_t* pData, uint16_t len)
+	{
+	    uint8_t retVal;
+	    cs = 1;
+	    dc = 1;
+	    cs = 0;
+	    for(uint16_t i=0; i<len; i++) {
+	        if((retVal=mspi.write(pData[i])) != 0) {
+	            cs = 1;
+	            return retVal;
+	        }
+	    }
+	    cs = 1;
+	    return 0;
+	};
+
 	DigitalOut2 cs, dc;
 	SPI &mspi;
 };
@@ -291,6 +371,10 @@ public:
 #endif
         , mi2c(i2c)
 	    , mi2cAddress(i2cAddress)
+#if (MX_SSD1306_I2C_QUEUE==1)
+        , cmdBufPos(0)
+        , transferErr(0)
+#endif
     {
         begin();
         splash();
@@ -313,6 +397,10 @@ public:
      */
     MxSSD1306_I2C(uint8_t i2cAddress, I2C &i2c, uint8_t rawHeight = 32, uint8_t rawWidth = 128)
         : MxSSD1306(rawHeight, rawWidth), mi2c(i2c), mi2cAddress(i2cAddress)
+#if (MX_SSD1306_I2C_QUEUE==1)
+        , cmdBufPos(0)
+        , transferErr(0)
+#endif
     {
     };
 
@@ -351,6 +439,37 @@ public:
 		return mi2c.write(mi2cAddress, buff, sizeof(buff));
 	}
 
+    /** Send multiple commands via I2C, as a single transfer
+     * @param c The commands to send
+     * @param len Number of commands, maximum is 8
+     * @return 0 if success, else I2C error
+     */
+    virtual uint8_t commands(const uint8_t* c, uint8_t len)
+	{
+#if (MX_SSD1306_I2C_QUEUE==1)
+        i2c_t* pI2c = getI2cObj();
+
+        //Commands are copied to cmdBuf, and sent after any queued display data
+        if (i2c_queue_busy(pI2c) == 0) {
+            cmdBufPos = 0;
+        }
+        else if ((cmdBufPos + len) > sizeof(cmdBuf)) {
+            if (i2c_queue_wait(pI2c) != 0) {
+                return 1;   //Return error code
+            }
+            cmdBufPos = 0;
+        }
+        memcpy(&cmdBuf[cmdBufPos], c, len);
+        cmdBufPos += len;
+        return queueWrite(0, (const char*)&cmdBuf[cmdBufPos-len], len);  // Command Mode, all following bytes are commands
+#else
+		char buff[9];
+		buff[0] = 0; // Command Mode, all following bytes are commands
+		memcpy(&buff[1], c, len);
+		return mi2c.write(mi2cAddress, buff, len+1);
+#endif
+	}
+
     /** Send Data via I2C
      * @param c The data to send
      * @return 0 if success, else I2C error
@@ -389,43 +508,87 @@ protected:
         return 0;
 	};
 
-    /** Write a block of display data. The 128x64 pixels are divided into:
-     * - 8 RowBlocks, each with 8 rows. This is 1 page of the SSD1206
-     * - 8 ColBlocks, each with 16 columns.
-     *
-     * @param rowBlock Value 0-7 indicating what block of 8 rows to write. 0=0-7,
-     *        1=8-15, ...., 7=56-63
-     * @param colBlock Value 0-7 indicating what block of 16 columns to write. 0=0-15,
-     *        1=16-31, ...., 7=112-127
-     * @return 0 if success, else I2C or SPI error code
+    /** Write display data to the current column/page window, as a single I2C transfer.
+     * @param pData Display data, each byte is 8 rows of a single column
+     * @param len Number of bytes to write, maximum is OLED_WIDTH
+     * @return 0 if success, else I2C error code
      */
-    uint8_t sendDisplayBuffer(uint8_t rowBlock, uint8_t colBlock) {
-        uint8_t retVal;
-        int idxBuffer;
-        char buff[17];
+    virtual uint8_t sendDisplayData(const uint8_t* pData, uint16_t len) {
+#if (MX_SSD1306_I2C_QUEUE==1)
+        //Send directly from display buffer, without copying
+        return queueWrite(0x40, (const char*)pData, len);   // Data Mode
+#else
+        char buff[OLED_WIDTH+1];
 
         buff[0] = 0x40; // Data Mode
+        memcpy(&buff[1], pData, len);
+
+        //Write all display data
+        return mi2c.write(mi2cAddress, buff, len+1);
+#endif
+    }
+
+#if (MX_SSD1306_I2C_QUEUE==1)
+    /** Check if queued display data has been sent
+     * @return 0 if done, SSD1306_BUSY if still sending, else I2C error code
+     */
+    virtual uint8_t pollTransfers() {
+        if (i2c_queue_busy(getI2cObj()) != 0) {
+            //Timeout, abort queue. Returns error below
+            if ((us_ticker_read() - tmrTransfer) > (OLED_I2C_QUEUE_TIMEOUT*1000)) {
+                i2c_queue_abort(getI2cObj());
+            }
+            else {
+                return SSD1306_BUSY;
+            }
+        }
+        if (transferErr != 0) {
+            transferErr = 0;
+            return 1;   //Return error code
+        }
+        return 0;
+    }
 
-        //Each byte of buffer contains 8pixels for single column, and 8 rows. For example:
-        //buffer[0] contains row 0-7 for column 0
-        //buffer[1] contains row 0-7 for column 1
-        idxBuffer = (rowBlock*128) + (colBlock*16);
+    /** Queue a write. If queue is full, wait for it to empty.
+     * @return 0 if success, else I2C error code
+     */
+    uint8_t queueWrite(int prefix, const char* data, int len) {
+        i2c_t* pI2c = getI2cObj();
 
-        // Copy requested "row block" and "column block"
-        for(uint16_t i=0; i<16; i++) {
-            buff[i+1] = buffer[idxBuffer+i];
+        if (i2c_queue_busy(pI2c) == 0) {
+            tmrTransfer = us_ticker_read();
+        }
+        if (i2c_queue_write(pI2c, mi2cAddress, prefix, data, len, &transferDone, this) != 0) {
+            if ((i2c_queue_wait(pI2c) != 0)
+                    || (i2c_queue_write(pI2c, mi2cAddress, prefix, data, len, &transferDone, this) != 0)) {
+                return 1;   //Return error code
+            }
         }
+        return 0;
+    }
 
-        //Write all display data
-        if((retVal=mi2c.write(mi2cAddress, buff, 17)) != 0) {
-            return retVal;  //Return error code
+    /** Called from I2C interrupt when a queued transfer is done */
+    static void transferDone(void* context, int result) {
+        if (result != 0) {
+            ((MxSSD1306_I2C*)context)->transferErr = 1;
         }
+    }
 
-        return 0;
+    /** Get HAL I2C object of mi2c */
+    i2c_t* getI2cObj() {
+        return mi2c.get_hal_obj();
     }
+#endif
 
 	I2C &mi2c;
 	uint8_t mi2cAddress;
+
+#if (MX_SSD1306_I2C_QUEUE==1)
+    uint8_t cmdBuf[6*(OLED_WIDTH/32)];  //Queued commands. Enough for window commands of all runs of a page
+    uint8_t cmdBufPos;
+    volatile uint8_t transferErr;       //Set by transferDone() if a queued transfer failed
+    uint32_t tmrTransfer;               //us_ticker value when queue was started
+#endif
 };
 
 #endif
@@ -63,23 +63,63 @@ InAir::InAir( void ( *txDone )( ), void ( *txTimeout ) ( ), void ( *rxDone ) ( u
                 nss( nss ),
                 reset( reset ),
                 dio0( dio0 ), dio1( dio1 ), dio2( dio2 ), dio3( dio3 ),
-                isRadioActive( false )
+                isRadioActive( false ),
+                resetBusy( false ),
+                initState( INAIR_INIT_COLD )
 {
-    wait_ms( 10 );
     this->rxTx = 0;
     this->rxBuffer = new uint8_t[RX_BUFFER_SIZE];
     previousOpMode = RF_OPMODE_STANDBY;
+    memset( channelPlan, 0, sizeof( channelPlan ) );
+    channelPlanNext = 0;
+    memset( &calLast, 0, sizeof( calLast ) );
+#if (INAIR_ENABLE_WARM_START==1)
+    regImageValid = false;
+#endif
+#if (INAIR_FHSS_MAX_CHANNELS > 0)
+    fhssChannels = 0;
+#endif
     
     this->settings.State = IDLE;
 
-    // From sx1276-inAir Constructor //////////////////////////////////////////
+    boardConnected = BOARD_UNKNOWN;
+
+    IoInit( );
+
+    // The radio could have just been powered up, so wait RADIO_POWER_UP_TIME instead of RADIO_RESET_TIME before
+    // accessing it. The remaining initialization is done by InitTask() once it is ready.
     Reset( );
+    resetTimer.attach_us( this, &InAir::OnResetDoneIrq, RADIO_POWER_UP_TIME );
+}
 
-    boardConnected = BOARD_UNKNOWN;
+InAir::~InAir( )
+{
+    delete this->rxBuffer;
+}
 
-    RxChainCalibration( );
+bool InAir::InitTask( void )
+{
+    if( initState == INAIR_INIT_DONE )
+    {
+        return true;
+    }
 
-    IoInit( );
+    // Radio can not be accessed yet
+    if( resetBusy )
+    {
+        return false;
+    }
+
+#if (INAIR_ENABLE_WARM_START==1)
+    if( initState == INAIR_INIT_WARM )
+    {
+        RestoreRegisterImage( );
+        initState = INAIR_INIT_DONE;
+        return true;
+    }
+#endif
+
+    RxChainCalibration( );
 
     SetOpMode( RF_OPMODE_SLEEP );
 
@@ -89,12 +129,9 @@ InAir::InAir( void ( *txDone )( ), void ( *txTimeout ) ( ), void ( *rxDone ) ( u
 
     SetModem( MODEM_LORA );
 
-    this->settings.State = IDLE ;
-}
-
-InAir::~InAir( )
-{
-    delete this->rxBuffer;
+    this->settings.State = IDLE;
+    initState = INAIR_INIT_DONE;
+    return true;
 }
 
 void InAir::task(void)
@@ -174,41 +211,109 @@ uint8_t InAir::GetBoardType( void )
 
 void InAir::SetBoardType( uint8_t boardType)
 {
+    uint8_t i;
+
     boardConnected = boardType;
+
+    // PA select depends on board type, invalidate channel plan cache
+    for( i = 0; i < INAIR_CHANNEL_CACHE_SIZE; i++ )
+    {
+        channelPlan[i].Valid = false;
+    }
 }
 
 void InAir::RxChainCalibration( void )
 {
     uint8_t regPaConfigInitVal;
+    uint8_t frf[3];
     uint32_t initialFreq;
+    int8_t temp;
 
     // Save context
     regPaConfigInitVal = this->Read( REG_PACONFIG );
-    initialFreq = ( double )( ( ( uint32_t )this->Read( REG_FRFMSB ) << 16 ) |
-                              ( ( uint32_t )this->Read( REG_FRFMID ) << 8 ) |
-                              ( ( uint32_t )this->Read( REG_FRFLSB ) ) ) * ( double )FREQ_STEP;
+    this->Read( REG_FRFMSB, frf, 3 );
+    initialFreq = FrfToFreq( ( ( uint32_t )frf[0] << 16 ) | ( ( uint32_t )frf[1] << 8 ) | ( uint32_t )frf[2] );
 
     // Cut the PA just in case, RFO output, power = -1 dBm
     this->Write( REG_PACONFIG, 0x00 );
 
-    // Launch Rx chain calibration for LF band
+    temp = ReadTemperatureFsk( );
+
+    // Launch Rx chain calibration for LF band, at reset frequency of 434MHz
+    ImageCalibration( );
+
+    // Sets a Frequency in HF band
+    SetChannel( 868000000 );
+
+    // Launch Rx chain calibration for HF band. Chip only keeps this last calibration
+    ImageCalibration( );
+    calLast.Valid = true;
+    calLast.HighBand = true;
+    calLast.Temperature = temp;
+
+    // Restore context
+    this->Write( REG_PACONFIG, regPaConfigInitVal );
+    SetChannel( initialFreq );
+}
+
+void InAir::ImageCalibration( void )
+{
     Write ( REG_IMAGECAL, ( Read( REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_MASK ) | RF_IMAGECAL_IMAGECAL_START );
     while( ( Read( REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_RUNNING ) == RF_IMAGECAL_IMAGECAL_RUNNING )
     {
     }
+}
 
-    // Sets a Frequency in HF band
-    settings.Channel=  868000000 ;
+int8_t InAir::ReadTemperatureFsk( void )
+{
+    // Temperature is measured when entering FSRx mode, takes about 140us
+    SetOpMode( RF_OPMODE_SYNTHESIZER_RX );
+    wait_us( 150 );
+    SetOpMode( RF_OPMODE_STANDBY );
 
-    // Launch Rx chain calibration for HF band 
-    Write ( REG_IMAGECAL, ( Read( REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_MASK ) | RF_IMAGECAL_IMAGECAL_START );
-    while( ( Read( REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_RUNNING ) == RF_IMAGECAL_IMAGECAL_RUNNING )
+    // Register value is a signed value with inverted sign
+    return -( int8_t )Read( REG_TEMP );
+}
+
+bool InAir::CalibrateIfRequired( void )
+{
+    ModemType modem = this->settings.Modem;
+    bool highBand = GetChannelPlan( this->settings.Channel )->HighBand;
+    uint8_t regPaConfigInitVal;
+    int8_t temp;
+    int8_t diff;
+
+    // Temperature sensor and image calibration are only accessible in FSK mode
+    SetModem( MODEM_FSK );
+    SetOpMode( RF_OPMODE_STANDBY );
+
+    temp = ReadTemperatureFsk( );
+    diff = temp - calLast.Temperature;
+    if( diff < 0 )
     {
+        diff = -diff;
     }
 
-    // Restore context
-    this->Write( REG_PACONFIG, regPaConfigInitVal );
-    SetChannel( initialFreq );
+    if( ( calLast.Valid == true ) && ( calLast.HighBand == highBand ) && ( diff < INAIR_CAL_TEMP_THRESHOLD ) )
+    {
+        SetModem( modem );
+        SetOpMode( RF_OPMODE_SLEEP );
+        return false;
+    }
+
+    // Cut the PA just in case
+    regPaConfigInitVal = Read( REG_PACONFIG );
+    Write( REG_PACONFIG, 0x00 );
+
+    ImageCalibration( );
+    calLast.Valid = true;
+    calLast.HighBand = highBand;
+    calLast.Temperature = temp;
+
+    Write( REG_PACONFIG, regPaConfigInitVal );
+    SetModem( modem );
+    SetOpMode( RF_OPMODE_SLEEP );
+    return true;
 }
 
 RadioState InAir::GetStatus( void )
@@ -218,12 +323,92 @@ RadioState InAir::GetStatus( void )
 
 void InAir::SetChannel( uint32_t freq )
 {
+    const ChannelPlan_t* plan = GetChannelPlan( freq );
+
     this->settings.Channel = freq;
-    freq = ( uint32_t )( ( double )freq / ( double )FREQ_STEP );
-    Write( REG_FRFMSB, ( uint8_t )( ( freq >> 16 ) & 0xFF ) );
-    Write( REG_FRFMID, ( uint8_t )( ( freq >> 8 ) & 0xFF ) );
-    Write( REG_FRFLSB, ( uint8_t )( freq & 0xFF ) );
+    Write( REG_FRFMSB, ( uint8_t* )plan->Frf, 3 );
+}
+
+const ChannelPlan_t* InAir::GetChannelPlan( uint32_t freq )
+{
+    uint8_t i;
+    uint32_t frf;
+    ChannelPlan_t* plan;
+
+    for( i = 0; i < INAIR_CHANNEL_CACHE_SIZE; i++ )
+    {
+        if( ( channelPlan[i].Valid == true ) && ( channelPlan[i].Freq == freq ) )
+        {
+            return &channelPlan[i];
+        }
+    }
+
+    // Not found, replace oldest entry
+    plan = &channelPlan[channelPlanNext];
+    if( ++channelPlanNext >= INAIR_CHANNEL_CACHE_SIZE )
+    {
+        channelPlanNext = 0;
+    }
+
+    frf = FreqToFrf( freq );
+    plan->Freq = freq;
+    plan->Frf[0] = ( uint8_t )( ( frf >> 16 ) & 0xFF );
+    plan->Frf[1] = ( uint8_t )( ( frf >> 8 ) & 0xFF );
+    plan->Frf[2] = ( uint8_t )( frf & 0xFF );
+    plan->PaSelect = GetPaSelect( freq );
+    plan->HighBand = ( freq > RF_MID_BAND_THRESH );
+    plan->Valid = true;
+    return plan;
+}
+
+#if (INAIR_FHSS_MAX_CHANNELS > 0)
+bool InAir::SetHopTable( uint32_t baseFreq, uint32_t spacing, uint8_t numChannels, uint32_t seed )
+{
+    uint8_t order[INAIR_FHSS_MAX_CHANNELS];
+    uint8_t i, j, tmp;
+    uint32_t frf;
+
+    if( ( numChannels == 0 ) || ( numChannels > INAIR_FHSS_MAX_CHANNELS ) )
+    {
+        return false;
+    }
+
+    // Disable hopping while table is updated
+    fhssChannels = 0;
+
+    // Shuffle channel order (Fisher-Yates), using xorshift32 pseudo random generator. Seed may not be 0.
+    if( seed == 0 )
+    {
+        seed = 0x2545F491;
+    }
+    for( i = 0; i < numChannels; i++ )
+    {
+        order[i] = i;
+    }
+    for( i = numChannels - 1; i > 0; i-- )
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        j = seed % ( i + 1 );
+        tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    // Precompute FRF register values for all channels
+    for( i = 0; i < numChannels; i++ )
+    {
+        frf = FreqToFrf( baseFreq + ( order[i] * spacing ) );
+        fhssFrf[i][0] = ( uint8_t )( ( frf >> 16 ) & 0xFF );
+        fhssFrf[i][1] = ( uint8_t )( ( frf >> 8 ) & 0xFF );
+        fhssFrf[i][2] = ( uint8_t )( frf & 0xFF );
+    }
+
+    fhssChannels = numChannels;
+    return true;
 }
+#endif
 
 bool InAir::IsChannelFree( ModemType modem, uint32_t freq, int8_t rssiThresh )
 {
@@ -476,7 +661,7 @@ void InAir::SetTxConfig( ModemType modem, int8_t power, uint32_t fdev,
     paConfig = Read( REG_PACONFIG );
     paDac = Read( REG_PADAC );
 
-    paConfig = ( paConfig & RF_PACONFIG_PASELECT_MASK ) | GetPaSelect( this->settings.Channel );
+    paConfig = ( paConfig & RF_PACONFIG_PASELECT_MASK ) | GetChannelPlan( this->settings.Channel )->PaSelect;
     paConfig = ( paConfig & RF_PACONFIG_MAX_POWER_MASK ) | 0x70;
 
     if( ( paConfig & RF_PACONFIG_PASELECT_PABOOST ) == RF_PACONFIG_PASELECT_PABOOST )
@@ -896,6 +1081,14 @@ void InAir::Rx( uint32_t timeout )
                                               
                 // DIO0=RxDone, DIO2=FhssChangeChannel
                 Write( REG_DIOMAPPING1, ( Read( REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK & RFLR_DIOMAPPING1_DIO2_MASK  ) | RFLR_DIOMAPPING1_DIO0_00 | RFLR_DIOMAPPING1_DIO2_00 );
+
+#if (INAIR_FHSS_MAX_CHANNELS > 0)
+                // Start on first channel of hop table
+                if( fhssChannels != 0 )
+                {
+                    Write( REG_FRFMSB, fhssFrf[0], 3 );
+                }
+#endif
             }
             else
             {
@@ -994,6 +1187,14 @@ void InAir::Tx( uint32_t timeout )
                 Write( REG_DIOMAPPING1, ( Read( REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK ) | RFLR_DIOMAPPING1_DIO0_01 );
                 // DIO2=FhssChangeChannel
                 Write( REG_DIOMAPPING1, ( Read( REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO2_MASK ) | RFLR_DIOMAPPING1_DIO2_00 );  
+
+#if (INAIR_FHSS_MAX_CHANNELS > 0)
+                // Start on first channel of hop table
+                if( fhssChannels != 0 )
+                {
+                    Write( REG_FRFMSB, fhssFrf[0], 3 );
+                }
+#endif
             }
             else
             {
@@ -1174,6 +1375,7 @@ void InAir::OnTimeoutIrq( void )
 void InAir::OnDio0Irq( void )
 {
     __IO uint8_t irqFlags = 0;
+    MX_PROFILE_SCOPE(MX_PROF_DIO0_IRQ);
   
     switch( this->settings.State )
     {                
@@ -1495,13 +1697,7 @@ void InAir::OnDio2Irq( void )
             case MODEM_LORA:
                 if( this->settings.LoRa.FreqHopOn == true )
                 {
-                    // Clear Irq
-                    Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL );
-                    
-                    if( ( fhssChangeChannel != NULL ) )
-                    {
-                        fhssChangeChannel( ( Read( REG_LR_HOPCHANNEL ) & RFLR_HOPCHANNEL_CHANNEL_MASK ) );
-                    }
+                    OnFhssChangeChannelIrq( );
                 }    
                 break;
             default:
@@ -1516,13 +1712,7 @@ void InAir::OnDio2Irq( void )
             case MODEM_LORA:
                 if( this->settings.LoRa.FreqHopOn == true )
                 {
-                    // Clear Irq
-                    Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL );
-                    
-                    if( ( fhssChangeChannel != NULL ) )
-                    {
-                        fhssChangeChannel( ( Read( REG_LR_HOPCHANNEL ) & RFLR_HOPCHANNEL_CHANNEL_MASK ) );
-                    }
+                    OnFhssChangeChannelIrq( );
                 }    
                 break;
             default:
@@ -1534,6 +1724,29 @@ void InAir::OnDio2Irq( void )
     }
 }
 
+void InAir::OnFhssChangeChannelIrq( void )
+{
+    uint8_t channel;
+
+    // Clear Irq
+    Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL );
+
+    channel = Read( REG_LR_HOPCHANNEL ) & RFLR_HOPCHANNEL_CHANNEL_MASK;
+
+#if (INAIR_FHSS_MAX_CHANNELS > 0)
+    // Set next channel with a single burst write, FRF values were calculated in SetHopTable()
+    if( fhssChannels != 0 )
+    {
+        Write( REG_FRFMSB, fhssFrf[channel % fhssChannels], 3 );
+    }
+#endif
+
+    if( ( fhssChangeChannel != NULL ) )
+    {
+        fhssChangeChannel( channel );
+    }
+}
+
 void InAir::OnDio3Irq( void )
 {
     switch( this->settings.Modem )
@@ -1603,13 +1816,113 @@ void InAir::OnDio5Irq( void )
 
 void InAir::Reset( void )
 {
+    // Datasheet requires reset to be low for at least 100us, and 5ms before radio is ready. InitTask() continues
+    // once resetTimer expired.
+    resetBusy = true;
+    initState = INAIR_INIT_COLD;
     reset.output();
     reset = 0;
-    wait_ms( 1 );
+    wait_us( 100 );
     reset.input();
-    wait_ms( 6 );
+    resetTimer.attach_us( this, &InAir::OnResetDoneIrq, RADIO_RESET_TIME );
 }
 
+void InAir::OnResetDoneIrq( void )
+{
+    resetBusy = false;
+}
+
+#if (INAIR_ENABLE_WARM_START==1)
+/*!
+ * Writable configuration registers restored by WarmStart(), as ranges of consecutive registers. Read only,
+ * reserved, IRQ flag and calibration registers are not restored.
+ */
+typedef struct
+{
+    uint8_t Addr;
+    uint8_t Count;
+} RegRange_t;
+
+static const RegRange_t RegImageLoRa[] =
+{
+    { 0x06, 10 },   //RegFrfMsb - RegFifoRxBaseAddr
+    { 0x11, 1 },    //RegIrqFlagsMask
+    { 0x1D, 8 },    //RegModemConfig1 - RegHopPeriod
+    { 0x26, 2 },    //RegModemConfig3, RegPpmCorrection
+    { 0x31, 1 },    //RegDetectOptimize
+    { 0x33, 1 },    //RegInvertIQ
+    { 0x37, 1 },    //RegDetectionThreshold
+    { 0x39, 1 },    //RegSyncWord
+    { 0x40, 2 },    //RegDioMapping1, RegDioMapping2
+    { 0x4B, 1 },    //RegTcxo
+    { 0x4D, 1 },    //RegPaDac
+};
+
+static const RegRange_t RegImageFsk[] =
+{
+    { 0x06, 11 },   //RegFrfMsb - RegRssiThresh
+    { 0x12, 5 },    //RegRxBw - RegOokAvg
+    { 0x1A, 1 },    //RegAfcFei
+    { 0x1F, 28 },   //RegPreambleDetect - RegTimer2Coef
+    { 0x3D, 1 },    //RegLowBat
+    { 0x40, 2 },    //RegDioMapping1, RegDioMapping2
+    { 0x44, 1 },    //RegPllHop
+    { 0x4B, 1 },    //RegTcxo
+    { 0x4D, 1 },    //RegPaDac
+};
+
+void InAir::SaveRegisterImage( void )
+{
+    regImageOpMode = Read( REG_OPMODE );
+    Read( INAIR_REG_IMAGE_START, regImage, INAIR_REG_IMAGE_SIZE );
+    regImageValid = true;
+}
+
+bool InAir::WarmStart( void )
+{
+    if( regImageValid == false )
+    {
+        return false;
+    }
+
+    // Register image is restored by InitTask() once radio is ready
+    Reset( );
+    initState = INAIR_INIT_WARM;
+    return true;
+}
+
+void InAir::RestoreRegisterImage( void )
+{
+    const RegRange_t* ranges;
+    uint8_t count;
+    uint8_t i;
+
+    // Modem can only be changed in sleep mode
+    Write( REG_OPMODE, RF_OPMODE_SLEEP );
+    Write( REG_OPMODE, ( regImageOpMode & RF_OPMODE_MASK ) | RF_OPMODE_SLEEP );
+    previousOpMode = RF_OPMODE_SLEEP;
+
+    if( ( regImageOpMode & RFLR_OPMODE_LONGRANGEMODE_ON ) != 0 )
+    {
+        ranges = RegImageLoRa;
+        count = sizeof( RegImageLoRa ) / sizeof( RegRange_t );
+    }
+    else
+    {
+        ranges = RegImageFsk;
+        count = sizeof( RegImageFsk ) / sizeof( RegRange_t );
+    }
+
+    // One burst write for each range of writable registers
+    for( i = 0; i < count; i++ )
+    {
+        Write( ranges[i].Addr, &regImage[ranges[i].Addr - INAIR_REG_IMAGE_START], ranges[i].Count );
+    }
+
+    this->settings.State = IDLE;
+}
+#endif
+
 void InAir::Write( uint8_t addr, uint8_t data )
 {
     Write( addr, &data, 1 );
@@ -1688,11 +2001,26 @@ static const RadioRegisters_t RadioRegsInit[] =
 };
 
 void InAir::RadioRegistersInit( ) {
-    uint8_t i = 0;
-    for( i = 0; i < sizeof( RadioRegsInit ) / sizeof( RadioRegisters_t ); i++ )
+    uint8_t i, n;
+    uint8_t buf[sizeof( RadioRegsInit ) / sizeof( RadioRegisters_t )];
+    const uint8_t count = sizeof( RadioRegsInit ) / sizeof( RadioRegisters_t );
+
+    // RadioRegsInit is grouped by modem, so modem only changes once. Consecutive registers are written in a
+    // single burst write.
+    for( i = 0; i < count; i += n )
     {
         SetModem( RadioRegsInit[i].Modem );
-        Write( RadioRegsInit[i].Addr, RadioRegsInit[i].Value );
+        buf[0] = RadioRegsInit[i].Value;
+        for( n = 1; ( i + n ) < count; n++ )
+        {
+            if( ( RadioRegsInit[i + n].Modem != RadioRegsInit[i].Modem ) ||
+                ( RadioRegsInit[i + n].Addr != ( RadioRegsInit[i].Addr + n ) ) )
+            {
+                break;
+            }
+            buf[n] = RadioRegsInit[i + n].Value;
+        }
+        Write( RadioRegsInit[i].Addr, buf, n );
     }
 }
 
@@ -1708,7 +2036,6 @@ void InAir::SpiInit( void )
     #else
         #warning "Check the board's SPI frequency"
     #endif
-    wait(0.1);
 }
 
 void InAir::IoIrqInit()
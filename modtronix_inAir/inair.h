@@ -17,6 +17,10 @@ Maintainers: Miguel Luis, Gregory Cristian and Nicolas Huguenin
 
 #include "inair_default_config.h"
 #include "radio.h"
+#if (INAIR_USE_MX_TIMEOUT==1)
+#include "mx_timer_wheel.h"
+#include "mx_profile.h"
+#endif
 #include "sx1276Regs-Fsk.h"
 #include "sx1276Regs-LoRa.h"
 
@@ -36,6 +40,12 @@ Maintainers: Miguel Luis, Gregory Cristian and Nicolas Huguenin
  */
 #define RADIO_WAKEUP_TIME                           1000 // [us]
 
+/*!
+ * Time from end of reset, and from power up, until radio can be accessed. Datasheet requires 5ms and 10ms
+ */
+#define RADIO_RESET_TIME                            6000 // [us]
+#define RADIO_POWER_UP_TIME                         10000 // [us]
+
 /*!
  * InAir definitions
  */
@@ -56,6 +66,22 @@ Maintainers: Miguel Luis, Gregory Cristian and Nicolas Huguenin
 
 #define RF_MID_BAND_THRESH                          525000000
 
+/*!
+ * Radio initialization state, see InAir::InitTask()
+ */
+enum InAirInitState
+{
+    INAIR_INIT_COLD = 0,    //Initialize all registers once radio is ready after reset
+    INAIR_INIT_WARM,        //Restore register image once radio is ready after reset
+    INAIR_INIT_DONE,        //Radio is ready
+};
+
+/*!
+ * Register range saved by SaveRegisterImage(), from RegFrfMsb to RegPaDac
+ */
+#define INAIR_REG_IMAGE_START                       0x06
+#define INAIR_REG_IMAGE_SIZE                        ( 0x4D - INAIR_REG_IMAGE_START + 1 )
+
 /*!
  * FSK bandwidth definition
  */
@@ -65,6 +91,18 @@ typedef struct
     uint8_t  RegValue;
 } FskBandwidth_t;
 
+/*!
+ * Channel plan, contains register values calculated for a channel frequency
+ */
+typedef struct
+{
+    uint32_t    Freq;       //Channel frequency [Hz]
+    uint8_t     Frf[3];     //RegFrfMsb, RegFrfMid and RegFrfLsb values
+    uint8_t     PaSelect;   //RegPaConfig PaSelect value
+    bool        HighBand;   //Above RF_MID_BAND_THRESH, uses HF band (RSSI offset and image calibration)
+    bool        Valid;
+} ChannelPlan_t;
+
 /*!
  * Radio registers definition
  */
@@ -132,9 +170,26 @@ protected:
     /*!
      * Tx and Rx timers
      */
+#if (INAIR_USE_MX_TIMEOUT==1)
+    MxTimeout txTimeoutTimer;
+    MxTimeout rxTimeoutTimer;
+    MxTimeout rxTimeoutSyncWord;
+#else
     Timeout txTimeoutTimer;
     Timeout rxTimeoutTimer;
     Timeout rxTimeoutSyncWord;
+#endif
+
+    /*!
+     * Reset timer, see Reset() and InitTask()
+     */
+#if (INAIR_USE_MX_TIMEOUT==1)
+    MxTimeout resetTimer;
+#else
+    Timeout resetTimer;
+#endif
+    volatile bool resetBusy;    //Radio not ready after reset yet, cleared by OnResetDoneIrq()
+    InAirInitState initState;
     
     /*!
      *  rxTx: [1: Tx, 0: Rx]
@@ -142,6 +197,41 @@ protected:
     uint8_t rxTx;
     
     RadioSettings_t settings;
+
+    /*!
+     * Channel plan cache, see GetChannelPlan()
+     */
+    ChannelPlan_t channelPlan[INAIR_CHANNEL_CACHE_SIZE];
+    uint8_t channelPlanNext;    //Next entry to replace on a cache miss
+
+    /*!
+     * Last image calibration. The SX1276 only holds the result of the last calibration, for a single band
+     */
+    struct
+    {
+        bool    Valid;
+        bool    HighBand;       //Band of last calibration
+        int8_t  Temperature;    //Temperature of last calibration
+    } calLast;
+
+#if (INAIR_ENABLE_WARM_START==1)
+    /*!
+     * Copy of radio registers, see SaveRegisterImage()
+     */
+    uint8_t regImage[INAIR_REG_IMAGE_SIZE];
+    uint8_t regImageOpMode; //RegOpMode when image was saved
+    bool regImageValid;
+#endif
+
+#if (INAIR_FHSS_MAX_CHANNELS > 0)
+    /*!
+     * FHSS hop table. Contains the precomputed RegFrfMsb, RegFrfMid and RegFrfLsb values for each hop channel, so
+     * the DIO2 FhssChangeChannel handler only has to do a single 3 byte burst write.
+     */
+    uint8_t fhssFrf[INAIR_FHSS_MAX_CHANNELS][3];
+
+    uint8_t fhssChannels;   //Number of channels in fhssFrf, 0 = no hop table configured
+#endif
     
     static const FskBandwidth_t FskBandwidths[] ;
 protected:
@@ -153,6 +243,20 @@ protected:
     */
     void RxChainCalibration( void );
 
+    /*!
+    * Runs the image calibration for the current frequency, and waits for it to finish.
+    * \remark Radio must be in FSK mode, standby
+    */
+    void ImageCalibration( void );
+
+    /*!
+    * Reads the temperature sensor. Value is relative (not calibrated), and can only be used to detect changes.
+    * \remark Radio must be in FSK mode, standby
+    *
+    * \retval Temperature in degrees C
+    */
+    int8_t ReadTemperatureFsk( void );
+
 public:
     InAir( void ( *txDone )( ), void ( *txTimeout ) ( ), void ( *rxDone ) ( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr ),
             void ( *rxTimeout ) ( ), void ( *rxError ) ( ), void ( *fhssChangeChannel ) ( uint8_t channelIndex ), void ( *cadDone ) ( bool channelActivityDetected ),
@@ -166,6 +270,15 @@ public:
      */
     virtual void task(void);
 
+    /*!
+     * @brief Continues initialization of the radio after the constructor, Reset() or WarmStart(). The radio can
+     *        only be accessed RADIO_POWER_UP_TIME or RADIO_RESET_TIME after that, and this function returns false
+     *        until then, without waiting. Call it from the main loop, and only use the radio once it returns true.
+     *
+     * @retval Returns true if the radio is ready, else false
+     */
+    bool InitTask( void );
+
     //-------------------------------------------------------------------------
     //                        Redefined Radio functions
     //-------------------------------------------------------------------------
@@ -205,6 +318,46 @@ public:
      * @param [IN] freq         Channel RF frequency
      */
     virtual void SetChannel( uint32_t freq );
+
+    /*!
+     * @brief Calibrates the RX chain for the band of the current channel, but only if the last calibration was
+     *        for a different band, or the temperature changed by INAIR_CAL_TEMP_THRESHOLD or more since then.
+     *        Call after SetChannel(), with the radio not receiving or transmitting. It leaves the radio in sleep.
+     *
+     * @retval Returns true if a calibration was done, else false
+     */
+    bool CalibrateIfRequired( void );
+
+#if (INAIR_FHSS_MAX_CHANNELS > 0)
+    /*!
+     * @brief Configures the FHSS hop table. The channels are "baseFreq + (n * spacing)" for n = 0 to numChannels-1,
+     *        and are put in a pseudo random order derived from the given seed. Both sides of a link must use the
+     *        same parameters. The FRF register values for all channels are calculated here, so no frequency
+     *        math is done when hopping.
+     *
+     * @param [IN] baseFreq     Frequency of first channel [Hz]
+     * @param [IN] spacing      Channel spacing [Hz]
+     * @param [IN] numChannels  Number of channels, 1 to INAIR_FHSS_MAX_CHANNELS
+     * @param [IN] seed         Seed used for pseudo random channel order
+     *
+     * @retval Returns true if OK, else false if numChannels is not valid
+     */
+    bool SetHopTable( uint32_t baseFreq, uint32_t spacing, uint8_t numChannels, uint32_t seed );
+
+    /*!
+     * @brief Clears the FHSS hop table. Radio will no longer change channels on FhssChangeChannel interrupts.
+     */
+    void ClearHopTable( void ) {
+        fhssChannels = 0;
+    }
+
+    /*!
+     * @brief Returns number of channels in FHSS hop table, or 0 if not configured
+     */
+    uint8_t GetHopChannels( void ) {
+        return fhssChannels;
+    }
+#endif
     
     /*!
      * @brief Sets the channels configuration
@@ -416,9 +569,38 @@ public:
     virtual void ReadFifo( uint8_t *buffer, uint8_t size );
 
     /*!
-     * @brief Resets the InAir
+     * @brief Resets the InAir. Returns after the reset pulse, the radio is ready RADIO_RESET_TIME later. All
+     *        registers are initialized again by InitTask(), which returns false until then.
      */
     virtual void Reset( void );
+
+#if (INAIR_ENABLE_WARM_START==1)
+    /*!
+     * @brief Saves a copy of the radio registers to RAM. Call once radio has been configured (after SetChannel,
+     *        SetTxConfig and SetRxConfig), with the radio not receiving or transmitting.
+     */
+    void SaveRegisterImage( void );
+
+    /*!
+     * @brief Resets the radio. Once it is ready, InitTask() restores the writable configuration registers saved
+     *        with SaveRegisterImage() using burst writes, instead of initializing all registers. Read only, reserved
+     *        and IRQ flag registers are not restored. Use after the radio was powered down, or the MCU was in STOP
+     *        mode, instead of creating and configuring it again. Returns after the reset pulse, without waiting.
+     *        Once InitTask() returns true the radio is in sleep mode, call Rx() or Send() to continue. Image
+     *        calibration is not repeated, call CalibrateIfRequired() if the temperature could have changed.
+     *
+     * @retval Returns true if OK, or false if no register image was saved
+     */
+    bool WarmStart( void );
+
+protected:
+    /*!
+     * @brief Writes the register image saved by SaveRegisterImage() to the radio, and puts it in sleep mode
+     */
+    void RestoreRegisterImage( void );
+
+public:
+#endif
     
     //-------------------------------------------------------------------------
     //                        Board relative functions
@@ -476,6 +658,12 @@ protected:
      */
     virtual void SetOpMode( uint8_t opMode );
 
+    /*!
+     * @brief Handles a LoRa FhssChangeChannel interrupt. Clears the interrupt, sets the next channel from the hop
+     *        table (if configured), and calls the fhssChangeChannel callback.
+     */
+    void OnFhssChangeChannelIrq( void );
+
     /*
      * InAir DIO IRQ callback functions prototype
      */
@@ -514,6 +702,11 @@ protected:
      * @brief Tx & Rx timeout timer callback
      */
     virtual void OnTimeoutIrq( void );
+
+    /*!
+     * @brief Reset timer callback, radio is ready after reset
+     */
+    void OnResetDoneIrq( void );
     
     /*!
      * Returns the known FSK bandwidth registers value
@@ -522,6 +715,40 @@ protected:
      * \retval regValue Bandwidth register value.
      */
     static uint8_t GetFskBandwidthRegValue( uint32_t bandwidth );
+
+    /*!
+     * Returns the channel plan for the given frequency. If not in the cache, it is calculated and replaces the
+     * oldest entry.
+     *
+     * \param [IN] freq Channel frequency in Hz
+     * \retval Channel plan for given frequency
+     */
+    const ChannelPlan_t* GetChannelPlan( uint32_t freq );
+
+public:
+    /*!
+     * Converts a frequency to the 24-bit RegFrf value, using integer math only.
+     * Gives exactly the same result as "(uint32_t)(freq / FREQ_STEP)".
+     *
+     * \param [IN] freq Frequency in Hz
+     * \retval RegFrf value
+     */
+    static inline uint32_t FreqToFrf( uint32_t freq ) {
+        //FREQ_STEP = XTAL_FREQ / 2^19 = 125000 / 2^11. Split to prevent 32-bit overflow.
+        return ( ( freq / 125000 ) << 11 ) + ( ( ( freq % 125000 ) << 11 ) / 125000 );
+    }
+
+    /*!
+     * Converts a 24-bit RegFrf value to a frequency, using integer math only.
+     * Gives exactly the same result as "(uint32_t)(frf * FREQ_STEP)".
+     *
+     * \param [IN] frf RegFrf value
+     * \retval Frequency in Hz
+     */
+    static inline uint32_t FrfToFreq( uint32_t frf ) {
+        //FREQ_STEP = 15625 / 2^8. Split to prevent 32-bit overflow.
+        return ( ( frf >> 8 ) * 15625 ) + ( ( ( frf & 0xFF ) * 15625 ) >> 8 );
+    }
 };
 
 #endif //__SX1276_H__
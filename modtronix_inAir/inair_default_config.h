@@ -48,6 +48,37 @@
 #define INAIR_DIO3_IS_INTERRUPT     0
 #endif
 
+//Set to 1 to use MxTimeout (MxTimerWheel in modtronix_NZ32S library) for TX and RX timeouts, instead of mbed Timeout.
+//Requires NZ32S_USE_TIMER_WHEEL.
+#if !defined(INAIR_USE_MX_TIMEOUT)
+#define INAIR_USE_MX_TIMEOUT        1
+#endif
+
+//Number of entries in channel plan cache. Each entry contains the FRF register values, PA select and band for a
+//frequency given to SetChannel(). Must be 1 or more.
+#if !defined(INAIR_CHANNEL_CACHE_SIZE)
+#define INAIR_CHANNEL_CACHE_SIZE    4
+#endif
+
+//Temperature change (in degrees C) since last image calibration, that will cause CalibrateIfRequired() to
+//calibrate again.
+#if !defined(INAIR_CAL_TEMP_THRESHOLD)
+#define INAIR_CAL_TEMP_THRESHOLD    10
+#endif
+
+//Enable warm start support. Uses INAIR_REG_IMAGE_SIZE bytes of RAM to save a copy of the radio registers, that can
+//be restored with burst writes after the radio was reset or powered down. See SaveRegisterImage() and WarmStart().
+//Disabled by default, the demo app resets the MCU after sleep, so it does not use WarmStart().
+#if !defined(INAIR_ENABLE_WARM_START)
+#define INAIR_ENABLE_WARM_START     0
+#endif
+
+//Maximum number of channels in FHSS hop table. Each channel uses 3 bytes of RAM (precomputed FRF register values).
+//Set to 0 to disable hop table support.
+#if !defined(INAIR_FHSS_MAX_CHANNELS)
+#define INAIR_FHSS_MAX_CHANNELS     16
+#endif
+
 
 // End of contents to copy to custom inair_defines.h file /////////////////////
 
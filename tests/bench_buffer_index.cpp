@@ -0,0 +1,196 @@
+/**
+ * File:      bench_buffer_index.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host benchmark of the index arithmetic of the buffers used for USB and the radio. Each buffer is compared with the
+ * original version taken from MX_LEGACY_REF (see CMakeLists.txt), which uses a uint32_t counter and a modulo. The
+ * current version uses MxBufferIndex (masks for power of 2 sizes) and the smallest counter type. A buffer size that
+ * is not a power of 2 is also measured, it uses a modulo.
+ *
+ * Each buffer is accessed through a put and get function that is not inlined, for example mxsize_usbisr_put(). The
+ * same functions are used for the timing, and for the code size printed by the "buffer_code_size" test (see
+ * code_size.cmake). Cycles are read with the x86 time stamp counter, and are only useful to compare the versions.
+ * They are NOT Cortex-M3 cycles, and the code size is for x86-64, not Thumb-2.
+ *
+ * The benchmark fails if a buffer does not return the data that was added.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <x86intrin.h>
+#include "mbed.h"
+#include "mx_circular_buffer.h"
+#include "mx_spsc_buffer.h"
+#include "mx_cmd_buffer.h"
+
+namespace legacy {
+#include "legacy/mx_circular_buffer.h"
+#include "legacy/mx_cmd_buffer.h"
+}
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define BYTES       4000000     //Bytes passed through each buffer
+#define REPEATS     5           //Best of REPEATS runs is used
+#define CHUNK       16          //Bytes added before they are read back, less than smallest buffer
+
+//Buffers used by the application, see app_defs.h and inair.h
+#define USB_CMD_SIZE    256     //RX_BUF_USB_SIZE
+#define USB_CMD_CMDS    16      //RX_BUF_USB_COMMANDS
+#define USB_ISR_SIZE    128     //RX_BUF_USB_ISR_SIZE
+#define RADIO_TX_SIZE   32      //RADIO_TXBUF_SIZE
+
+/** Define a put and get function for given buffer, that are not inlined. Their names start with "mxsize_", which is
+ * used by code_size.cmake to find them.
+ */
+#define MXSIZE_FUNCTIONS(name, type, buf)                                                       \
+    static type buf;                                                                            \
+    extern "C" __attribute__((noinline)) bool mxsize_##name##_put(uint8_t c) {                  \
+        return buf.put(c);                                                                      \
+    }                                                                                           \
+    extern "C" __attribute__((noinline)) uint8_t mxsize_##name##_get(void) {                    \
+        return buf.get();                                                                       \
+    }
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+typedef legacy::MxCircularBuffer<uint8_t, RADIO_TX_SIZE> LegacyRadioTx;
+typedef legacy::MxCircularBuffer<uint8_t, USB_ISR_SIZE> LegacyUsbIsr;
+typedef legacy::MxCircularBuffer<uint8_t, 100> LegacyOdd;
+typedef MxCircularBuffer<uint8_t, RADIO_TX_SIZE> RadioTx;
+typedef MxCircularBuffer<uint8_t, USB_ISR_SIZE> UsbIsr;
+typedef MxSpscBuffer<uint8_t, USB_ISR_SIZE> UsbIsrSpsc;
+typedef MxCircularBuffer<uint8_t, 100> Odd;
+
+MXSIZE_FUNCTIONS(legacy_radiotx, LegacyRadioTx, legacyRadioTx)
+MXSIZE_FUNCTIONS(legacy_usbisr, LegacyUsbIsr, legacyUsbIsr)
+MXSIZE_FUNCTIONS(legacy_size100, LegacyOdd, legacyOdd)
+MXSIZE_FUNCTIONS(radiotx, RadioTx, radioTx)
+MXSIZE_FUNCTIONS(usbisr, UsbIsr, usbIsr)
+MXSIZE_FUNCTIONS(usbisr_spsc, UsbIsrSpsc, usbIsrSpsc)
+MXSIZE_FUNCTIONS(size100, Odd, odd)
+
+//The command buffer has no get(), each command is removed with removeCommand()
+static legacy::MxCmdBuffer<USB_CMD_SIZE, USB_CMD_CMDS> legacyUsbCmd;
+static MxCmdBuffer<USB_CMD_SIZE, USB_CMD_CMDS> usbCmd;
+
+extern "C" __attribute__((noinline)) bool mxsize_legacy_usbcmd_put(uint8_t c) {
+    return legacyUsbCmd.put(c);
+}
+
+extern "C" __attribute__((noinline)) void mxsize_legacy_usbcmd_remove(void) {
+    legacyUsbCmd.removeCommand();
+}
+
+extern "C" __attribute__((noinline)) bool mxsize_usbcmd_put(uint8_t c) {
+    return usbCmd.put(c);
+}
+
+extern "C" __attribute__((noinline)) void mxsize_usbcmd_remove(void) {
+    usbCmd.removeCommand();
+}
+
+static int errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+
+/** Pass BYTES bytes through given put and get functions, in CHUNK byte chunks. Returns best cycles per byte. */
+static double benchBuffer(bool (*put)(uint8_t), uint8_t (*get)(void)) {
+    double best = 1e30;
+    uint64_t start;
+    uint32_t i;
+    uint32_t j;
+    uint32_t wrong = 0;
+    int r;
+
+    for (r = 0; r < REPEATS; r++) {
+        start = __rdtsc();
+        for (i = 0; i < BYTES; i += CHUNK) {
+            for (j = 0; j < CHUNK; j++) {
+                put((uint8_t)(i + j));
+            }
+            for (j = 0; j < CHUNK; j++) {
+                if (get() != (uint8_t)(i + j)) {
+                    wrong++;
+                }
+            }
+        }
+        if ((double)(__rdtsc() - start) / BYTES < best) {
+            best = (double)(__rdtsc() - start) / BYTES;
+        }
+    }
+    if (wrong != 0) {
+        printf("FAIL buffer returned wrong data\n");
+        errors++;
+    }
+    return best;
+}
+
+/** Add BYTES bytes of short "name=value;" commands to given command buffer, removing each command after it was
+ * added. Returns best cycles per byte.
+ */
+static double benchCmdBuffer(bool (*put)(uint8_t), void (*remove)(void)) {
+    static const uint8_t cmd[] = "bw=7;lbl=25;p=14;sf=12;";
+    double best = 1e30;
+    uint64_t start;
+    uint32_t i;
+    uint32_t j;
+    int r;
+
+    for (r = 0; r < REPEATS; r++) {
+        start = __rdtsc();
+        for (i = 0; i < BYTES; i += (sizeof(cmd) - 1)) {
+            for (j = 0; j < (sizeof(cmd) - 1); j++) {
+                put(cmd[j]);
+                if (cmd[j] == ';') {
+                    remove();
+                }
+            }
+        }
+        if ((double)(__rdtsc() - start) / BYTES < best) {
+            best = (double)(__rdtsc() - start) / BYTES;
+        }
+    }
+    return best;
+}
+
+static void report(const char* name, double before, double after) {
+    printf("%-36s %7.2f %7.2f\n", name, before, after);
+}
+
+int main() {
+    printf("Host TSC cycles per byte (put + get)   before   after\n");
+    report("Radio TX  MxCircularBuffer<32>", benchBuffer(&mxsize_legacy_radiotx_put, &mxsize_legacy_radiotx_get),
+            benchBuffer(&mxsize_radiotx_put, &mxsize_radiotx_get));
+    report("USB ISR   MxCircularBuffer<128>", benchBuffer(&mxsize_legacy_usbisr_put, &mxsize_legacy_usbisr_get),
+            benchBuffer(&mxsize_usbisr_put, &mxsize_usbisr_get));
+    report("USB ISR   MxSpscBuffer<128>", benchBuffer(&mxsize_legacy_usbisr_put, &mxsize_legacy_usbisr_get),
+            benchBuffer(&mxsize_usbisr_spsc_put, &mxsize_usbisr_spsc_get));
+    report("          MxCircularBuffer<100>", benchBuffer(&mxsize_legacy_size100_put, &mxsize_legacy_size100_get),
+            benchBuffer(&mxsize_size100_put, &mxsize_size100_get));
+    report("USB RX    MxCmdBuffer<256, 16>", benchCmdBuffer(&mxsize_legacy_usbcmd_put, &mxsize_legacy_usbcmd_remove),
+            benchCmdBuffer(&mxsize_usbcmd_put, &mxsize_usbcmd_remove));
+    printf("'before' for MxSpscBuffer is the original MxCircularBuffer<128> it replaced. Its __DMB() is an x86\n");
+    printf("mfence on the host, which costs a lot more than a DMB on the Cortex-M3.\n");
+    printf("Code size of the mxsize_ functions is printed by the buffer_code_size test.\n");
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
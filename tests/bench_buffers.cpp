@@ -0,0 +1,236 @@
+/**
+ * File:      bench_buffers.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host benchmark of MxCircularBuffer and MxCmdBuffer, for data received from USB in 64 byte packets. The current
+ * buffers (bulk memcpy putArray/getArray) are compared with the original ones (byte by byte put/get), taken from
+ * MX_LEGACY_REF (see CMakeLists.txt). Reports MB/s on the host CPU, only useful to compare the two versions.
+ *
+ * - Circular buffer: each 64 byte packet is added with putArray(), and read back with getArray() (original
+ *   buffer: get() for each byte, it has no getArray()).
+ * - Command buffer: each 64 byte packet of USB commands is added like mx_usbcdc_receive() does (original: put()
+ *   for each byte, current: putArray()). After each packet all complete commands are read with getCommandName()
+ *   and getCommandValue(), and removed, like processUsbCmds() in main.cpp does.
+ *
+ * The benchmark fails if the current and original buffers do not give the same data.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <time.h>
+#include "mbed.h"
+#include "mx_circular_buffer.h"
+#include "mx_cmd_buffer.h"
+
+namespace legacy {
+#include "legacy/mx_circular_buffer.h"
+#include "legacy/mx_cmd_buffer.h"
+}
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define PACKET_SIZE     64      //USB full speed bulk packet
+#define PACKETS         200000
+#define REPEATS         3       //Best of REPEATS runs is used
+#define CMD_BUF_SIZE    256     //Same as RX_BUF_USB_SIZE
+#define CMD_BUF_CMDS    16      //Same as RX_BUF_USB_COMMANDS
+
+//USB commands, as sent by the PC application
+static const char usbCommands[] =
+    "f=868100000;r=1;bw=7;sf=12;cr=1;p=14;tx=0102030405060708090A0B0C0D0E0F;"
+    "rx=1;lbl=25;f=915000000;t=1;hop=0;tx='Hello World';s=1;d=00FF;";
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static uint8_t  stream[PACKET_SIZE * 64];   //Repeated usbCommands, is sent in PACKET_SIZE chunks
+static uint32_t streamLen;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static uint64_t nowNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static inline const uint8_t* packet(uint32_t i) {
+    return &stream[(i * PACKET_SIZE) % streamLen];
+}
+
+/** Print and return best MB/s of given runs */
+static double report(const char* name, uint64_t bestNs) {
+    double mbs = ((double)PACKETS * PACKET_SIZE) / ((double)bestNs / 1e9) / 1e6;
+
+    printf("  %-10s %8.1f MB/s\n", name, mbs);
+    return mbs;
+}
+
+/** Original circular buffer, returns checksum of data read */
+static uint32_t circLegacy(uint64_t* pNs) {
+    legacy::MxCircularBuffer<uint8_t, 256> buf;
+    uint32_t sum = 0;
+    uint64_t start;
+    uint32_t i;
+    uint32_t j;
+
+    start = nowNs();
+    for (i = 0; i < PACKETS; i++) {
+        buf.putArray((uint8_t*)packet(i), PACKET_SIZE);
+        for (j = 0; j < PACKET_SIZE; j++) {
+            sum = (sum * 31) + buf.get();
+        }
+    }
+    *pNs = nowNs() - start;
+    return sum;
+}
+
+/** Current circular buffer, returns checksum of data read */
+static uint32_t circCurrent(uint64_t* pNs) {
+    MxCircularBuffer<uint8_t, 256> buf;
+    uint8_t out[PACKET_SIZE];
+    uint32_t sum = 0;
+    uint64_t start;
+    uint32_t i;
+    uint32_t j;
+
+    start = nowNs();
+    for (i = 0; i < PACKETS; i++) {
+        buf.putArray(packet(i), PACKET_SIZE);
+        buf.getArray(out, PACKET_SIZE);
+        for (j = 0; j < PACKET_SIZE; j++) {
+            sum = (sum * 31) + out[j];
+        }
+    }
+    *pNs = nowNs() - start;
+    return sum;
+}
+
+/** Read and remove all commands, returns updated checksum of names and values */
+template<class CmdBuf>
+static uint32_t readCommands(CmdBuf& buf, uint32_t sum) {
+    uint8_t name[32];
+    uint8_t value[64];
+    uint16_t nameLen;
+    uint16_t valueLen;
+    bool isNameValue;
+    uint16_t i;
+
+    while (buf.hasCommand()) {
+        nameLen = buf.getCommandName(name, sizeof(name), isNameValue);
+        valueLen = isNameValue ? buf.getCommandValue(value, sizeof(value), nameLen + 1) : 0;
+        for (i = 0; i < nameLen; i++) {
+            sum = (sum * 31) + name[i];
+        }
+        for (i = 0; i < valueLen; i++) {
+            sum = (sum * 31) + value[i];
+        }
+        sum = (sum * 31) + ';';
+        buf.removeCommand();
+    }
+    return sum;
+}
+
+/** Original command buffer, bytes added with put() like the original mx_usbcdc_receive() */
+static uint32_t cmdLegacy(uint64_t* pNs) {
+    legacy::MxCmdBuffer<CMD_BUF_SIZE, CMD_BUF_CMDS> buf;
+    const uint8_t* p;
+    uint32_t sum = 0;
+    uint64_t start;
+    uint32_t i;
+    uint32_t j;
+
+    start = nowNs();
+    for (i = 0; i < PACKETS; i++) {
+        p = packet(i);
+        for (j = 0; j < PACKET_SIZE; j++) {
+            buf.put(p[j]);
+        }
+        sum = readCommands(buf, sum);
+    }
+    *pNs = nowNs() - start;
+    return sum;
+}
+
+/** Current command buffer, packets added with putArray() */
+static uint32_t cmdCurrent(uint64_t* pNs) {
+    MxCmdBuffer<CMD_BUF_SIZE, CMD_BUF_CMDS> buf;
+    uint32_t sum = 0;
+    uint64_t start;
+    uint32_t i;
+
+    start = nowNs();
+    for (i = 0; i < PACKETS; i++) {
+        buf.putArray(packet(i), PACKET_SIZE);
+        sum = readCommands(buf, sum);
+    }
+    *pNs = nowNs() - start;
+    return sum;
+}
+
+/** Run given benchmark REPEATS times, return best time, and checksum in pSum */
+static uint64_t best(uint32_t (*fn)(uint64_t* pNs), uint32_t* pSum) {
+    uint64_t bestNs = ~0ULL;
+    uint64_t ns;
+    int r;
+
+    for (r = 0; r < REPEATS; r++) {
+        *pSum = fn(&ns);
+        if (ns < bestNs) {
+            bestNs = ns;
+        }
+    }
+    return bestNs;
+}
+
+int main() {
+    uint32_t sumLegacy;
+    uint32_t sumCurrent;
+    double before;
+    double after;
+    int errors = 0;
+
+    //Build stream of whole commands, a multiple of PACKET_SIZE long
+    while ((streamLen + sizeof(usbCommands) - 1) <= sizeof(stream)) {
+        memcpy(&stream[streamLen], usbCommands, sizeof(usbCommands) - 1);
+        streamLen += sizeof(usbCommands) - 1;
+    }
+    streamLen -= streamLen % PACKET_SIZE;
+
+    printf("MxCircularBuffer<uint8_t, 256>, %d byte packets\n", PACKET_SIZE);
+    before = report("before", best(&circLegacy, &sumLegacy));
+    after = report("after", best(&circCurrent, &sumCurrent));
+    printf("  speedup    %8.1fx\n", after / before);
+    if (sumLegacy != sumCurrent) {
+        printf("FAIL circular buffer data differs\n");
+        errors++;
+    }
+
+    printf("MxCmdBuffer<%d, %d>, %d byte packets of USB commands\n", CMD_BUF_SIZE, CMD_BUF_CMDS, PACKET_SIZE);
+    before = report("before", best(&cmdLegacy, &sumLegacy));
+    after = report("after", best(&cmdCurrent, &sumCurrent));
+    printf("  speedup    %8.1fx\n", after / before);
+    if (sumLegacy != sumCurrent) {
+        printf("FAIL command buffer commands differ\n");
+        errors++;
+    }
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
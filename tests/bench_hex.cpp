@@ -0,0 +1,167 @@
+/**
+ * File:      bench_hex.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host benchmark of the word at a time hex functions, against the original character at a time code:
+ * - Encode, as processRxDataUSB() does for received radio data: byte_to_ascii_hex_str() for each byte, against
+ *   MxHelpers::bytes_to_ascii_hex().
+ * - Decode: ascii_hex_nibble_to_byte() for each character, against MxHelpers::ascii_hex_to_bytes().
+ * - decodeAsciiCmd(), as used for the data of a "t=" command: original of MX_LEGACY_REF, against current.
+ *
+ * Each is run on a full 64 byte radio packet (128 hex characters). Cycles are read with the x86 time stamp counter,
+ * and are only useful to compare the versions, they are NOT Cortex-M3 cycles. The benchmark fails if the two
+ * versions do not give the same result.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <x86intrin.h>
+#include "mbed.h"
+#include "mx_helpers.h"
+#include "app_helpers.h"
+
+namespace legacy {
+#include "legacy/decode_ascii_cmd.h"
+}
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define PACKET_SIZE     64          //Largest radio packet, see RADIO_RXBUF_SIZE
+#define ITERATIONS      100000
+#define REPEATS         5           //Best of REPEATS runs is used
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+//Application globals, are defined in main.cpp, and used by app_helpers.cpp
+AppConfig       appConfig;
+AppData         appData;
+RadioConfig     radioConfig[RADIO_COUNT];
+RadioData       radioData[RADIO_COUNT];
+
+static uint8_t  packet[PACKET_SIZE];
+static uint8_t  hex[(2 * PACKET_SIZE) + 1];     //NULL terminated
+static uint8_t  outLegacy[(2 * PACKET_SIZE) + 1];
+static uint8_t  out[(2 * PACKET_SIZE) + 1];
+static int      errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+
+//Original encode, one byte at a time
+static __attribute__((noinline)) uint16_t encodeLegacy(const uint8_t* src, uint16_t len, uint8_t* dst) {
+    uint16_t i;
+
+    for (i = 0; i < len; i++) {
+        MxHelpers::byte_to_ascii_hex_str(src[i], (char*)&dst[2 * i]);
+    }
+    return 2 * len;
+}
+
+static __attribute__((noinline)) uint16_t encodeCurrent(const uint8_t* src, uint16_t len, uint8_t* dst) {
+    MxHelpers::bytes_to_ascii_hex(src, len, dst);
+    return 2 * len;
+}
+
+//Original decode, one character at a time, like the original decodeAsciiCmd()
+static __attribute__((noinline)) uint16_t decodeLegacy(const uint8_t* src, uint16_t len, uint8_t* dst) {
+    uint8_t hi;
+    uint8_t lo;
+    uint16_t i;
+
+    for (i = 0; i < len; i++) {
+        hi = MxHelpers::ascii_hex_nibble_to_byte(src[2 * i]);
+        lo = MxHelpers::ascii_hex_nibble_to_byte(src[(2 * i) + 1]);
+        if ((hi == 0xff) || (lo == 0xff)) {
+            break;
+        }
+        dst[i] = (hi << 4) | lo;
+    }
+    return i;
+}
+
+static __attribute__((noinline)) uint16_t decodeCurrent(const uint8_t* src, uint16_t len, uint8_t* dst) {
+    return MxHelpers::ascii_hex_to_bytes(src, len, dst);
+}
+
+static __attribute__((noinline)) uint16_t asciiCmdLegacy(const uint8_t* src, uint16_t len, uint8_t* dst) {
+    return legacy::decodeAsciiCmd(dst, len + 1, src, 0);
+}
+
+static __attribute__((noinline)) uint16_t asciiCmdCurrent(const uint8_t* src, uint16_t len, uint8_t* dst) {
+    return decodeAsciiCmd(dst, len + 1, src, 0);
+}
+
+/** Run given function ITERATIONS times, returns best TSC cycles per packet byte */
+static double bench(uint16_t (*fn)(const uint8_t*, uint16_t, uint8_t*), const uint8_t* src, uint8_t* dst) {
+    double best = 1e30;
+    uint64_t start;
+    uint32_t i;
+    int r;
+
+    for (r = 0; r < REPEATS; r++) {
+        start = __rdtsc();
+        for (i = 0; i < ITERATIONS; i++) {
+            fn(src, PACKET_SIZE, dst);
+        }
+        if ((double)(__rdtsc() - start) / ((double)ITERATIONS * PACKET_SIZE) < best) {
+            best = (double)(__rdtsc() - start) / ((double)ITERATIONS * PACKET_SIZE);
+        }
+    }
+    return best;
+}
+
+/** Benchmark and report both versions, fail if they give different results */
+static void compare(const char* name, uint16_t (*fnLegacy)(const uint8_t*, uint16_t, uint8_t*),
+        uint16_t (*fnCurrent)(const uint8_t*, uint16_t, uint8_t*), const uint8_t* src) {
+    double before;
+    double after;
+    uint16_t lenLegacy;
+    uint16_t len;
+
+    memset(outLegacy, 0, sizeof(outLegacy));
+    memset(out, 0, sizeof(out));
+    lenLegacy = fnLegacy(src, PACKET_SIZE, outLegacy);
+    len = fnCurrent(src, PACKET_SIZE, out);
+    if ((len != lenLegacy) || (memcmp(out, outLegacy, len) != 0)) {
+        printf("FAIL %s results differ\n", name);
+        errors++;
+    }
+
+    before = bench(fnLegacy, src, outLegacy);
+    after = bench(fnCurrent, src, out);
+    printf("%-36s %7.2f %7.2f %7.1fx\n", name, before, after, before / after);
+}
+
+int main() {
+    uint16_t i;
+
+    for (i = 0; i < PACKET_SIZE; i++) {
+        packet[i] = (uint8_t)((i * 151) + 7);
+    }
+    MxHelpers::bytes_to_ascii_hex(packet, PACKET_SIZE, hex);
+    hex[2 * PACKET_SIZE] = 0;
+
+    printf("Host TSC cycles per byte, %d byte packet     before   after\n", PACKET_SIZE);
+    compare("Encode (radio to USB)", &encodeLegacy, &encodeCurrent, packet);
+    compare("Decode", &decodeLegacy, &decodeCurrent, hex);
+    compare("decodeAsciiCmd() (USB t= to radio)", &asciiCmdLegacy, &asciiCmdCurrent, hex);
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * File:      bench_menu_render.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host benchmark rendering the menu screens of Src/app_display.cpp into the in-memory display buffer. main.cpp and
+ * app_display.cpp are compiled unmodified into this file (main() renamed to app_main(), it is not called), so the
+ * screens are drawn with the application's own widgets and drawScreen().
+ *
+ * Each screen is drawn like the menu does when it is entered (clear with fillRect(), then draw all widgets), and a
+ * "Home tick" updates the home screen after the RX counters changed, like mx_menu_task() does every 10ms.
+ * - after: drawScreen() on the application's "oled", the current MxSSD1306_I2C (span fillRect(), blitChar()).
+ * - before: the same screens drawn on the original driver of MX_LEGACY_REF (see CMakeLists.txt), which uses the
+ *   per pixel MxGfx primitives.
+ *
+ * Only drawing into the buffer is timed, the I2C flush is measured by bench_ssd1306. Times are measured on the host
+ * CPU, and are only useful to compare the two versions. The benchmark fails if the display RAM of the SSD1306 model
+ * (ssd1306_model.h) does not match the original driver's buffer after flushing, or the current driver is slower.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <time.h>
+#include <algorithm>
+
+#define main app_main
+#include "main.cpp"
+#undef main
+
+#undef DEBUG_ENABLE     //Is defined by each source file
+#include "app_display.cpp"
+#include "ssd1306_model.h"
+
+#undef DEBUG_ENABLE
+namespace legacy {
+#include "legacy/mx_ssd1306.cpp"
+}
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define BUF_SIZE        (OLED_HEIGHT * OLED_WIDTH / 8)
+#define LEGACY_ADDRESS  0x7a    //I2C address of the original driver's display, app's "oled" is at 0x78
+#define RENDERS         20000   //Times each screen is drawn
+#define REPEATS         3       //Best of REPEATS runs is used
+
+/** Original driver, with access to the display buffer */
+class LegacyOled : public legacy::MxSSD1306_I2C {
+public:
+    LegacyOled(I2C& i2c) : legacy::MxSSD1306_I2C(LEGACY_ADDRESS, i2c, OLED_HEIGHT, OLED_WIDTH) {
+    }
+
+    const uint8_t* getBuffer(void) {
+        return &buffer[0];
+    }
+};
+
+/** A menu screen of app_display.cpp */
+struct MenuScreen {
+    const char*                 name;
+    MxTextWidget* const*        widgets;
+    uint8_t                     count;
+    bool                        tick;       //Only update widgets, after the RX counters changed
+};
+
+static const MenuScreen menuScreens[] = {
+    {"Home",                    WIDGETS(homeWidgets),       false},
+    {"Home tick (RX counters)", WIDGETS(homeWidgets),       true},
+    {"Select",                  WIDGETS(selectWidgets),     false},
+    {"Settings",                WIDGETS(settingsWidgets),   false},
+    {"Configure Radio 1",       WIDGETS(cfgRadio1Widgets),  false},
+    {"Configure Radio 2",       WIDGETS(cfgRadio2Widgets),  false},
+};
+#define MENU_SCREENS    (sizeof(menuScreens) / sizeof(menuScreens[0]))
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static Ssd1306Model ssd(SSD_I2C_ADDRESS);
+static Ssd1306Model ssdLegacy(LEGACY_ADDRESS);
+static int errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static uint64_t nowNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/** Change RX counters shown on home screen */
+static void changeCounters(uint32_t i) {
+    appData.rxCountPingPong = (uint16_t)(i % 10000);
+    appData.rxErrCountPingPong = (uint16_t)((i / 7) % 10000);
+}
+
+/** Draw given screen on original driver, same as drawScreen() does on "oled" */
+static void drawLegacy(LegacyOled& gfx, const MenuScreen& screen) {
+    if (!screen.tick) {
+        gfx.fillRect(0, 0, gfx.width(), gfx.height(), 0);
+        MxTextWidget::invalidateAll(screen.widgets, screen.count);
+    }
+    MxTextWidget::updateAll(gfx, screen.widgets, screen.count);
+}
+
+static void drawCurrent(const MenuScreen& screen) {
+    if (!screen.tick) {
+        drawScreen(screen.widgets, screen.count);
+    }
+    else {
+        MxTextWidget::updateAll(oled, screen.widgets, screen.count);
+    }
+}
+
+/** Draw given screen RENDERS times, returns ns per screen */
+static double bench(LegacyOled* legacyOled, const MenuScreen& screen) {
+    uint64_t start = nowNs();
+    uint32_t i;
+
+    for (i = 0; i < RENDERS; i++) {
+        if (screen.tick) {
+            changeCounters(i);
+        }
+        if (legacyOled != NULL) {
+            drawLegacy(*legacyOled, screen);
+        }
+        else {
+            drawCurrent(screen);
+        }
+    }
+    return (double)(nowNs() - start) / RENDERS;
+}
+
+/** Draw screen on both, flush the application's display, and compare with the original driver's buffer. The widgets
+ * remember what was drawn, so the screen is first drawn in full on each display, with other RX counters for a tick.
+ */
+static void check(LegacyOled& legacyOled, const MenuScreen& screen) {
+    MenuScreen full = screen;
+    uint8_t i;
+
+    full.tick = false;
+    changeCounters(0);
+    drawLegacy(legacyOled, full);
+    changeCounters(1234);
+    drawLegacy(legacyOled, screen);
+    changeCounters(0);
+    drawCurrent(full);
+    changeCounters(1234);
+    drawCurrent(screen);
+    for (i = 0; i < (OLED_HEIGHT / 8); i++) {
+        oled.display();
+    }
+    if (memcmp(ssd.getRam(), legacyOled.getBuffer(), BUF_SIZE) != 0) {
+        printf("FAIL %s: display RAM does not match original driver\n", screen.name);
+        errors++;
+    }
+}
+
+int main() {
+    LegacyOled legacyOled(i2cBus1);
+    double before;
+    double after;
+    uint32_t s;
+    int r;
+
+    i2cBus1.frequency(I2C1_SPEED);
+    radioConfig[0].boardType = BOARD_INAIR9;
+    radioConfig[0].frequency = 915000000;
+    radioConfig[0].bw = 7;
+    radioConfig[0].sf = 12;
+    radioData[0].mode = RADIO_MODE_MASTER;
+    mx_display_init();
+    if (!hasOLED || (legacyOled.init() != 0)) {
+        printf("FAIL display init\n");
+        return 1;
+    }
+
+    printf("Host ns per screen                  before     after\n");
+    for (s = 0; s < MENU_SCREENS; s++) {
+        check(legacyOled, menuScreens[s]);
+        //Runs of both versions are interleaved, so both see the same load on the host
+        before = 1e30;
+        after = 1e30;
+        for (r = 0; r < REPEATS; r++) {
+            before = std::min(before, bench(&legacyOled, menuScreens[s]));
+            after = std::min(after, bench(NULL, menuScreens[s]));
+        }
+        printf("  %-30s %9.0f %9.0f %7.1fx\n", menuScreens[s].name, before, after, before / after);
+        if (after > before) {
+            printf("FAIL %s is slower\n", menuScreens[s].name);
+            errors++;
+        }
+        check(legacyOled, menuScreens[s]);
+    }
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,180 @@
+/**
+ * File:      bench_ssd1306.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host benchmark of MxSSD1306_I2C::display() flush time, at 100kHz and 400kHz I2C. The current driver (dirty runs
+ * sent in horizontal address mode) is compared with the original one of MX_LEGACY_REF, see CMakeLists.txt (one 16
+ * column block per display() call, page address mode). Both are connected to the SSD1306 model (ssd1306_model.h) on the
+ * simulated I2C bus, which takes the time of each I2C transfer at the bus speed.
+ *
+ * For each case, display() is called until nothing is dirty, like mx_display_task() does every 10ms. Reported:
+ * - Simulated time on the I2C bus, which is the flush time on the target (CPU time not included).
+ * - Number of display() calls, and of I2C write transfers.
+ *
+ * The benchmark fails if the display RAM of the model does not match the display buffer after a flush, or the
+ * current driver is slower than the original.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <algorithm>
+#include "mbed.h"
+#include "mx_ssd1306.h"
+#include "ssd1306_model.h"
+
+namespace legacy {
+#include "legacy/mx_ssd1306.cpp"
+}
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define BUF_SIZE        (OLED_HEIGHT * OLED_WIDTH / 8)
+
+/** Display driver, with access to the display buffer and dirty bits */
+template<class Driver>
+class TestOled : public Driver {
+public:
+    TestOled(I2C& i2c) : Driver(SSD_I2C_ADDRESS, i2c, OLED_HEIGHT, OLED_WIDTH) {
+    }
+
+    bool isDirty(void) {
+        uint16_t i;
+
+        for (i = 0; i < (OLED_HEIGHT / 8); i++) {
+            if (this->dirty[i] != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Change given page and dirty blocks of the buffer, with given seed */
+    void change(uint8_t page, uint8_t dirtyBlocks, uint8_t seed) {
+        uint16_t col;
+
+        for (col = 0; col < OLED_WIDTH; col++) {
+            if ((dirtyBlocks & (1 << (col / 16))) != 0) {
+                this->buffer[(page * OLED_WIDTH) + col] = (uint8_t)((col * 7) + (page * 31) + seed);
+            }
+        }
+        this->dirty[page] |= dirtyBlocks;
+    }
+
+    const uint8_t* getBuffer(void) {
+        return this->buffer;
+    }
+};
+
+/** A flush case. Given blocks of given pages are changed */
+struct FlushCase {
+    const char* name;
+    uint8_t     pages;          //Bit for each page
+    uint8_t     dirtyBlocks;    //Bit for each 16 column block
+};
+
+static const FlushCase flushCases[] = {
+    {"Full frame",              0xff, 0xff},
+    {"Menu line (1 page)",      0x08, 0xff},
+    {"Value (2 blocks)",        0x20, 0x30},
+    {"Scattered (8 blocks)",    0xff, 0x01},
+};
+#define FLUSH_CASES     (sizeof(flushCases) / sizeof(flushCases[0]))
+
+static const uint32_t busSpeeds[] = {100000, 400000};
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static Ssd1306Model ssd(SSD_I2C_ADDRESS);
+static int errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+
+/** Flush result */
+struct FlushResult {
+    uint64_t    ns;
+    uint32_t    calls;
+    uint32_t    writes;
+};
+
+/** Initialize display, then flush given case. Returns simulated flush time. */
+template<class Driver>
+static FlushResult flush(const char* version, uint32_t hz, const FlushCase& fc) {
+    I2C i2c(PB_9, PB_8);
+    TestOled<Driver> oled(i2c);
+    FlushResult r;
+    uint64_t start;
+    uint8_t page;
+
+    i2c.frequency(hz);
+    ssd.fillRam(0xa5);
+    oled.init();
+    while (oled.isDirty()) {
+        oled.display();
+    }
+
+    for (page = 0; page < 8; page++) {
+        if ((fc.pages & (1 << page)) != 0) {
+            oled.change(page, fc.dirtyBlocks, 0x5a);
+        }
+    }
+
+    ssd.getStats();
+    start = host_time_ns();
+    r.calls = 0;
+    while (oled.isDirty()) {
+        oled.display();
+        r.calls++;
+    }
+    r.ns = host_time_ns() - start;
+    r.writes = ssd.getStats().writes;
+
+    if (memcmp(ssd.getRam(), oled.getBuffer(), BUF_SIZE) != 0) {
+        printf("FAIL %s %s: display RAM does not match buffer\n", version, fc.name);
+        errors++;
+    }
+    return r;
+}
+
+int main() {
+    FlushResult before;
+    FlushResult after;
+    uint32_t s;
+    uint32_t c;
+
+    for (s = 0; s < (sizeof(busSpeeds) / sizeof(busSpeeds[0])); s++) {
+        printf("I2C %ukHz                      flush ms       display() calls   I2C writes\n",
+                busSpeeds[s] / 1000);
+        printf("                             before  after     before  after     before  after\n");
+        for (c = 0; c < FLUSH_CASES; c++) {
+            before = flush<legacy::MxSSD1306_I2C>("before", busSpeeds[s], flushCases[c]);
+            after = flush<MxSSD1306_I2C>("after", busSpeeds[s], flushCases[c]);
+            printf("  %-24s %7.2f %7.2f    %7u %6u    %7u %6u\n", flushCases[c].name,
+                    (double)before.ns / 1e6, (double)after.ns / 1e6, before.calls, after.calls,
+                    before.writes, after.writes);
+            if (after.ns > before.ns) {
+                printf("FAIL %s is slower\n", flushCases[c].name);
+                errors++;
+            }
+        }
+    }
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * File:      bench_text.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host benchmark of text drawing into the display buffer, in characters per millisecond. The current MxSSD1306_I2C,
+ * which blits glyph columns into the page buffer (blitChar()), is compared with the original driver of
+ * MX_LEGACY_REF (see CMakeLists.txt), for which MxGfx::drawChar() draws each pixel.
+ *
+ * Cases are the text drawn by the menu: size 1 characters on a text row (y a multiple of 8) and between rows, with
+ * and without background, and size 2 (home screen board name). Times are measured on the host CPU, and are only
+ * useful to compare the two versions. The benchmark fails if the two drivers do not give the same display buffer, or
+ * the current driver is slower.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <time.h>
+#include "mbed.h"
+#include "mx_ssd1306.h"
+#include "ssd1306_model.h"
+
+namespace legacy {
+#include "legacy/mx_ssd1306.cpp"
+}
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define BUF_SIZE        (OLED_HEIGHT * OLED_WIDTH / 8)
+#define CHARS           200000  //Characters drawn by each case
+#define REPEATS         3       //Best of REPEATS runs is used
+
+/** Display driver, with access to the display buffer */
+template<class Driver>
+class TestOled : public Driver {
+public:
+    TestOled(I2C& i2c) : Driver(SSD_I2C_ADDRESS, i2c, OLED_HEIGHT, OLED_WIDTH) {
+    }
+
+    const uint8_t* getBuffer(void) {
+        return &this->buffer[0];
+    }
+};
+
+/** A text case. Characters are drawn in rows, "rowOffset" pixels below each page */
+struct TextCase {
+    const char* name;
+    uint8_t     size;
+    uint8_t     rowOffset;
+    bool        background;     //Draw background, else transparent
+};
+
+static const TextCase textCases[] = {
+    {"Size 1, on row, background",          1, 0, true},
+    {"Size 1, on row, transparent",         1, 0, false},
+    {"Size 1, between rows, background",    1, 5, true},
+    {"Size 1, between rows, transparent",   1, 5, false},
+    {"Size 2, on row, background",          2, 0, true},
+};
+#define TEXT_CASES      (sizeof(textCases) / sizeof(textCases[0]))
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static Ssd1306Model ssd(SSD_I2C_ADDRESS);
+static int errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static uint64_t nowNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/** Draw "count" characters of given case, filling the display row by row */
+static void drawText(MxGfx& gfx, const TextCase& tc, uint32_t count) {
+    uint16_t cols = OLED_WIDTH / (6 * tc.size);
+    uint16_t rows = (OLED_HEIGHT - tc.rowOffset) / (8 * tc.size);
+    uint16_t color;
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        //Alternate colors each screen, so every character changes the buffer
+        color = ((i / (cols * rows)) & 1) ? 0 : 1;
+        gfx.drawChar((i % cols) * 6 * tc.size, (((i / cols) % rows) * 8 * tc.size) + tc.rowOffset,
+                (unsigned char)(' ' + (i % 95)), color, tc.background ? !color : color, tc.size);
+    }
+}
+
+/** Returns best characters per ms */
+static double bench(MxGfx& gfx, const TextCase& tc) {
+    double best = 0;
+    uint64_t start;
+    int r;
+
+    for (r = 0; r < REPEATS; r++) {
+        start = nowNs();
+        drawText(gfx, tc, CHARS);
+        if (((double)CHARS * 1e6 / (nowNs() - start)) > best) {
+            best = (double)CHARS * 1e6 / (nowNs() - start);
+        }
+    }
+    return best;
+}
+
+int main() {
+    I2C i2c(PB_9, PB_8);
+    TestOled<legacy::MxSSD1306_I2C> legacyOled(i2c);
+    TestOled<MxSSD1306_I2C> oled(i2c);
+    double before;
+    double after;
+    uint32_t c;
+
+    if ((legacyOled.init() != 0) || (oled.init() != 0)) {
+        printf("FAIL display init\n");
+        return 1;
+    }
+
+    printf("Characters per ms                       before     after\n");
+    for (c = 0; c < TEXT_CASES; c++) {
+        legacyOled.clearDisplay();
+        oled.clearDisplay();
+        drawText(legacyOled, textCases[c], 1000);
+        drawText(oled, textCases[c], 1000);
+        if (memcmp(oled.getBuffer(), legacyOled.getBuffer(), BUF_SIZE) != 0) {
+            printf("FAIL %s: display buffers differ\n", textCases[c].name);
+            errors++;
+        }
+
+        before = bench(legacyOled, textCases[c]);
+        after = bench(oled, textCases[c]);
+        printf("  %-36s %9.0f %9.0f %7.1fx\n", textCases[c].name, before, after, after / before);
+        if (after < before) {
+            printf("FAIL %s is slower\n", textCases[c].name);
+            errors++;
+        }
+    }
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
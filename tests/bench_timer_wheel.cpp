@@ -0,0 +1,216 @@
+/**
+ * File:      bench_timer_wheel.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host benchmark of MxTimerWheel against the mbed ticker_insert_event() sorted list (mbed_nz32sc151/common/
+ * ticker_api.c, compiled unmodified with a dummy ticker interface). Measures the time to arm and cancel a timeout,
+ * like the InAir driver does for each packet, with 0 to 64 other timeouts already pending. The list insert time
+ * grows with the number of pending timeouts, the timer wheel time should not.
+ *
+ * Times are measured on the host CPU, and are only useful to compare the two implementations. The benchmark fails
+ * if the timer wheel does not fire timeouts at the right time, or its arm/cancel time grows with the number of
+ * pending timeouts.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <time.h>
+#include "mbed.h"
+#include "ticker_api.h"
+#include "mx_timer_wheel.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define MAX_PENDING     64
+#define ITERATIONS      200000
+#define REPEATS         5       //Best of REPEATS runs is used
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static void tiInit(void) {
+}
+
+static uint32_t tiRead(void) {
+    return 0;
+}
+
+static void tiDisable(void) {
+}
+
+static void tiClear(void) {
+}
+
+static void tiSet(timestamp_t timestamp) {
+    (void)timestamp;
+}
+
+static const ticker_interface_t tickerInterface = {
+    &tiInit, &tiRead, &tiDisable, &tiClear, &tiSet
+};
+static ticker_event_queue_t tickerQueue;
+static const ticker_data_t  tickerData = {&tickerInterface, &tickerQueue};
+
+static ticker_event_t   listPending[MAX_PENDING];
+static ticker_event_t   listEvent;
+static MxTimeout        wheelPending[MAX_PENDING];
+static MxTimeout        wheelTimeout;
+
+static uint32_t rnd = 12345;
+static volatile uint32_t fired;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static uint32_t random32(void) {
+    rnd = (rnd * 1103515245) + 12345;
+    return rnd >> 8;
+}
+
+static uint64_t nowNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static void onTimeout(void) {
+    fired++;
+}
+
+/** Host time for an arm and cancel of a timeout up to 1s, with the mbed sorted list */
+static double benchList(int pending) {
+    double best = 1e30;
+    uint64_t start;
+    int r;
+    int i;
+
+    tickerQueue.head = NULL;
+    for (i = 0; i < pending; i++) {
+        ticker_insert_event(&tickerData, &listPending[i], random32() % 1000000, i);
+    }
+
+    for (r = 0; r < REPEATS; r++) {
+        start = nowNs();
+        for (i = 0; i < ITERATIONS; i++) {
+            ticker_insert_event(&tickerData, &listEvent, random32() % 1000000, MAX_PENDING);
+            ticker_remove_event(&tickerData, &listEvent);
+        }
+        if ((double)(nowNs() - start) / ITERATIONS < best) {
+            best = (double)(nowNs() - start) / ITERATIONS;
+        }
+    }
+
+    for (i = 0; i < pending; i++) {
+        ticker_remove_event(&tickerData, &listPending[i]);
+    }
+    return best;
+}
+
+/** Host time for an arm and cancel of a timeout up to 1s, with MxTimerWheel */
+static double benchWheel(int pending) {
+    double best = 1e30;
+    uint64_t start;
+    int r;
+    int i;
+
+    for (i = 0; i < pending; i++) {
+        wheelPending[i].attach_ms(&onTimeout, 1 + (random32() % 1000));
+    }
+
+    for (r = 0; r < REPEATS; r++) {
+        start = nowNs();
+        for (i = 0; i < ITERATIONS; i++) {
+            wheelTimeout.attach_ms(&onTimeout, 1 + (random32() % 1000));
+            wheelTimeout.detach();
+        }
+        if ((double)(nowNs() - start) / ITERATIONS < best) {
+            best = (double)(nowNs() - start) / ITERATIONS;
+        }
+    }
+
+    for (i = 0; i < pending; i++) {
+        wheelPending[i].detach();
+    }
+    return best;
+}
+
+/** Check timeouts fire after the requested time, and at most 1ms later. Uses simulated time. */
+static int checkWheel(void) {
+    static const uint32_t times[] = {1, 2, 3, 63, 64, 65, 127, 128, 1000, 5000};
+    uint32_t n = sizeof(times) / sizeof(times[0]);
+    uint64_t start;
+    uint64_t elapsed;
+    uint32_t i;
+    int errors = 0;
+
+    for (i = 0; i < n; i++) {
+        //Another timeout pending, so the wheel ticker is already running
+        wheelPending[0].attach_ms(&onTimeout, 100000);
+        host_advance_ns(random32() % 1000000);
+
+        fired = 0;
+        start = host_time_ns();
+        wheelTimeout.attach_ms(&onTimeout, times[i]);
+        while (fired == 0) {
+            __WFI();
+        }
+        elapsed = host_time_ns() - start;
+        if ((elapsed < (uint64_t)times[i] * 1000000) || (elapsed > ((uint64_t)times[i] + 1) * 1000000)) {
+            printf("FAIL %ums timeout fired after %lluns\n", times[i], (unsigned long long)elapsed);
+            errors++;
+        }
+        wheelPending[0].detach();
+    }
+    return errors;
+}
+
+int main() {
+    static const int pendingCounts[] = {0, 1, 2, 4, 8, 16, 32, 64};
+    double tList;
+    double tWheel;
+    double tWheelFirst = 0;
+    double tWheelMax = 0;
+    uint32_t i;
+    int errors;
+
+    errors = checkWheel();
+
+    printf("Arm + cancel of a timeout, host ns per operation\n");
+    printf("pending  ticker_insert_event  MxTimerWheel\n");
+    for (i = 0; i < (sizeof(pendingCounts) / sizeof(pendingCounts[0])); i++) {
+        tList = benchList(pendingCounts[i]);
+        tWheel = benchWheel(pendingCounts[i]);
+        printf("%7d  %19.1f  %12.1f\n", pendingCounts[i], tList, tWheel);
+        //With 0 pending, the wheel ticker is also started and stopped, compare with 1 pending
+        if (i == 1) {
+            tWheelFirst = tWheel;
+        }
+        if ((i >= 1) && (tWheel > tWheelMax)) {
+            tWheelMax = tWheel;
+        }
+    }
+
+    //Generous limit, host timing is noisy
+    if (tWheelMax > (3 * tWheelFirst)) {
+        printf("FAIL MxTimerWheel arm/cancel time grows with pending timeouts\n");
+        errors++;
+    }
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,431 @@
+/**
+ * File:      bench_usb_dispatch.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host benchmark of the USB command dispatcher in main.cpp. main.cpp is compiled unmodified (main() renamed to
+ * app_main(), it is not called), with USB enabled, the simulated USB CDC port (host_usb.h), and a simulated SX1276.
+ *
+ * - Replay: a recorded stream of commands, as written by the PC application, is sent to the simulated USB port. It
+ *   is received by the USB interrupt in 64 byte packets, and processed by mx_usbcdc_task() and processUsbCmds(),
+ *   like the main loop does. Reports host time per command for processUsbCmds(), which includes getting the name
+ *   and value from rxBufUsb, the lookup, the handler, and queuing the reply. Fails if any command is replied to with
+ *   "uc" (unknown) or "er", or the radio configuration is not what the stream set.
+ * - Lookup: the dispatch table binary search, findUsbCmd(), is compared with the original if-else chain on the
+ *   first character of the name (copied below from the original processUsbCmds(), handlers replaced by the handler
+ *   they became). Fails if they do not find the same handler for any command the original knew.
+ * - Errors: "t" commands with an invalid value, or too much data for the radio TX buffer, must be replied to with
+ *   "er".
+ * - Tables: fails if usbNameValueCmds[] or usbCmds[] is not sorted in strcmp order, the binary search needs it.
+ *
+ * Times are measured on the host CPU, and are only useful to compare the two versions.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <time.h>
+
+#define main app_main
+#include "main.cpp"
+#undef main
+
+#include "mx_spsc_buffer.h"
+#include "host_usb.h"
+#include "sx1276_model.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define REPLAYS         2000    //Times the recorded stream is replayed
+#define LOOKUPS         1000000 //Lookups of each command name
+#define REPEATS         3       //Best of REPEATS runs is used
+#define LOOP_NS         20000   //Simulated time of one main loop
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+extern MxSpscBuffer <uint8_t, RX_BUF_USB_ISR_SIZE> rxIsrBufUsb;     //In mx_usb_cdc.cpp
+
+//Recorded stream, each entry is one write of the PC application. No "rst", "save" or "test" commands, they reset
+//the board, write the EEPROM, or block.
+static const char* const usbStream[] = {
+    "tv=0;f=915000000;bw=8;sf=12;crc=1;pr=8;tpw=17;tm=1;",
+    "rm=2;rto=0;rsym=5;rx;",
+    "t=48656C6C6F;rs;tvs;",
+    "t0=0102030405;f0=918800000;rx0;rs0;",
+    "sf0=9;bw0=7;pr0=12;run;",
+};
+
+struct DispatchName {
+    const char* name;
+    bool        isNameValue;
+};
+
+//Names looked up by the lookup benchmark, including unknown ones
+static const DispatchName dispatchNames[] = {
+    {"bw", true}, {"crc", true}, {"f", true}, {"pr", true}, {"rm", true}, {"rsym", true}, {"rto", true},
+    {"sf", true}, {"t", true}, {"tm", true}, {"tpw", true}, {"tv", true},
+    {"rs", false}, {"rst", false}, {"run", false}, {"rx", false}, {"test", false}, {"tvs", false},
+    {"tx", true}, {"cr", true}, {"xyz", true}, {"r", false}, {"tv", false},
+};
+#define DISPATCH_NAMES  (sizeof(dispatchNames) / sizeof(dispatchNames[0]))
+
+static Sx1276Air    air;
+static Sx1276Model  model(&air, PC_8, PA_9, PB_0, PB_1, PC_6, PA_10);
+
+static uint32_t     replies;
+static uint32_t     badReplies;
+static uint32_t     errReplies;     //"er" replies while expectErr is set
+static bool         expectErr;
+static uint8_t      replyLine[64];
+static uint8_t      replyLen;
+static volatile uint32_t sink;      //Stops the compiler removing the lookups
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static uint64_t nowNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/** Data sent to the PC, each reply ends with '\r' */
+static void onUsbTx(void* ctx, const uint8_t* data, uint16_t len) {
+    uint16_t i;
+    (void)ctx;
+
+    for (i = 0; i < len; i++) {
+        if (data[i] != '\r') {
+            if (replyLen < sizeof(replyLine) - 1) {
+                replyLine[replyLen++] = data[i];
+            }
+            continue;
+        }
+        replyLine[replyLen] = 0;
+        replies++;
+        if (expectErr && (strncmp((const char*)replyLine, "er", 2) == 0)) {
+            errReplies++;
+        }
+        else if ((strncmp((const char*)replyLine, "uc", 2) == 0) || (strncmp((const char*)replyLine, "er", 2) == 0)) {
+            if (badReplies++ < 10) {
+                printf("FAIL reply '%s'\n", replyLine);
+            }
+        }
+        replyLen = 0;
+    }
+}
+
+/** Original lookup, the if-else chain of processUsbCmds() before the dispatch tables. Returns NULL if not found. */
+static UsbCmdHandler legacyFindUsbCmd(bool isNameValue, const uint8_t* nameBuf, uint16_t nameLen) {
+    if (isNameValue) {
+        if(nameBuf[0]=='t') {
+            if(nameLen==1) {
+                return usbCmdTransmit;
+            }
+            else if(nameLen==2) {
+                if(nameBuf[1]=='v') {
+                    return usbCmdSetTransceiver;
+                }
+                else if(nameBuf[1]=='m') {
+                    return usbCmdTxMode;
+                }
+            }
+            else if(strcmp((const char*)&nameBuf[1], "pw") == 0) {
+                return usbCmdTxPower;
+            }
+        }
+        else if(nameBuf[0]=='r') {
+            if(nameLen==2) {
+                if(nameBuf[1]=='m') {
+                    return usbCmdRxMode;
+                }
+            }
+            else  {
+                if(strcmp((const char*)&nameBuf[1], "to") == 0) {
+                    return usbCmdRxTimeout;
+                }
+                if(strcmp((const char*)&nameBuf[1], "sym") == 0) {
+                    return usbCmdRxSymbolTimeout;
+                }
+            }
+        }
+        else if(nameBuf[0]=='b') {
+            if(nameLen==2) {
+                if(nameBuf[1]=='w') {
+                    return usbCmdBandwidth;
+                }
+            }
+        }
+        else if(nameBuf[0]=='c') {
+            if(nameLen==3) {
+                if(strcmp((const char*)&nameBuf[1], "rc") == 0) {
+                    return usbCmdCrc;
+                }
+            }
+        }
+        else if(nameBuf[0]=='p') {
+            if(nameLen==2) {
+                if(nameBuf[1]=='r') {
+                    return usbCmdPreamble;
+                }
+            }
+        }
+        else if(nameBuf[0]=='s') {
+            if(nameLen==2) {
+                if(nameBuf[1]=='f') {
+                    return usbCmdSpreadingFactor;
+                }
+            }
+        }
+        else if(nameBuf[0]=='f') {
+            if(nameLen==1) {
+                return usbCmdFrequency;
+            }
+        }
+    }
+    else {
+        if(nameBuf[0]=='r') {
+            if(nameLen==2) {
+                if(nameBuf[1]=='s') {
+                    return usbCmdRssi;
+                }
+                else if(nameBuf[1]=='x') {
+                    return usbCmdReceive;
+                }
+            }
+            else if(strcmp((const char*)&nameBuf[1], "st") == 0) {
+                return usbCmdReset;
+            }
+            else if(strcmp((const char*)&nameBuf[1], "un") == 0) {
+                return usbCmdRun;
+            }
+        }
+        else if(nameBuf[0]=='t') {
+            if(strcmp((const char*)&nameBuf[1], "vs") == 0) {
+                return usbCmdTransceiverStatus;
+            }
+            else if(strcmp((const char*)&nameBuf[1], "est") == 0) {
+                return usbCmdTest;
+            }
+        }
+    }
+    return NULL;
+}
+
+/** Current lookup, as done by processUsbCmds(). Returns NULL if not found. */
+static UsbCmdHandler currentFindUsbCmd(bool isNameValue, const uint8_t* nameBuf, uint16_t nameLen) {
+    const UsbCmdEntry* pEntry;
+    (void)nameLen;
+
+    if (isNameValue) {
+        pEntry = findUsbCmd(usbNameValueCmds, sizeof(usbNameValueCmds)/sizeof(usbNameValueCmds[0]),
+                (const char*)nameBuf);
+    }
+    else {
+        pEntry = findUsbCmd(usbCmds, sizeof(usbCmds)/sizeof(usbCmds[0]), (const char*)nameBuf);
+    }
+    return (pEntry != NULL) ? pEntry->handler : NULL;
+}
+
+/** Host ns per lookup of all dispatchNames[], with given lookup function */
+static double benchLookup(UsbCmdHandler (*find)(bool, const uint8_t*, uint16_t)) {
+    double best = 1e30;
+    uint64_t start;
+    uint32_t i;
+    uint32_t n;
+    int r;
+
+    for (r = 0; r < REPEATS; r++) {
+        start = nowNs();
+        for (i = 0; i < LOOKUPS; i++) {
+            for (n = 0; n < DISPATCH_NAMES; n++) {
+                sink += (find(dispatchNames[n].isNameValue, (const uint8_t*)dispatchNames[n].name,
+                        strlen(dispatchNames[n].name)) != NULL);
+            }
+        }
+        if ((double)(nowNs() - start) / ((double)LOOKUPS * DISPATCH_NAMES) < best) {
+            best = (double)(nowNs() - start) / ((double)LOOKUPS * DISPATCH_NAMES);
+        }
+    }
+    return best;
+}
+
+/** Check given dispatch table is sorted in strcmp order, findUsbCmd() does a binary search */
+static int checkSorted(const char* tableName, const UsbCmdEntry* table, uint8_t count) {
+    uint8_t i;
+    int errors = 0;
+
+    for (i = 1; i < count; i++) {
+        if (strcmp(table[i - 1].name, table[i].name) >= 0) {
+            printf("FAIL %s[] not sorted, '%s' before '%s'\n", tableName, table[i - 1].name, table[i].name);
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/** Check both lookups find the same handler. Commands added after the if-else chain are not known by it. */
+static int checkLookup(void) {
+    UsbCmdHandler legacy;
+    UsbCmdHandler current;
+    uint32_t n;
+    int errors = 0;
+
+    for (n = 0; n < DISPATCH_NAMES; n++) {
+        legacy = legacyFindUsbCmd(dispatchNames[n].isNameValue, (const uint8_t*)dispatchNames[n].name,
+                strlen(dispatchNames[n].name));
+        current = currentFindUsbCmd(dispatchNames[n].isNameValue, (const uint8_t*)dispatchNames[n].name,
+                strlen(dispatchNames[n].name));
+        if (legacy != current) {
+            printf("FAIL lookup of '%s' differs\n", dispatchNames[n].name);
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/** Send given commands to the simulated USB port, and run the main loop until they are processed */
+static void sendCmds(const char* cmds) {
+    host_usb_send((const uint8_t*)cmds, strlen(cmds));
+    while ((host_usb_pending() != 0) || !rxIsrBufUsb.isEmpty() || rxBufUsb.hasCommand() || txBufUsb.hasCommand()) {
+        host_advance_ns(LOOP_NS);
+        mx_usbcdc_task();
+        processUsbCmds();
+    }
+}
+
+/** Check "t" commands with an invalid value, or more data than fits in the radio TX buffer, are replied to with
+ * "er", and nothing is added to the TX buffer.
+ */
+static int checkTransmitErrors(void) {
+    char cmd[8 + (RADIO_TXBUF_SIZE * 2) + 2];
+    uint16_t i;
+    int errors = 0;
+
+    radioData[0].txBuf.reset();
+    expectErr = true;
+    errReplies = 0;
+    sendCmds("t=4G;");
+    strcpy(cmd, "t=");
+    for (i = 0; i <= RADIO_TXBUF_SIZE; i++) {
+        strcat(cmd, "A5");
+    }
+    strcat(cmd, ";");
+    sendCmds(cmd);
+    expectErr = false;
+
+    if ((errReplies != 2) || !radioData[0].txBuf.isEmpty()) {
+        printf("FAIL invalid \"t\" commands: %u \"er\" replies, %u bytes to transmit\n", (unsigned)errReplies,
+                (unsigned)radioData[0].txBuf.getAvailable());
+        errors++;
+    }
+    return errors;
+}
+
+/** Replay usbStream[] REPLAYS times. Returns host ns spent in processUsbCmds() per command, and count in pCmds. */
+static double replay(uint32_t* pCmds) {
+    uint64_t ns = 0;
+    uint64_t start;
+    uint32_t cmds = 0;
+    uint32_t r;
+    uint32_t s;
+
+    for (r = 0; r < REPLAYS; r++) {
+        for (s = 0; s < (sizeof(usbStream) / sizeof(usbStream[0])); s++) {
+            host_usb_send((const uint8_t*)usbStream[s], strlen(usbStream[s]));
+
+            //Main loop, until all commands processed and replies sent
+            while ((host_usb_pending() != 0) || !rxIsrBufUsb.isEmpty() || rxBufUsb.hasCommand()
+                    || txBufUsb.hasCommand()) {
+                host_advance_ns(LOOP_NS);
+                mx_usbcdc_task();
+                if (rxBufUsb.hasCommand()) {
+                    cmds++;
+                    start = nowNs();
+                    processUsbCmds();
+                    ns += nowNs() - start;
+                }
+                //Packets of "t" commands are not transmitted, radioTask() is not called
+                radioData[0].txBuf.reset();
+            }
+        }
+    }
+    *pCmds = cmds;
+    return (double)ns / cmds;
+}
+
+int main() {
+    RadioConfig* pConf = &radioConfig[0];
+    uint32_t cmds;
+    uint32_t expectedCmds = 0;
+    uint32_t s;
+    uint32_t i;
+    double tLegacy;
+    double tCurrent;
+    double tReplay;
+    int errors = 0;
+
+    host_usb_set_tx_handler(&onUsbTx, NULL);
+    mx_usbcdc_init();
+    rxBufUsb.enableReplaceCrLfWithEoc();
+    txBufUsb.disableReplaceCrLfWithEoc();
+
+    restoreRadioConfigDefaults(pConf);
+    pConf->boardType = BOARD_INAIR9B;
+    radioData[0].smRadio = IDLE;
+    while (!initializeRadio(0)) {
+        host_advance_ns(1000000);
+    }
+
+    for (s = 0; s < (sizeof(usbStream) / sizeof(usbStream[0])); s++) {
+        for (i = 0; usbStream[s][i] != 0; i++) {
+            expectedCmds += (usbStream[s][i] == ';');
+        }
+    }
+
+    tReplay = replay(&cmds);
+    printf("Replay of %u commands through simulated USB\n", cmds);
+    printf("  processUsbCmds() %8.1f host ns per command\n", tReplay);
+    if (cmds != (expectedCmds * REPLAYS)) {
+        printf("FAIL %u commands processed, %u sent\n", cmds, expectedCmds * REPLAYS);
+        errors++;
+    }
+    if ((pConf->frequency != 918800000) || (pConf->sf != 9) || (pConf->bw != 7) || (pConf->preambleLength != 12)
+            || (pConf->power != 17) || (pConf->txMode != 1) || (pConf->rxMode != 2) || (pConf->symbolTimeout != 5)
+            || (pConf->conf.lora.crcEnable != true)) {
+        printf("FAIL radio configuration not set by commands\n");
+        errors++;
+    }
+    if (replies == 0) {
+        printf("FAIL no replies\n");
+        errors++;
+    }
+    errors += checkTransmitErrors();
+    errors += badReplies;
+
+    errors += checkSorted("usbNameValueCmds", usbNameValueCmds, sizeof(usbNameValueCmds) / sizeof(usbNameValueCmds[0]));
+    errors += checkSorted("usbCmds", usbCmds, sizeof(usbCmds) / sizeof(usbCmds[0]));
+    errors += checkLookup();
+    tLegacy = benchLookup(&legacyFindUsbCmd);
+    tCurrent = benchLookup(&currentFindUsbCmd);
+    printf("Lookup of %u command names, host ns per lookup\n", (unsigned)DISPATCH_NAMES);
+    printf("  if-else chain    %8.1f\n", tLegacy);
+    printf("  findUsbCmd()     %8.1f\n", tCurrent);
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,22 @@
+# Prints the x86-64 code size of the "mxsize_" functions of bench_buffer_index, see bench_buffer_index.cpp.
+# Run with: cmake -DNM=<nm> -DFILE=<bench_buffer_index executable> -P code_size.cmake
+execute_process(COMMAND ${NM} -S ${FILE} OUTPUT_VARIABLE symbols RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${NM} failed on ${FILE}")
+endif()
+
+string(REPLACE "\n" ";" symbols "${symbols}")
+set(found 0)
+message("Host code size in bytes (x86-64, not Thumb-2)")
+foreach(line ${symbols})
+    # Format is "<address> <size> <type> <name>", size is hex
+    if(line MATCHES "^[0-9a-fA-F]+ ([0-9a-fA-F]+) [tT] mxsize_(.*)$")
+        math(EXPR size "0x${CMAKE_MATCH_1}")
+        message("  ${CMAKE_MATCH_2}: ${size}")
+        math(EXPR found "${found} + 1")
+    endif()
+endforeach()
+
+if(found EQUAL 0)
+    message(FATAL_ERROR "No mxsize_ functions found in ${FILE}")
+endif()
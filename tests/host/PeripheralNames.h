@@ -0,0 +1,43 @@
+/**
+ * File:      PeripheralNames.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) replacement for the mbed "PeripheralNames.h" file of the target. Only the I2C busses are defined, they
+ * have the address of their registers like on the target (see cmsis.h).
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_PERIPHERALNAMES_H_
+#define TESTS_HOST_PERIPHERALNAMES_H_
+
+#include <stdint.h>
+#include "cmsis.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    I2C_1 = (int)I2C1_BASE,
+    I2C_2 = (int)I2C2_BASE,
+    I2C_HOST_PTR_SIZE = INTPTR_MAX  //Makes I2CName pointer sized, i2c_api.c casts it to an I2C_TypeDef pointer
+} I2CName;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TESTS_HOST_PERIPHERALNAMES_H_ */
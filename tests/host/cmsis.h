@@ -0,0 +1,272 @@
+/**
+ * File:      cmsis.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) replacement for the CMSIS core and STM32L1 device headers. Provides the Cortex-M intrinsics used by
+ * the firmware, and a RAM copy of the few peripheral registers that are accessed directly. Interrupt enable and
+ * disable, and the NVIC are emulated by host_hal.cpp, see host_hal.h.
+ *
+ * The I2C registers are at their target address, they are only used by the I2C peripheral model in
+ * stm32_i2c_model.h, which maps them. The target HAL (i2c_api.c) casts the I2CName of a bus to the register address.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_CMSIS_H_
+#define TESTS_HOST_CMSIS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//Implemented in host_hal.cpp
+void     host_disable_irq(void);
+void     host_enable_irq(void);
+uint32_t host_get_primask(void);
+void     host_set_primask(uint32_t primask);
+void     host_wfi(void);
+void     host_system_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+typedef enum {
+    RESET = 0,
+    SET = !RESET
+} FlagStatus, ITStatus;
+
+
+// Core intrinsics ////////////////////////////////////////////////////////////
+#define __IO    volatile
+#define __I     volatile const
+#define __O     volatile
+
+static inline void __disable_irq(void) {
+    host_disable_irq();
+}
+
+static inline void __enable_irq(void) {
+    host_enable_irq();
+}
+
+static inline uint32_t __get_PRIMASK(void) {
+    return host_get_primask();
+}
+
+static inline void __set_PRIMASK(uint32_t priMask) {
+    host_set_primask(priMask);
+}
+
+static inline void __DMB(void) {
+    __sync_synchronize();
+}
+
+static inline void __DSB(void) {
+    __sync_synchronize();
+}
+
+static inline void __ISB(void) {
+    __sync_synchronize();
+}
+
+static inline void __NOP(void) {
+}
+
+static inline void __WFI(void) {
+    host_wfi();
+}
+
+static inline uint32_t __CLZ(uint32_t value) {
+    return (value == 0) ? 32 : __builtin_clz(value);
+}
+
+static inline uint32_t __RBIT(uint32_t value) {
+    uint32_t result = 0;
+    uint8_t i;
+
+    for (i = 0; i < 32; i++) {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+
+//Carry flag is not known on the host, is always shifted in as 0
+static inline uint32_t __RRX(uint32_t value) {
+    return value >> 1;
+}
+
+static inline void NVIC_SystemReset(void) {
+    host_system_reset();
+}
+
+
+// NVIC ///////////////////////////////////////////////////////////////////////
+// Only the interrupts of simulated peripherals that are accessed through registers are defined
+typedef enum {
+    I2C1_EV_IRQn    = 31,
+    I2C1_ER_IRQn    = 32,
+    I2C2_EV_IRQn    = 33,
+    I2C2_ER_IRQn    = 34
+} IRQn_Type;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//Implemented in host_hal.cpp
+void host_nvic_set_vector(IRQn_Type IRQn, void (*vector)(void));
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+
+#ifdef __cplusplus
+}
+#endif
+
+//The target code gives the vector cast to uint32_t, which would truncate a 64-bit host pointer. HOST_NVIC_VECTOR
+//removes the cast: "HOST_NVIC_VECTOR (uint32_t)&handler" expands to "&handler".
+#define HOST_NVIC_VECTOR(type)
+#define NVIC_SetVector(IRQn, vector)    host_nvic_set_vector((IRQn), HOST_NVIC_VECTOR vector)
+
+
+// Core and device registers //////////////////////////////////////////////////
+// Only registers written directly by the firmware are defined. They are RAM variables, writes have no effect.
+typedef struct {
+    __IO uint32_t SCR;
+} SCB_Type;
+
+typedef struct {
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+    __IO uint32_t CR;
+    __IO uint32_t CSR;
+} PWR_TypeDef;
+
+typedef struct {
+    __IO uint32_t CSR;
+} RCC_TypeDef;
+
+typedef struct {
+    __IO uint32_t MODER;
+    __IO uint32_t OTYPER;
+    __IO uint32_t OSPEEDR;
+    __IO uint32_t PUPDR;
+    __IO uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t DIER;
+} TIM_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR;
+} WWDG_TypeDef;
+
+typedef struct {
+    __IO uint32_t KR;
+} IWDG_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t OAR1;
+    __IO uint32_t OAR2;
+    __IO uint32_t DR;
+    __IO uint32_t SR1;
+    __IO uint32_t SR2;
+    __IO uint32_t CCR;
+    __IO uint32_t TRISE;
+} I2C_TypeDef;
+
+typedef struct {
+    SCB_Type        scb;
+    DWT_Type        dwt;
+    CoreDebug_Type  coreDebug;
+    PWR_TypeDef     pwr;
+    RCC_TypeDef     rcc;
+    GPIO_TypeDef    gpio[8];
+    TIM_TypeDef     tim5;
+    WWDG_TypeDef    wwdg;
+    IWDG_TypeDef    iwdg;
+} HostRegs;
+
+extern HostRegs hostRegs;
+
+#define SCB         (&hostRegs.scb)
+#define DWT         (&hostRegs.dwt)
+#define CoreDebug   (&hostRegs.coreDebug)
+#define PWR         (&hostRegs.pwr)
+#define RCC         (&hostRegs.rcc)
+#define GPIOA       (&hostRegs.gpio[0])
+#define GPIOB       (&hostRegs.gpio[1])
+#define GPIOC       (&hostRegs.gpio[2])
+#define GPIOD       (&hostRegs.gpio[3])
+#define GPIOH       (&hostRegs.gpio[7])
+#define TIM5        (&hostRegs.tim5)
+#define WWDG        (&hostRegs.wwdg)
+#define IWDG        (&hostRegs.iwdg)
+
+#define I2C1_BASE   ((uint32_t)0x40005400)
+#define I2C2_BASE   ((uint32_t)0x40005800)
+#define I2C1        ((I2C_TypeDef *)(uintptr_t)I2C1_BASE)
+#define I2C2        ((I2C_TypeDef *)(uintptr_t)I2C2_BASE)
+
+#define SCB_SCR_SLEEPDEEP_Msk           (1UL << 2)
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+#define PWR_CR_LPSDSR                   (1UL << 0)
+#define PWR_CR_PDDS                     (1UL << 1)
+
+#define I2C_CR1_PE                      ((uint16_t)0x0001)
+#define I2C_CR1_START                   ((uint16_t)0x0100)
+#define I2C_CR1_STOP                    ((uint16_t)0x0200)
+#define I2C_CR1_ACK                     ((uint16_t)0x0400)
+#define I2C_CR2_ITERREN                 ((uint16_t)0x0100)
+#define I2C_CR2_ITEVTEN                 ((uint16_t)0x0200)
+#define I2C_CR2_ITBUFEN                 ((uint16_t)0x0400)
+#define I2C_OAR1_ADD0                   ((uint16_t)0x0001)
+#define I2C_SR1_SB                      ((uint16_t)0x0001)
+#define I2C_SR1_ADDR                    ((uint16_t)0x0002)
+#define I2C_SR1_BTF                     ((uint16_t)0x0004)
+#define I2C_SR1_ADD10                   ((uint16_t)0x0008)
+#define I2C_SR1_STOPF                   ((uint16_t)0x0010)
+#define I2C_SR1_RXNE                    ((uint16_t)0x0040)
+#define I2C_SR1_TXE                     ((uint16_t)0x0080)
+#define I2C_SR1_BERR                    ((uint16_t)0x0100)
+#define I2C_SR1_ARLO                    ((uint16_t)0x0200)
+#define I2C_SR1_AF                      ((uint16_t)0x0400)
+#define I2C_SR1_OVR                     ((uint16_t)0x0800)
+#define I2C_SR1_TIMEOUT                 ((uint16_t)0x4000)
+#define I2C_SR2_MSL                     ((uint16_t)0x0001)
+#define I2C_SR2_BUSY                    ((uint16_t)0x0002)
+#define I2C_SR2_TRA                     ((uint16_t)0x0004)
+
+#define SET_BIT(REG, BIT)               ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)             ((REG) &= ~(BIT))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK)  ((REG) = (((REG) & (~(CLEARMASK))) | (SETMASK)))
+
+#include "stm32l1xx_hal.h"
+
+#endif /* TESTS_HOST_CMSIS_H_ */
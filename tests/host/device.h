@@ -0,0 +1,45 @@
+/**
+ * File:      device.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) replacement for the mbed "device.h" file. Lists the HAL features available in the host build.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_DEVICE_H_
+#define TESTS_HOST_DEVICE_H_
+
+#define DEVICE_PORTIN           0
+#define DEVICE_PORTOUT          0
+#define DEVICE_INTERRUPTIN      1
+#define DEVICE_ANALOGIN         1
+#define DEVICE_ANALOGIN_ASYNC   1
+#define DEVICE_SERIAL           1
+#define DEVICE_I2C              1
+#define DEVICE_SPI              1
+#define DEVICE_LOCALFILESYSTEM  0
+
+//Interrupt driven I2C queue of the target HAL. Only the tests of the I2C peripheral model (stm32_i2c_model.h) enable
+//it, they compile the target's i2c_api.c. All others use the blocking I2C of host_hal.h.
+#if !defined(DEVICE_I2C_QUEUE)
+#define DEVICE_I2C_QUEUE        0
+#endif
+
+#include "cmsis.h"
+#include "PinNames.h"
+#include "objects.h"
+
+#endif /* TESTS_HOST_DEVICE_H_ */
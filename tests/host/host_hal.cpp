@@ -0,0 +1,530 @@
+/**
+ * File:      host_hal.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) implementation of the target hardware, see host_hal.h for details.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "host_hal.h"
+#include "us_ticker_api.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define PIN_COUNT           128     //8 ports of 16 pins
+#define PIN_INDEX(pin)      ((uint8_t)((pin) & 0x7F))
+#define SPI_MAX_DEVICES     8
+#define I2C_MAX_DEVICES     8
+#define WFI_IDLE_NS         1000000 //Time __WFI() waits if there are no events at all
+#define IRQ_COUNT           64
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+// All variables are POD, and zero initialized before any constructors run. Global mbed objects (DigitalOut...)
+// of the firmware can use them from their constructors.
+HostRegs hostRegs;
+
+typedef struct HostPin_ {
+    uint8_t output;     //1 if configured as MCU output
+    uint8_t latch;      //MCU output value
+    uint8_t drive;      //Value driven by simulated device, only valid if driven is 1
+    uint8_t driven;     //1 if pin is driven by a simulated device
+    uint8_t pull;       //PinMode
+    uint8_t level;      //Current level
+    void    (*onChange)(void* ctx, PinName pin, int level);
+    void*   onChangeCtx;
+    void    (*onIrq)(void* ctx, PinName pin, int level);
+    void*   onIrqCtx;
+} HostPin;
+
+typedef struct SpiSlot_ {
+    HostSpiDevice*  dev;
+    PinName         nss;
+} SpiSlot;
+
+typedef struct I2cSlot_ {
+    HostI2cDevice*  dev;
+    int             address;
+} I2cSlot;
+
+static uint64_t     timeNs;
+static uint32_t     tickerCostNs = 1000;
+static HostEvent*   eventHead;
+static uint32_t     primask;
+static bool         inIsr;
+static HostIsrStats isrStats;
+static HostPin      pins[PIN_COUNT];
+static SpiSlot      spiSlots[SPI_MAX_DEVICES];
+static I2cSlot      i2cSlots[I2C_MAX_DEVICES];
+static void         (*resetHandler)(void);
+static uint16_t     adcValues[PIN_COUNT];
+static HostEvent    adcEvent;
+static analogin_handler_t adcHandler;
+static void*        adcContext;
+static uint32_t     adcSum;
+static bool         adcBusy;
+static void         (*registerHook)(void* ctx);
+static void*        registerHookCtx;
+static bool         inRegisterHook;
+static void         (*nvicVectors[IRQ_COUNT])(void);
+static bool         nvicEnabled[IRQ_COUNT];
+
+
+// Time and events ////////////////////////////////////////////////////////////
+
+/** Returns first event that may run now, and is due at or before given time. Interrupt events are skipped while
+ * interrupts are disabled.
+ */
+static HostEvent* nextRunnable(uint64_t until) {
+    HostEvent* evt;
+
+    for (evt = eventHead; (evt != NULL) && (evt->when <= until); evt = evt->next) {
+        if ((evt->isr == false) || ((primask == 0) && (inIsr == false))) {
+            return evt;
+        }
+    }
+    return NULL;
+}
+
+static void unlink(HostEvent* evt) {
+    HostEvent** pp;
+
+    for (pp = &eventHead; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == evt) {
+            *pp = evt->next;
+            break;
+        }
+    }
+    evt->pending = false;
+    evt->next = NULL;
+}
+
+/** Call register hook, if set. Is not called again while it is running. */
+static void checkRegisters(void) {
+    if ((registerHook != NULL) && !inRegisterHook) {
+        inRegisterHook = true;
+        registerHook(registerHookCtx);
+        inRegisterHook = false;
+    }
+}
+
+/** Run all events due up to given time, and advance time to it */
+static void runUntil(uint64_t until) {
+    HostEvent* evt;
+    uint64_t start;
+
+    checkRegisters();
+    while ((evt = nextRunnable(until)) != NULL) {
+        if (evt->when > timeNs) {
+            timeNs = evt->when;
+        }
+        unlink(evt);
+
+        if (evt->isr) {
+            if ((timeNs - evt->when) > isrStats.maxLatNs) {
+                isrStats.maxLatNs = timeNs - evt->when;
+            }
+            start = timeNs;
+            inIsr = true;
+            evt->handler(evt->ctx);
+            inIsr = false;
+            isrStats.count++;
+            isrStats.totalNs += timeNs - start;
+            if ((timeNs - start) > isrStats.maxNs) {
+                isrStats.maxNs = timeNs - start;
+            }
+        }
+        else {
+            evt->handler(evt->ctx);
+        }
+        checkRegisters();
+    }
+
+    if (until > timeNs) {
+        timeNs = until;
+    }
+}
+
+uint64_t host_time_ns(void) {
+    return timeNs;
+}
+
+void host_advance_ns(uint64_t ns) {
+    runUntil(timeNs + ns);
+}
+
+void host_set_ticker_cost(uint32_t ns) {
+    tickerCostNs = ns;
+}
+
+bool host_in_isr(void) {
+    return inIsr;
+}
+
+void host_event_init(HostEvent* evt, void (*handler)(void* ctx), void* ctx, bool isr) {
+    evt->when = 0;
+    evt->handler = handler;
+    evt->ctx = ctx;
+    evt->isr = isr;
+    evt->pending = false;
+    evt->next = NULL;
+}
+
+void host_event_schedule(HostEvent* evt, uint64_t when) {
+    HostEvent** pp;
+
+    if (evt->pending) {
+        unlink(evt);
+    }
+
+    //Keep list sorted by time. Events with the same time run in the order they were scheduled.
+    evt->when = when;
+    for (pp = &eventHead; (*pp != NULL) && ((*pp)->when <= when); pp = &(*pp)->next) {
+    }
+    evt->next = *pp;
+    *pp = evt;
+    evt->pending = true;
+}
+
+void host_event_cancel(HostEvent* evt) {
+    if (evt->pending) {
+        unlink(evt);
+    }
+}
+
+void host_set_register_hook(void (*fn)(void* ctx), void* ctx) {
+    registerHook = fn;
+    registerHookCtx = ctx;
+}
+
+void host_isr_stats(HostIsrStats* pStats) {
+    *pStats = isrStats;
+    isrStats.count = 0;
+    isrStats.totalNs = 0;
+    isrStats.maxNs = 0;
+    isrStats.maxLatNs = 0;
+}
+
+uint32_t us_ticker_read(void) {
+    host_advance_ns(tickerCostNs);
+    return (uint32_t)(timeNs / 1000);
+}
+
+
+// Interrupt masking, cmsis.h /////////////////////////////////////////////////
+extern "C" void host_disable_irq(void) {
+    primask = 1;
+}
+
+extern "C" void host_enable_irq(void) {
+    primask = 0;
+    runUntil(timeNs);   //Run interrupts that became pending while disabled
+}
+
+extern "C" uint32_t host_get_primask(void) {
+    return primask;
+}
+
+extern "C" void host_set_primask(uint32_t priMask) {
+    primask = priMask & 1;
+    if (primask == 0) {
+        runUntil(timeNs);
+    }
+}
+
+extern "C" void host_wfi(void) {
+    //Sleep until next event. Wakes up for a pending interrupt, even if interrupts are disabled.
+    if (eventHead == NULL) {
+        runUntil(timeNs + WFI_IDLE_NS);
+    }
+    else if (eventHead->when > timeNs) {
+        runUntil(eventHead->when);
+    }
+    else {
+        runUntil(timeNs);
+    }
+}
+
+extern "C" void host_system_reset(void) {
+    if (resetHandler != NULL) {
+        resetHandler();
+    }
+    fprintf(stderr, "\nNVIC_SystemReset() called\n");
+    exit(3);
+}
+
+void host_set_reset_handler(void (*fn)(void)) {
+    resetHandler = fn;
+}
+
+
+// NVIC, cmsis.h //////////////////////////////////////////////////////////////
+extern "C" void host_nvic_set_vector(IRQn_Type IRQn, void (*vector)(void)) {
+    nvicVectors[IRQn] = vector;
+}
+
+extern "C" void NVIC_EnableIRQ(IRQn_Type IRQn) {
+    nvicEnabled[IRQn] = true;
+}
+
+extern "C" void NVIC_DisableIRQ(IRQn_Type IRQn) {
+    nvicEnabled[IRQn] = false;
+}
+
+bool host_nvic_enabled(IRQn_Type IRQn) {
+    return nvicEnabled[IRQn] && (nvicVectors[IRQn] != NULL);
+}
+
+bool host_nvic_call(IRQn_Type IRQn) {
+    if (!host_nvic_enabled(IRQn)) {
+        return false;
+    }
+    nvicVectors[IRQn]();
+    return true;
+}
+
+
+// GPIO ///////////////////////////////////////////////////////////////////////
+
+/** Update level of pin, and call change handlers if it changed */
+static void pinUpdate(PinName pin) {
+    HostPin* p = &pins[PIN_INDEX(pin)];
+    uint8_t level;
+
+    if (p->output) {
+        level = p->latch;
+    }
+    else if (p->driven) {
+        level = p->drive;
+    }
+    else {
+        level = (p->pull == PullUp) ? 1 : 0;    //Floating input reads 0
+    }
+
+    if (level != p->level) {
+        p->level = level;
+        if (p->onChange != NULL) {
+            p->onChange(p->onChangeCtx, pin, level);
+        }
+        if (p->onIrq != NULL) {
+            p->onIrq(p->onIrqCtx, pin, level);
+        }
+    }
+}
+
+void host_pin_input(PinName pin, PinMode pull) {
+    if (pin == NC) {
+        return;
+    }
+    pins[PIN_INDEX(pin)].output = 0;
+    pins[PIN_INDEX(pin)].pull = (uint8_t)pull;
+    pinUpdate(pin);
+}
+
+void host_pin_output(PinName pin) {
+    if (pin == NC) {
+        return;
+    }
+    pins[PIN_INDEX(pin)].output = 1;
+    pinUpdate(pin);
+}
+
+void host_pin_write(PinName pin, int value) {
+    if (pin == NC) {
+        return;
+    }
+    pins[PIN_INDEX(pin)].latch = (value != 0) ? 1 : 0;
+    pinUpdate(pin);
+}
+
+int host_pin_read(PinName pin) {
+    if (pin == NC) {
+        return 0;
+    }
+    runUntil(timeNs);   //Pin read is a poll point, interrupts can become pending
+    return pins[PIN_INDEX(pin)].level;
+}
+
+void host_pin_drive(PinName pin, int value) {
+    if (pin == NC) {
+        return;
+    }
+    pins[PIN_INDEX(pin)].driven = (value >= 0) ? 1 : 0;
+    pins[PIN_INDEX(pin)].drive = (value > 0) ? 1 : 0;
+    pinUpdate(pin);
+}
+
+void host_pin_on_change(PinName pin, void (*fn)(void* ctx, PinName pin, int level), void* ctx) {
+    if (pin == NC) {
+        return;
+    }
+    pins[PIN_INDEX(pin)].onChange = fn;
+    pins[PIN_INDEX(pin)].onChangeCtx = ctx;
+}
+
+void host_pin_on_irq(PinName pin, void (*fn)(void* ctx, PinName pin, int level), void* ctx) {
+    if (pin == NC) {
+        return;
+    }
+    pins[PIN_INDEX(pin)].onIrq = fn;
+    pins[PIN_INDEX(pin)].onIrqCtx = ctx;
+}
+
+
+// SPI ////////////////////////////////////////////////////////////////////////
+void host_spi_attach(HostSpiDevice* dev, PinName nss) {
+    uint8_t i;
+
+    for (i = 0; i < SPI_MAX_DEVICES; i++) {
+        if (spiSlots[i].dev == NULL) {
+            spiSlots[i].dev = dev;
+            spiSlots[i].nss = nss;
+            return;
+        }
+    }
+    fprintf(stderr, "host_spi_attach(): too many devices\n");
+    exit(2);
+}
+
+uint8_t host_spi_transfer(uint32_t hz, uint8_t mosi) {
+    uint8_t i;
+    uint8_t miso = 0xFF;
+
+    for (i = 0; i < SPI_MAX_DEVICES; i++) {
+        if ((spiSlots[i].dev != NULL) && (pins[PIN_INDEX(spiSlots[i].nss)].level == 0)) {
+            miso = spiSlots[i].dev->spiTransfer(mosi);
+            break;
+        }
+    }
+
+    host_advance_ns((8ULL * 1000000000ULL) / hz);
+    return miso;
+}
+
+
+// I2C ////////////////////////////////////////////////////////////////////////
+void host_i2c_attach(HostI2cDevice* dev, int address) {
+    uint8_t i;
+
+    for (i = 0; i < I2C_MAX_DEVICES; i++) {
+        if (i2cSlots[i].dev == NULL) {
+            i2cSlots[i].dev = dev;
+            i2cSlots[i].address = address & 0xFE;
+            return;
+        }
+    }
+    fprintf(stderr, "host_i2c_attach(): too many devices\n");
+    exit(2);
+}
+
+HostI2cDevice* host_i2c_find(int address) {
+    uint8_t i;
+
+    for (i = 0; i < I2C_MAX_DEVICES; i++) {
+        if ((i2cSlots[i].dev != NULL) && (i2cSlots[i].address == (address & 0xFE))) {
+            return i2cSlots[i].dev;
+        }
+    }
+    return NULL;
+}
+
+/** Advance time by duration of an I2C transfer: start, address and data bytes with ACK bits, stop */
+static void i2cAdvance(uint32_t hz, int len) {
+    host_advance_ns(((((uint64_t)len + 1) * 9) + 2) * 1000000000ULL / hz);
+}
+
+int host_i2c_write(uint32_t hz, int address, const uint8_t* data, int len) {
+    HostI2cDevice* dev = host_i2c_find(address);
+    bool ack;
+
+    if (dev == NULL) {
+        i2cAdvance(hz, 0);  //Only address byte is sent
+        return 1;
+    }
+    ack = dev->i2cWrite(data, len);
+    i2cAdvance(hz, len);
+    return ack ? 0 : 1;
+}
+
+int host_i2c_read(uint32_t hz, int address, uint8_t* data, int len) {
+    HostI2cDevice* dev = host_i2c_find(address);
+
+    if (dev == NULL) {
+        i2cAdvance(hz, 0);
+        return 1;
+    }
+    dev->i2cRead(data, len);
+    i2cAdvance(hz, len);
+    return 0;
+}
+
+
+// ADC ////////////////////////////////////////////////////////////////////////
+void host_adc_set(PinName pin, uint16_t value) {
+    adcValues[PIN_INDEX(pin)] = value & 0x0FFF;
+}
+
+extern "C" void analogin_init(analogin_t *obj, PinName pin) {
+    obj->pin = pin;
+}
+
+/** Wait for an ongoing oversampled read, then do a single conversion */
+static uint16_t adcConvert(analogin_t *obj) {
+    while (adcBusy) {
+        host_wfi();
+    }
+    host_advance_ns(HOST_ADC_CONVERSION_NS);
+    return adcValues[PIN_INDEX(obj->pin)];
+}
+
+extern "C" float analogin_read(analogin_t *obj) {
+    return (float)adcConvert(obj) / 4095.0f;
+}
+
+extern "C" uint16_t analogin_read_u16(analogin_t *obj) {
+    uint16_t value = adcConvert(obj);
+
+    return (value << 4) | (value >> 8);     //12-bit to 16-bit, same as target
+}
+
+static void adcDone(void* ctx) {
+    (void)ctx;
+    adcBusy = false;
+    if (adcHandler != NULL) {
+        adcHandler(adcContext, adcSum);
+    }
+}
+
+extern "C" int analogin_read_oversampled(analogin_t *obj, uint16_t count, analogin_handler_t handler, void *context) {
+    if (adcBusy || (count == 0)) {
+        return -1;
+    }
+    if (adcEvent.handler == NULL) {
+        host_event_init(&adcEvent, &adcDone, NULL, true);
+    }
+    adcBusy = true;
+    adcHandler = handler;
+    adcContext = context;
+    adcSum = (uint32_t)count * adcValues[PIN_INDEX(obj->pin)];
+    host_event_schedule(&adcEvent, timeNs + ((uint64_t)count * HOST_ADC_CONVERSION_NS));
+    return 0;
+}
+
+extern "C" int analogin_busy(void) {
+    return adcBusy ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * File:      host_hal.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) implementation of the target hardware used by the stub "mbed.h". Provides a simulated clock, an event
+ * queue, emulated interrupt masking, GPIO pins, and SPI and I2C busses that simulated devices (like the SX1276
+ * model in sx1276_model.h) can be attached to.
+ *
+ * Simulated time only advances when the firmware does something that takes time on the target: reading the
+ * us_ticker, waiting, sleeping (__WFI) and SPI or I2C transfers. Events that are due are run at these points.
+ * "Hardware" events (changes inside simulated devices) always run. "Interrupt" events (InterruptIn, Ticker and
+ * Timeout handlers) are held back while interrupts are disabled, or while another interrupt handler is running,
+ * like on the target. Results are reproducible, the same firmware always gives the same timing.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_HOST_HAL_H_
+#define TESTS_HOST_HOST_HAL_H_
+
+#include <stdint.h>
+#include "device.h"
+
+
+// Time ///////////////////////////////////////////////////////////////////////
+
+/** Returns simulated time in nano seconds since start */
+uint64_t host_time_ns(void);
+
+/** Advance simulated time by given number of nano seconds, running all events that become due */
+void host_advance_ns(uint64_t ns);
+
+/** Set how long a us_ticker_read() takes, in nano seconds. Default is 1000 (1us, about 32 cycles at 32MHz).
+ * Busy wait loops polling the us_ticker need this, else time never advances.
+ */
+void host_set_ticker_cost(uint32_t ns);
+
+/** Returns true if called from an interrupt handler */
+bool host_in_isr(void);
+
+
+// Events /////////////////////////////////////////////////////////////////////
+
+/** A scheduled event. Owned by caller, must stay valid while pending. */
+typedef struct HostEvent_ {
+    uint64_t    when;                   //Simulated time event is due, in ns
+    void        (*handler)(void* ctx);  //Function called when due
+    void*       ctx;                    //Given to handler
+    bool        isr;                    //True if an interrupt handler, is held back while interrupts are disabled
+    bool        pending;                //True while scheduled
+    struct HostEvent_* next;
+} HostEvent;
+
+/** Initialize event, must be called before first use */
+void host_event_init(HostEvent* evt, void (*handler)(void* ctx), void* ctx, bool isr);
+
+/** Schedule event at given simulated time. If already pending, it is rescheduled. */
+void host_event_schedule(HostEvent* evt, uint64_t when);
+
+/** Cancel event. Does nothing if not pending. */
+void host_event_cancel(HostEvent* evt);
+
+/** Set function called before running events, and after each event. Is used by models of peripherals the firmware
+ * accesses through registers (like stm32_i2c_model.h), to check for register writes. Registers are plain memory on
+ * the host, a write has no side effect until the model sees it. Only one hook can be set.
+ */
+void host_set_register_hook(void (*fn)(void* ctx), void* ctx);
+
+
+// NVIC ///////////////////////////////////////////////////////////////////////
+
+/** Returns true if given interrupt is enabled, and has a handler set with NVIC_SetVector() */
+bool host_nvic_enabled(IRQn_Type IRQn);
+
+/** Call handler set with NVIC_SetVector() for given interrupt. Is used by peripheral models, from an interrupt
+ * event. Does nothing if host_nvic_enabled() is false.
+ * @return True if handler was called
+ */
+bool host_nvic_call(IRQn_Type IRQn);
+
+
+// Interrupt statistics ///////////////////////////////////////////////////////
+typedef struct HostIsrStats_ {
+    uint32_t    count;      //Number of interrupt handlers run
+    uint64_t    totalNs;    //Total simulated time spent in interrupt handlers
+    uint64_t    maxNs;      //Longest interrupt handler
+    uint64_t    maxLatNs;   //Longest time from interrupt being due until handler started
+} HostIsrStats;
+
+/** Get statistics of interrupt handlers run since last call. Statistics are cleared. */
+void host_isr_stats(HostIsrStats* pStats);
+
+
+// GPIO ///////////////////////////////////////////////////////////////////////
+
+/** Configure pin as MCU input, with given pull resistor */
+void host_pin_input(PinName pin, PinMode pull);
+
+/** Configure pin as MCU output */
+void host_pin_output(PinName pin);
+
+/** Set value of MCU output latch. Pin level only changes if configured as output. */
+void host_pin_write(PinName pin, int value);
+
+/** Read pin level */
+int  host_pin_read(PinName pin);
+
+/** Drive pin from outside the MCU (by a simulated device). Value 0 or 1, or -1 to release (high impedance).
+ * An MCU output on the same pin has priority.
+ */
+void host_pin_drive(PinName pin, int value);
+
+/** Set function called on each level change of given pin, from hardware context. Only one per pin. Is used by
+ * simulated devices that have to know when the MCU changes one of their inputs (like a chip select).
+ */
+void host_pin_on_change(PinName pin, void (*fn)(void* ctx, PinName pin, int level), void* ctx);
+
+/** Same as host_pin_on_change(), but for the MCU's external interrupt of the pin. Is used by InterruptIn. */
+void host_pin_on_irq(PinName pin, void (*fn)(void* ctx, PinName pin, int level), void* ctx);
+
+
+// SPI ////////////////////////////////////////////////////////////////////////
+
+/** A simulated SPI slave device */
+class HostSpiDevice {
+public:
+    virtual ~HostSpiDevice() {}
+
+    /** Exchange a byte. Called for each byte while chip select is low.
+     * @return Byte returned on MISO
+     */
+    virtual uint8_t spiTransfer(uint8_t mosi) = 0;
+};
+
+/** Attach device to SPI bus, selected when given chip select pin is low */
+void host_spi_attach(HostSpiDevice* dev, PinName nss);
+
+/** Exchange a byte with the selected device, takes 8 SPI clocks of simulated time
+ * @return Byte returned by device, or 0xFF if no device is selected
+ */
+uint8_t host_spi_transfer(uint32_t hz, uint8_t mosi);
+
+
+// I2C ////////////////////////////////////////////////////////////////////////
+
+/** A simulated I2C slave device */
+class HostI2cDevice {
+public:
+    virtual ~HostI2cDevice() {}
+
+    /** Write transfer, with data following address byte
+     * @return True if device ACKed all bytes
+     */
+    virtual bool i2cWrite(const uint8_t* data, int len) = 0;
+
+    /** Read transfer
+     * @return True if device ACKed address
+     */
+    virtual bool i2cRead(uint8_t* data, int len) = 0;
+};
+
+/** Attach device to I2C bus with given 8-bit address (bit 0 = 0) */
+void host_i2c_attach(HostI2cDevice* dev, int address);
+
+/** Returns device attached with given 8-bit address, or NULL if none */
+HostI2cDevice* host_i2c_find(int address);
+
+/** Write to device at given 8-bit address. Takes ((len+1) * 9) + 2 I2C clocks of simulated time.
+ * @return 0 if OK, else 1 (no device, or NACK)
+ */
+int host_i2c_write(uint32_t hz, int address, const uint8_t* data, int len);
+
+/** Read from device at given 8-bit address. Takes ((len+1) * 9) + 2 I2C clocks of simulated time.
+ * @return 0 if OK, else 1 (no device)
+ */
+int host_i2c_read(uint32_t hz, int address, uint8_t* data, int len);
+
+
+// ADC ////////////////////////////////////////////////////////////////////////
+// Implements the analogin C API of mbed_nz32sc151/hal/analogin_api.h, including the interrupt driven
+// analogin_read_oversampled(). Each conversion takes HOST_ADC_CONVERSION_NS of simulated time.
+
+#define HOST_ADC_CONVERSION_NS  4000
+
+struct analogin_s {
+    PinName pin;
+};
+typedef struct analogin_s analogin_t;
+typedef void (*analogin_handler_t)(void *context, uint32_t sum);
+
+/** Set 12-bit value (0-4095) returned by conversions of given pin, default is 0 */
+void host_adc_set(PinName pin, uint16_t value);
+
+extern "C" {
+void     analogin_init(analogin_t *obj, PinName pin);
+float    analogin_read(analogin_t *obj);
+uint16_t analogin_read_u16(analogin_t *obj);
+int      analogin_read_oversampled(analogin_t *obj, uint16_t count, analogin_handler_t handler, void *context);
+int      analogin_busy(void);
+}
+
+
+// System /////////////////////////////////////////////////////////////////////
+
+/** Set function called by NVIC_SystemReset(). Default exits the program with exit code 3. */
+void host_set_reset_handler(void (*fn)(void));
+
+#endif /* TESTS_HOST_HOST_HAL_H_ */
@@ -0,0 +1,109 @@
+/**
+ * File:      host_usb.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Simulated USB CDC port, see host_usb.h for details.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <stddef.h>
+#include "host_hal.h"
+#include "host_usb.h"
+#include "usb_device.h"
+#include "usbd_cdc_if.h"
+#include "mx_usb_cdc.h"
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static uint8_t      rxFifo[HOST_USB_RX_FIFO_SIZE];
+static uint32_t     rxHead;
+static uint32_t     rxTail;
+static uint32_t     rxCount;
+static HostEvent    rxEvent;
+static bool         connected;
+static bool         txBusy;
+static void         (*txHandler)(void* ctx, const uint8_t* data, uint16_t len);
+static void*        txHandlerCtx;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+
+/** USB interrupt, give next packet to firmware */
+static void rxPacket(void* ctx) {
+    uint8_t packet[HOST_USB_PACKET_SIZE];
+    uint32_t len = 0;
+    (void)ctx;
+
+    while ((rxCount != 0) && (len < HOST_USB_PACKET_SIZE)) {
+        packet[len++] = rxFifo[rxTail];
+        rxTail = (rxTail + 1) % HOST_USB_RX_FIFO_SIZE;
+        rxCount--;
+    }
+    if (len != 0) {
+        mx_usbcdc_receive(packet, &len);
+    }
+    if (rxCount != 0) {
+        host_event_schedule(&rxEvent, host_time_ns() + HOST_USB_PACKET_NS);
+    }
+}
+
+uint32_t host_usb_send(const uint8_t* data, uint32_t len) {
+    uint32_t added = 0;
+
+    if (rxEvent.handler == NULL) {
+        host_event_init(&rxEvent, &rxPacket, NULL, true);
+    }
+    while ((added < len) && (rxCount < HOST_USB_RX_FIFO_SIZE)) {
+        rxFifo[rxHead] = data[added++];
+        rxHead = (rxHead + 1) % HOST_USB_RX_FIFO_SIZE;
+        rxCount++;
+    }
+    if ((rxCount != 0) && !rxEvent.pending) {
+        host_event_schedule(&rxEvent, host_time_ns() + HOST_USB_PACKET_NS);
+    }
+    return added;
+}
+
+uint32_t host_usb_pending(void) {
+    return rxCount;
+}
+
+void host_usb_set_tx_handler(void (*fn)(void* ctx, const uint8_t* data, uint16_t len), void* ctx) {
+    txHandler = fn;
+    txHandlerCtx = ctx;
+}
+
+void host_usb_set_tx_busy(bool busy) {
+    txBusy = busy;
+}
+
+bool host_usb_connected(void) {
+    return connected;
+}
+
+extern "C" void MX_USB_DEVICE_Init(void) {
+    connected = true;
+}
+
+extern "C" uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len) {
+    if (txBusy) {
+        return USBD_BUSY;
+    }
+    if (txHandler != NULL) {
+        txHandler(txHandlerCtx, Buf, Len);
+    }
+    return USBD_OK;
+}
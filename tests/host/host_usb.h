@@ -0,0 +1,50 @@
+/**
+ * File:      host_usb.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Simulated USB CDC (virtual COM) port, used with the firmware's mx_usb_cdc.cpp. Data sent by the PC is given to
+ * mx_usbcdc_receive() from an interrupt event, in 64 byte packets, like the STM32Cube USB library does. Data sent by
+ * the firmware with CDC_Transmit_FS() is given to a handler.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_HOST_USB_H_
+#define TESTS_HOST_HOST_USB_H_
+
+#include <stdint.h>
+
+#define HOST_USB_PACKET_SIZE    64      //Full speed bulk packet
+#define HOST_USB_PACKET_NS      50000   //Time between packets, about 19 packets per 1ms frame
+#define HOST_USB_RX_FIFO_SIZE   4096    //Data sent by PC, waiting to be given to firmware
+
+/** Send data from the PC to the firmware. Data that does not fit in the FIFO is discarded.
+ * @return Number of bytes added
+ */
+uint32_t host_usb_send(const uint8_t* data, uint32_t len);
+
+/** Get number of bytes sent by the PC, that were not given to the firmware yet */
+uint32_t host_usb_pending(void);
+
+/** Set handler called with data transmitted by the firmware with CDC_Transmit_FS() */
+void host_usb_set_tx_handler(void (*fn)(void* ctx, const uint8_t* data, uint16_t len), void* ctx);
+
+/** Set if the PC stops reading. CDC_Transmit_FS() then returns USBD_BUSY. */
+void host_usb_set_tx_busy(bool busy);
+
+/** Check if MX_USB_DEVICE_Init() was called by the firmware */
+bool host_usb_connected(void);
+
+#endif /* TESTS_HOST_HOST_USB_H_ */
@@ -0,0 +1,559 @@
+/**
+ * File:      mbed.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) replacement for the mbed library. Implements the parts of the mbed API used by the firmware, on top of
+ * the simulated hardware of host_hal.h. The classes have the same interface as the mbed 2 library in the
+ * "mbed_nz32sc151" folder, FunctionPointer.h and PinNames.h are used from it.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_MBED_H_
+#define TESTS_HOST_MBED_H_
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+#include "device.h"
+#include "us_ticker_api.h"
+#include "host_hal.h"
+#if DEVICE_I2C_QUEUE
+#include "i2c_api.h"
+#endif
+
+#if !defined(MBED_OPERATORS)
+#define MBED_OPERATORS
+#endif
+#include "../../mbed_nz32sc151/api/FunctionPointer.h"
+
+typedef uint32_t timestamp_t;
+
+namespace mbed {
+
+
+// Wait functions /////////////////////////////////////////////////////////////
+inline void wait_us(int us) {
+    host_advance_ns((uint64_t)us * 1000);
+}
+
+inline void wait_ms(int ms) {
+    host_advance_ns((uint64_t)ms * 1000000);
+}
+
+inline void wait(float s) {
+    host_advance_ns((uint64_t)(s * 1000000000.0));
+}
+
+
+// Digital IO /////////////////////////////////////////////////////////////////
+class DigitalOut {
+public:
+    DigitalOut(PinName pin, int value = 0) : _pin(pin) {
+        host_pin_write(_pin, value);
+        host_pin_output(_pin);
+    }
+
+    void write(int value) {
+        host_pin_write(_pin, value);
+    }
+
+    int read() {
+        return host_pin_read(_pin);
+    }
+
+    DigitalOut& operator= (int value) {
+        write(value);
+        return *this;
+    }
+
+    operator int() {
+        return read();
+    }
+
+protected:
+    PinName _pin;
+};
+
+class DigitalIn {
+public:
+    DigitalIn(PinName pin, PinMode pull = PullDefault) : _pin(pin) {
+        host_pin_input(_pin, pull);
+    }
+
+    int read() {
+        return host_pin_read(_pin);
+    }
+
+    void mode(PinMode pull) {
+        host_pin_input(_pin, pull);
+    }
+
+    operator int() {
+        return read();
+    }
+
+protected:
+    PinName _pin;
+};
+
+class DigitalInOut {
+public:
+    DigitalInOut(PinName pin) : _pin(pin), _pull(PullDefault) {
+        host_pin_input(_pin, _pull);
+    }
+
+    DigitalInOut(PinName pin, PinDirection direction, PinMode pull, int value) : _pin(pin), _pull(pull) {
+        host_pin_write(_pin, value);
+        if (direction == PIN_OUTPUT) {
+            host_pin_output(_pin);
+        }
+        else {
+            host_pin_input(_pin, _pull);
+        }
+    }
+
+    void write(int value) {
+        host_pin_write(_pin, value);
+    }
+
+    int read() {
+        return host_pin_read(_pin);
+    }
+
+    void output() {
+        host_pin_output(_pin);
+    }
+
+    void input() {
+        host_pin_input(_pin, _pull);
+    }
+
+    void mode(PinMode pull) {
+        _pull = pull;
+        host_pin_input(_pin, _pull);
+    }
+
+    DigitalInOut& operator= (int value) {
+        write(value);
+        return *this;
+    }
+
+    operator int() {
+        return read();
+    }
+
+protected:
+    PinName _pin;
+    PinMode _pull;
+};
+
+/** Input with rise and fall interrupt handlers. Handlers are called from simulated interrupt context. */
+class InterruptIn {
+public:
+    InterruptIn(PinName pin) : _pin(pin), _pull(PullDefault) {
+        host_event_init(&_evtRise, &InterruptIn::riseIsr, this, true);
+        host_event_init(&_evtFall, &InterruptIn::fallIsr, this, true);
+        host_pin_input(_pin, _pull);
+        host_pin_on_irq(_pin, &InterruptIn::edge, this);
+    }
+
+    virtual ~InterruptIn() {
+        host_pin_on_irq(_pin, NULL, NULL);
+        host_event_cancel(&_evtRise);
+        host_event_cancel(&_evtFall);
+    }
+
+    int read() {
+        return host_pin_read(_pin);
+    }
+
+    operator int() {
+        return read();
+    }
+
+    void mode(PinMode pull) {
+        _pull = pull;
+        host_pin_input(_pin, _pull);
+    }
+
+    void rise(void (*fptr)(void)) {
+        _rise.attach(fptr);
+    }
+
+    template<typename T>
+    void rise(T* tptr, void (T::*mptr)(void)) {
+        _rise.attach(tptr, mptr);
+    }
+
+    void fall(void (*fptr)(void)) {
+        _fall.attach(fptr);
+    }
+
+    template<typename T>
+    void fall(T* tptr, void (T::*mptr)(void)) {
+        _fall.attach(tptr, mptr);
+    }
+
+protected:
+    static void edge(void* ctx, PinName pin, int level) {
+        InterruptIn* self = (InterruptIn*)ctx;
+        (void)pin;
+
+        //Interrupt becomes pending now, is run as soon as interrupts are enabled
+        if ((level != 0) && (self->_rise)) {
+            if (self->_evtRise.pending == false) {
+                host_event_schedule(&self->_evtRise, host_time_ns());
+            }
+        }
+        else if ((level == 0) && (self->_fall)) {
+            if (self->_evtFall.pending == false) {
+                host_event_schedule(&self->_evtFall, host_time_ns());
+            }
+        }
+    }
+
+    static void riseIsr(void* ctx) {
+        ((InterruptIn*)ctx)->_rise.call();
+    }
+
+    static void fallIsr(void* ctx) {
+        ((InterruptIn*)ctx)->_fall.call();
+    }
+
+    PinName         _pin;
+    PinMode         _pull;
+    FunctionPointer _rise;
+    FunctionPointer _fall;
+    HostEvent       _evtRise;
+    HostEvent       _evtFall;
+};
+
+
+// Timers /////////////////////////////////////////////////////////////////////
+
+/** Periodic interrupt. Like mbed, the next period is scheduled from the time the interrupt was due, not from the
+ * time the handler was called.
+ */
+class Ticker {
+public:
+    Ticker() : _periodNs(0) {
+        host_event_init(&_evt, &Ticker::isr, this, true);
+    }
+
+    virtual ~Ticker() {
+        detach();
+    }
+
+    void attach(void (*fptr)(void), float t) {
+        attach_us(fptr, (timestamp_t)(t * 1000000.0f));
+    }
+
+    template<typename T>
+    void attach(T* tptr, void (T::*mptr)(void), float t) {
+        attach_us(tptr, mptr, (timestamp_t)(t * 1000000.0f));
+    }
+
+    void attach_us(void (*fptr)(void), timestamp_t t) {
+        _function.attach(fptr);
+        setup(t);
+    }
+
+    template<typename T>
+    void attach_us(T* tptr, void (T::*mptr)(void), timestamp_t t) {
+        _function.attach(tptr, mptr);
+        setup(t);
+    }
+
+    void detach() {
+        host_event_cancel(&_evt);
+    }
+
+protected:
+    void setup(timestamp_t t) {
+        _periodNs = (uint64_t)t * 1000;
+        host_event_schedule(&_evt, host_time_ns() + _periodNs);
+    }
+
+    virtual void handler() {
+        host_event_schedule(&_evt, _evt.when + _periodNs);
+        _function.call();
+    }
+
+    static void isr(void* ctx) {
+        ((Ticker*)ctx)->handler();
+    }
+
+    FunctionPointer _function;
+    HostEvent       _evt;
+    uint64_t        _periodNs;
+};
+
+/** Single shot interrupt */
+class Timeout : public Ticker {
+protected:
+    virtual void handler() {
+        _function.call();
+    }
+};
+
+class Timer {
+public:
+    Timer() : _running(false), _start(0), _time(0) {
+    }
+
+    void start() {
+        if (!_running) {
+            _start = us_ticker_read();
+            _running = true;
+        }
+    }
+
+    void stop() {
+        _time += slicetime();
+        _running = false;
+    }
+
+    void reset() {
+        _start = us_ticker_read();
+        _time = 0;
+    }
+
+    float read() {
+        return (float)read_us() / 1000000.0f;
+    }
+
+    int read_ms() {
+        return read_us() / 1000;
+    }
+
+    int read_us() {
+        return _time + slicetime();
+    }
+
+    operator float() {
+        return read();
+    }
+
+protected:
+    int slicetime() {
+        return _running ? (int)(us_ticker_read() - _start) : 0;
+    }
+
+    bool        _running;
+    uint32_t    _start;
+    int         _time;
+};
+
+
+// Streams ////////////////////////////////////////////////////////////////////
+class Stream {
+public:
+    Stream(const char* name = NULL) {
+        (void)name;
+    }
+
+    virtual ~Stream() {
+    }
+
+    int putc(int c) {
+        return _putc(c);
+    }
+
+    int puts(const char* s) {
+        while (*s != 0) {
+            _putc(*s++);
+        }
+        return 0;
+    }
+
+    int getc() {
+        return _getc();
+    }
+
+    int printf(const char* format, ...) {
+        char buf[256];
+        va_list args;
+        int len;
+        int i;
+
+        va_start(args, format);
+        len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (len > (int)sizeof(buf) - 1) {
+            len = sizeof(buf) - 1;
+        }
+        for (i = 0; i < len; i++) {
+            _putc(buf[i]);
+        }
+        return len;
+    }
+
+protected:
+    virtual int _putc(int c) = 0;
+    virtual int _getc() = 0;
+};
+
+/** UART. Output is written to the file set with setOutput(), default is none (output discarded). */
+class Serial : public Stream {
+public:
+    Serial(PinName tx, PinName rx, const char* name = NULL) : Stream(name), _out(NULL) {
+        (void)tx;
+        (void)rx;
+    }
+
+    void baud(int baudrate) {
+        (void)baudrate;
+    }
+
+    int readable() {
+        return 0;
+    }
+
+    int writeable() {
+        return 1;
+    }
+
+    /** Host only. Set file output is written to, or NULL to discard it */
+    void setOutput(FILE* out) {
+        _out = out;
+    }
+
+protected:
+    virtual int _putc(int c) {
+        if (_out != NULL) {
+            fputc(c, _out);
+        }
+        return c;
+    }
+
+    virtual int _getc() {
+        return -1;
+    }
+
+    FILE* _out;
+};
+
+
+// Busses /////////////////////////////////////////////////////////////////////
+class SPI {
+public:
+    SPI(PinName mosi, PinName miso, PinName sclk, PinName ssel = NC) : _hz(1000000) {
+        (void)mosi;
+        (void)miso;
+        (void)sclk;
+        (void)ssel;
+    }
+
+    void format(int bits, int mode = 0) {
+        (void)bits;
+        (void)mode;
+    }
+
+    void frequency(int hz = 1000000) {
+        _hz = hz;
+    }
+
+    int write(int value) {
+        return host_spi_transfer(_hz, (uint8_t)value);
+    }
+
+protected:
+    uint32_t _hz;
+};
+
+#if DEVICE_I2C_QUEUE
+/** Same as mbed I2C.cpp, uses the target HAL (i2c_api.c) with the I2C peripheral model of stm32_i2c_model.h */
+class I2C {
+public:
+    I2C(PinName sda, PinName scl) {
+        i2c_init(&_i2c, sda, scl);
+    }
+
+    void frequency(int hz) {
+        i2c_frequency(&_i2c, hz);
+    }
+
+    /** Write given data to slave with given 8-bit address
+     * @return 0 on success (ACK), non-0 on failure (NACK)
+     */
+    int write(int address, const char* data, int length, bool repeated = false) {
+        int written = i2c_write(&_i2c, address, data, length, repeated ? 0 : 1);
+        return (length != written);
+    }
+
+    /** Read data from slave with given 8-bit address
+     * @return 0 on success (ACK), non-0 on failure (NACK)
+     */
+    int read(int address, char* data, int length, bool repeated = false) {
+        int read = i2c_read(&_i2c, address, data, length, repeated ? 0 : 1);
+        return (length != read);
+    }
+
+    /** Get the HAL I2C object, for use with the i2c_queue_xxx() functions */
+    i2c_t* get_hal_obj(void) {
+        return &_i2c;
+    }
+
+protected:
+    i2c_t _i2c;
+};
+
+#else
+class I2C {
+public:
+    I2C(PinName sda, PinName scl) : _hz(100000) {
+        (void)sda;
+        (void)scl;
+    }
+
+    void frequency(int hz) {
+        _hz = hz;
+    }
+
+    /** Write given data to slave with given 8-bit address
+     * @return 0 on success (ACK), non-0 on failure (NACK)
+     */
+    int write(int address, const char* data, int length, bool repeated = false) {
+        (void)repeated;
+        return host_i2c_write(_hz, address, (const uint8_t*)data, length);
+    }
+
+    /** Read data from slave with given 8-bit address
+     * @return 0 on success (ACK), non-0 on failure (NACK)
+     */
+    int read(int address, char* data, int length, bool repeated = false) {
+        (void)repeated;
+        return host_i2c_read(_hz, address, (uint8_t*)data, length);
+    }
+
+protected:
+    uint32_t _hz;
+};
+#endif
+
+} // namespace mbed
+
+namespace std {
+}
+
+using namespace mbed;
+using namespace std;
+
+#endif /* TESTS_HOST_MBED_H_ */
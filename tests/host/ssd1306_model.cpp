@@ -0,0 +1,195 @@
+/**
+ * File:      ssd1306_model.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Behavioural model of the SSD1306 OLED controller, see ssd1306_model.h for details.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <string.h>
+#include "ssd1306_model.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define CTRL_CO         0x80    //Control byte "Continuation" bit, only one byte follows
+#define CTRL_DC         0x40    //Control byte "Data/Command" bit, 1=display data
+
+#define MODE_HORIZONTAL 0
+#define MODE_VERTICAL   1
+#define MODE_PAGE       2
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+Ssd1306Model::Ssd1306Model(int address) {
+    memset(ram, 0, sizeof(ram));
+    mode = MODE_PAGE;   //Reset values
+    col = 0;
+    page = 0;
+    colStart = 0;
+    colEnd = SSD1306_MODEL_WIDTH - 1;
+    pageStart = 0;
+    pageEnd = SSD1306_MODEL_PAGES - 1;
+    cmdLen = 0;
+    cmdArgs = 0;
+    displayOn = false;
+    inverted = false;
+    contrast = 0x7f;
+    memset(&stats, 0, sizeof(stats));
+    host_i2c_attach(this, address);
+}
+
+/** Number of argument bytes following given command byte */
+static uint8_t commandArgs(uint8_t c) {
+    switch (c) {
+    case 0x20:  //Memory addressing mode
+    case 0x81:  //Contrast
+    case 0x8D:  //Charge pump
+    case 0xA8:  //Multiplex ratio
+    case 0xD3:  //Display offset
+    case 0xD5:  //Clock divide
+    case 0xD9:  //Precharge
+    case 0xDA:  //COM pins
+    case 0xDB:  //VCOMH deselect level
+        return 1;
+    case 0x21:  //Column address
+    case 0x22:  //Page address
+    case 0xA3:  //Vertical scroll area
+        return 2;
+    case 0x29:  //Vertical and horizontal scroll setup
+    case 0x2A:
+        return 5;
+    case 0x26:  //Horizontal scroll setup
+    case 0x27:
+        return 6;
+    }
+    return 0;
+}
+
+void Ssd1306Model::command(uint8_t c) {
+    stats.commandBytes++;
+    cmd[cmdLen++] = c;
+    if (cmdLen == 1) {
+        cmdArgs = commandArgs(c);
+    }
+    if (cmdLen <= cmdArgs) {
+        return;     //Wait for arguments
+    }
+    cmdLen = 0;
+
+    if (cmd[0] <= 0x0F) {
+        col = (col & 0xF0) | (cmd[0] & 0x0F);   //Page mode, lower column nibble
+    }
+    else if (cmd[0] <= 0x1F) {
+        col = (col & 0x0F) | ((cmd[0] & 0x0F) << 4);    //Page mode, higher column nibble
+    }
+    else if (cmd[0] == 0x20) {
+        mode = cmd[1] & 0x03;
+    }
+    else if (cmd[0] == 0x21) {
+        colStart = cmd[1] & 0x7F;
+        colEnd = cmd[2] & 0x7F;
+        col = colStart;
+    }
+    else if (cmd[0] == 0x22) {
+        pageStart = cmd[1] & 0x07;
+        pageEnd = cmd[2] & 0x07;
+        page = pageStart;
+    }
+    else if (cmd[0] == 0x81) {
+        contrast = cmd[1];
+    }
+    else if ((cmd[0] == 0xA6) || (cmd[0] == 0xA7)) {
+        inverted = (cmd[0] == 0xA7);
+    }
+    else if ((cmd[0] == 0xAE) || (cmd[0] == 0xAF)) {
+        displayOn = (cmd[0] == 0xAF);
+    }
+    else if ((cmd[0] >= 0xB0) && (cmd[0] <= 0xB7)) {
+        page = cmd[0] & 0x07;   //Page mode, page start
+    }
+}
+
+void Ssd1306Model::writeData(uint8_t d) {
+    stats.dataBytes++;
+    ram[page][col] = d;
+
+    if (mode == MODE_PAGE) {
+        //Column wraps to 0, page is not changed
+        col = (col + 1) % SSD1306_MODEL_WIDTH;
+    }
+    else if (mode == MODE_HORIZONTAL) {
+        if (col++ >= colEnd) {
+            col = colStart;
+            page = (page >= pageEnd) ? pageStart : (page + 1);
+        }
+    }
+    else {
+        if (page++ >= pageEnd) {
+            page = pageStart;
+            col = (col >= colEnd) ? colStart : (col + 1);
+        }
+    }
+}
+
+bool Ssd1306Model::i2cWrite(const uint8_t* data, int len) {
+    uint8_t ctrl;
+    int i = 0;
+
+    //Command arguments can be sent in following transfers, cmdLen is not reset
+    stats.writes++;
+    while (i < len) {
+        ctrl = data[i++];
+        //Co=1: only one command or data byte follows, then another control byte
+        if ((ctrl & CTRL_CO) != 0) {
+            if (i < len) {
+                if ((ctrl & CTRL_DC) != 0) {
+                    writeData(data[i]);
+                }
+                else {
+                    command(data[i]);
+                }
+                i++;
+            }
+            continue;
+        }
+        //Co=0: all following bytes are commands or data
+        for (; i < len; i++) {
+            if ((ctrl & CTRL_DC) != 0) {
+                writeData(data[i]);
+            }
+            else {
+                command(data[i]);
+            }
+        }
+    }
+    return true;
+}
+
+bool Ssd1306Model::i2cRead(uint8_t* data, int len) {
+    memset(data, 0, len);   //Status register, not modelled
+    return true;
+}
+
+void Ssd1306Model::fillRam(uint8_t value) {
+    memset(ram, value, sizeof(ram));
+}
+
+Ssd1306Stats Ssd1306Model::getStats(void) {
+    Ssd1306Stats s = stats;
+
+    memset(&stats, 0, sizeof(stats));
+    return s;
+}
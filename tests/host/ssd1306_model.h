@@ -0,0 +1,105 @@
+/**
+ * File:      ssd1306_model.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Behavioural model of the Solomon SSD1306 OLED controller (im4OLED module), for host tests. Is attached to the
+ * simulated I2C bus of host_hal.h, and is used by the unmodified MxSSD1306_I2C driver.
+ *
+ * Modelled:
+ * - I2C control byte (Co and D/C bits), with command and data streams.
+ * - 128x64 GDDRAM, with page, horizontal and vertical addressing modes, and the column/page windows of
+ *   SET_COLUMN_ADR and SET_PAGE_ADR.
+ * - Argument bytes of all commands, so the command stream is parsed correctly. Display on/off, contrast and
+ *   invert are recorded, all other settings are ignored.
+ * - Number of I2C writes, and command and data bytes received.
+ *
+ * Not modelled: scrolling, segment remap and COM scan direction (GDDRAM is not remapped), reading.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_SSD1306_MODEL_H_
+#define TESTS_HOST_SSD1306_MODEL_H_
+
+#include <stdint.h>
+#include "host_hal.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define SSD1306_MODEL_WIDTH     128
+#define SSD1306_MODEL_PAGES     8       //Each page is 8 rows
+
+/** Counters of I2C traffic received by the model */
+typedef struct Ssd1306Stats_ {
+    uint32_t    writes;         //I2C write transfers
+    uint32_t    commandBytes;   //Command bytes, including arguments
+    uint32_t    dataBytes;      //Display data bytes
+} Ssd1306Stats;
+
+class Ssd1306Model : public HostI2cDevice {
+public:
+    /** Create model, and attach it to the I2C bus with given 8-bit address */
+    Ssd1306Model(int address);
+
+    virtual bool i2cWrite(const uint8_t* data, int len);
+    virtual bool i2cRead(uint8_t* data, int len);
+
+    /** Get GDDRAM, SSD1306_MODEL_PAGES pages of SSD1306_MODEL_WIDTH bytes. Same layout as the MxSSD1306 buffer. */
+    const uint8_t* getRam(void) {
+        return ram[0];
+    }
+
+    /** Set all GDDRAM bytes to given value */
+    void fillRam(uint8_t value);
+
+    /** Get statistics since last call, they are cleared */
+    Ssd1306Stats getStats(void);
+
+    bool isDisplayOn(void) {
+        return displayOn;
+    }
+
+    bool isInverted(void) {
+        return inverted;
+    }
+
+    uint8_t getContrast(void) {
+        return contrast;
+    }
+
+protected:
+    void command(uint8_t c);
+    void writeData(uint8_t d);
+
+    uint8_t     ram[SSD1306_MODEL_PAGES][SSD1306_MODEL_WIDTH];
+    uint8_t     mode;           //0=horizontal, 1=vertical, 2=page addressing mode
+    uint8_t     col;
+    uint8_t     page;
+    uint8_t     colStart;
+    uint8_t     colEnd;
+    uint8_t     pageStart;
+    uint8_t     pageEnd;
+
+    uint8_t     cmd[7];         //Current command and its arguments
+    uint8_t     cmdLen;         //Bytes received of current command
+    uint8_t     cmdArgs;        //Argument bytes of current command
+
+    bool        displayOn;
+    bool        inverted;
+    uint8_t     contrast;
+    Ssd1306Stats stats;
+};
+
+#endif /* TESTS_HOST_SSD1306_MODEL_H_ */
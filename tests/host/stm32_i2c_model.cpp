@@ -0,0 +1,484 @@
+/**
+ * File:      stm32_i2c_model.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) model of the STM32L1 I2C peripheral, see stm32_i2c_model.h. Also implements the STM32L1 HAL functions,
+ * and the mbed pinmap functions used by i2c_api.c.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "stm32_i2c_model.h"
+#include "mbed_assert.h"
+#include "pinmap.h"
+#include "PeripheralPins.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define REGS_PAGE           ((uintptr_t)0x40005000) //Page with the I2C1 and I2C2 registers
+#define REGS_PAGE_SIZE      4096
+#define BUS_COUNT           2
+#define TRANSFER_MAX        2048    //Maximum length of a write transfer, excluding address
+#define IRQ_STORM_MAX       1000    //Maximum interrupt handler calls without simulated time advancing
+
+#define SR1_EV_FLAGS        (I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_BTF | I2C_SR1_ADD10 | I2C_SR1_STOPF)
+#define SR1_BUF_FLAGS       (I2C_SR1_TXE | I2C_SR1_RXNE)
+#define SR1_ER_FLAGS        (I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | I2C_SR1_OVR | I2C_SR1_TIMEOUT)
+
+typedef enum {
+    PHASE_IDLE,         //Not master
+    PHASE_START,        //Generating START condition
+    PHASE_SB,           //SB set, waiting for address to be written to DR
+    PHASE_ADDR,         //Sending address byte
+    PHASE_ADDR_DONE,    //ADDR or AF set, waiting for firmware
+    PHASE_DATA,         //Sending data, shifting is true while a byte is sent
+    PHASE_STOP          //Generating STOP condition
+} Phase;
+
+typedef struct Bus_ {
+    const char*     name;
+    I2C_TypeDef*    regs;
+    IRQn_Type       evIrqn;
+    IRQn_Type       erIrqn;
+    uint32_t        hz;
+    Phase           phase;
+    bool            startReq;   //START bit of CR1 has been seen
+    bool            shifting;   //Data byte is being sent
+    bool            holdFull;   //Byte waiting in DR, TXE is 0
+    uint8_t         hold;
+    uint8_t         shift;
+    uint8_t         address;
+    HostI2cDevice*  dev;        //Device that acknowledged the address
+    uint8_t         data[TRANSFER_MAX];
+    int             len;
+    HostEvent       timer;      //End of START, STOP or byte
+    HostEvent       evIrq;
+    HostEvent       erIrq;
+    uint64_t        irqTime;    //Time of last interrupt, and number of interrupts at that time
+    uint32_t        irqCount;
+    Stm32I2cStats   stats;
+} Bus;
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static Bus  buses[BUS_COUNT];
+static bool mapped;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static void check(Bus* b);
+static void checkAll(void* ctx);
+static void timerDone(void* ctx);
+static void evIrqRun(void* ctx);
+static void erIrqRun(void* ctx);
+
+static void error(Bus* b, const char* msg) {
+    fprintf(stderr, "%s: %s\n", b->name, msg);
+    b->stats.errors++;
+}
+
+static void busReset(Bus* b) {
+    host_event_cancel(&b->timer);
+    host_event_cancel(&b->evIrq);
+    host_event_cancel(&b->erIrq);
+    memset((void*)b->regs, 0, sizeof(I2C_TypeDef));
+    b->regs->DR = STM32_I2C_DR_EMPTY;
+    b->phase = PHASE_IDLE;
+    b->startReq = false;
+    b->shifting = false;
+    b->holdFull = false;
+    b->dev = NULL;
+    b->len = 0;
+}
+
+/** Map the registers, and initialize the model. Called by all functions i2c_api.c uses before accessing registers. */
+static void init(void) {
+    void* p;
+    uint8_t i;
+
+    if (mapped) {
+        return;
+    }
+    p = mmap((void*)REGS_PAGE, REGS_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p != (void*)REGS_PAGE) {
+        fprintf(stderr, "stm32_i2c_model: can not map registers at 0x%lx\n", (unsigned long)REGS_PAGE);
+        exit(2);
+    }
+    mapped = true;
+
+    buses[0].name = "I2C1";
+    buses[0].regs = I2C1;
+    buses[0].evIrqn = I2C1_EV_IRQn;
+    buses[0].erIrqn = I2C1_ER_IRQn;
+    buses[1].name = "I2C2";
+    buses[1].regs = I2C2;
+    buses[1].evIrqn = I2C2_EV_IRQn;
+    buses[1].erIrqn = I2C2_ER_IRQn;
+    for (i = 0; i < BUS_COUNT; i++) {
+        buses[i].hz = 100000;
+        host_event_init(&buses[i].timer, &timerDone, &buses[i], false);
+        host_event_init(&buses[i].evIrq, &evIrqRun, &buses[i], true);
+        host_event_init(&buses[i].erIrq, &erIrqRun, &buses[i], true);
+        busReset(&buses[i]);
+    }
+    host_set_register_hook(&checkAll, NULL);
+}
+
+static Bus* busOf(I2C_TypeDef* regs) {
+    uint8_t i;
+
+    init();
+    for (i = 0; i < BUS_COUNT; i++) {
+        if (buses[i].regs == regs) {
+            return &buses[i];
+        }
+    }
+    fprintf(stderr, "stm32_i2c_model: no I2C peripheral at %p\n", (void*)regs);
+    exit(2);
+}
+
+static void startTimer(Bus* b, uint32_t bits) {
+    host_event_schedule(&b->timer, host_time_ns() + ((bits * 1000000000ULL) / b->hz));
+}
+
+/** Give the write transfer to the device that acknowledged the address, if any */
+static void deliver(Bus* b) {
+    if (b->dev != NULL) {
+        b->stats.transfers++;
+        b->dev->i2cWrite(b->data, b->len);
+    }
+    b->dev = NULL;
+    b->len = 0;
+}
+
+static void clearAddr(Bus* b) {
+    if (b->regs->SR1 & I2C_SR1_ADDR) {
+        b->regs->SR1 = (b->regs->SR1 & ~I2C_SR1_ADDR) | I2C_SR1_TXE;
+        b->phase = PHASE_DATA;
+    }
+}
+
+static void drWritten(Bus* b, uint8_t value) {
+    I2C_TypeDef* r = b->regs;
+
+    if ((b->phase == PHASE_SB) && (r->CR1 & I2C_CR1_STOP) == 0) {
+        r->SR1 &= ~I2C_SR1_SB;
+        b->address = value;
+        b->phase = PHASE_ADDR;
+        startTimer(b, 9);
+    }
+    else if ((b->phase != PHASE_DATA) || (r->CR1 & I2C_CR1_STOP)) {
+        error(b, "DR written while no byte can be sent");
+    }
+    else if (!b->shifting) {
+        b->shift = value;
+        b->shifting = true;
+        r->SR1 &= ~I2C_SR1_BTF;
+        startTimer(b, 9);
+    }
+    else {
+        if (b->holdFull) {
+            error(b, "DR written while TXE is 0, byte overwritten");
+        }
+        b->hold = value;
+        b->holdFull = true;
+        r->SR1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF);
+    }
+}
+
+/** Schedule or cancel interrupts, depending on flags and interrupt enables */
+static void updateIrq(Bus* b) {
+    uint32_t sr1 = b->regs->SR1;
+    uint32_t cr2 = b->regs->CR2;
+    bool ev;
+    bool er;
+
+    ev = (cr2 & I2C_CR2_ITEVTEN) && ((sr1 & SR1_EV_FLAGS) || ((cr2 & I2C_CR2_ITBUFEN) && (sr1 & SR1_BUF_FLAGS)));
+    er = (cr2 & I2C_CR2_ITERREN) && (sr1 & SR1_ER_FLAGS);
+
+    if (ev && host_nvic_enabled(b->evIrqn)) {
+        if (!b->evIrq.pending) {
+            host_event_schedule(&b->evIrq, host_time_ns());
+        }
+    }
+    else {
+        host_event_cancel(&b->evIrq);
+    }
+    if (er && host_nvic_enabled(b->erIrqn)) {
+        if (!b->erIrq.pending) {
+            host_event_schedule(&b->erIrq, host_time_ns());
+        }
+    }
+    else {
+        host_event_cancel(&b->erIrq);
+    }
+}
+
+/** Check registers for writes by the firmware */
+static void check(Bus* b) {
+    I2C_TypeDef* r = b->regs;
+
+    if (r->DR != STM32_I2C_DR_EMPTY) {
+        uint8_t value = (uint8_t)r->DR;
+        r->DR = STM32_I2C_DR_EMPTY;
+        drWritten(b, value);
+    }
+
+    if ((r->CR1 & I2C_CR1_START) && !b->startReq) {
+        b->startReq = true;
+        if ((r->CR1 & I2C_CR1_STOP) || (b->phase == PHASE_STOP)) {
+            b->stats.startsAfterStop++;
+        }
+    }
+
+    //STOP and START are generated after the current START condition or byte
+    if (!b->timer.pending && (r->CR1 & I2C_CR1_PE)) {
+        if (r->CR1 & I2C_CR1_STOP) {
+            if (b->phase == PHASE_IDLE) {
+                r->CR1 &= ~I2C_CR1_STOP;    //Not master, nothing to do
+            }
+            else if (b->phase != PHASE_STOP) {
+                b->phase = PHASE_STOP;
+                b->shifting = false;
+                b->holdFull = false;
+                startTimer(b, 1);
+            }
+        }
+        else if (r->CR1 & I2C_CR1_START) {
+            deliver(b);     //Repeated START ends previous transfer
+            b->phase = PHASE_START;
+            b->shifting = false;
+            b->holdFull = false;
+            startTimer(b, 1);
+        }
+    }
+
+    updateIrq(b);
+}
+
+static void checkAll(void* ctx) {
+    uint8_t i;
+
+    (void)ctx;
+    for (i = 0; i < BUS_COUNT; i++) {
+        check(&buses[i]);
+    }
+}
+
+static void timerDone(void* ctx) {
+    Bus* b = (Bus*)ctx;
+    I2C_TypeDef* r = b->regs;
+
+    switch (b->phase) {
+    case PHASE_START:
+        r->CR1 &= ~I2C_CR1_START;
+        r->SR1 = (r->SR1 & ~(I2C_SR1_TXE | I2C_SR1_BTF)) | I2C_SR1_SB;
+        r->SR2 |= I2C_SR2_MSL | I2C_SR2_BUSY;
+        b->startReq = false;
+        b->phase = PHASE_SB;
+        b->stats.starts++;
+        break;
+    case PHASE_ADDR:
+        b->dev = (b->address & 0x01) ? NULL : host_i2c_find(b->address);
+        if (b->dev != NULL) {
+            r->SR1 |= I2C_SR1_ADDR;
+            r->SR2 |= I2C_SR2_TRA;
+        }
+        else {
+            r->SR1 |= I2C_SR1_AF;
+            b->stats.nacks++;
+        }
+        b->phase = PHASE_ADDR_DONE;
+        break;
+    case PHASE_DATA:
+        if (b->len < TRANSFER_MAX) {
+            b->data[b->len++] = b->shift;
+        }
+        else {
+            error(b, "transfer too long");
+        }
+        if (b->holdFull) {
+            b->shift = b->hold;
+            b->holdFull = false;
+            r->SR1 |= I2C_SR1_TXE;
+            startTimer(b, 9);
+        }
+        else {
+            b->shifting = false;
+            r->SR1 |= I2C_SR1_BTF;
+        }
+        break;
+    case PHASE_STOP:
+        r->CR1 &= ~I2C_CR1_STOP;
+        r->SR1 &= ~(I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_BTF | I2C_SR1_TXE);
+        r->SR2 &= ~(I2C_SR2_MSL | I2C_SR2_BUSY | I2C_SR2_TRA);
+        deliver(b);
+        b->phase = PHASE_IDLE;
+        b->stats.stops++;
+        break;
+    default:
+        break;
+    }
+    check(b);
+}
+
+/** Stop program if interrupt handlers run without end, firmware did not clear an interrupt flag */
+static void checkStorm(Bus* b) {
+    if (b->irqTime != host_time_ns()) {
+        b->irqTime = host_time_ns();
+        b->irqCount = 0;
+    }
+    if (++b->irqCount > IRQ_STORM_MAX) {
+        fprintf(stderr, "%s: interrupt flags not cleared, SR1=0x%04lx\n", b->name, (unsigned long)b->regs->SR1);
+        exit(2);
+    }
+}
+
+static void evIrqRun(void* ctx) {
+    Bus* b = (Bus*)ctx;
+    uint32_t sr1 = b->regs->SR1;
+
+    checkStorm(b);
+    if (host_nvic_call(b->evIrqn)) {
+        b->stats.evIrqs++;
+        //Handler has read SR1 and SR2
+        if (sr1 & I2C_SR1_ADDR) {
+            clearAddr(b);
+        }
+    }
+}
+
+static void erIrqRun(void* ctx) {
+    Bus* b = (Bus*)ctx;
+
+    checkStorm(b);
+    if (host_nvic_call(b->erIrqn)) {
+        b->stats.erIrqs++;
+    }
+}
+
+void stm32_i2c_stats(int bus, Stm32I2cStats* pStats) {
+    Bus* b = &buses[(bus == 2) ? 1 : 0];
+
+    *pStats = b->stats;
+    memset(&b->stats, 0, sizeof(b->stats));
+}
+
+bool stm32_i2c_busy(int bus) {
+    return mapped && ((buses[(bus == 2) ? 1 : 0].regs->SR2 & I2C_SR2_BUSY) != 0);
+}
+
+
+// STM32L1 HAL, stm32l1xx_hal.h ///////////////////////////////////////////////
+extern "C" HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c) {
+    Bus* b = busOf(hi2c->Instance);
+
+    b->hz = hi2c->Init.ClockSpeed;
+    b->regs->CR2 = 0;
+    b->regs->CR1 = I2C_CR1_PE;
+    return HAL_OK;
+}
+
+extern "C" FlagStatus host_i2c_get_flag(I2C_TypeDef* regs, uint32_t flag) {
+    uint32_t reg;
+
+    //i2c_reset() uses I2cHandle before it is initialized
+    if (regs == NULL) {
+        return RESET;
+    }
+    busOf(regs);
+    host_advance_ns(STM32_I2C_FLAG_READ_NS);
+    reg = ((flag >> 16) == 0x01) ? regs->SR1 : regs->SR2;
+    return ((reg & (flag & 0xFFFF)) == (flag & 0xFFFF)) ? SET : RESET;
+}
+
+extern "C" void host_i2c_clear_flag(I2C_TypeDef* regs, uint32_t flag) {
+    busOf(regs)->regs->SR1 &= ~(flag & 0xFFFF);
+}
+
+extern "C" void host_i2c_clear_addr(I2C_TypeDef* regs) {
+    Bus* b = busOf(regs);
+
+    clearAddr(b);
+    check(b);
+}
+
+extern "C" void host_i2c_clk_enable(I2C_TypeDef* regs) {
+    busOf(regs);
+}
+
+extern "C" void host_i2c_force_reset(I2C_TypeDef* regs) {
+    Bus* b = busOf(regs);
+
+    if (b->phase != PHASE_IDLE) {
+        error(b, "reset while bus is busy");
+    }
+    busReset(b);
+}
+
+
+// mbed HAL ///////////////////////////////////////////////////////////////////
+const PinMap PinMap_I2C_SDA[] = {
+    {PB_7,  I2C_1, 0},
+    {PB_9,  I2C_1, 0},
+    {PB_11, I2C_2, 0},
+    {NC,    NC,    0}
+};
+
+const PinMap PinMap_I2C_SCL[] = {
+    {PB_6,  I2C_1, 0},
+    {PB_8,  I2C_1, 0},
+    {PB_10, I2C_2, 0},
+    {NC,    NC,    0}
+};
+
+extern "C" uint32_t pinmap_peripheral(PinName pin, const PinMap* map) {
+    while (map->pin != NC) {
+        if (map->pin == pin) {
+            return (uint32_t)map->peripheral;
+        }
+        map++;
+    }
+    fprintf(stderr, "pinmap_peripheral(): pin not found\n");
+    exit(2);
+}
+
+extern "C" uint32_t pinmap_merge(uint32_t a, uint32_t b) {
+    if (a != b) {
+        fprintf(stderr, "pinmap_merge(): pins are on different peripherals\n");
+        exit(2);
+    }
+    return a;
+}
+
+//I2C pins are not simulated, only the model of the peripheral
+extern "C" void pinmap_pinout(PinName pin, const PinMap* map) {
+    (void)pin;
+    (void)map;
+}
+
+extern "C" void pin_mode(PinName pin, PinMode mode) {
+    (void)pin;
+    (void)mode;
+}
+
+extern "C" void mbed_assert_internal(const char* expr, const char* file, int line) {
+    fprintf(stderr, "mbed assertation failed: %s, file: %s, line %d\n", expr, file, line);
+    exit(2);
+}
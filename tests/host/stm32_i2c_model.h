@@ -0,0 +1,72 @@
+/**
+ * File:      stm32_i2c_model.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) model of the STM32L1 I2C peripheral (I2C1 and I2C2), in master transmitter mode. Is used to run the
+ * target HAL (i2c_api.c, including the interrupt driven queue of DEVICE_I2C_QUEUE) unmodified on the host. Devices
+ * attached with host_i2c_attach() are on both busses.
+ *
+ * The registers are plain memory at their target address. The model checks them for writes by the firmware each
+ * time simulated time advances, and after each interrupt handler (see host_set_register_hook()). This gives the
+ * following limitations:
+ * - A write to DR is seen because the model sets DR to STM32_I2C_DR_EMPTY after taking a byte. SB is cleared by
+ *   writing DR.
+ * - Reading SR1 and SR2 can not be seen. ADDR is cleared by __HAL_I2C_CLEAR_ADDRFLAG(), or when the event interrupt
+ *   handler returns, if it was set when the handler was called.
+ * - Only write transfers are modelled, a read address is not acknowledged. All data bytes are acknowledged, a
+ *   transfer is given to the device when its STOP or repeated START is generated.
+ * - There are no bus, arbitration lost or timeout errors.
+ *
+ * A START or STOP condition takes 1 I2C clock, a byte 9 I2C clocks. Like on the target, a START requested while a
+ * STOP is pending is generated after the STOP. Register accesses the peripheral does not allow in the current state
+ * are reported on stderr, and counted in Stm32I2cStats.errors:
+ * - DR written while no byte can be sent (no START, address not acknowledged, STOP requested or being generated).
+ * - DR written while TXE is 0, the byte in DR is overwritten.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_STM32_I2C_MODEL_H_
+#define TESTS_HOST_STM32_I2C_MODEL_H_
+
+#include <stdint.h>
+#include "host_hal.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define STM32_I2C_DR_EMPTY      0xFFFFFF00UL    //DR value after model took the byte, firmware writes 0-255
+#define STM32_I2C_FLAG_READ_NS  250             //Time __HAL_I2C_GET_FLAG() takes, about 8 cycles at 32MHz
+
+typedef struct Stm32I2cStats_ {
+    uint32_t    starts;             //START conditions generated, including repeated STARTs
+    uint32_t    startsAfterStop;    //STARTs requested while a STOP was pending
+    uint32_t    stops;              //STOP conditions generated
+    uint32_t    transfers;          //Write transfers given to a device
+    uint32_t    nacks;              //Address bytes not acknowledged
+    uint32_t    evIrqs;             //Event interrupt handler calls
+    uint32_t    erIrqs;             //Error interrupt handler calls
+    uint32_t    errors;             //Register accesses not allowed in the current state
+} Stm32I2cStats;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+
+/** Get statistics of given bus (1 or 2) since last call. Statistics are cleared. */
+void stm32_i2c_stats(int bus, Stm32I2cStats* pStats);
+
+/** Returns true if given bus (1 or 2) is busy, from the START to the end of the STOP condition */
+bool stm32_i2c_busy(int bus);
+
+#endif /* TESTS_HOST_STM32_I2C_MODEL_H_ */
@@ -0,0 +1,217 @@
+/**
+ * File:      stm32l1xx_hal.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) replacement for the parts of the STM32L1 HAL used by the firmware. All functions do nothing, and
+ * return HAL_OK. They are only required so the application compiles unmodified on the host. The exception are the
+ * I2C functions used by the target HAL (i2c_api.c), they are implemented by the I2C peripheral model in
+ * stm32_i2c_model.cpp.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_STM32L1XX_HAL_H_
+#define TESTS_HOST_STM32L1XX_HAL_H_
+
+#include <stdint.h>
+
+//Same as stm32l1xx_hal_def.h
+#ifndef __packed
+#define __packed __attribute__((__packed__))
+#endif
+
+typedef enum {
+    HAL_OK      = 0x00,
+    HAL_ERROR   = 0x01,
+    HAL_BUSY    = 0x02,
+    HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+
+// GPIO ///////////////////////////////////////////////////////////////////////
+#define GPIO_PIN_10         ((uint16_t)0x0400)
+#define GPIO_PIN_All        ((uint16_t)0xFFFF)
+#define GPIO_MODE_ANALOG    ((uint32_t)0x00000003)
+#define GPIO_NOPULL         ((uint32_t)0x00000000)
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+static inline void HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init) {
+    (void)GPIOx;
+    (void)GPIO_Init;
+}
+
+
+// Timers and power ///////////////////////////////////////////////////////////
+#define TIM_IT_CC2                  ((uint32_t)0x00000004)
+#define PWR_LOWPOWERREGULATOR_ON    PWR_CR_LPSDSR
+
+typedef struct {
+    TIM_TypeDef* Instance;
+} TIM_HandleTypeDef;
+
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __INTERRUPT__)  ((__HANDLE__)->Instance->DIER |= (__INTERRUPT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->Instance->DIER &= ~(__INTERRUPT__))
+
+static inline void SetSysClock(void) {
+}
+
+
+// Reset and clock control ////////////////////////////////////////////////////
+#define RCC_FLAG_BORRST     ((uint8_t)0x59)
+#define RCC_FLAG_PINRST     ((uint8_t)0x5A)
+#define RCC_FLAG_PORRST     ((uint8_t)0x5B)
+#define RCC_FLAG_SFTRST     ((uint8_t)0x5C)
+#define RCC_FLAG_IWDGRST    ((uint8_t)0x5D)
+#define RCC_FLAG_WWDGRST    ((uint8_t)0x5E)
+#define RCC_FLAG_LPWRRST    ((uint8_t)0x5F)
+#define PWR_FLAG_SB         ((uint32_t)0x00000002)
+
+#define __HAL_RCC_GET_FLAG(__FLAG__)    ((RCC->CSR & (1UL << ((__FLAG__) & 0x1F))) != 0)
+#define __HAL_RCC_CLEAR_RESET_FLAGS()   (RCC->CSR &= 0x00FFFFFF)
+#define __SYSCFG_CLK_ENABLE()
+#define __HAL_DBGMCU_FREEZE_WWDG()
+
+
+// Watchdogs //////////////////////////////////////////////////////////////////
+#define WWDG_PRESCALER_8    ((uint32_t)0x00000180)
+#define IWDG_PRESCALER_32   ((uint8_t)0x03)
+#define IWDG_PRESCALER_256  ((uint8_t)0x06)
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t Window;
+    uint32_t Counter;
+} WWDG_InitTypeDef;
+
+typedef struct {
+    WWDG_TypeDef*       Instance;
+    WWDG_InitTypeDef    Init;
+} WWDG_HandleTypeDef;
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t Reload;
+} IWDG_InitTypeDef;
+
+typedef struct {
+    IWDG_TypeDef*       Instance;
+    IWDG_InitTypeDef    Init;
+} IWDG_HandleTypeDef;
+
+static inline HAL_StatusTypeDef HAL_WWDG_Init(WWDG_HandleTypeDef* hwwdg) {
+    (void)hwwdg;
+    return HAL_OK;
+}
+
+static inline HAL_StatusTypeDef HAL_WWDG_Start(WWDG_HandleTypeDef* hwwdg) {
+    (void)hwwdg;
+    return HAL_OK;
+}
+
+static inline HAL_StatusTypeDef HAL_WWDG_Refresh(WWDG_HandleTypeDef* hwwdg, uint32_t counter) {
+    (void)hwwdg;
+    (void)counter;
+    return HAL_OK;
+}
+
+static inline HAL_StatusTypeDef HAL_IWDG_Init(IWDG_HandleTypeDef* hiwdg) {
+    (void)hiwdg;
+    return HAL_OK;
+}
+
+static inline HAL_StatusTypeDef HAL_IWDG_Start(IWDG_HandleTypeDef* hiwdg) {
+    (void)hiwdg;
+    return HAL_OK;
+}
+
+static inline HAL_StatusTypeDef HAL_IWDG_Refresh(IWDG_HandleTypeDef* hiwdg) {
+    (void)hiwdg;
+    return HAL_OK;
+}
+
+
+// I2C ////////////////////////////////////////////////////////////////////////
+// Flags have the register in the upper 16 bits, same as stm32l1xx_hal_i2c.h
+#define I2C_FLAG_SB                 ((uint32_t)0x00010001)
+#define I2C_FLAG_ADDR               ((uint32_t)0x00010002)
+#define I2C_FLAG_BTF                ((uint32_t)0x00010004)
+#define I2C_FLAG_RXNE               ((uint32_t)0x00010040)
+#define I2C_FLAG_TXE                ((uint32_t)0x00010080)
+#define I2C_FLAG_AF                 ((uint32_t)0x00010400)
+#define I2C_FLAG_MSL                ((uint32_t)0x00100001)
+#define I2C_FLAG_BUSY               ((uint32_t)0x00100002)
+#define I2C_FLAG_TRA                ((uint32_t)0x00100004)
+
+#define I2C_ADDRESSINGMODE_7BIT     ((uint32_t)0x00004000)
+#define I2C_DUALADDRESS_DISABLED    ((uint32_t)0x00000000)
+#define I2C_DUTYCYCLE_2             ((uint32_t)0x00000000)
+#define I2C_GENERALCALL_DISABLED    ((uint32_t)0x00000000)
+#define I2C_NOSTRETCH_DISABLED      ((uint32_t)0x00000000)
+
+#define I2C_7BIT_ADD_WRITE(__ADDRESS__)     ((uint8_t)((__ADDRESS__) & (~I2C_OAR1_ADD0)))
+#define I2C_7BIT_ADD_READ(__ADDRESS__)      ((uint8_t)((__ADDRESS__) | I2C_OAR1_ADD0))
+
+typedef struct {
+    uint32_t ClockSpeed;
+    uint32_t DutyCycle;
+    uint32_t OwnAddress1;
+    uint32_t AddressingMode;
+    uint32_t DualAddressMode;
+    uint32_t OwnAddress2;
+    uint32_t GeneralCallMode;
+    uint32_t NoStretchMode;
+} I2C_InitTypeDef;
+
+typedef struct {
+    I2C_TypeDef*        Instance;
+    I2C_InitTypeDef     Init;
+} I2C_HandleTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//Implemented in stm32_i2c_model.cpp
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c);
+FlagStatus  host_i2c_get_flag(I2C_TypeDef* regs, uint32_t flag);
+void        host_i2c_clear_flag(I2C_TypeDef* regs, uint32_t flag);
+void        host_i2c_clear_addr(I2C_TypeDef* regs);
+void        host_i2c_clk_enable(I2C_TypeDef* regs);
+void        host_i2c_force_reset(I2C_TypeDef* regs);
+
+#ifdef __cplusplus
+}
+#endif
+
+//Flags are only changed by the model when simulated time advances, reading one takes time like on the target. The
+//status registers are plain memory on the host, writing ~flag (like the HAL does) would set all other flags.
+#define __HAL_I2C_GET_FLAG(__HANDLE__, __FLAG__)    host_i2c_get_flag((__HANDLE__)->Instance, (__FLAG__))
+#define __HAL_I2C_CLEAR_FLAG(__HANDLE__, __FLAG__)  host_i2c_clear_flag((__HANDLE__)->Instance, (__FLAG__))
+#define __HAL_I2C_CLEAR_ADDRFLAG(__HANDLE__)        host_i2c_clear_addr((__HANDLE__)->Instance)
+#define __I2C1_CLK_ENABLE()         host_i2c_clk_enable(I2C1)
+#define __I2C2_CLK_ENABLE()         host_i2c_clk_enable(I2C2)
+#define __I2C1_FORCE_RESET()        host_i2c_force_reset(I2C1)
+#define __I2C2_FORCE_RESET()        host_i2c_force_reset(I2C2)
+#define __I2C1_RELEASE_RESET()
+#define __I2C2_RELEASE_RESET()
+
+#endif /* TESTS_HOST_STM32L1XX_HAL_H_ */
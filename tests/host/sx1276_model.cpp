@@ -0,0 +1,638 @@
+/**
+ * File:      sx1276_model.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Behavioural model of the Semtech SX1276 LoRa transceiver, see sx1276_model.h for details.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sx1276Regs-Fsk.h"
+#include "sx1276Regs-LoRa.h"
+#include "sx1276_model.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define MODE_SLEEP      RFLR_OPMODE_SLEEP
+#define MODE_STANDBY    RFLR_OPMODE_STANDBY
+#define MODE_TX         RFLR_OPMODE_TRANSMITTER
+#define MODE_RXCONT     RFLR_OPMODE_RECEIVER
+#define MODE_RXSINGLE   RFLR_OPMODE_RECEIVER_SINGLE
+#define MODE_CAD        RFLR_OPMODE_CAD
+
+#define PKT_SNR         40      //Value of RegPktSnrValue for received packets, 10dB
+#define PKT_RSSI        80      //Value of RegPktRssiValue for received packets, -77dBm in HF band
+
+//LoRa bandwidths for RegModemConfig1 bits 7-4
+static const uint32_t loraBandwidths[10] = {
+    7810, 10420, 15630, 20830, 31250, 41670, 62500, 125000, 250000, 500000
+};
+
+
+// Sx1276Air //////////////////////////////////////////////////////////////////
+Sx1276Air::Sx1276Air() : count(0), tx(NULL), rxCount(0), txStartNs(0), txEndNs(0), hopPeriodNs(0), hopIndex(0) {
+    host_event_init(&evtHop, &Sx1276Air::hopEvent, this, false);
+    host_event_init(&evtEnd, &Sx1276Air::endEvent, this, false);
+}
+
+void Sx1276Air::startTx(Sx1276Model* txModel) {
+    uint8_t i;
+
+    //Only a single transmission at a time is received, a second one collides with it and is lost
+    if (tx != NULL) {
+        for (i = 0; i < rxCount; i++) {
+            rxHopOk[i] = false;
+        }
+        return;
+    }
+
+    tx = txModel;
+    txStartNs = host_time_ns();
+    txEndNs = txStartNs + tx->airtimeNs(tx->txLen);
+    rxCount = 0;
+    for (i = 0; i < count; i++) {
+        if ((radios[i] != tx) && radios[i]->rxStart(tx)) {
+            rxHopOk[rxCount] = true;
+            rx[rxCount++] = radios[i];
+        }
+    }
+
+    tx->hopCount = 0;
+    hopIndex = 0;
+    hopPeriodNs = (uint64_t)tx->pageLora[REG_LR_HOPPERIOD] * tx->symbolNs();
+    if (hopPeriodNs != 0) {
+        hop();  //First hop period starts now
+    }
+    host_event_schedule(&evtEnd, txEndNs);
+}
+
+void Sx1276Air::abortTx(Sx1276Model* txModel) {
+    uint8_t i;
+
+    if (tx != txModel) {
+        return;
+    }
+    host_event_cancel(&evtHop);
+    host_event_cancel(&evtEnd);
+    for (i = 0; i < rxCount; i++) {
+        rx[i]->rxLocked = false;
+    }
+    rxCount = 0;
+    tx = NULL;
+}
+
+void Sx1276Air::hopEvent(void* ctx) {
+    ((Sx1276Air*)ctx)->hop();
+}
+
+void Sx1276Air::endEvent(void* ctx) {
+    ((Sx1276Air*)ctx)->end();
+}
+
+void Sx1276Air::hop() {
+    uint64_t now = host_time_ns();
+    uint32_t frfTx = tx->getFrf();
+    uint8_t i;
+
+    //Sample frequency of all radios for this hop period, and tell them to program the next one
+    tx->addHop(hopIndex, now, frfTx);
+    for (i = 0; i < rxCount; i++) {
+        if (rx[i]->pageLora[REG_LR_HOPPERIOD] != tx->pageLora[REG_LR_HOPPERIOD]) {
+            rxHopOk[i] = false;
+            continue;
+        }
+        rx[i]->addHop(hopIndex, now, rx[i]->getFrf());
+        if (rx[i]->getFrf() != frfTx) {
+            rxHopOk[i] = false;
+        }
+    }
+
+    hopIndex++;
+    tx->fhssChangeChannel(hopIndex);
+    for (i = 0; i < rxCount; i++) {
+        if (rx[i]->pageLora[REG_LR_HOPPERIOD] == tx->pageLora[REG_LR_HOPPERIOD]) {
+            rx[i]->fhssChangeChannel(hopIndex);
+        }
+    }
+
+    if ((txStartNs + (hopIndex * hopPeriodNs)) < txEndNs) {
+        host_event_schedule(&evtHop, txStartNs + (hopIndex * hopPeriodNs));
+    }
+}
+
+void Sx1276Air::end() {
+    Sx1276Model* txModel = tx;
+    uint8_t i;
+
+    tx = NULL;
+    host_event_cancel(&evtHop);
+    for (i = 0; i < rxCount; i++) {
+        rx[i]->rxEnd(txModel, rxHopOk[i]);
+    }
+    rxCount = 0;
+}
+
+
+// Sx1276Model ////////////////////////////////////////////////////////////////
+Sx1276Model::Sx1276Model(Sx1276Air* air, PinName nss, PinName reset, PinName dio0, PinName dio1, PinName dio2,
+        PinName dio3)
+    : imageCalCount(0), resetCount(0), txCount(0), rxCount(0), rxCrcErrCount(0), spiErrCount(0),
+      air(air), pinNss(nss), pinReset(reset), inReset(false), readyNs(0), selected(false), addrPhase(false),
+      writeAccess(false), addr(0), temperature(25), rssiSeed(0x12345678), frfWriteNs(0), hopCount(0)
+{
+    pinDio[0] = dio0;
+    pinDio[1] = dio1;
+    pinDio[2] = dio2;
+    pinDio[3] = dio3;
+
+    if (air->count >= SX1276_AIR_MAX_RADIOS) {
+        fprintf(stderr, "Sx1276Model: too many radios\n");
+        exit(2);
+    }
+    air->radios[air->count++] = this;
+
+    host_event_init(&evtMode, &Sx1276Model::modeEvent, this, false);
+    host_event_init(&evtCal, &Sx1276Model::calEvent, this, false);
+    host_event_init(&evtTxStart, &Sx1276Model::txStartEvent, this, false);
+    host_spi_attach(this, nss);
+    host_pin_on_change(nss, &Sx1276Model::nssChanged, this);
+    host_pin_on_change(reset, &Sx1276Model::resetChanged, this);
+
+    powerOnReset();
+
+    //NRESET has an internal pull-up
+    host_pin_drive(reset, 1);
+}
+
+void Sx1276Model::powerOnReset(void) {
+    air->abortTx(this);
+    host_event_cancel(&evtMode);
+    host_event_cancel(&evtCal);
+    host_event_cancel(&evtTxStart);
+
+    memset(common, 0, sizeof(common));
+    memset(pageFsk, 0, sizeof(pageFsk));
+    memset(pageLora, 0, sizeof(pageLora));
+    memset(fifo, 0, sizeof(fifo));
+
+    common[REG_OPMODE]      = 0x09;     //FSK, LF registers, standby
+    common[REG_FRFMSB]      = 0x6C;     //434MHz
+    common[REG_FRFMID]      = 0x80;
+    common[REG_FRFLSB]      = 0x00;
+    common[REG_PACONFIG]    = 0x4F;
+    common[REG_PARAMP]      = 0x09;
+    common[REG_OCP]         = 0x2B;
+    common[REG_LNA]         = 0x20;
+    common[REG_DIOMAPPING2] = 0x00;
+    common[REG_VERSION]     = 0x12;
+    common[REG_LR_PLLHOP]   = 0x2D;
+    common[REG_TCXO]        = 0x09;
+    common[REG_PADAC]       = 0x84;
+    common[REG_AGCREF]      = 0x13;
+    common[REG_AGCTHRESH1]  = 0x0E;
+    common[REG_AGCTHRESH2]  = 0x5B;
+    common[REG_AGCTHRESH3]  = 0xDB;
+    common[REG_PLL]         = 0xD0;
+
+    pageFsk[REG_RXCONFIG]   = 0x0E;
+    pageFsk[REG_RSSICONFIG] = 0x02;
+    pageFsk[REG_IMAGECAL]   = 0x82;
+
+    pageLora[REG_LR_FIFOTXBASEADDR]     = 0x80;
+    pageLora[REG_LR_MODEMCONFIG1]       = 0x72;
+    pageLora[REG_LR_MODEMCONFIG2]       = 0x70;
+    pageLora[REG_LR_SYMBTIMEOUTLSB]     = 0x64;
+    pageLora[REG_LR_PREAMBLELSB]        = 0x08;
+    pageLora[REG_LR_PAYLOADLENGTH]      = 0x01;
+    pageLora[REG_LR_PAYLOADMAXLENGTH]   = 0xFF;
+    pageLora[REG_LR_MODEMCONFIG3]       = 0x04;
+    pageLora[REG_LR_DETECTOPTIMIZE]     = 0xC3;
+    pageLora[REG_LR_INVERTIQ]           = 0x27;
+    pageLora[REG_LR_DETECTIONTHRESHOLD] = 0x0A;
+    pageLora[REG_LR_SYNCWORD]           = 0x12;
+
+    mode = MODE_STANDBY;
+    rxLocked = false;
+    txLen = 0;
+    hopCount = 0;
+    updateDio();
+}
+
+void Sx1276Model::nssChanged(void* ctx, PinName pin, int level) {
+    Sx1276Model* self = (Sx1276Model*)ctx;
+    (void)pin;
+
+    //Falling edge of NSS starts a new SPI access, first byte is address
+    self->selected = (level == 0);
+    self->addrPhase = (level == 0);
+}
+
+void Sx1276Model::resetChanged(void* ctx, PinName pin, int level) {
+    Sx1276Model* self = (Sx1276Model*)ctx;
+    uint8_t i;
+    (void)pin;
+
+    if (level == 0) {
+        //Chip held in reset. Stop everything, DIO outputs are high impedance (pulled down by MCU)
+        self->inReset = true;
+        self->air->abortTx(self);
+        host_event_cancel(&self->evtMode);
+        host_event_cancel(&self->evtCal);
+        host_event_cancel(&self->evtTxStart);
+        for (i = 0; i < 4; i++) {
+            host_pin_drive(self->pinDio[i], -1);
+        }
+    }
+    else if (self->inReset) {
+        self->inReset = false;
+        self->readyNs = host_time_ns() + SX1276_RESET_READY_NS;
+        self->resetCount++;
+        self->powerOnReset();
+    }
+}
+
+uint8_t Sx1276Model::spiTransfer(uint8_t mosi) {
+    uint8_t ret = 0;
+
+    if (inReset || (host_time_ns() < readyNs)) {
+        spiErrCount++;
+        return 0;
+    }
+
+    if (addrPhase) {
+        addr = mosi & 0x7F;
+        writeAccess = (mosi & 0x80) != 0;
+        addrPhase = false;
+        return 0;
+    }
+
+    if (writeAccess) {
+        writeReg(addr, mosi);
+    }
+    else {
+        ret = readReg(addr);
+    }
+
+    //Burst access auto increments address, except for FIFO
+    if (addr != REG_LR_FIFO) {
+        addr = (addr + 1) & 0x7F;
+    }
+    return ret;
+}
+
+uint8_t* Sx1276Model::regPtr(uint8_t a) {
+    if ((a >= PAGE_START) && (a <= PAGE_END)) {
+        return loraPage() ? &pageLora[a] : &pageFsk[a];
+    }
+    return &common[a];
+}
+
+uint8_t Sx1276Model::peek(uint8_t a) {
+    if (loraPage() && ((a == REG_LR_RSSIVALUE) || (a == REG_LR_RSSIWIDEBAND))) {
+        return (uint8_t)(rssiSeed >> 24);
+    }
+    if (!loraPage() && (a == REG_TEMP)) {
+        return (uint8_t)(-temperature);
+    }
+    return *regPtr(a);
+}
+
+uint8_t Sx1276Model::readReg(uint8_t a) {
+    if (a == REG_LR_FIFO) {
+        //Only LoRa FIFO is modelled
+        if (!isLoRa() || (mode == MODE_SLEEP)) {
+            return 0;
+        }
+        return fifo[pageLora[REG_LR_FIFOADDRPTR]++];
+    }
+
+    //Noise for RSSI reads, is used by InAir::Random()
+    if (loraPage() && ((a == REG_LR_RSSIVALUE) || (a == REG_LR_RSSIWIDEBAND))) {
+        rssiSeed ^= rssiSeed << 13;
+        rssiSeed ^= rssiSeed >> 17;
+        rssiSeed ^= rssiSeed << 5;
+    }
+    return peek(a);
+}
+
+void Sx1276Model::writeReg(uint8_t a, uint8_t value) {
+    uint8_t newMode;
+
+    switch (a) {
+    case REG_LR_FIFO:
+        if (isLoRa() && (mode != MODE_SLEEP)) {
+            fifo[pageLora[REG_LR_FIFOADDRPTR]++] = value;
+        }
+        return;
+    case REG_OPMODE:
+        //LongRangeMode can only be changed in sleep mode
+        if (mode != MODE_SLEEP) {
+            value = (value & 0x7F) | (common[REG_OPMODE] & 0x80);
+        }
+        common[REG_OPMODE] = value;
+        newMode = value & ~RFLR_OPMODE_MASK;
+        if (newMode != mode) {
+            setMode(newMode);
+        }
+        updateDio();
+        return;
+    case REG_FRFLSB:
+        common[a] = value;
+        frfWriteNs = host_time_ns();
+        return;
+    case REG_DIOMAPPING1:
+    case REG_DIOMAPPING2:
+        common[a] = value;
+        updateDio();
+        return;
+    case REG_VERSION:
+        return;     //Read only
+    }
+
+    if ((a >= PAGE_START) && (a <= PAGE_END)) {
+        if (loraPage()) {
+            switch (a) {
+            case REG_LR_IRQFLAGS:
+                pageLora[a] &= ~value;  //Write 1 to clear
+                updateDio();
+                return;
+            case REG_LR_FIFORXCURRENTADDR:
+            case REG_LR_RXNBBYTES:
+            case REG_LR_RXHEADERCNTVALUEMSB:
+            case REG_LR_RXHEADERCNTVALUELSB:
+            case REG_LR_RXPACKETCNTVALUEMSB:
+            case REG_LR_RXPACKETCNTVALUELSB:
+            case REG_LR_MODEMSTAT:
+            case REG_LR_PKTSNRVALUE:
+            case REG_LR_PKTRSSIVALUE:
+            case REG_LR_RSSIVALUE:
+            case REG_LR_HOPCHANNEL:
+            case REG_LR_FIFORXBYTEADDR:
+            case REG_LR_RSSIWIDEBAND:
+                return;     //Read only
+            }
+        }
+        else {
+            switch (a) {
+            case REG_IMAGECAL:
+                //Bit 5 (ImageCalRunning) is read only. Writing 1 to bit 6 starts a calibration, is cleared again.
+                pageFsk[a] = (pageFsk[a] & RF_IMAGECAL_IMAGECAL_RUNNING)
+                        | (value & ~(RF_IMAGECAL_IMAGECAL_RUNNING | RF_IMAGECAL_IMAGECAL_START));
+                if (((value & RF_IMAGECAL_IMAGECAL_START) != 0) && !isLoRa()) {
+                    pageFsk[a] |= RF_IMAGECAL_IMAGECAL_RUNNING;
+                    imageCalCount++;
+                    host_event_schedule(&evtCal, host_time_ns() + SX1276_IMAGECAL_NS);
+                }
+                return;
+            case REG_TEMP:
+                return;     //Read only
+            }
+        }
+    }
+
+    *regPtr(a) = value;
+}
+
+void Sx1276Model::setMode(uint8_t newMode) {
+    uint8_t oldMode = mode;
+    uint16_t symbTimeout;
+    uint16_t i;
+
+    host_event_cancel(&evtMode);
+    host_event_cancel(&evtTxStart);
+    air->abortTx(this);
+    rxLocked = false;
+    mode = newMode;
+
+    if (!isLoRa()) {
+        return;     //FSK modem is not modelled
+    }
+
+    switch (mode) {
+    case MODE_SLEEP:
+        memset(fifo, 0, sizeof(fifo));  //FIFO is cleared in sleep mode
+        break;
+    case MODE_TX:
+        txLen = pageLora[REG_LR_PAYLOADLENGTH];
+        for (i = 0; i < txLen; i++) {
+            txPayload[i] = fifo[(uint8_t)(pageLora[REG_LR_FIFOTXBASEADDR] + i)];
+        }
+        host_event_schedule(&evtTxStart, host_time_ns() + SX1276_TX_STARTUP_NS);
+        break;
+    case MODE_RXCONT:
+    case MODE_RXSINGLE:
+        if ((oldMode != MODE_RXCONT) && (oldMode != MODE_RXSINGLE)) {
+            pageLora[REG_LR_FIFORXBYTEADDR] = pageLora[REG_LR_FIFORXBASEADDR];
+        }
+        if (mode == MODE_RXSINGLE) {
+            symbTimeout = ((uint16_t)(pageLora[REG_LR_MODEMCONFIG2] & 0x03) << 8) | pageLora[REG_LR_SYMBTIMEOUTLSB];
+            host_event_schedule(&evtMode, host_time_ns() + (symbTimeout * symbolNs()));
+        }
+        break;
+    case MODE_CAD:
+        host_event_schedule(&evtMode, host_time_ns() + symbolNs());
+        break;
+    }
+}
+
+/** Go to standby mode after TX, RX single or CAD is done */
+void Sx1276Model::modeEvent(void* ctx) {
+    Sx1276Model* self = (Sx1276Model*)ctx;
+    uint8_t flags = 0;
+
+    switch (self->mode) {
+    case MODE_TX:
+        flags = RFLR_IRQFLAGS_TXDONE;
+        break;
+    case MODE_RXSINGLE:
+        flags = RFLR_IRQFLAGS_RXTIMEOUT;
+        break;
+    case MODE_CAD:
+        flags = RFLR_IRQFLAGS_CADDONE;
+        if ((self->air->tx != NULL) && (self->air->tx->getFrf() == self->getFrf())
+                && (self->air->tx->getSf() == self->getSf()) && (self->air->tx->getBwHz() == self->getBwHz())) {
+            flags |= RFLR_IRQFLAGS_CADDETECTED;
+        }
+        break;
+    }
+
+    self->mode = MODE_STANDBY;
+    self->common[REG_OPMODE] = (self->common[REG_OPMODE] & RFLR_OPMODE_MASK) | MODE_STANDBY;
+    self->setIrq(flags);
+}
+
+/** TX startup done, packet goes on air */
+void Sx1276Model::txStartEvent(void* ctx) {
+    Sx1276Model* self = (Sx1276Model*)ctx;
+
+    self->txCount++;
+    host_event_schedule(&self->evtMode, host_time_ns() + self->airtimeNs(self->txLen));
+    self->air->startTx(self);
+}
+
+void Sx1276Model::calEvent(void* ctx) {
+    ((Sx1276Model*)ctx)->pageFsk[REG_IMAGECAL] &= ~RF_IMAGECAL_IMAGECAL_RUNNING;
+}
+
+void Sx1276Model::setIrq(uint8_t flags) {
+    pageLora[REG_LR_IRQFLAGS] |= flags & ~pageLora[REG_LR_IRQFLAGSMASK];
+    updateDio();
+}
+
+void Sx1276Model::updateDio(void) {
+    uint8_t flags = pageLora[REG_LR_IRQFLAGS];
+    uint8_t map = common[REG_DIOMAPPING1];
+    uint8_t dio[4] = {0, 0, 0, 0};
+    uint8_t i;
+
+    if (inReset) {
+        return;
+    }
+
+    if (isLoRa()) {
+        switch ((map >> 6) & 0x03) {
+        case 0: dio[0] = flags & RFLR_IRQFLAGS_RXDONE; break;
+        case 1: dio[0] = flags & RFLR_IRQFLAGS_TXDONE; break;
+        case 2: dio[0] = flags & RFLR_IRQFLAGS_CADDONE; break;
+        }
+        switch ((map >> 4) & 0x03) {
+        case 0: dio[1] = flags & RFLR_IRQFLAGS_RXTIMEOUT; break;
+        case 1: dio[1] = flags & RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL; break;
+        case 2: dio[1] = flags & RFLR_IRQFLAGS_CADDETECTED; break;
+        }
+        if (((map >> 2) & 0x03) != 3) {
+            dio[2] = flags & RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL;
+        }
+        switch (map & 0x03) {
+        case 0: dio[3] = flags & RFLR_IRQFLAGS_CADDONE; break;
+        case 1: dio[3] = flags & RFLR_IRQFLAGS_VALIDHEADER; break;
+        case 2: dio[3] = flags & RFLR_IRQFLAGS_PAYLOADCRCERROR; break;
+        }
+    }
+
+    for (i = 0; i < 4; i++) {
+        host_pin_drive(pinDio[i], (dio[i] != 0) ? 1 : 0);
+    }
+}
+
+uint8_t Sx1276Model::getSf(void) {
+    uint8_t sf = pageLora[REG_LR_MODEMCONFIG2] >> 4;
+
+    if (sf < 6) {
+        return 6;
+    }
+    return (sf > 12) ? 12 : sf;
+}
+
+uint32_t Sx1276Model::getBwHz(void) {
+    uint8_t i = pageLora[REG_LR_MODEMCONFIG1] >> 4;
+
+    return loraBandwidths[(i > 9) ? 9 : i];
+}
+
+uint64_t Sx1276Model::symbolNs(void) {
+    return (uint64_t)llround(((double)(1UL << getSf()) * 1e9) / (double)getBwHz());
+}
+
+uint64_t Sx1276Model::airtimeNs(uint8_t payloadLen) {
+    double tSym = ((double)(1UL << getSf()) * 1e9) / (double)getBwHz();
+    int sf = getSf();
+    int cr = (pageLora[REG_LR_MODEMCONFIG1] >> 1) & 0x07;
+    int ih = pageLora[REG_LR_MODEMCONFIG1] & 0x01;
+    int crc = (pageLora[REG_LR_MODEMCONFIG2] >> 2) & 0x01;
+    int de = (pageLora[REG_LR_MODEMCONFIG3] >> 3) & 0x01;
+    int preamble = ((int)pageLora[REG_LR_PREAMBLEMSB] << 8) | pageLora[REG_LR_PREAMBLELSB];
+    double payloadSymb;
+
+    payloadSymb = ceil((double)((8 * payloadLen) - (4 * sf) + 28 + (16 * crc) - (20 * ih)) / (double)(4 * (sf - (2 * de))));
+    if (payloadSymb < 0) {
+        payloadSymb = 0;
+    }
+    payloadSymb = 8 + (payloadSymb * (cr + 4));
+
+    return (uint64_t)llround(((preamble + 4.25) + payloadSymb) * tSym);
+}
+
+void Sx1276Model::addHop(uint32_t index, uint64_t startNs, uint32_t frf) {
+    if (index < SX1276_MAX_HOPS) {
+        hops[index].startNs = startNs;
+        hops[index].frf = frf;
+        hops[index].frfWriteNs = frfWriteNs;
+        hopCount = index + 1;
+    }
+}
+
+void Sx1276Model::fhssChangeChannel(uint32_t channel) {
+    pageLora[REG_LR_HOPCHANNEL] = (pageLora[REG_LR_HOPCHANNEL] & ~RFLR_HOPCHANNEL_CHANNEL_MASK)
+            | (channel & RFLR_HOPCHANNEL_CHANNEL_MASK);
+    setIrq(RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL);
+}
+
+bool Sx1276Model::rxStart(Sx1276Model* txModel) {
+    if (inReset || !isLoRa() || ((mode != MODE_RXCONT) && (mode != MODE_RXSINGLE)) || rxLocked) {
+        return false;
+    }
+    if ((getFrf() != txModel->getFrf()) || (getSf() != txModel->getSf()) || (getBwHz() != txModel->getBwHz())
+            || (pageLora[REG_LR_SYNCWORD] != txModel->pageLora[REG_LR_SYNCWORD])) {
+        return false;
+    }
+
+    //Preamble detected, RX single timeout is stopped
+    host_event_cancel(&evtMode);
+    rxLocked = true;
+    hopCount = 0;
+    return true;
+}
+
+void Sx1276Model::rxEnd(Sx1276Model* txModel, bool hopOk) {
+    uint8_t start = pageLora[REG_LR_FIFORXBYTEADDR];
+    uint8_t flags = RFLR_IRQFLAGS_VALIDHEADER | RFLR_IRQFLAGS_RXDONE;
+    uint16_t i;
+
+    if (!rxLocked) {
+        return;
+    }
+    rxLocked = false;
+
+    //Payload is written to FIFO after previous packet
+    for (i = 0; i < txModel->txLen; i++) {
+        fifo[(uint8_t)(start + i)] = hopOk ? txModel->txPayload[i] : (uint8_t)~txModel->txPayload[i];
+    }
+    pageLora[REG_LR_FIFORXCURRENTADDR] = start;
+    pageLora[REG_LR_FIFORXBYTEADDR] = (uint8_t)(start + txModel->txLen);
+    pageLora[REG_LR_RXNBBYTES] = txModel->txLen;
+    pageLora[REG_LR_PKTSNRVALUE] = PKT_SNR;
+    pageLora[REG_LR_PKTRSSIVALUE] = PKT_RSSI;
+
+    if (hopOk) {
+        rxCount++;
+    }
+    else {
+        rxCrcErrCount++;
+        if ((txModel->pageLora[REG_LR_MODEMCONFIG2] & RFLR_MODEMCONFIG2_RXPAYLOADCRC_ON) != 0) {
+            flags |= RFLR_IRQFLAGS_PAYLOADCRCERROR;
+        }
+    }
+
+    if (mode == MODE_RXSINGLE) {
+        mode = MODE_STANDBY;
+        common[REG_OPMODE] = (common[REG_OPMODE] & RFLR_OPMODE_MASK) | MODE_STANDBY;
+    }
+    setIrq(flags);
+}
@@ -0,0 +1,215 @@
+/**
+ * File:      sx1276_model.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Behavioural model of the Semtech SX1276 LoRa transceiver (inAir4, inAir9 and inAir9B modules), for host tests.
+ * Is attached to the simulated SPI bus and pins of host_hal.h, and is used by the unmodified InAir driver.
+ *
+ * Modelled:
+ * - Register file, with separate FSK and LoRa pages for registers 0x0D to 0x3F, and reset values.
+ * - 256 byte FIFO accessed via RegFifoAddrPtr, with Tx and Rx base addresses.
+ * - LoRa TX and RX with the airtime given by the Semtech formula, after a TX startup time. All models attached to the same Sx1276Air
+ *   receive each others packets if frequency, spreading factor, bandwidth and sync word match.
+ * - IRQ flags, IRQ mask and DIO0 to DIO3 mapping, the DIO pins are driven with the mapped IRQ flag.
+ * - RX single timeout, CAD, image calibration (RegImageCal), temperature (RegTemp) and the reset pin. The chip
+ *   can only be accessed SX1276_RESET_READY_NS after the reset pin was released.
+ * - Intra-packet frequency hopping (FHSS). At the start of each hop period k (k = 0, 1, ...) the FRF register is
+ *   sampled as the frequency used for period k, FhssPresentChannel is set to k+1, and FhssChangeChannel is
+ *   raised. The firmware has until the start of the next period to program its frequency. A receiver only gets
+ *   the packet if it used the same frequency as the transmitter in every period, else it gets a CRC error.
+ *
+ * Not modelled: FSK packet mode, RF power and noise (received packets always have the same RSSI and SNR).
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_SX1276_MODEL_H_
+#define TESTS_HOST_SX1276_MODEL_H_
+
+#include <stdint.h>
+#include "host_hal.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define SX1276_AIR_MAX_RADIOS   4
+#define SX1276_MAX_HOPS         256     //Maximum hop periods recorded per packet
+#define SX1276_IMAGECAL_NS      10000000ULL //Image calibration takes 10ms
+#define SX1276_TX_STARTUP_NS    60000ULL    //Time from setting TX mode until the preamble starts (PLL lock, PA ramp)
+#define SX1276_RESET_READY_NS   5000000ULL  //Time from end of reset until chip can be accessed
+
+class Sx1276Model;
+
+/** Record of a single hop period */
+typedef struct Sx1276Hop_ {
+    uint64_t    startNs;        //Start of hop period, FhssChangeChannel was raised at this time
+    uint32_t    frf;            //FRF register value used during this hop period
+    uint64_t    frfWriteNs;     //Time RegFrfLsb was last written before this hop period started
+} Sx1276Hop;
+
+/** Radio channel shared by all attached models */
+class Sx1276Air {
+public:
+    Sx1276Air();
+
+    /** Called by model when it starts transmitting */
+    void startTx(Sx1276Model* tx);
+
+    /** Called by model when it stops transmitting before the end of the packet (mode change or reset) */
+    void abortTx(Sx1276Model* tx);
+
+protected:
+    friend class Sx1276Model;
+
+    /** Hop period event of the current transmission */
+    static void hopEvent(void* ctx);
+
+    /** End of current transmission */
+    static void endEvent(void* ctx);
+
+    void hop();
+    void end();
+
+    Sx1276Model*    radios[SX1276_AIR_MAX_RADIOS];
+    uint8_t         count;
+
+    Sx1276Model*    tx;                             //Current transmitter, NULL if none
+    Sx1276Model*    rx[SX1276_AIR_MAX_RADIOS];      //Receivers locked on current transmission
+    bool            rxHopOk[SX1276_AIR_MAX_RADIOS]; //Cleared if receiver was on a different frequency
+    uint8_t         rxCount;
+    uint64_t        txStartNs;
+    uint64_t        txEndNs;
+    uint64_t        hopPeriodNs;                    //0 if not hopping
+    uint32_t        hopIndex;                       //Index of next hop period
+    HostEvent       evtHop;
+    HostEvent       evtEnd;
+};
+
+class Sx1276Model : public HostSpiDevice {
+public:
+    /** Create a model attached to given air, with given MCU pins.
+     */
+    Sx1276Model(Sx1276Air* air, PinName nss, PinName reset, PinName dio0, PinName dio1, PinName dio2,
+            PinName dio3);
+
+    virtual uint8_t spiTransfer(uint8_t mosi);
+
+    /** Read register as the MCU would see it, without side effects */
+    uint8_t peek(uint8_t addr);
+
+    /** Returns current RegFrf value */
+    uint32_t getFrf(void) {
+        return ((uint32_t)common[FRF_MSB] << 16) | ((uint32_t)common[FRF_MSB + 1] << 8) | common[FRF_MSB + 2];
+    }
+
+    /** LoRa symbol time of current configuration, in nano seconds */
+    uint64_t symbolNs(void);
+
+    /** Time on air of a LoRa packet with given payload length, for current configuration, in nano seconds */
+    uint64_t airtimeNs(uint8_t payloadLen);
+
+    /** Set value returned by temperature sensor, in degrees Celsius */
+    void setTemperature(int8_t temp) {
+        temperature = temp;
+    }
+
+    /** Hop periods of last packet sent or received. Count is 0 if it was not sent with frequency hopping. */
+    const Sx1276Hop* getHops(void) {
+        return hops;
+    }
+    uint16_t getHopCount(void) {
+        return hopCount;
+    }
+
+    uint32_t    imageCalCount;  //Number of image calibrations done
+    uint32_t    resetCount;     //Number of times chip was reset with reset pin
+    uint32_t    txCount;        //Number of packets sent
+    uint32_t    rxCount;        //Number of packets received OK
+    uint32_t    rxCrcErrCount;  //Number of packets received with CRC error
+    uint32_t    spiErrCount;    //Number of SPI accesses while chip was held in reset, or not ready after reset
+
+protected:
+    friend class Sx1276Air;
+
+    enum {
+        FRF_MSB     = 0x06,     //RegFrfMsb
+        PAGE_START  = 0x0D,     //First register of FSK/LoRa page
+        PAGE_END    = 0x3F      //Last register of FSK/LoRa page
+    };
+
+    static void nssChanged(void* ctx, PinName pin, int level);
+    static void resetChanged(void* ctx, PinName pin, int level);
+    static void modeEvent(void* ctx);
+    static void txStartEvent(void* ctx);
+    static void calEvent(void* ctx);
+
+    void powerOnReset(void);
+    bool isLoRa(void) {
+        return (common[0x01] & 0x80) != 0;
+    }
+    bool loraPage(void) {
+        return (common[0x01] & 0xC0) == 0x80;   //LongRangeMode, and AccessSharedReg not set
+    }
+    uint8_t* regPtr(uint8_t addr);
+    uint8_t readReg(uint8_t addr);
+    void writeReg(uint8_t addr, uint8_t value);
+    void setMode(uint8_t mode);
+    void setIrq(uint8_t flags);
+    void updateDio(void);
+    uint8_t getSf(void);
+    uint32_t getBwHz(void);
+
+    /** Called by air when a packet starts. Returns true if this receiver locks on it. */
+    bool rxStart(Sx1276Model* tx);
+
+    /** Called by air at end of packet this receiver locked on */
+    void rxEnd(Sx1276Model* tx, bool hopOk);
+
+    /** Record frequency used for given hop period */
+    void addHop(uint32_t index, uint64_t startNs, uint32_t frf);
+
+    /** Set FhssPresentChannel to given value, and raise FhssChangeChannel */
+    void fhssChangeChannel(uint32_t channel);
+
+    Sx1276Air*  air;
+    PinName     pinNss;
+    PinName     pinReset;
+    PinName     pinDio[4];
+
+    uint8_t     common[0x80];       //0x00 to 0x0C, and 0x40 to 0x7F
+    uint8_t     pageFsk[0x40];
+    uint8_t     pageLora[0x40];
+    uint8_t     fifo[256];
+
+    bool        inReset;
+    uint64_t    readyNs;            //Time chip is ready after last reset
+    bool        selected;
+    bool        addrPhase;
+    bool        writeAccess;
+    uint8_t     addr;
+    uint8_t     mode;               //Current mode, RegOpMode bits 2-0
+    bool        rxLocked;           //Receiving a packet
+    uint8_t     txPayload[256];
+    uint8_t     txLen;
+    int8_t      temperature;
+    uint32_t    rssiSeed;
+    uint64_t    frfWriteNs;         //Time RegFrfLsb was last written
+    Sx1276Hop   hops[SX1276_MAX_HOPS];
+    uint16_t    hopCount;
+    HostEvent   evtMode;            //End of TX, RX single timeout, CAD
+    HostEvent   evtTxStart;         //End of TX startup, packet starts
+    HostEvent   evtCal;             //End of image calibration
+};
+
+#endif /* TESTS_HOST_SX1276_MODEL_H_ */
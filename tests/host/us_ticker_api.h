@@ -0,0 +1,41 @@
+/**
+ * File:      us_ticker_api.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) replacement for the mbed "us_ticker_api.h" file. The us_ticker is implemented by host_hal.cpp, and
+ * reads the simulated time.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_US_TICKER_API_H_
+#define TESTS_HOST_US_TICKER_API_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Read the current simulated time in micro seconds. Wraps every 71 minutes, like the target's us_ticker.
+ * Each call advances the simulated time by the configured read cost, see host_set_ticker_cost().
+ */
+uint32_t us_ticker_read(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TESTS_HOST_US_TICKER_API_H_ */
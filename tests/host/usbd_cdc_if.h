@@ -0,0 +1,45 @@
+/**
+ * File:      usbd_cdc_if.h
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host (PC) replacement for the CDC interface of the STM32Cube USB library. Data transmitted with CDC_Transmit_FS()
+ * is given to the handler set with host_usb_set_tx_handler(), see host_usb.h.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#ifndef TESTS_HOST_USBD_CDC_IF_H_
+#define TESTS_HOST_USBD_CDC_IF_H_
+
+#include <stdint.h>
+
+#define USBD_OK     0
+#define USBD_BUSY   1
+#define USBD_FAIL   2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Transmit given data on the simulated USB CDC port
+ * @return USBD_OK if sent, USBD_BUSY if previous transfer is still in progress
+ */
+uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TESTS_HOST_USBD_CDC_IF_H_ */
@@ -0,0 +1,469 @@
+/**
+ * File:      sim_devkit.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host simulator of a complete SX1276 Development Kit module. main.cpp is compiled unmodified (main() renamed to
+ * app_main()), with inair.cpp, the NZ32S buffers and the display code, against the stub "mbed.h" in the "host"
+ * folder. The firmware runs on simulated time, with:
+ * - The SX1276 model (sx1276_model.h) on the inAir pins.
+ * - An optional "peer" SX1276, that acts like a second module in slave mode. It uses the radio settings of the
+ *   firmware's radio, and replies to each PING message with a PONG message. It does not do frequency hopping.
+ * - The SSD1306 model (ssd1306_model.h) on I2C bus 1. Each time the display changes, it can be written to a PPM
+ *   file named "<prefix>_<simulated ms>.ppm".
+ * - The USB CDC port (host_usb.h). Is exposed as a pseudo terminal (-u), or commands given with -c are sent, and
+ *   the replies written to stdout.
+ * - The simulated EEPROM of MxConfig, which can be loaded from and saved to a file (-e).
+ *
+ * Without -u and -r, a run is deterministic, the same options always give the same output.
+ *
+ * Usage: sim_devkit [-t sec] [-r] [-u] [-c cmds] [-b ms] [-p] [-o prefix] [-e file]
+ *  -t sec      Stop after given simulated seconds, default is to run until stopped.
+ *  -r          Run in real time, simulated time does not run ahead of wall clock time.
+ *  -u          Create a pseudo terminal for the USB CDC port, its name is written to stderr.
+ *  -c cmds     USB commands sent after startup, for example "tvs;mtr;".
+ *  -b ms       Press OK button at given simulated ms. First press selects Master mode, second Slave mode. Can be
+ *              given up to SIM_MAX_PRESSES times.
+ *  -p          Add the peer radio.
+ *  -o prefix   Write display to PPM files.
+ *  -e file     EEPROM file. Is loaded at startup if it exists, and saved when the simulator stops.
+ *
+ * Example, a master talking to the peer for 20 seconds, display written to "oled_xxxxxxxx.ppm":
+ *  sim_devkit -t 20 -p -b 500 -o oled -c "mtr;"
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define main app_main
+#include "main.cpp"
+#undef main
+
+#include "host_usb.h"
+#include "sx1276_model.h"
+#include "ssd1306_model.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define SIM_POLL_NS         1000000ULL      //USB pseudo terminal, real time and stop time are checked every 1ms
+#define SIM_FRAME_NS        10000000ULL     //Display is checked for changes every 10ms
+#define SIM_CMDS_NS         1000000000ULL   //Commands given with -c are sent 1 second after startup
+#define SIM_PRESS_NS        100000000ULL    //Button is held for 100ms
+#define SIM_MAX_PRESSES     8
+#define SIM_BTN_OK          PC_2            //OK & Star buttons of im4OLED via PT01NZ. OK pulls it low.
+
+#define PEER_TURNAROUND_NS  10000000ULL     //Time from receiving PING until PONG is sent, main loop of a slave
+#define PEER_REACTION_NS    1000ULL         //Time to react to TxDone
+#define PEER_SYNC_NS        10000000ULL     //Radio settings are copied from firmware's radio every 10ms
+#define PEER_RSSI           -77             //RSSI peer reports in PONG message, same as the model's packets
+
+/** Second SX1276 on the same air, that replies to PING messages like a module in slave mode */
+class PeerRadio : public Sx1276Model {
+public:
+    /** Create a peer for given radio. Is not active until enable() is called. Uses pins not used by firmware. */
+    PeerRadio(Sx1276Air* air, Sx1276Model* radio);
+
+    /** Put peer in LoRa RX continuous mode, and start copying radio settings */
+    void enable(void);
+
+    uint32_t    pingCount;  //PING messages received
+    uint32_t    pongCount;  //PONG messages sent
+
+protected:
+    static void syncEvent(void* ctx);
+    static void replyEvent(void* ctx);
+    static void dio0Changed(void* ctx, PinName pin, int level);
+
+    void setOpMode(uint8_t opMode);
+    void copyReg(uint8_t addr);
+
+    Sx1276Model*    radio;
+    uint8_t         reply[7];
+    HostEvent       evtSync;
+    HostEvent       evtReply;
+};
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static Sx1276Air    air;
+static Sx1276Model  radioModel(&air, PC_8, PA_9, PB_0, PB_1, PC_6, PA_10);
+static PeerRadio    peer(&air, &radioModel);
+static Ssd1306Model ssd(SSD_I2C_ADDRESS);
+
+static uint64_t     stopNs;             //Simulated time to stop, 0 for never
+static bool         realTime;
+static uint64_t     wallStartNs;
+static int          ptyFd = -1;         //Master side of USB pseudo terminal, -1 if not used
+static const char*  simCmds;            //Commands given with -c
+static const char*  framePrefix;        //PPM file prefix, NULL if not used
+static uint8_t      frame[SSD1306_MODEL_PAGES][SSD1306_MODEL_WIDTH];
+static bool         frameOn;
+static uint32_t     frameCount;
+static const char*  eepromFile;
+static uint64_t     pressNs[SIM_MAX_PRESSES];
+static uint8_t      pressCount;
+static uint8_t      pressIndex;
+static bool         pressed;
+
+static HostEvent    evtPoll;
+static HostEvent    evtFrame;
+static HostEvent    evtCmds;
+static HostEvent    evtButton;
+
+
+// PeerRadio //////////////////////////////////////////////////////////////////
+PeerRadio::PeerRadio(Sx1276Air* air, Sx1276Model* radio)
+    : Sx1276Model(air, PB_10, PB_11, PB_13, PB_14, PB_15, PC_7), pingCount(0), pongCount(0), radio(radio)
+{
+    host_event_init(&evtSync, &PeerRadio::syncEvent, this, false);
+    host_event_init(&evtReply, &PeerRadio::replyEvent, this, false);
+
+    //Chip select is pulled up, peer is never accessed via SPI
+    host_pin_drive(PB_10, 1);
+}
+
+void PeerRadio::enable(void) {
+    writeReg(REG_OPMODE, RFLR_OPMODE_LONGRANGEMODE_ON | RFLR_OPMODE_SLEEP);
+    writeReg(REG_LR_IRQFLAGSMASK, 0);
+    host_pin_on_change(pinDio[0], &PeerRadio::dio0Changed, this);
+    syncEvent(this);
+}
+
+void PeerRadio::setOpMode(uint8_t opMode) {
+    writeReg(REG_OPMODE, RFLR_OPMODE_LONGRANGEMODE_ON | opMode);
+}
+
+void PeerRadio::copyReg(uint8_t addr) {
+    if (peek(addr) != radio->peek(addr)) {
+        writeReg(addr, radio->peek(addr));
+    }
+}
+
+/** Copy settings of firmware's radio, while waiting for a PING message */
+void PeerRadio::syncEvent(void* ctx) {
+    PeerRadio* self = (PeerRadio*)ctx;
+
+    host_event_schedule(&self->evtSync, host_time_ns() + PEER_SYNC_NS);
+
+    //Radio's LoRa registers can only be read when it is in LoRa mode
+    if (((self->radio->peek(REG_OPMODE) & RFLR_OPMODE_LONGRANGEMODE_ON) == 0) || self->rxLocked
+            || (self->mode == RFLR_OPMODE_TRANSMITTER) || self->evtReply.pending) {
+        return;
+    }
+    self->copyReg(REG_LR_FRFMSB);
+    self->copyReg(REG_LR_FRFMID);
+    self->copyReg(REG_LR_FRFLSB);
+    self->copyReg(REG_LR_MODEMCONFIG1);
+    self->copyReg(REG_LR_MODEMCONFIG2);
+    self->copyReg(REG_LR_MODEMCONFIG3);
+    self->copyReg(REG_LR_PREAMBLEMSB);
+    self->copyReg(REG_LR_PREAMBLELSB);
+    self->copyReg(REG_LR_SYNCWORD);
+    self->copyReg(REG_LR_INVERTIQ);
+    if (self->mode != RFLR_OPMODE_RECEIVER) {
+        self->writeReg(REG_DIOMAPPING1, RFLR_DIOMAPPING1_DIO0_00);
+        self->setOpMode(RFLR_OPMODE_RECEIVER);
+    }
+}
+
+/** DIO0 is RxDone in RX mode, and TxDone in TX mode */
+void PeerRadio::dio0Changed(void* ctx, PinName pin, int level) {
+    PeerRadio* self = (PeerRadio*)ctx;
+    uint8_t flags = self->pageLora[REG_LR_IRQFLAGS];
+    uint8_t start = self->pageLora[REG_LR_FIFORXCURRENTADDR];
+    uint8_t i;
+    (void)pin;
+
+    if (level == 0) {
+        return;
+    }
+    self->writeReg(REG_LR_IRQFLAGS, 0xFF);
+
+    //TxDone is raised at the same time the packet ends on air, return to RX mode after it ended
+    if ((flags & RFLR_IRQFLAGS_TXDONE) != 0) {
+        self->pongCount++;
+        host_event_schedule(&self->evtSync, host_time_ns() + PEER_REACTION_NS);
+        return;
+    }
+
+    //PING message: Slave address, "pInG". Peer replies to all slave addresses.
+    if (((flags & RFLR_IRQFLAGS_PAYLOADCRCERROR) != 0) || (self->pageLora[REG_LR_RXNBBYTES] < 5)) {
+        return;
+    }
+    for (i = 0; i < 4; i++) {
+        if (self->fifo[(uint8_t)(start + 1 + i)] != (uint8_t)pingMsg[i]) {
+            return;
+        }
+    }
+    self->pingCount++;
+
+    //PONG message: 0 (master address), "pOnG", RSSI LSB, RSSI MSB
+    self->reply[0] = 0;
+    memcpy(&self->reply[1], pongMsg, 4);
+    self->reply[5] = (uint8_t)((int16_t)PEER_RSSI);
+    self->reply[6] = (uint8_t)(((int16_t)PEER_RSSI) >> 8);
+    host_event_schedule(&self->evtReply, host_time_ns() + PEER_TURNAROUND_NS);
+}
+
+void PeerRadio::replyEvent(void* ctx) {
+    PeerRadio* self = (PeerRadio*)ctx;
+    uint8_t i;
+
+    self->setOpMode(RFLR_OPMODE_STANDBY);
+    self->writeReg(REG_LR_FIFOADDRPTR, self->pageLora[REG_LR_FIFOTXBASEADDR]);
+    for (i = 0; i < sizeof(self->reply); i++) {
+        self->writeReg(REG_LR_FIFO, self->reply[i]);
+    }
+    self->writeReg(REG_LR_PAYLOADLENGTH, sizeof(self->reply));
+    self->writeReg(REG_DIOMAPPING1, RFLR_DIOMAPPING1_DIO0_01);
+    self->setOpMode(RFLR_OPMODE_TRANSMITTER);
+}
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static uint64_t wallNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/** Data sent to the PC. Replies end with '\r', is written as a new line to stdout. */
+static void onUsbTx(void* ctx, const uint8_t* data, uint16_t len) {
+    uint16_t i;
+    (void)ctx;
+
+    if (ptyFd >= 0) {
+        //If the pseudo terminal is full, the PC is not reading. Firmware gets USBD_BUSY until next poll.
+        if ((write(ptyFd, data, len) < 0) && (errno == EAGAIN)) {
+            host_usb_set_tx_busy(true);
+        }
+        return;
+    }
+    for (i = 0; i < len; i++) {
+        putchar((data[i] == '\r') ? '\n' : data[i]);
+    }
+}
+
+static void writeFrame(void) {
+    char name[256];
+    uint8_t rgb[SSD1306_MODEL_WIDTH * 3];
+    FILE* f;
+    uint16_t x;
+    uint16_t y;
+    bool on;
+
+    snprintf(name, sizeof(name), "%s_%08llu.ppm", framePrefix, (unsigned long long)(host_time_ns() / 1000000));
+    f = fopen(name, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Can not write %s\n", name);
+        return;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", SSD1306_MODEL_WIDTH, SSD1306_MODEL_PAGES * 8);
+    for (y = 0; y < (SSD1306_MODEL_PAGES * 8); y++) {
+        for (x = 0; x < SSD1306_MODEL_WIDTH; x++) {
+            on = frameOn && (((frame[y / 8][x] >> (y % 8)) & 0x01) != ssd.isInverted());
+            memset(&rgb[x * 3], on ? 0xFF : 0, 3);
+        }
+        fwrite(rgb, 1, sizeof(rgb), f);
+    }
+    fclose(f);
+    frameCount++;
+}
+
+/** Write display to a PPM file if it changed. Display is flushed a page at a time, it is only written once it did not
+ * change for SIM_FRAME_NS.
+ */
+static void frameEvent(void* ctx) {
+    static uint8_t last[SSD1306_MODEL_PAGES][SSD1306_MODEL_WIDTH];
+    static bool lastOn;
+    bool stable;
+    (void)ctx;
+
+    host_event_schedule(&evtFrame, host_time_ns() + SIM_FRAME_NS);
+    stable = (memcmp(last, ssd.getRam(), sizeof(last)) == 0) && (lastOn == ssd.isDisplayOn());
+    memcpy(last, ssd.getRam(), sizeof(last));
+    lastOn = ssd.isDisplayOn();
+    if (!stable || ((frameCount != 0) && (memcmp(frame, last, sizeof(frame)) == 0) && (frameOn == lastOn))) {
+        return;
+    }
+    memcpy(frame, last, sizeof(frame));
+    frameOn = lastOn;
+    writeFrame();
+}
+
+static void cmdsEvent(void* ctx) {
+    (void)ctx;
+    host_usb_send((const uint8_t*)simCmds, strlen(simCmds));
+}
+
+/** Press and release OK button */
+static void buttonEvent(void* ctx) {
+    (void)ctx;
+
+    pressed = !pressed;
+    if (pressed) {
+        host_pin_drive(SIM_BTN_OK, 0);
+        host_event_schedule(&evtButton, host_time_ns() + SIM_PRESS_NS);
+        return;
+    }
+    host_pin_drive(SIM_BTN_OK, -1);
+    if (++pressIndex < pressCount) {
+        host_event_schedule(&evtButton, (pressNs[pressIndex] > host_time_ns()) ? pressNs[pressIndex] : host_time_ns());
+    }
+}
+
+/** Pass data from the pseudo terminal to the firmware, keep real time, and stop */
+static void pollEvent(void* ctx) {
+    uint8_t buf[HOST_USB_PACKET_SIZE];
+    uint64_t now = host_time_ns();
+    uint64_t wall;
+    ssize_t len;
+    (void)ctx;
+
+    if ((stopNs != 0) && (now >= stopNs)) {
+        exit(0);
+    }
+    host_event_schedule(&evtPoll, now + SIM_POLL_NS);
+    host_usb_set_tx_busy(false);
+
+    //Read no more than fits in the USB FIFO, rest stays in the pseudo terminal
+    if ((ptyFd >= 0) && ((HOST_USB_RX_FIFO_SIZE - host_usb_pending()) >= sizeof(buf))) {
+        len = read(ptyFd, buf, sizeof(buf));
+        if (len > 0) {
+            host_usb_send(buf, (uint32_t)len);
+        }
+    }
+
+    if (realTime) {
+        wall = wallNs() - wallStartNs;
+        if (now > wall) {
+            usleep((useconds_t)((now - wall) / 1000));
+        }
+    }
+}
+
+/** Called at exit, also if firmware resets the MCU */
+static void finish(void) {
+    FILE* f;
+
+    if (eepromFile != NULL) {
+        f = fopen(eepromFile, "wb");
+        if ((f == NULL) || (fwrite(mxconfSimEeprom, 1, sizeof(mxconfSimEeprom), f) != sizeof(mxconfSimEeprom))) {
+            fprintf(stderr, "Can not write %s\n", eepromFile);
+        }
+        if (f != NULL) {
+            fclose(f);
+        }
+    }
+    fflush(stdout);
+    fprintf(stderr, "Stopped at %.3f s, radio TX=%u RX=%u, peer PING=%u PONG=%u, %u display frames\n",
+            (double)host_time_ns() / 1e9, radioModel.txCount, radioModel.rxCount, peer.pingCount, peer.pongCount,
+            frameCount);
+}
+
+static bool openPty(void) {
+    ptyFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((ptyFd < 0) || (grantpt(ptyFd) != 0) || (unlockpt(ptyFd) != 0)) {
+        return false;
+    }
+    fcntl(ptyFd, F_SETFL, fcntl(ptyFd, F_GETFL) | O_NONBLOCK);
+    fprintf(stderr, "USB CDC port: %s\n", ptsname(ptyFd));
+    return true;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: sim_devkit [-t sec] [-r] [-u] [-c cmds] [-b ms] [-p] [-o prefix] [-e file]\n");
+    exit(2);
+}
+
+int main(int argc, char* argv[]) {
+    FILE* f;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:ruc:b:po:e:")) != -1) {
+        switch (opt) {
+        case 't':
+            stopNs = (uint64_t)(atof(optarg) * 1e9);
+            break;
+        case 'r':
+            realTime = true;
+            break;
+        case 'u':
+            if (!openPty()) {
+                fprintf(stderr, "Can not create pseudo terminal\n");
+                return 1;
+            }
+            break;
+        case 'c':
+            simCmds = optarg;
+            break;
+        case 'b':
+            if (pressCount == SIM_MAX_PRESSES) {
+                usage();
+            }
+            pressNs[pressCount++] = (uint64_t)atoi(optarg) * 1000000;
+            break;
+        case 'p':
+            peer.enable();
+            break;
+        case 'o':
+            framePrefix = optarg;
+            break;
+        case 'e':
+            eepromFile = optarg;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind != argc) {
+        usage();
+    }
+
+    if (eepromFile != NULL) {
+        f = fopen(eepromFile, "rb");
+        if (f != NULL) {
+            if (fread(mxconfSimEeprom, 1, sizeof(mxconfSimEeprom), f) != sizeof(mxconfSimEeprom)) {
+                fprintf(stderr, "%s is not a valid EEPROM file\n", eepromFile);
+                return 1;
+            }
+            fclose(f);
+        }
+    }
+    atexit(&finish);
+
+    host_usb_set_tx_handler(&onUsbTx, NULL);
+    host_event_init(&evtPoll, &pollEvent, NULL, false);
+    host_event_schedule(&evtPoll, SIM_POLL_NS);
+    if (simCmds != NULL) {
+        host_event_init(&evtCmds, &cmdsEvent, NULL, false);
+        host_event_schedule(&evtCmds, SIM_CMDS_NS);
+    }
+    if (pressCount != 0) {
+        host_event_init(&evtButton, &buttonEvent, NULL, false);
+        host_event_schedule(&evtButton, pressNs[0]);
+    }
+    if (framePrefix != NULL) {
+        host_event_init(&evtFrame, &frameEvent, NULL, false);
+        host_event_schedule(&evtFrame, SIM_FRAME_NS);
+    }
+
+    wallStartNs = wallNs();
+    return app_main();
+}
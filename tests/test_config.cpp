@@ -0,0 +1,400 @@
+/**
+ * File:      test_config.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host tests for the "MxConfig Structure" log in mx_config.cpp, using the simulated Data EEPROM (MXCONF_EEPROM_SIM),
+ * which counts the program cycles of each 32-bit word.
+ *
+ * - Wear: random saves of the AppConfig and two RadioConfig structures, each changing one or two bytes, like the
+ *   USB commands do. mxconf_erase_spare() is called between saves like saveConfigTask() does, and the board is
+ *   rebooted every few hundred saves. Each structure is read back after every save. Reports the program cycles of
+ *   the most written word. Fails if it is not at least WEAR_FACTOR times less than the original in place store,
+ *   which programmed the header and footer bytes of a structure on every save.
+ * - Torn writes: the same, but power fails at a random word program of some saves and spare bank erases (the word
+ *   is half programmed). After the reboot, every byte of the structure being saved must have its old or new value,
+ *   and all other structures must be unchanged.
+ * - Write errors: the same, but a word program of some saves fails without a reboot (programming error). The save
+ *   must return false, every byte of the structure must have its old or new value, and the following saves must
+ *   not be lost.
+ * - Migration: a structure is saved with an old layout and "Data Descriptor". It is then read by new firmware with a
+ *   new layout (member inserted, 1-bit flags grown, member added at end), and must be migrated field by field, with
+ *   new members keeping their defaults. The new layout must survive reboots, and many saves with log compactions.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <setjmp.h>
+#include "mbed.h"
+#include "app_defs.h"
+#include "mx_config.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define WEAR_SAVES      20000   //Saves of wear test
+#define TORN_SAVES      30000   //Saves of torn write test
+#define ERROR_SAVES     30000   //Saves of write error test
+#define REBOOT_EVERY    997     //Saves between reboots
+#define WEAR_FACTOR     10      //Log must program most written word at least this many times less than original
+#define MIGRATE_ID      3       //Structure ID used by migration test
+#define MIGRATE_SAVES   3000    //Saves after migration, many compactions
+
+//Size(Byte2) of "Data Descriptor" entry, and offset(Byte3-4) with bits 8-11 of size in bits 12-15
+#define DESC_SIZE_OFFSET(size, strc, mem) (uint8_t)(size), \
+    (uint8_t)((((size) >> 4) & 0xf0) | OFFSETOF_MSB(strc, mem)), OFFSETOF_LSB(strc, mem)
+
+/** A structure saved by the test */
+struct TestStruct {
+    uint8_t     id;
+    uint16_t    adrOffset;
+    uint16_t    sizeStruct;
+    uint16_t    sizeData;
+};
+
+static const TestStruct testStructs[] = {
+    {MXCONF_ID_AppConfig,   MXCONF_ADR_AppConfig,       MXCONF_SIZE_AppConfig,      sizeof(AppConfig)},
+    {1,                     MXCONF_ADR_RadioConfig0,    MXCONF_SIZE_RadioConfig,    sizeof(RadioConfig)},
+    {2,                     MXCONF_ADR_RadioConfig1,    MXCONF_SIZE_RadioConfig,    sizeof(RadioConfig)},
+};
+#define TEST_STRUCTS    (sizeof(testStructs) / sizeof(testStructs[0]))
+
+//Layout of structure saved by old firmware
+typedef struct OldLayout_ {
+    uint8_t     flags;              //5 flags
+    uint8_t     a;
+    uint8_t     b;
+    uint32_t    c;
+} PACKED OldLayout;
+
+//Layout of new firmware. Member n1 inserted, 4 flags added, and n2 added at end
+typedef struct NewLayout_ {
+    uint16_t    flags;              //9 flags
+    uint8_t     n1;
+    uint8_t     a;
+    uint8_t     b;
+    uint32_t    c;
+    uint8_t     n2;
+} PACKED NewLayout;
+
+static uint8_t oldDesc[] = {2,
+    MXCONF_DESC_TYPE_1BIT, DESC_SIZE_OFFSET(5, OldLayout_, flags),
+    MXCONF_DESC_TYPE_8BIT, DESC_SIZE_OFFSET(6, OldLayout_, a)};
+static uint8_t newDesc[] = {3,
+    MXCONF_DESC_TYPE_1BIT, DESC_SIZE_OFFSET(9, NewLayout_, flags),
+    MXCONF_DESC_TYPE_8BIT, DESC_SIZE_OFFSET(6, NewLayout_, a),
+    MXCONF_DESC_TYPE_8BIT, DESC_SIZE_OFFSET(1, NewLayout_, n2)};
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static uint8_t  saved[TEST_STRUCTS][MXCONF_MAX_DATA];   //Data each structure should have in EEPROM
+static uint32_t saveCount[TEST_STRUCTS];
+static uint32_t rnd = 1;
+static jmp_buf  powerFailJmp;
+static int      errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static void fail(const char* msg, uint32_t save) {
+    if (errors++ < 10) {
+        printf("FAIL %s, save %u\n", msg, save);
+    }
+}
+
+static inline uint32_t random32(void) {
+    rnd = (rnd * 1103515245) + 12345;
+    return rnd >> 8;
+}
+
+static void onPowerFail(void) {
+    longjmp(powerFailJmp, 1);
+}
+
+/** Erase EEPROM, and save all structures with their initial values */
+static void reset(void) {
+    uint32_t s;
+
+    memset(mxconfSimEeprom, 0, sizeof(mxconfSimEeprom));
+    memset(mxconfSimCycles, 0, sizeof(mxconfSimCycles));
+    mxconfSimReboot();
+    for (s = 0; s < TEST_STRUCTS; s++) {
+        memset(saved[s], (int)s, MXCONF_MAX_DATA);
+        saveCount[s] = 0;
+        mxconf_save_struct(testStructs[s].id, saved[s], testStructs[s].sizeData, testStructs[s].adrOffset,
+                testStructs[s].sizeStruct);
+    }
+}
+
+/** Read given structure, and compare it with what was saved */
+static bool readCompare(uint32_t s, uint8_t* pData) {
+    memset(pData, 0xee, MXCONF_MAX_DATA);
+    if (mxconf_read_struct(testStructs[s].id, pData, testStructs[s].sizeData, testStructs[s].adrOffset,
+            testStructs[s].sizeStruct) == false) {
+        return false;
+    }
+    return memcmp(pData, saved[s], testStructs[s].sizeData) == 0;
+}
+
+/** Change one or two bytes of given data, like a USB command does */
+static void change(uint8_t* pData, uint16_t size) {
+    pData[random32() % size] = (uint8_t)random32();
+    if ((random32() % 2) == 0) {
+        pData[random32() % size] = (uint8_t)random32();
+    }
+}
+
+static uint32_t maxCycles(void) {
+    uint32_t max = 0;
+    uint32_t i;
+
+    for (i = 0; i < (EEPROM_SIZE / 4); i++) {
+        if (mxconfSimCycles[i] > max) {
+            max = mxconfSimCycles[i];
+        }
+    }
+    return max;
+}
+
+static void testWear(void) {
+    uint8_t data[MXCONF_MAX_DATA];
+    uint32_t maxSaves = 0;
+    uint32_t total = 0;
+    uint32_t n;
+    uint32_t s;
+    uint32_t i;
+
+    reset();
+    for (n = 0; n < WEAR_SAVES; n++) {
+        s = random32() % TEST_STRUCTS;
+        change(saved[s], testStructs[s].sizeData);
+        if (mxconf_save_struct(testStructs[s].id, saved[s], testStructs[s].sizeData, testStructs[s].adrOffset,
+                testStructs[s].sizeStruct) == false) {
+            fail("wear save", n);
+        }
+        saveCount[s]++;
+        for (i = 0; i < 3; i++) {
+            mxconf_erase_spare();
+        }
+        if ((n % REBOOT_EVERY) == 0) {
+            mxconfSimReboot();
+        }
+        if (readCompare(s, data) == false) {
+            fail("wear read back", n);
+        }
+    }
+
+    for (s = 0; s < TEST_STRUCTS; s++) {
+        maxSaves = (saveCount[s] > maxSaves) ? saveCount[s] : maxSaves;
+    }
+    for (i = 0; i < (EEPROM_SIZE / 4); i++) {
+        total += mxconfSimCycles[i];
+    }
+    printf("Wear: %u saves, %u word programs (%.1f per save)\n", WEAR_SAVES, total, (double)total / WEAR_SAVES);
+    printf("  Most written word: %u programs, original in place store: %u\n", maxCycles(), maxSaves);
+    if ((maxCycles() * WEAR_FACTOR) > maxSaves) {
+        fail("wear, most written word", WEAR_SAVES);
+    }
+}
+
+static void testTornWrites(void) {
+    uint8_t data[MXCONF_MAX_DATA];
+    uint8_t newData[MXCONF_MAX_DATA];
+    uint32_t torn = 0;
+    uint32_t n;
+    uint32_t s;
+    uint32_t i;
+    uint16_t k;
+
+    reset();
+    mxconfSimPowerFail = &onPowerFail;
+    for (n = 0; n < TORN_SAVES; n++) {
+        s = random32() % TEST_STRUCTS;
+        memcpy(newData, saved[s], MXCONF_MAX_DATA);
+        change(newData, testStructs[s].sizeData);
+        mxconfSimFailAfter = ((random32() % 10) == 0) ? (int32_t)(random32() % 12) : -1;
+
+        if (setjmp(powerFailJmp) == 0) {
+            mxconf_save_struct(testStructs[s].id, newData, testStructs[s].sizeData, testStructs[s].adrOffset,
+                    testStructs[s].sizeStruct);
+            memcpy(saved[s], newData, MXCONF_MAX_DATA);
+            for (i = 0; i < 3; i++) {
+                mxconf_erase_spare();
+            }
+            mxconfSimFailAfter = -1;
+        }
+        else {
+            //Power failed, each byte must have old or new value
+            torn++;
+            mxconfSimReboot();
+            memset(data, 0xee, sizeof(data));
+            if (mxconf_read_struct(testStructs[s].id, data, testStructs[s].sizeData, testStructs[s].adrOffset,
+                    testStructs[s].sizeStruct) == false) {
+                fail("torn write, structure lost", n);
+            }
+            for (k = 0; k < testStructs[s].sizeData; k++) {
+                if ((data[k] != saved[s][k]) && (data[k] != newData[k])) {
+                    fail("torn write, byte has neither old nor new value", n);
+                    break;
+                }
+            }
+            memcpy(saved[s], data, MXCONF_MAX_DATA);
+        }
+
+        if ((n % REBOOT_EVERY) == 0) {
+            mxconfSimReboot();
+        }
+        for (i = 0; i < TEST_STRUCTS; i++) {
+            if (readCompare(i, data) == false) {
+                fail("torn write, structure changed", n);
+            }
+        }
+    }
+    mxconfSimPowerFail = NULL;
+    printf("Torn writes: %u saves, %u power failures\n", TORN_SAVES, torn);
+}
+
+static void testWriteErrors(void) {
+    uint8_t data[MXCONF_MAX_DATA];
+    uint8_t newData[MXCONF_MAX_DATA];
+    uint32_t failed = 0;
+    uint32_t n;
+    uint32_t s;
+    uint32_t i;
+    uint16_t k;
+
+    reset();
+    for (n = 0; n < ERROR_SAVES; n++) {
+        s = random32() % TEST_STRUCTS;
+        memcpy(newData, saved[s], MXCONF_MAX_DATA);
+        change(newData, testStructs[s].sizeData);
+        mxconfSimFailAfter = ((random32() % 10) == 0) ? (int32_t)(random32() % 12) : -1;
+
+        if (mxconf_save_struct(testStructs[s].id, newData, testStructs[s].sizeData, testStructs[s].adrOffset,
+                testStructs[s].sizeStruct)) {
+            memcpy(saved[s], newData, MXCONF_MAX_DATA);
+        }
+        else {
+            //Write failed, each byte must have old or new value
+            failed++;
+            memset(data, 0xee, sizeof(data));
+            if (mxconf_read_struct(testStructs[s].id, data, testStructs[s].sizeData, testStructs[s].adrOffset,
+                    testStructs[s].sizeStruct) == false) {
+                fail("write error, structure lost", n);
+            }
+            for (k = 0; k < testStructs[s].sizeData; k++) {
+                if ((data[k] != saved[s][k]) && (data[k] != newData[k])) {
+                    fail("write error, byte has neither old nor new value", n);
+                    break;
+                }
+            }
+            memcpy(saved[s], data, MXCONF_MAX_DATA);
+        }
+        mxconfSimFailAfter = -1;
+        for (i = 0; i < 3; i++) {
+            mxconf_erase_spare();
+        }
+
+        if ((n % REBOOT_EVERY) == 0) {
+            mxconfSimReboot();
+        }
+        for (i = 0; i < TEST_STRUCTS; i++) {
+            if (readCompare(i, data) == false) {
+                fail("write error, structure changed", n);
+            }
+        }
+    }
+    printf("Write errors: %u saves, %u failed\n", ERROR_SAVES, failed);
+}
+
+static bool saveNew(NewLayout* p) {
+    return mxconf_save_struct(MIGRATE_ID, (uint8_t*)p, sizeof(NewLayout), MXCONF_ADR_ID3, MXCONF_SIZE_ID3, newDesc);
+}
+
+static bool readNew(NewLayout* p) {
+    return mxconf_read_struct(MIGRATE_ID, (uint8_t*)p, sizeof(NewLayout), MXCONF_ADR_ID3, MXCONF_SIZE_ID3, newDesc);
+}
+
+static void testMigration(void) {
+    OldLayout oldData = {0x15, 1, 2, 0x12345678};
+    OldLayout oldRead;
+    NewLayout newData;
+    NewLayout newRead;
+    uint32_t n;
+
+    reset();
+
+    //Old firmware
+    if (!mxconf_save_struct(MIGRATE_ID, (uint8_t*)&oldData, sizeof(oldData), MXCONF_ADR_ID3, MXCONF_SIZE_ID3,
+            oldDesc)) {
+        fail("migration, old save", 0);
+    }
+    oldData.b = 9;
+    mxconf_save_struct(MIGRATE_ID, (uint8_t*)&oldData, sizeof(oldData), MXCONF_ADR_ID3, MXCONF_SIZE_ID3, oldDesc);
+    mxconfSimReboot();
+    memset(&oldRead, 0, sizeof(oldRead));
+    if (!mxconf_read_struct(MIGRATE_ID, (uint8_t*)&oldRead, sizeof(oldRead), MXCONF_ADR_ID3, MXCONF_SIZE_ID3, oldDesc)
+            || (memcmp(&oldRead, &oldData, sizeof(oldData)) != 0)) {
+        fail("migration, old read", 0);
+    }
+
+    //Firmware update. New members have defaults, flags not in old layout keep their default
+    mxconfSimReboot();
+    newData.flags = 0xff00;
+    newData.n1 = 0x77;
+    newData.a = 0;
+    newData.b = 0;
+    newData.c = 0;
+    newData.n2 = 0x55;
+    if (!readNew(&newData) || (newData.flags != 0xff15) || (newData.n1 != 0x77) || (newData.a != 1)
+            || (newData.b != 9) || (newData.c != 0x12345678) || (newData.n2 != 0x55)) {
+        fail("migration, new read", 0);
+    }
+    mxconfSimReboot();
+    memset(&newRead, 0, sizeof(newRead));
+    if (!readNew(&newRead) || (memcmp(&newRead, &newData, sizeof(newData)) != 0)) {
+        fail("migration, new read after reboot", 0);
+    }
+
+    //Saves with new layout, with compactions and reboots
+    newData.c = 5;
+    for (n = 0; n < MIGRATE_SAVES; n++) {
+        newData.a = (uint8_t)n;
+        if (!saveNew(&newData)) {
+            fail("migration, new save", n);
+        }
+        mxconf_erase_spare();
+        if ((n % 500) == 0) {
+            mxconfSimReboot();
+        }
+    }
+    mxconfSimReboot();
+    memset(&newRead, 0, sizeof(newRead));
+    if (!readNew(&newRead) || (memcmp(&newRead, &newData, sizeof(newData)) != 0)) {
+        fail("migration, read after saves", MIGRATE_SAVES);
+    }
+    printf("Migration: %u saves after migration\n", MIGRATE_SAVES);
+}
+
+int main() {
+    testWear();
+    testTornWrites();
+    testWriteErrors();
+    testMigration();
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
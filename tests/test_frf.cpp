@@ -0,0 +1,134 @@
+/**
+ * File:      test_frf.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host test for the integer RegFrf conversion of the InAir driver. Checks that InAir::FreqToFrf() gives exactly
+ * the same value as the floating point formula "(uint32_t)((double)freq / FREQ_STEP)" it replaced, for every
+ * frequency from 137 to 1020MHz in 1Hz steps. InAir::FrfToFreq() is checked against "(uint32_t)(frf * FREQ_STEP)"
+ * for every RegFrf value in this range. Then SetChannel() is checked with the SX1276 model, including channel plan
+ * cache hits and evictions.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include "mbed.h"
+#include "inair.h"
+#include "sx1276_model.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define FREQ_MIN    137000000
+#define FREQ_MAX    1020000000
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static Sx1276Air   air;
+static Sx1276Model model(&air, PA_4, PC_0, PB_0, PB_1, PB_2, PB_3);
+
+static int errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+
+/** Formula used by SetChannel() before the integer conversion */
+static uint32_t freqToFrfFloat(uint32_t freq) {
+    return (uint32_t)((double)freq / (double)FREQ_STEP);
+}
+
+static uint32_t frfToFreqFloat(uint32_t frf) {
+    return (uint32_t)((double)frf * (double)FREQ_STEP);
+}
+
+static void checkFreqToFrf(void) {
+    uint32_t freq;
+    uint32_t count = 0;
+
+    for (freq = FREQ_MIN; freq <= FREQ_MAX; freq++) {
+        if (InAir::FreqToFrf(freq) != freqToFrfFloat(freq)) {
+            if (++count <= 10) {
+                printf("FAIL FreqToFrf(%u) = %u, expected %u\n", freq, InAir::FreqToFrf(freq), freqToFrfFloat(freq));
+            }
+        }
+    }
+    printf("FreqToFrf(): %u frequencies checked, %u errors\n", FREQ_MAX - FREQ_MIN + 1, count);
+    errors += count;
+}
+
+static void checkFrfToFreq(void) {
+    uint32_t frf;
+    uint32_t first = freqToFrfFloat(FREQ_MIN);
+    uint32_t last = freqToFrfFloat(FREQ_MAX);
+    uint32_t count = 0;
+
+    for (frf = first; frf <= last; frf++) {
+        if (InAir::FrfToFreq(frf) != frfToFreqFloat(frf)) {
+            if (++count <= 10) {
+                printf("FAIL FrfToFreq(%u) = %u, expected %u\n", frf, InAir::FrfToFreq(frf), frfToFreqFloat(frf));
+            }
+        }
+    }
+    printf("FrfToFreq(): %u RegFrf values checked, %u errors\n", last - first + 1, count);
+    errors += count;
+}
+
+/** Set channels with SetChannel(), and check RegFrf of the radio. More channels than INAIR_CHANNEL_CACHE_SIZE are
+ * used, and each is set twice, so cache hits, misses and evictions are all tested.
+ */
+static void checkSetChannel(InAir* radio) {
+    static const uint32_t freqs[] = {
+        137000000, 433175000, 434000001, 868100000, 868300000, 868500000, 915000000, 923300000, 1020000000,
+        525000000, 525000001, 779000000, 779999999
+    };
+    uint32_t count = 0;
+    uint8_t pass;
+    uint8_t i;
+
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < (sizeof(freqs) / sizeof(freqs[0])); i++) {
+            //Set twice, second time is a cache hit
+            radio->SetChannel(freqs[i]);
+            radio->SetChannel(freqs[i]);
+            if (model.getFrf() != freqToFrfFloat(freqs[i])) {
+                printf("FAIL SetChannel(%u): RegFrf = %u, expected %u\n", freqs[i], model.getFrf(),
+                        freqToFrfFloat(freqs[i]));
+                count++;
+            }
+        }
+    }
+    printf("SetChannel(): %u frequencies checked, %u errors\n", (uint32_t)(2 * (sizeof(freqs) / sizeof(freqs[0]))),
+            count);
+    errors += count;
+}
+
+int main() {
+    InAir* radio;
+
+    checkFreqToFrf();
+    checkFrfToFreq();
+
+    radio = new InAir(NULL, NULL, NULL, NULL, NULL, NULL, NULL, PB_15, PB_14, PB_13, PA_4, PC_0, PB_0, PB_1, PB_2,
+            PB_3);
+    while (!radio->InitTask()) {
+        wait_ms(1);
+    }
+    checkSetChannel(radio);
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
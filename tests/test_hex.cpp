@@ -0,0 +1,288 @@
+/**
+ * File:      test_hex.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Exhaustive host tests for the word at a time hex functions, MxHelpers::bytes_to_ascii_hex() and
+ * MxHelpers::ascii_hex_to_bytes(), and for decodeAsciiCmd() and AsciiCmdDecoder, which use them.
+ *
+ * - bytes_to_ascii_hex(): every byte value, in every position of a 4 byte word, for lengths 1 to 9 (so whole words,
+ *   and every tail length are tested). Compared with byte_to_ascii_hex_str().
+ * - ascii_hex_to_bytes(): every pair of characters (all 65536), in every pair position of a 5 byte (10 character)
+ *   source, with and without lower case allowed. Compared with a character at a time reference.
+ * - decodeAsciiCmd(): every string up to 5 characters long, of characters that are handled differently (hex, lower
+ *   case, quotes, escape, ';' and invalid), and random longer strings. Compared with the original decodeAsciiCmd() of
+ *   MX_LEGACY_REF (see CMakeLists.txt), for different destination sizes, with and without an escape character. Each
+ *   string is also decoded by AsciiCmdDecoder in two parts, split at every position.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include "mbed.h"
+#include "mx_helpers.h"
+#include "app_helpers.h"
+
+namespace legacy {
+#include "legacy/decode_ascii_cmd.h"
+}
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define DECODE_MAX_LEN      5           //Longest string tested with all combinations
+#define DECODE_RANDOM       200000      //Random strings tested
+#define DECODE_RANDOM_LEN   40          //Longest random string
+
+//Characters used for decodeAsciiCmd() strings, one of each type it handles differently
+static const char decodeChars[] = "09AFafG'^; ";
+#define DECODE_CHARS        (sizeof(decodeChars) - 1)
+
+//Destination sizes and escape characters decodeAsciiCmd() is tested with
+static const uint16_t decodeDestSizes[] = {1, 2, 3, 4, 64};
+static const uint8_t decodeEscChars[] = {0, '^'};
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+//Application globals, are defined in main.cpp, and used by app_helpers.cpp
+AppConfig       appConfig;
+AppData         appData;
+RadioConfig     radioConfig[RADIO_COUNT];
+RadioData       radioData[RADIO_COUNT];
+
+static uint32_t errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static void fail(const char* msg, const uint8_t* s, uint16_t len) {
+    uint16_t i;
+
+    if (errors++ >= 10) {
+        return;
+    }
+    printf("FAIL %s: '", msg);
+    for (i = 0; i < len; i++) {
+        printf("%c", ((s[i] >= 0x20) && (s[i] < 0x7f)) ? s[i] : '?');
+    }
+    printf("'\n");
+}
+
+static inline uint32_t random32(uint32_t* state) {
+    *state = (*state * 1103515245) + 12345;
+    return *state >> 8;
+}
+
+/** Character at a time reference for ascii_hex_to_bytes(). Returns nibble value, or -1 if not a hex character. */
+static int refNibble(uint8_t c, bool allowLower) {
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    }
+    if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    }
+    if (allowLower && (c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static void testEncode(void) {
+    uint8_t src[9];
+    uint8_t dst[2 * sizeof(src)];
+    char expected[3];
+    uint16_t len;
+    uint16_t pos;
+    uint16_t i;
+    int v;
+
+    for (len = 1; len <= sizeof(src); len++) {
+        for (pos = 0; pos < len; pos++) {
+            for (v = 0; v < 256; v++) {
+                for (i = 0; i < len; i++) {
+                    src[i] = (uint8_t)((i * 37) + 11);
+                }
+                src[pos] = v;
+                memset(dst, 0, sizeof(dst));
+                MxHelpers::bytes_to_ascii_hex(src, len, dst);
+                for (i = 0; i < len; i++) {
+                    MxHelpers::byte_to_ascii_hex_str(src[i], expected);
+                    if ((dst[2 * i] != expected[0]) || (dst[(2 * i) + 1] != expected[1])) {
+                        fail("bytes_to_ascii_hex", dst, 2 * len);
+                        break;
+                    }
+                }
+                //Must not write past end
+                for (i = 2 * len; i < sizeof(dst); i++) {
+                    if (dst[i] != 0) {
+                        fail("bytes_to_ascii_hex wrote past end", dst, sizeof(dst));
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void testDecode(void) {
+    static const uint8_t base[] = "3F9aC0e1B7";     //Valid if lower case allowed
+    uint8_t src[10];
+    uint8_t dst[6];
+    uint16_t expected;
+    uint16_t count;
+    uint16_t pos;
+    int allowLower;
+    int hi;
+    int lo;
+    int a;
+    int b;
+
+    for (allowLower = 0; allowLower < 2; allowLower++) {
+        for (pos = 0; pos < 5; pos++) {
+            for (a = 0; a < 256; a++) {
+                for (b = 0; b < 256; b++) {
+                    memcpy(src, base, sizeof(src));
+                    if (!allowLower) {
+                        src[3] = 'A';
+                        src[6] = '5';
+                    }
+                    src[2 * pos] = a;
+                    src[(2 * pos) + 1] = b;
+                    memset(dst, 0xa5, sizeof(dst));
+                    count = MxHelpers::ascii_hex_to_bytes(src, 5, dst, allowLower);
+
+                    for (expected = 0; expected < 5; expected++) {
+                        hi = refNibble(src[2 * expected], allowLower);
+                        lo = refNibble(src[(2 * expected) + 1], allowLower);
+                        if ((hi < 0) || (lo < 0)) {
+                            break;
+                        }
+                        if (dst[expected] != ((hi << 4) | lo)) {
+                            fail("ascii_hex_to_bytes value", src, sizeof(src));
+                        }
+                    }
+                    if (count != expected) {
+                        fail("ascii_hex_to_bytes count", src, sizeof(src));
+                    }
+                    if (dst[5] != 0xa5) {
+                        fail("ascii_hex_to_bytes wrote past end", src, sizeof(src));
+                    }
+                }
+            }
+        }
+    }
+}
+
+/** Compare decodeAsciiCmd() with the original, and split AsciiCmdDecoder decoding, for given NULL terminated string */
+static void checkAsciiCmd(const uint8_t* s, uint16_t len) {
+    uint8_t dstLegacy[64];
+    uint8_t dst[64];
+    uint16_t retLegacy;
+    uint16_t ret;
+    uint16_t destSize;
+    uint16_t split;
+    uint32_t d;
+    uint32_t e;
+
+    for (e = 0; e < sizeof(decodeEscChars); e++) {
+        for (d = 0; d < (sizeof(decodeDestSizes) / sizeof(decodeDestSizes[0])); d++) {
+            destSize = decodeDestSizes[d];
+            retLegacy = legacy::decodeAsciiCmd(dstLegacy, destSize, s, decodeEscChars[e]);
+            ret = decodeAsciiCmd(dst, destSize, s, decodeEscChars[e]);
+            if ((ret != retLegacy) || (memcmp(dst, dstLegacy, ret) != 0)) {
+                fail("decodeAsciiCmd", s, len);
+                return;
+            }
+            if (ret == 0) {
+                continue;
+            }
+
+            //Decoding in two parts must give same result
+            for (split = 0; split <= len; split++) {
+                AsciiCmdDecoder decoder(decodeEscChars[e]);
+                AsciiCmdArraySink sink(dst, destSize - 1);
+                AsciiCmdDecoder counterDecoder(decodeEscChars[e]);
+                AsciiCmdCounter counter;
+
+                decoder.decode(s, split, sink);
+                decoder.decode(&s[split], len - split, sink);
+                if (decoder.isError() || (sink.len != ret) || (memcmp(dst, dstLegacy, ret) != 0)) {
+                    fail("AsciiCmdDecoder split", s, len);
+                    return;
+                }
+                counterDecoder.decode(s, split, counter);
+                counterDecoder.decode(&s[split], len - split, counter);
+                if (counterDecoder.getCount() != ret) {
+                    fail("AsciiCmdDecoder count", s, len);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+static void testAsciiCmd(void) {
+    uint8_t s[DECODE_RANDOM_LEN + 1];
+    uint32_t combinations;
+    uint32_t rnd = 7;
+    uint32_t i;
+    uint32_t n;
+    uint16_t len;
+    uint16_t k;
+
+    //All strings up to DECODE_MAX_LEN characters
+    for (len = 0; len <= DECODE_MAX_LEN; len++) {
+        combinations = 1;
+        for (k = 0; k < len; k++) {
+            combinations *= DECODE_CHARS;
+        }
+        for (i = 0; i < combinations; i++) {
+            n = i;
+            for (k = 0; k < len; k++) {
+                s[k] = decodeChars[n % DECODE_CHARS];
+                n /= DECODE_CHARS;
+            }
+            s[len] = 0;
+            checkAsciiCmd(s, len);
+        }
+    }
+
+    //Random longer strings, mostly hex so the word at a time path is used
+    for (i = 0; i < DECODE_RANDOM; i++) {
+        len = random32(&rnd) % (DECODE_RANDOM_LEN + 1);
+        for (k = 0; k < len; k++) {
+            if ((random32(&rnd) % 8) != 0) {
+                s[k] = "0123456789ABCDEF"[random32(&rnd) % 16];
+            }
+            else {
+                s[k] = decodeChars[random32(&rnd) % DECODE_CHARS];
+            }
+        }
+        s[len] = 0;
+        checkAsciiCmd(s, len);
+    }
+}
+
+int main() {
+    testEncode();
+    printf("bytes_to_ascii_hex: %u errors\n", errors);
+    testDecode();
+    printf("ascii_hex_to_bytes: %u errors\n", errors);
+    testAsciiCmd();
+    printf("decodeAsciiCmd: %u errors\n", errors);
+
+    if (errors != 0) {
+        printf("%u errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,300 @@
+/**
+ * File:      test_hop_timing.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host test for LoRa intra-packet frequency hopping (FHSS) of the InAir driver. Two InAir objects, a transmitter
+ * and a receiver, are connected to SX1276 models sharing the same air. A packet is sent with hopping enabled, and
+ * for each hop period it is checked that:
+ * - The FRF register was written after the FhssChangeChannel interrupt of the previous period, and within one
+ *   symbol time of it (the budget). The interrupt handler has to program the next channel before the radio
+ *   hops, and the shortest hop period is one symbol.
+ * - The frequency used is the one in the hop table, for transmitter and receiver.
+ * - The receiver gets the packet with a valid CRC.
+ * A final case disables interrupts for longer than a hop period during a packet, and checks that the test detects
+ * the missed hops.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include "mbed.h"
+#include "inair.h"
+#include "sx1276_model.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define HOP_BASE_FREQ       863100000   //First hop channel [Hz]
+#define HOP_SPACING         200000      //Hop channel spacing [Hz]
+#define HOP_CHANNELS        16
+#define HOP_SEED            0x5A17
+#define PAYLOAD_LEN         64
+#define TX_TIMEOUT_US       20000000    //Longer than any packet in this test
+
+/** InAir, with access to the hop table */
+class TestInAir : public InAir {
+public:
+    TestInAir(void (*txDone)(), void (*txTimeout)(), void (*rxDone)(uint8_t* payload, uint16_t size, int16_t rssi,
+            int8_t snr), void (*rxError)(), PinName nss, PinName reset, PinName dio0, PinName dio1, PinName dio2,
+            PinName dio3)
+        : InAir(txDone, txTimeout, rxDone, NULL, rxError, NULL, NULL, PB_15, PB_14, PB_13, nss, reset, dio0, dio1,
+                dio2, dio3)
+    {
+    }
+
+    /** Returns RegFrf value of given hop table entry */
+    uint32_t getHopFrf(uint8_t i) {
+        return ((uint32_t)fhssFrf[i][0] << 16) | ((uint32_t)fhssFrf[i][1] << 8) | fhssFrf[i][2];
+    }
+};
+
+typedef struct TestCase_ {
+    uint8_t     bw;         //LoRa bandwidth, 0=7.8kHz to 9=500kHz
+    uint8_t     sf;         //Spreading factor
+    uint8_t     hopPeriod;  //Symbols per hop
+} TestCase;
+
+//Shortest hop periods, with fastest symbol rates, are the hardest for the interrupt handler
+static const TestCase testCases[] = {
+    {9, 7, 1},
+    {9, 7, 4},
+    {8, 7, 1},
+    {7, 7, 2},
+    {7, 9, 1},
+    {7, 12, 1},
+    {6, 8, 3}
+};
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static Sx1276Air   air;
+static Sx1276Model modelTx(&air, PA_4, PC_0, PB_0, PB_1, PB_2, PB_3);
+static Sx1276Model modelRx(&air, PA_8, PC_1, PB_4, PB_5, PB_6, PB_7);
+
+static TestInAir*  radioTx;
+static TestInAir*  radioRx;
+
+static volatile bool txDone;
+static volatile bool txTimeout;
+static volatile bool rxDone;
+static volatile bool rxError;
+static uint8_t       rxPayload[256];
+static uint16_t      rxSize;
+static uint8_t       txPayload[PAYLOAD_LEN];
+
+static int errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static void onTxDone() {
+    txDone = true;
+}
+
+static void onTxTimeout() {
+    txTimeout = true;
+}
+
+static void onRxDone(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr) {
+    (void)rssi;
+    (void)snr;
+    memcpy(rxPayload, payload, size);
+    rxSize = size;
+    rxDone = true;
+}
+
+static void onRxError() {
+    rxError = true;
+}
+
+static void fail(const char* name, const char* msg, int hop) {
+    printf("FAIL %s: %s (hop %d)\n", name, msg, hop);
+    errors++;
+}
+
+/** Check hops recorded by given model. Returns worst latency from interrupt to FRF write, or 0 if a check failed. */
+static uint64_t checkHops(const char* name, Sx1276Model* model, TestInAir* radio, bool report) {
+    const Sx1276Hop* hops = model->getHops();
+    uint64_t budget = model->symbolNs();
+    uint64_t worst = 0;
+    uint64_t lat;
+    int k;
+
+    if (model->getHopCount() < 3) {
+        if (report) {
+            fail(name, "too few hops", model->getHopCount());
+        }
+        return 0;
+    }
+
+    for (k = 0; k < model->getHopCount(); k++) {
+        if (hops[k].frf != radio->getHopFrf(k % HOP_CHANNELS)) {
+            if (report) {
+                fail(name, "wrong frequency", k);
+            }
+            return 0;
+        }
+        if (k == 0) {
+            continue;
+        }
+
+        if (hops[k].frfWriteNs <= hops[k - 1].startNs) {
+            if (report) {
+                fail(name, "FRF not written after FhssChangeChannel interrupt", k);
+            }
+            return 0;
+        }
+        lat = hops[k].frfWriteNs - hops[k - 1].startNs;
+        if (lat > budget) {
+            if (report) {
+                printf("FAIL %s: hop %d latency %lluns, budget %lluns\n", name, k, (unsigned long long)lat,
+                        (unsigned long long)budget);
+                errors++;
+            }
+            return 0;
+        }
+        if (lat > worst) {
+            worst = lat;
+        }
+    }
+    return worst;
+}
+
+/** Configure both radios, and start receiver. Radios are put to sleep first, like the application does after each
+ * packet. InAir::SetOpMode() does not know the radio returned to standby after TxDone.
+ */
+static void setup(const TestCase* tc) {
+    radioTx->Sleep();
+    radioRx->Sleep();
+    radioTx->SetTxConfig(MODEM_LORA, 14, 0, tc->bw, tc->sf, 1, 8, false, true, true, tc->hopPeriod, false,
+            TX_TIMEOUT_US);
+    radioRx->SetRxConfig(MODEM_LORA, tc->bw, tc->sf, 1, 0, 8, 5, false, 0, true, true, tc->hopPeriod, false, true);
+
+    txDone = txTimeout = rxDone = rxError = false;
+    rxSize = 0;
+    radioRx->Rx(0);
+}
+
+/** Send packet, and wait until transmitter and receiver are done. Interrupts are disabled for maskNs at maskAtNs
+ * after the start of the packet if maskNs is not 0.
+ */
+static void sendAndWait(uint64_t maskAtNs, uint64_t maskNs) {
+    uint64_t start;
+    uint64_t timeout;
+
+    radioTx->Send(txPayload, PAYLOAD_LEN);
+    start = host_time_ns();
+    timeout = start + (TX_TIMEOUT_US * 1000ULL);
+
+    if (maskNs != 0) {
+        host_advance_ns(maskAtNs);
+        __disable_irq();
+        host_advance_ns(maskNs);
+        __enable_irq();
+    }
+
+    while ((!txDone || (!rxDone && !rxError)) && !txTimeout && (host_time_ns() < timeout)) {
+        __WFI();
+    }
+}
+
+static void runCase(const TestCase* tc) {
+    HostIsrStats stats;
+    uint64_t worstTx;
+    uint64_t worstRx;
+
+    setup(tc);
+    host_isr_stats(&stats);
+    sendAndWait(0, 0);
+    host_isr_stats(&stats);
+
+    printf("BW=%d SF=%d hopPeriod=%d: symbol %lluus, %d hops", tc->bw, tc->sf, tc->hopPeriod,
+            (unsigned long long)(modelTx.symbolNs() / 1000), modelTx.getHopCount());
+
+    if (!txDone) {
+        printf("\n");
+        fail("tx", "no TxDone", -1);
+        return;
+    }
+    if (!rxDone || (rxSize != PAYLOAD_LEN) || (memcmp(rxPayload, txPayload, PAYLOAD_LEN) != 0)) {
+        printf("\n");
+        fail("rx", rxError ? "CRC error" : "packet not received", -1);
+        return;
+    }
+
+    worstTx = checkHops("tx", &modelTx, radioTx, true);
+    worstRx = checkHops("rx", &modelRx, radioRx, true);
+    printf(", worst FRF write latency tx %lluns rx %lluns, longest ISR %lluns\n", (unsigned long long)worstTx,
+            (unsigned long long)worstRx, (unsigned long long)stats.maxNs);
+}
+
+/** Disable interrupts for 3 hop periods in the middle of a packet. The hop check must detect the late FRF writes.
+ * Both radios are on the same (simulated) MCU and miss the same hops, so the receiver still gets the packet.
+ */
+static void runMaskedCase(void) {
+    const TestCase tc = {9, 7, 1};
+    uint64_t hopNs;
+
+    setup(&tc);
+    hopNs = modelTx.symbolNs() * tc.hopPeriod;
+    sendAndWait(20 * hopNs, 3 * hopNs);
+
+    printf("Interrupts disabled for 3 hop periods: ");
+    if (!txDone) {
+        printf("\n");
+        fail("masked", "no TxDone", -1);
+        return;
+    }
+    if (checkHops("masked", &modelTx, radioTx, false) != 0) {
+        printf("\n");
+        fail("masked", "missed hop not detected", -1);
+        return;
+    }
+    printf("missed hop detected OK\n");
+}
+
+int main() {
+    uint8_t i;
+
+    for (i = 0; i < PAYLOAD_LEN; i++) {
+        txPayload[i] = (uint8_t)((i * 37) + 11);
+    }
+
+    radioTx = new TestInAir(&onTxDone, &onTxTimeout, NULL, NULL, PA_4, PC_0, PB_0, PB_1, PB_2, PB_3);
+    radioRx = new TestInAir(NULL, NULL, &onRxDone, &onRxError, PA_8, PC_1, PB_4, PB_5, PB_6, PB_7);
+    while (!radioTx->InitTask() || !radioRx->InitTask()) {
+        wait_ms(1);
+    }
+
+    if ((modelTx.imageCalCount == 0) || (modelTx.resetCount != 1) || (modelTx.spiErrCount != 0)) {
+        fail("init", "radio not reset and calibrated", -1);
+    }
+
+    radioTx->SetChannel(HOP_BASE_FREQ);
+    radioRx->SetChannel(HOP_BASE_FREQ);
+    if (!radioTx->SetHopTable(HOP_BASE_FREQ, HOP_SPACING, HOP_CHANNELS, HOP_SEED)
+            || !radioRx->SetHopTable(HOP_BASE_FREQ, HOP_SPACING, HOP_CHANNELS, HOP_SEED)) {
+        fail("init", "SetHopTable() failed", -1);
+    }
+
+    for (i = 0; i < (sizeof(testCases) / sizeof(testCases[0])); i++) {
+        runCase(&testCases[i]);
+    }
+    runMaskedCase();
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,417 @@
+/**
+ * File:      test_i2c_queue.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host test of the interrupt driven I2C queue of the target HAL (i2c_api.c, DEVICE_I2C_QUEUE), on the model of the
+ * STM32 I2C peripheral (stm32_i2c_model.h). It is checked that:
+ * - Queued transfers are sent by the event interrupt (i2c_queue_ev_irq), in order, with the prefix byte, and their
+ *   handlers are called in order.
+ * - The START of a transfer queued behind another one is deferred until the STOP has been generated, and is only
+ *   generated by i2c_queue_poll() (called by i2c_queue_busy()). No register is written while the STOP is pending.
+ * - A NACKed address fails the transfer and all following ones with I2C_ERROR_NO_SLAVE.
+ * - i2c_init() (i2c_reset()) aborts the queue, handlers are called with I2C_ERROR_BUS_BUSY, and the bus can be
+ *   used again.
+ * - A blocking i2c_write() is sent after the queued transfers.
+ * - MxSSD1306_I2C with OLED_I2C_QUEUE sends the display buffer correctly to the SSD1306 model.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include "mbed.h"
+#include "stm32_i2c_model.h"
+#include "ssd1306_model.h"
+#include "mx_ssd1306.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define DEV_ADDRESS     0x50        //Recording device
+#define NACK_ADDRESS    0x52        //No device
+#define MAX_TRANSFERS   8
+#define MAX_DONE        16
+#define WAIT_TIMEOUT_US 100000
+#define BUF_SIZE        (OLED_HEIGHT * OLED_WIDTH / 8)
+
+/** I2C device recording all write transfers */
+class Recorder : public HostI2cDevice {
+public:
+    Recorder(int address) : count(0) {
+        host_i2c_attach(this, address);
+    }
+
+    virtual bool i2cWrite(const uint8_t* data, int len) {
+        if (count < MAX_TRANSFERS) {
+            memcpy(transfers[count], data, (len < (int)sizeof(transfers[0])) ? len : sizeof(transfers[0]));
+            lengths[count] = len;
+        }
+        count++;
+        return true;
+    }
+
+    virtual bool i2cRead(uint8_t* data, int len) {
+        memset(data, 0, len);
+        return true;
+    }
+
+    /** Returns true if transfer with given index is given prefix (-1 if none) followed by given data */
+    bool check(int index, int prefix, const uint8_t* data, int len) {
+        int offset = (prefix >= 0) ? 1 : 0;
+
+        if ((index >= count) || (lengths[index] != (len + offset))) {
+            return false;
+        }
+        if ((prefix >= 0) && (transfers[index][0] != (uint8_t)prefix)) {
+            return false;
+        }
+        return memcmp(&transfers[index][offset], data, len) == 0;
+    }
+
+    uint8_t transfers[MAX_TRANSFERS][256];
+    int     lengths[MAX_TRANSFERS];
+    int     count;
+};
+
+/** Display driver, with access to the display buffer and dirty bits */
+class TestOled : public MxSSD1306_I2C {
+public:
+    TestOled(I2C& i2c) : MxSSD1306_I2C(SSD_I2C_ADDRESS, i2c, OLED_HEIGHT, OLED_WIDTH) {
+    }
+
+    bool isDirty(void) {
+        uint16_t i;
+
+        for (i = 0; i < (OLED_HEIGHT / 8); i++) {
+            if (dirty[i] != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Returns true while queued display data is being sent */
+    bool isSending(void) {
+        return pollTransfers() == SSD1306_BUSY;
+    }
+
+    const uint8_t* getBuffer(void) {
+        return buffer;
+    }
+};
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static Recorder     recorder(DEV_ADDRESS);
+static Ssd1306Model ssd(SSD_I2C_ADDRESS);
+static i2c_t        bus;
+static uint8_t      data[4][64];
+
+//Handler calls, context is the transfer number
+static int          doneContext[MAX_DONE];
+static int          doneResult[MAX_DONE];
+static int          doneCount;
+
+static int errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static void onDone(void* context, int result) {
+    if (doneCount < MAX_DONE) {
+        doneContext[doneCount] = (int)(intptr_t)context;
+        doneResult[doneCount] = result;
+    }
+    doneCount++;
+}
+
+static void fail(const char* name, const char* msg) {
+    printf("FAIL %s: %s\n", name, msg);
+    errors++;
+}
+
+/** Start a test: clear handler calls, recorded transfers and model statistics */
+static void begin(void) {
+    Stm32I2cStats stats;
+
+    doneCount = 0;
+    recorder.count = 0;
+    stm32_i2c_stats(1, &stats);
+}
+
+/** Queue transfer with given number, of given length of data[number] */
+static void queue(const char* name, int number, int address, int prefix, int len) {
+    if (i2c_queue_write(&bus, address, prefix, (const char*)data[number], len, &onDone, (void*)(intptr_t)number)
+            != 0) {
+        fail(name, "i2c_queue_write() failed");
+    }
+}
+
+/** Poll queue until it is empty, and the STOP of the last transfer has been generated */
+static void waitQueue(const char* name) {
+    uint64_t timeout = host_time_ns() + (WAIT_TIMEOUT_US * 1000ULL);
+
+    while (i2c_queue_busy(&bus) || stm32_i2c_busy(1)) {
+        if (host_time_ns() > timeout) {
+            fail(name, "queue not empty");
+            return;
+        }
+        wait_us(10);
+    }
+}
+
+/** Check that handlers were called for given transfer numbers in order, with given result */
+static void checkDone(const char* name, const int* numbers, int count, int result) {
+    int i;
+
+    if (doneCount != count) {
+        printf("FAIL %s: %d handler calls, expected %d\n", name, doneCount, count);
+        errors++;
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        if ((doneContext[i] != numbers[i]) || (doneResult[i] != result)) {
+            printf("FAIL %s: handler call %d was transfer %d result %d, expected transfer %d result %d\n", name, i,
+                    doneContext[i], doneResult[i], numbers[i], result);
+            errors++;
+        }
+    }
+}
+
+/** Check model statistics, and that the bus is idle */
+static void checkStats(const char* name, Stm32I2cStats* pStats) {
+    stm32_i2c_stats(1, pStats);
+    if (pStats->errors != 0) {
+        fail(name, "registers accessed in wrong state");
+    }
+    if (stm32_i2c_busy(1)) {
+        fail(name, "bus still busy");
+    }
+}
+
+/** Transfers are sent in order by the event interrupt, without blocking the caller */
+static void testQueue(void) {
+    static const int numbers[] = {0, 1, 2};
+    Stm32I2cStats stats;
+    uint64_t start;
+
+    begin();
+    start = host_time_ns();
+    queue("queue", 0, DEV_ADDRESS, 0x40, 16);
+    queue("queue", 1, DEV_ADDRESS, -1, 5);
+    queue("queue", 2, DEV_ADDRESS, 0x00, 1);
+    if ((host_time_ns() - start) > 10000) {
+        fail("queue", "i2c_queue_write() blocked");
+    }
+    waitQueue("queue");
+
+    checkDone("queue", numbers, 3, 0);
+    if ((recorder.count != 3) || !recorder.check(0, 0x40, data[0], 16) || !recorder.check(1, -1, data[1], 5)
+            || !recorder.check(2, 0x00, data[2], 1)) {
+        fail("queue", "transfers not received");
+    }
+    checkStats("queue", &stats);
+    if ((stats.starts != 3) || (stats.stops != 3) || (stats.evIrqs == 0)) {
+        fail("queue", "transfers not sent by event interrupt");
+    }
+    if (stats.startsAfterStop != 0) {
+        fail("queue", "START requested while STOP pending");
+    }
+}
+
+/** START of a queued transfer is deferred until the STOP of the previous one is done, and generated by polling */
+static void testDeferredStart(void) {
+    static const int numbers[] = {0, 1};
+    Stm32I2cStats stats;
+
+    begin();
+    queue("deferred", 0, DEV_ADDRESS, 0x40, 8);
+    queue("deferred", 1, DEV_ADDRESS, 0x40, 8);
+
+    //Not polled, only first transfer is sent
+    wait_us(2000);
+    stm32_i2c_stats(1, &stats);
+    if ((recorder.count != 1) || (stats.starts != 1) || (stats.stops != 1) || stm32_i2c_busy(1)) {
+        fail("deferred", "second transfer started without polling");
+    }
+    if (stats.errors != 0) {
+        fail("deferred", "registers accessed while STOP pending");
+    }
+
+    //Polling generates the deferred START
+    if (i2c_queue_busy(&bus) == 0) {
+        fail("deferred", "queue empty");
+    }
+    waitQueue("deferred");
+    checkDone("deferred", numbers, 2, 0);
+    if ((recorder.count != 2) || !recorder.check(1, 0x40, data[1], 8)) {
+        fail("deferred", "second transfer not received");
+    }
+    checkStats("deferred", &stats);
+    if ((stats.starts != 1) || (stats.startsAfterStop != 0)) {
+        fail("deferred", "START requested while STOP pending");
+    }
+}
+
+/** NACKed address fails the transfer, and all following ones */
+static void testNack(void) {
+    static const int numbers[] = {0, 1, 2};
+    static const int numbersOk[] = {3};
+    Stm32I2cStats stats;
+
+    begin();
+    queue("nack", 0, NACK_ADDRESS, 0x40, 8);
+    queue("nack", 1, DEV_ADDRESS, 0x40, 8);
+    queue("nack", 2, DEV_ADDRESS, 0x40, 8);
+    waitQueue("nack");
+    checkDone("nack", numbers, 3, I2C_ERROR_NO_SLAVE);
+    if (recorder.count != 0) {
+        fail("nack", "transfer after NACK was sent");
+    }
+    checkStats("nack", &stats);
+    if ((stats.nacks != 1) || (stats.erIrqs == 0)) {
+        fail("nack", "NACK not handled by error interrupt");
+    }
+
+    //Bus can be used again
+    begin();
+    queue("nack", 3, DEV_ADDRESS, -1, 4);
+    waitQueue("nack");
+    checkDone("nack", numbersOk, 1, 0);
+    if ((recorder.count != 1) || !recorder.check(0, -1, data[3], 4)) {
+        fail("nack", "transfer after error not received");
+    }
+    checkStats("nack", &stats);
+}
+
+/** i2c_init() (i2c_reset()) aborts all queued transfers */
+static void testAbort(void) {
+    static const int numbers[] = {0, 1, 2, 3};
+    static const int numbersOk[] = {2};
+    Stm32I2cStats stats;
+    int i;
+
+    begin();
+    i2c_frequency(&bus, 100000);
+    for (i = 0; i < 4; i++) {
+        queue("abort", i, DEV_ADDRESS, 0x40, 64);
+    }
+    wait_us(1000);     //First transfer takes 5.9ms at 100kHz
+    i2c_init(&bus, PB_9, PB_8);
+
+    checkDone("abort", numbers, 4, I2C_ERROR_BUS_BUSY);
+    if (i2c_queue_busy(&bus) != 0) {
+        fail("abort", "queue not empty");
+    }
+    //Transfer is stopped after the current byte
+    if ((recorder.count != 1) || (recorder.lengths[0] >= 65)
+            || (memcmp(&recorder.transfers[0][1], data[0], recorder.lengths[0] - 1) != 0)) {
+        fail("abort", "first transfer not stopped");
+    }
+    checkStats("abort", &stats);
+
+    begin();
+    queue("abort", 2, DEV_ADDRESS, 0x40, 64);
+    waitQueue("abort");
+    checkDone("abort", numbersOk, 1, 0);
+    if ((recorder.count != 1) || !recorder.check(0, 0x40, data[2], 64)) {
+        fail("abort", "transfer after abort not received");
+    }
+    checkStats("abort", &stats);
+    i2c_frequency(&bus, 400000);
+}
+
+/** Blocking writes are sent after the queued transfers */
+static void testBlocking(void) {
+    static const int numbers[] = {0, 1};
+    Stm32I2cStats stats;
+
+    begin();
+    queue("blocking", 0, DEV_ADDRESS, 0x40, 16);
+    queue("blocking", 1, DEV_ADDRESS, 0x40, 16);
+    if ((i2c_write(&bus, DEV_ADDRESS, (const char*)data[2], 10, 1) != 10)
+            || (i2c_write(&bus, DEV_ADDRESS, (const char*)data[3], 10, 1) != 10)) {
+        fail("blocking", "i2c_write() failed");
+    }
+    wait_us(100);   //Last STOP
+
+    checkDone("blocking", numbers, 2, 0);
+    if ((recorder.count != 4) || !recorder.check(0, 0x40, data[0], 16) || !recorder.check(1, 0x40, data[1], 16)
+            || !recorder.check(2, -1, data[2], 10) || !recorder.check(3, -1, data[3], 10)) {
+        fail("blocking", "transfers not received in order");
+    }
+    checkStats("blocking", &stats);
+}
+
+/** Display buffer is sent with the queue by MxSSD1306_I2C */
+static void testOled(void) {
+    I2C i2c(PB_9, PB_8);
+    TestOled oled(i2c);
+    Stm32I2cStats stats;
+    uint64_t timeout;
+    int16_t i;
+
+    i2c.frequency(400000);
+    ssd.fillRam(0xa5);
+    oled.init();
+    for (i = 0; i < 8; i++) {
+        oled.fillRect(i * 16, i * 8, 16, 8, 1);
+        oled.fillRect(0, (i * 8) + 3, OLED_WIDTH, 1, 1);
+    }
+    stm32_i2c_stats(1, &stats);
+
+    timeout = host_time_ns() + (WAIT_TIMEOUT_US * 1000ULL);
+    while (oled.isDirty() || oled.isSending()) {
+        if (host_time_ns() > timeout) {
+            fail("oled", "display() did not finish");
+            break;
+        }
+        if (oled.display() != 0) {
+            fail("oled", "display() failed");
+        }
+        wait_us(100);
+    }
+
+    if (memcmp(ssd.getRam(), oled.getBuffer(), BUF_SIZE) != 0) {
+        fail("oled", "display RAM does not match buffer");
+    }
+    checkStats("oled", &stats);
+    if (stats.evIrqs == 0) {
+        fail("oled", "display data not sent by I2C queue");
+    }
+}
+
+int main() {
+    int i;
+    int j;
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 64; j++) {
+            data[i][j] = (uint8_t)((i * 64) + (j * 3) + 1);
+        }
+    }
+    i2c_init(&bus, PB_9, PB_8);
+    i2c_frequency(&bus, 400000);
+
+    testQueue();
+    testDeferredStart();
+    testNack();
+    testAbort();
+    testBlocking();
+    testOled();
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
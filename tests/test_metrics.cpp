@@ -0,0 +1,238 @@
+/**
+ * File:      test_metrics.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host test of the metrics registry (mx_metrics.h), and of the "mtr" USB command in main.cpp. main.cpp is compiled
+ * unmodified (main() renamed to app_main(), it is not called), with the simulated USB CDC port (host_usb.h).
+ *
+ * - Registry: snapshot text of a counter, gauge and histogram, reset semantics, histogram buckets, and a buffer that
+ *   is too small.
+ * - Drops: more commands are sent than rxBufUsb can hold, and more replies are queued than txBufUsb can hold. The
+ *   "usbcmddrop" and "usbtxdrop" metrics read with "mtr1" must count every lost command and reply.
+ * - Host not reading: "mtr" is processed while CDC_Transmit_FS() is busy. processUsbCmds() must return, and the lost
+ *   replies must be counted by "usbtxretry" and "usbtxfail".
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <stdlib.h>
+
+#define main app_main
+#include "main.cpp"
+#undef main
+
+#include "mx_spsc_buffer.h"
+#include "host_usb.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define LOOP_NS         20000   //Simulated time of one main loop
+#define REPLIES_SIZE    4096
+#define UNKNOWN_CMD     "xyz;"  //Command replied to with "uc"
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+extern MxSpscBuffer <uint8_t, RX_BUF_USB_ISR_SIZE> rxIsrBufUsb;     //In mx_usb_cdc.cpp
+
+static MxCounter    tstCounter("tstcnt");
+static MxGauge      tstGauge("tstgauge");
+static MxHistogram  tstHistogram("tsthist");
+
+static char         replies[REPLIES_SIZE];  //All data sent to the PC, NULL terminated
+static uint32_t     repliesLen;
+static int          errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static void check(bool ok, const char* msg) {
+    if (!ok) {
+        printf("FAIL %s\n", msg);
+        errors++;
+    }
+}
+
+static void onUsbTx(void* ctx, const uint8_t* data, uint16_t len) {
+    (void)ctx;
+
+    if ((repliesLen + len) < REPLIES_SIZE) {
+        memcpy(&replies[repliesLen], data, len);
+        repliesLen += len;
+        replies[repliesLen] = 0;
+    }
+}
+
+static MxMetric* findMetric(const char* name) {
+    MxMetric* m;
+
+    for (m = MxMetrics::first(); m != NULL; m = m->getNext()) {
+        if (strcmp(m->getName(), name) == 0) {
+            return m;
+        }
+    }
+    return NULL;
+}
+
+/** Get value of given metric in replies, or -1 if not found */
+static long replyValue(const char* name) {
+    char key[32];
+    const char* p;
+
+    snprintf(key, sizeof(key), "mtr%s=", name);
+    p = strstr(replies, key);
+    return (p == NULL) ? -1 : strtol(p + strlen(key), NULL, 10);
+}
+
+/** Move data sent by the PC into rxBufUsb, without processing commands */
+static void receive(void) {
+    while ((host_usb_pending() != 0) || !rxIsrBufUsb.isEmpty()) {
+        host_advance_ns(LOOP_NS);
+        mx_usbcdc_task();
+    }
+}
+
+/** Main loop until all commands are processed and replies sent. Returns simulated ns. */
+static uint64_t run(void) {
+    uint64_t start = host_time_ns();
+
+    while ((host_usb_pending() != 0) || !rxIsrBufUsb.isEmpty() || rxBufUsb.hasCommand() || txBufUsb.hasCommand()) {
+        host_advance_ns(LOOP_NS);
+        mx_usbcdc_task();
+        if (rxBufUsb.hasCommand()) {
+            processUsbCmds();
+        }
+    }
+    return host_time_ns() - start;
+}
+
+/** Send "mtr1" and process it. Clears replies first. */
+static void pollMetrics(void) {
+    repliesLen = 0;
+    replies[0] = 0;
+    host_usb_send((const uint8_t*)"mtr1;", 5);
+    run();
+}
+
+static void sendUnknown(uint32_t count) {
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        host_usb_send((const uint8_t*)UNKNOWN_CMD, strlen(UNKNOWN_CMD));
+    }
+}
+
+static void testRegistry(void) {
+    MxMetric* m;
+    char buf[128];
+
+    tstCounter.inc();
+    tstCounter.inc(3);
+    tstGauge.set(-5);
+    tstHistogram.add(0);        //Bucket 0
+    tstHistogram.add(1);        //Bucket 1
+    tstHistogram.add(2);        //Bucket 2 = 2-3
+    tstHistogram.add(3);
+    tstHistogram.add(4);        //Bucket 3 = 4-7
+    tstHistogram.add(7);
+    tstHistogram.add(8);        //Bucket 4 = 8-15
+    tstHistogram.add(100000);   //Last bucket
+
+    m = findMetric("tstcnt");
+    check(m != NULL, "counter registered");
+    MxMetrics::snapshot(m, buf, sizeof(buf), false);
+    check(strcmp(buf, "mtrtstcnt=4;") == 0, "counter snapshot");
+    MxMetrics::snapshot(m, buf, sizeof(buf), true);
+    MxMetrics::snapshot(m, buf, sizeof(buf), false);
+    check(strcmp(buf, "mtrtstcnt=0;") == 0, "counter reset");
+
+    m = findMetric("tstgauge");
+    check(m != NULL, "gauge registered");
+    MxMetrics::snapshot(m, buf, sizeof(buf), true);
+    MxMetrics::snapshot(m, buf, sizeof(buf), false);
+    check(strcmp(buf, "mtrtstgauge=-5;") == 0, "gauge is not reset");
+
+    m = findMetric("tsthist");
+    check(m != NULL, "histogram registered");
+    MxMetrics::snapshot(m, buf, sizeof(buf), true);
+    check(strcmp(buf, "mtrtsthist=1,1,2,2,1,0,0,1;") == 0, "histogram buckets");
+    MxMetrics::snapshot(m, buf, sizeof(buf), false);
+    check(strcmp(buf, "mtrtsthist=0,0,0,0,0,0,0,0;") == 0, "histogram reset");
+
+    check((MxMetrics::snapshot(m, buf, 20, false) == 0) && (buf[0] == 0), "buffer too small");
+}
+
+static void testDrops(void) {
+    uint32_t extra = 8;
+
+    pollMetrics();
+
+    //Commands sent while none are processed. rxBufUsb holds RX_BUF_USB_COMMANDS
+    sendUnknown(RX_BUF_USB_COMMANDS + extra);
+    receive();
+    run();
+    pollMetrics();
+    check(replyValue("usbcmddrop") == (long)extra, "usbcmddrop counts every lost command");
+    check(replyValue("usbrxdrop") == 0, "usbrxdrop");
+
+    //Replies queued while PC does not read. txBufUsb holds TX_BUF_USB_COMMANDS
+    host_usb_set_tx_busy(true);
+    sendUnknown(RX_BUF_USB_COMMANDS);
+    receive();
+    while (rxBufUsb.hasCommand()) {
+        processUsbCmds();
+    }
+    sendUnknown(extra);
+    receive();
+    while (rxBufUsb.hasCommand()) {
+        processUsbCmds();
+    }
+    host_usb_set_tx_busy(false);
+    run();
+    pollMetrics();
+    check(replyValue("usbtxdrop") == (long)extra, "usbtxdrop counts every lost reply");
+}
+
+static void testHostNotReading(void) {
+    uint64_t ns;
+
+    pollMetrics();
+    host_usb_set_tx_busy(true);
+    host_usb_send((const uint8_t*)"mtr;", 4);
+    ns = run();
+    host_usb_set_tx_busy(false);
+    printf("\"mtr\" with PC not reading took %.1f ms\n", (double)ns / 1e6);
+    check(ns < (5ULL * USB_TX_WAIT_TIMEOUT * 1000000), "mtr returns when PC does not read");
+
+    pollMetrics();
+    check(replyValue("usbtxretry") > 0, "usbtxretry");
+    check(replyValue("usbtxfail") > 0, "usbtxfail");
+}
+
+int main() {
+    host_usb_set_tx_handler(&onUsbTx, NULL);
+    mx_usbcdc_init();
+    rxBufUsb.enableReplaceCrLfWithEoc();
+    txBufUsb.disableReplaceCrLfWithEoc();
+
+    testRegistry();
+    testDrops();
+    testHostNotReading();
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
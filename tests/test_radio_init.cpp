@@ -0,0 +1,266 @@
+/**
+ * File:      test_radio_init.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host test for the non blocking initialization and warm start of the InAir driver. Two InAir objects are connected
+ * to SX1276 models sharing the same air. It is checked that:
+ * - The constructor returns right after the reset pulse, and InitTask() only accesses the radio once it is ready
+ *   (RADIO_POWER_UP_TIME). The SX1276 model counts SPI accesses done before the chip is ready.
+ * - A packet is received after the cold start.
+ * - After SaveRegisterImage() and WarmStart(), InitTask() waits RADIO_RESET_TIME, restores the configuration
+ *   registers without an image calibration, and a packet is received again with the restored configuration.
+ * - WarmStart() fails if no register image was saved.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include "mbed.h"
+#include "inair.h"
+#include "sx1276_model.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define CHANNEL_FREQ        868100000
+#define PAYLOAD_LEN         32
+#define TX_TIMEOUT_US       3000000
+#define POLL_US             50          //InitTask() poll interval
+#define RESET_PULSE_US      100         //Ready time is counted from end of reset pulse
+#define POLL_SLACK_NS       ((RESET_PULSE_US + POLL_US + 10) * 1000ULL)
+
+typedef struct RegRange_ {
+    uint8_t addr;
+    uint8_t count;
+} RegRange;
+
+//Writable LoRa configuration registers, must be restored by a warm start
+static const RegRange loraConfigRegs[] = {
+    {0x06, 10}, {0x11, 1}, {0x1D, 8}, {0x26, 2}, {0x31, 1}, {0x33, 1}, {0x37, 1}, {0x39, 1}, {0x40, 2},
+    {0x4B, 1}, {0x4D, 1}
+};
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static Sx1276Air   air;
+static Sx1276Model modelTx(&air, PA_4, PC_0, PB_0, PB_1, PB_2, PB_3);
+static Sx1276Model modelRx(&air, PA_8, PC_1, PB_4, PB_5, PB_6, PB_7);
+
+static InAir*      radioTx;
+static InAir*      radioRx;
+
+static volatile bool txDone;
+static volatile bool txTimeout;
+static volatile bool rxDone;
+static volatile bool rxError;
+static uint8_t       rxPayload[256];
+static uint16_t      rxSize;
+static uint8_t       txPayload[PAYLOAD_LEN];
+
+static int errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static void onTxDone() {
+    txDone = true;
+}
+
+static void onTxTimeout() {
+    txTimeout = true;
+}
+
+static void onRxDone(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr) {
+    (void)rssi;
+    (void)snr;
+    memcpy(rxPayload, payload, size);
+    rxSize = size;
+    rxDone = true;
+}
+
+static void onRxError() {
+    rxError = true;
+}
+
+static void fail(const char* name, const char* msg) {
+    printf("FAIL %s: %s\n", name, msg);
+    errors++;
+}
+
+/** Call InitTask() of given radio until it returns true. Returns time it first returned true, relative to given
+ * start time. Checks that it did not return true before readyUs.
+ */
+static uint64_t pollInit(const char* name, InAir* radio, uint64_t startNs, uint32_t readyUs) {
+    uint64_t callNs;
+
+    while (1) {
+        callNs = host_time_ns();
+        if (radio->InitTask()) {
+            break;
+        }
+        if ((callNs - startNs) > (readyUs * 2000ULL)) {
+            fail(name, "InitTask() never returned true");
+            return 0;
+        }
+        wait_us(POLL_US);
+    }
+
+    callNs -= startNs;
+    if ((callNs < (readyUs * 1000ULL)) || (callNs > ((readyUs * 1000ULL) + POLL_SLACK_NS))) {
+        printf("FAIL %s: InitTask() returned true after %lluus, expected %luus\n", name,
+                (unsigned long long)(callNs / 1000), (unsigned long)readyUs);
+        errors++;
+    }
+    return host_time_ns() - startNs;
+}
+
+static void configure(void) {
+    radioTx->SetChannel(CHANNEL_FREQ);
+    radioRx->SetChannel(CHANNEL_FREQ);
+    radioTx->SetTxConfig(MODEM_LORA, 14, 0, 7, 7, 1, 8, false, true, false, 0, false, TX_TIMEOUT_US);
+    radioRx->SetRxConfig(MODEM_LORA, 7, 7, 1, 0, 8, 5, false, 0, true, false, 0, false, true);
+}
+
+/** Start receiver, send packet and check it is received */
+static void sendAndCheck(const char* name) {
+    uint64_t timeout;
+
+    txDone = txTimeout = rxDone = rxError = false;
+    rxSize = 0;
+    radioRx->Rx(0);
+    radioTx->Send(txPayload, PAYLOAD_LEN);
+
+    timeout = host_time_ns() + (TX_TIMEOUT_US * 1000ULL);
+    while ((!txDone || (!rxDone && !rxError)) && !txTimeout && (host_time_ns() < timeout)) {
+        __WFI();
+    }
+
+    if (!txDone) {
+        fail(name, "no TxDone");
+    }
+    else if (!rxDone || (rxSize != PAYLOAD_LEN) || (memcmp(rxPayload, txPayload, PAYLOAD_LEN) != 0)) {
+        fail(name, rxError ? "CRC error" : "packet not received");
+    }
+}
+
+/** Read configuration registers of given model */
+static void readConfig(Sx1276Model* model, uint8_t* regs) {
+    uint8_t i;
+    uint8_t j;
+
+    for (i = 0; i < (sizeof(loraConfigRegs) / sizeof(loraConfigRegs[0])); i++) {
+        for (j = 0; j < loraConfigRegs[i].count; j++) {
+            regs[loraConfigRegs[i].addr + j] = model->peek(loraConfigRegs[i].addr + j);
+        }
+    }
+}
+
+int main() {
+    uint8_t regsSaved[2][0x80];
+    uint8_t regsRestored[0x80];
+    uint64_t startNs;
+    uint64_t coldNs;
+    uint64_t warmNs;
+    uint32_t calCount;
+    uint16_t i;
+
+    for (i = 0; i < PAYLOAD_LEN; i++) {
+        txPayload[i] = (uint8_t)((i * 53) + 7);
+    }
+
+    //Cold start. Constructor only does the reset pulse, InitTask() initializes the radio once it is ready
+    startNs = host_time_ns();
+    radioTx = new InAir(&onTxDone, &onTxTimeout, NULL, NULL, NULL, NULL, NULL, PB_15, PB_14, PB_13, PA_4, PC_0,
+            PB_0, PB_1, PB_2, PB_3);
+    if ((host_time_ns() - startNs) > 1000000ULL) {
+        fail("cold", "constructor blocked");
+    }
+    coldNs = pollInit("cold", radioTx, startNs, RADIO_POWER_UP_TIME);
+    radioRx = new InAir(NULL, NULL, &onRxDone, NULL, &onRxError, NULL, NULL, PB_15, PB_14, PB_13, PA_8, PC_1,
+            PB_4, PB_5, PB_6, PB_7);
+    while (!radioRx->InitTask()) {
+        wait_us(POLL_US);
+    }
+    startNs = host_time_ns();
+    configure();
+    coldNs += host_time_ns() - startNs;
+
+    if ((modelTx.resetCount != 1) || (modelTx.imageCalCount == 0)) {
+        fail("cold", "radio not reset and calibrated");
+    }
+    sendAndCheck("cold");
+
+    //No register image saved yet
+    if (radioTx->WarmStart()) {
+        fail("warm", "WarmStart() without register image did not fail");
+    }
+
+    //Save configuration, and put radios to sleep like the application does before STOP mode
+    radioTx->Sleep();
+    radioRx->Sleep();
+    radioTx->SaveRegisterImage();
+    radioRx->SaveRegisterImage();
+    readConfig(&modelTx, regsSaved[0]);
+    readConfig(&modelRx, regsSaved[1]);
+    wait_ms(1000);
+
+    //Warm start. Reset clears all registers, InitTask() restores them without image calibration
+    calCount = modelTx.imageCalCount;
+    startNs = host_time_ns();
+    if (!radioTx->WarmStart() || !radioRx->WarmStart()) {
+        fail("warm", "WarmStart() failed");
+    }
+    warmNs = pollInit("warm", radioTx, startNs, RADIO_RESET_TIME);
+    while (!radioRx->InitTask()) {
+        wait_us(POLL_US);
+    }
+
+    if ((modelTx.resetCount != 2) || (modelTx.imageCalCount != calCount)) {
+        fail("warm", "radio not reset, or calibrated again");
+    }
+    readConfig(&modelTx, regsRestored);
+    for (i = 0; i < sizeof(loraConfigRegs) / sizeof(loraConfigRegs[0]); i++) {
+        if (memcmp(&regsRestored[loraConfigRegs[i].addr], &regsSaved[0][loraConfigRegs[i].addr],
+                loraConfigRegs[i].count) != 0) {
+            printf("FAIL warm: register 0x%02X-0x%02X of tx not restored\n", loraConfigRegs[i].addr,
+                    loraConfigRegs[i].addr + loraConfigRegs[i].count - 1);
+            errors++;
+        }
+    }
+    readConfig(&modelRx, regsRestored);
+    for (i = 0; i < sizeof(loraConfigRegs) / sizeof(loraConfigRegs[0]); i++) {
+        if (memcmp(&regsRestored[loraConfigRegs[i].addr], &regsSaved[1][loraConfigRegs[i].addr],
+                loraConfigRegs[i].count) != 0) {
+            printf("FAIL warm: register 0x%02X-0x%02X of rx not restored\n", loraConfigRegs[i].addr,
+                    loraConfigRegs[i].addr + loraConfigRegs[i].count - 1);
+            errors++;
+        }
+    }
+    sendAndCheck("warm");
+
+    if ((modelTx.spiErrCount != 0) || (modelRx.spiErrCount != 0)) {
+        fail("init", "radio accessed while in reset, or not ready");
+    }
+
+    printf("Cold start %lluus, warm start %lluus\n", (unsigned long long)(coldNs / 1000),
+            (unsigned long long)(warmNs / 1000));
+    if (warmNs >= coldNs) {
+        fail("warm", "warm start not faster than cold start");
+    }
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * File:      test_spsc_buffer.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host stress test for MxSpscBuffer. A producer and a consumer thread pass a known sequence through the buffer,
+ * using single put/get and putArray/getArray with random lengths. The consumer checks that every value arrives
+ * exactly once, in order, and unchanged. Small buffers with 8-bit counters are used, so the counters wrap often.
+ *
+ * The threads run on the host CPU with the real __DMB() barrier of cmsis.h (a full memory barrier). On a single
+ * core host the threads are interleaved by the scheduler at random points, on a multi core host they run in
+ * parallel.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include "mbed.h"
+#include "mx_spsc_buffer.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define STRESS_COUNT    20000000    //Values passed through buffer per test
+#define MAX_CHUNK       100         //Largest putArray/getArray, larger than some buffers
+
+
+/** Value at given position of the test sequence. Not a simple counter, so a wrong index or stale data is detected.
+ */
+template<typename T>
+static inline T seqValue(uint32_t i) {
+    return (T)((i * 2654435761UL) ^ (i >> 7));
+}
+
+static inline uint32_t random32(uint32_t* state) {
+    *state = (*state * 1103515245) + 12345;
+    return *state >> 8;
+}
+
+template<typename T, uint32_t BufferSize>
+class StressTest {
+public:
+    StressTest() : errors(0), received(0), producerDone(false) {
+    }
+
+    /** Run test, returns number of errors */
+    uint32_t run(const char* name) {
+        pthread_t thread;
+
+        pthread_create(&thread, NULL, &StressTest::producerThread, this);
+        consumer();
+        pthread_join(thread, NULL);
+
+        if (received != STRESS_COUNT) {
+            printf("FAIL %s: received %u values, %u sent\n", name, received, STRESS_COUNT);
+            errors++;
+        }
+        if (!buffer.isEmpty()) {
+            printf("FAIL %s: buffer not empty at end\n", name);
+            errors++;
+        }
+        printf("%s: %u values, %u errors\n", name, received, errors);
+        return errors;
+    }
+
+protected:
+    static void* producerThread(void* arg) {
+        ((StressTest*)arg)->producer();
+        return NULL;
+    }
+
+    void producer(void) {
+        T chunk[MAX_CHUNK];
+        uint32_t rnd = 1;
+        uint32_t sent = 0;
+        uint32_t len;
+        uint32_t i;
+
+        while (sent < STRESS_COUNT) {
+            if ((random32(&rnd) & 1) == 0) {
+                if (buffer.put(seqValue<T>(sent))) {
+                    sent++;
+                }
+                else {
+                    sched_yield();
+                }
+            }
+            else {
+                len = 1 + (random32(&rnd) % MAX_CHUNK);
+                if (len > (STRESS_COUNT - sent)) {
+                    len = STRESS_COUNT - sent;
+                }
+                for (i = 0; i < len; i++) {
+                    chunk[i] = seqValue<T>(sent + i);
+                }
+                len = buffer.putArray(chunk, len);
+                if (len == 0) {
+                    sched_yield();
+                }
+                sent += len;
+            }
+        }
+        producerDone = true;
+    }
+
+    /** Receive until all values were received, or producer is done and buffer is empty */
+    void consumer(void) {
+        T chunk[MAX_CHUNK];
+        uint32_t rnd = 2;
+        uint32_t len;
+        uint32_t i;
+        T value;
+
+        while ((received < STRESS_COUNT) && !(producerDone && buffer.isEmpty())) {
+            if ((random32(&rnd) & 1) == 0) {
+                if (!buffer.getAndCheck(value)) {
+                    sched_yield();
+                    continue;
+                }
+                check(value);
+            }
+            else {
+                len = buffer.getArray(chunk, 1 + (random32(&rnd) % MAX_CHUNK));
+                if (len == 0) {
+                    sched_yield();
+                }
+                for (i = 0; i < len; i++) {
+                    check(chunk[i]);
+                }
+            }
+        }
+    }
+
+    void check(T value) {
+        if (value != seqValue<T>(received)) {
+            if (errors++ < 10) {
+                printf("FAIL value %u is 0x%x, expected 0x%x\n", received, (unsigned)value,
+                        (unsigned)seqValue<T>(received));
+            }
+        }
+        received++;
+    }
+
+    MxSpscBuffer<T, BufferSize> buffer;
+    uint32_t errors;
+    uint32_t received;
+    volatile bool producerDone;
+};
+
+int main() {
+    uint32_t errors = 0;
+
+    {
+        StressTest<uint8_t, 64> test;
+        errors += test.run("MxSpscBuffer<uint8_t, 64>");
+    }
+    {
+        StressTest<uint8_t, 128> test;
+        errors += test.run("MxSpscBuffer<uint8_t, 128>");
+    }
+    {
+        StressTest<uint32_t, 16> test;
+        errors += test.run("MxSpscBuffer<uint32_t, 16>");
+    }
+    {
+        StressTest<uint16_t, 512> test;
+        errors += test.run("MxSpscBuffer<uint16_t, 512>");
+    }
+
+    if (errors != 0) {
+        printf("%u errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
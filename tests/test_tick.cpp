@@ -0,0 +1,138 @@
+/**
+ * File:      test_tick.cpp
+ *
+ * Author:    Modtronix Engineering - www.modtronix.com
+ *
+ * Description:
+ * Host test of the tickless MxTick (mx_tick.cpp), on the simulated 32-bit us_ticker. Simulated time is advanced in
+ * irregular steps over TEST_DAYS days, so the us_ticker wraps many times (every 71.6 minutes) and read_ms() wraps
+ * once (after 24.8 days). Some steps are gaps of hours in which nothing reads the time, only the keep-alive Ticker
+ * runs.
+ *
+ * After each step, read_us64(), read_ms64(), read_ms(), read_ms10(), read_ms100() and read_sec() must give the
+ * simulated time. expired_ms() and elapsed_ms() are checked with deadlines that cross the read_ms() wrap.
+ *
+ * Software License Agreement:
+ * This software has been written or modified by Modtronix Engineering. The code
+ * may be modified and can be used free of charge for commercial and non commercial
+ * applications. If this is modified software, any license conditions from original
+ * software also apply. Any redistribution must include reference to 'Modtronix
+ * Engineering' and web link(www.modtronix.com) in the file header.
+ *
+ * THIS SOFTWARE IS PROVIDED IN AN 'AS IS' CONDITION. NO WARRANTIES, WHETHER EXPRESS,
+ * IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE
+ * COMPANY SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ * CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ */
+#include "mbed.h"
+#include "mx_tick.h"
+
+
+// DEFINES ////////////////////////////////////////////////////////////////////
+#define TEST_DAYS       40
+#define GAP_EVERY       1000                    //Steps between long steps
+#define GAP_US          (3ULL * 3600 * 1000000) //Longest gap, 3 hours
+#define DEADLINE_MS     5000                    //Deadline checked with expired_ms() and elapsed_ms()
+
+
+// VARIABLES //////////////////////////////////////////////////////////////////
+static uint32_t rnd = 1;
+static int errors;
+
+
+// FUNCTIONS //////////////////////////////////////////////////////////////////
+static void fail(const char* msg, uint64_t us) {
+    if (errors++ < 10) {
+        printf("FAIL %s, at %llu us\n", msg, (unsigned long long)us);
+    }
+}
+
+/** Returns 24-bit random value */
+static inline uint32_t random32(void) {
+    rnd = (rnd * 1103515245) + 12345;
+    return rnd >> 8;
+}
+
+int main() {
+    uint64_t endUs = (uint64_t)TEST_DAYS * 24 * 3600 * 1000000;
+    uint64_t startUs;
+    uint64_t us;
+    uint64_t deadlineUs = 0;
+    uint32_t steps = 0;
+    uint32_t wraps = 0;
+    int deadline = 0;
+    int lastMs = 0;
+    int ms;
+
+    //Time is only advanced by the test
+    host_set_ticker_cost(0);
+    host_advance_ns(12345678);
+    startUs = host_time_ns() / 1000;
+    MxTick tick;
+
+    while (((host_time_ns() / 1000) - startUs) < endUs) {
+        //Mostly short steps, some gaps of up to 3 hours with nothing reading the time
+        if ((steps++ % GAP_EVERY) == 0) {
+            host_advance_ns(((((uint64_t)random32() << 24) | random32()) % GAP_US) * 1000);
+        }
+        else {
+            host_advance_ns((uint64_t)(random32() % 5000000) * 100);
+        }
+        us = (host_time_ns() / 1000) - startUs;
+
+        if (MxTick::read_us64() != us) {
+            fail("read_us64", us);
+        }
+        if (MxTick::read_ms64() != (us / 1000)) {
+            fail("read_ms64", us);
+        }
+        ms = MxTick::read_ms();
+        if (ms != (int)(uint32_t)(us / 1000)) {
+            fail("read_ms", us);
+        }
+        if (MxTick::read_ms10() != (int)(uint32_t)(us / 10000)) {
+            fail("read_ms10", us);
+        }
+        if (MxTick::read_ms100() != (int)(uint32_t)(us / 100000)) {
+            fail("read_ms100", us);
+        }
+        if (MxTick::read_sec() != (int)(uint32_t)(us / 1000000)) {
+            fail("read_sec", us);
+        }
+        if (ms < lastMs) {
+            wraps++;
+        }
+        lastMs = ms;
+
+        //Deadline set by "deadline = read_ms() + DEADLINE_MS", and checked until it expired
+        if (deadlineUs == 0) {
+            deadline = ms + DEADLINE_MS;
+            deadlineUs = ((us / 1000) + DEADLINE_MS) * 1000;
+        }
+        if (MxTick::expired_ms(deadline) != (us >= deadlineUs)) {
+            fail("expired_ms", us);
+        }
+        if (MxTick::elapsed_ms(deadline) != (int)((int64_t)(us / 1000) - (int64_t)(deadlineUs / 1000))) {
+            fail("elapsed_ms", us);
+        }
+        if (MxTick::expired_ms(deadline)) {
+            deadlineUs = 0;
+        }
+        if (!MxTick::expired_ms(ms - 10) || MxTick::expired_ms(ms + 10)) {
+            fail("expired_ms near read_ms()", us);
+        }
+    }
+
+    printf("%u steps over %d days, read_ms() wrapped %u times\n", steps, TEST_DAYS, wraps);
+    if (wraps == 0) {
+        fail("read_ms() did not wrap", (host_time_ns() / 1000) - startUs);
+    }
+
+    if (errors != 0) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}